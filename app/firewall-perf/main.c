@@ -0,0 +1,321 @@
+/** Offline benchmark of the firewall, the real worker roles and module chain
+ * run against ring ports fed by a synthetic traffic generator, or against any
+ * ports given on the eal command line, e.g. net_null or a net_pcap replay.
+ * */
+
+#include <getopt.h>
+#include <signal.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include <rte_common.h>
+#include <rte_cycles.h>
+#include <rte_eal.h>
+#include <rte_ethdev.h>
+#include <rte_launch.h>
+#include <rte_lcore.h>
+
+#include "config.h"
+#include "module.h"
+#include "packet.h"
+#include "stats.h"
+#include "worker.h"
+
+#include "traffic.h"
+
+#define DEF_PERF_TIME 10  // s
+#define DEF_PERF_PORT_NUM 2
+
+extern config_t config_a;
+
+static config_t *config = &config_a;
+static perf_traffic_t traffic;
+static volatile bool perf_quit;
+
+static unsigned int perf_gen_lcore = RTE_MAX_LCORE;
+static unsigned int perf_sink_lcore = RTE_MAX_LCORE;
+static uint64_t perf_packets[RTE_MAX_LCORE];
+static uint32_t perf_time = DEF_PERF_TIME;
+static bool perf_synthetic;
+
+static void perf_signal_handler(int signum) {
+  if (signum == SIGINT || signum == SIGTERM) {
+    perf_quit = true;
+  }
+}
+
+static void perf_usage(const char *prog) {
+  printf("%s [EAL options] -- [options]\n"
+         "  --config DIR     firewall config directory (default %s)\n"
+         "  --time S         seconds to run (default %d)\n"
+         "  --ports N        ring ports to create (default %d)\n"
+         "  --flows N        synthetic flows (default %d)\n"
+         "  --sizes LIST     frame size mix, e.g. 64:7,576:4,1500:1\n"
+         "  --ipv6 PCT       percent of ipv6 flows (default 0)\n"
+         "  --hit PCT        percent of flows sent to hit dport (default 0)\n"
+         "  --hit-dport P    destination port the rules match (default %d)\n"
+         "  --no-profile     do not collect cycles per module\n"
+         "Without eal ports ring ports and a generator are used, with ports\n"
+         "(--vdev net_null0 or --vdev net_pcap0,rx_pcap=f.pcap,infinite_rx=1)\n"
+         "they are polled as they are and latency is not reported.\n",
+         prog, CONFIG_PATH, DEF_PERF_TIME, DEF_PERF_PORT_NUM,
+         DEF_PERF_FLOW_NUM, DEF_PERF_HIT_DPORT);
+}
+
+static int perf_parse_args(int argc, char **argv, uint16_t *port_num) {
+  static const struct option opts[] = {
+    {"config", required_argument, NULL, 'c'},
+    {"time", required_argument, NULL, 't'},
+    {"ports", required_argument, NULL, 'p'},
+    {"flows", required_argument, NULL, 'f'},
+    {"sizes", required_argument, NULL, 's'},
+    {"ipv6", required_argument, NULL, '6'},
+    {"hit", required_argument, NULL, 'h'},
+    {"hit-dport", required_argument, NULL, 'd'},
+    {"no-profile", no_argument, NULL, 'n'},
+    {NULL, 0, NULL, 0},
+  };
+  const char *sizes = DEF_PERF_SIZES;
+  int opt;
+
+  traffic.flow_num = DEF_PERF_FLOW_NUM;
+  traffic.hit_dport = DEF_PERF_HIT_DPORT;
+  *port_num = DEF_PERF_PORT_NUM;
+  modules_profile = true;
+
+  while ((opt = getopt_long(argc, argv, "", opts, NULL)) != -1) {
+    switch (opt) {
+    case 'c':
+      config_path = optarg;
+      break;
+    case 't':
+      perf_time = atoi(optarg);
+      break;
+    case 'p':
+      *port_num = RTE_MIN(atoi(optarg), MAX_PORT_NUM);
+      break;
+    case 'f':
+      traffic.flow_num = atoi(optarg);
+      break;
+    case 's':
+      sizes = optarg;
+      break;
+    case '6':
+      traffic.ipv6 = RTE_MIN(atoi(optarg), 100);
+      break;
+    case 'h':
+      traffic.hit = RTE_MIN(atoi(optarg), 100);
+      break;
+    case 'd':
+      traffic.hit_dport = atoi(optarg);
+      break;
+    case 'n':
+      modules_profile = false;
+      break;
+    default:
+      perf_usage(argv[0]);
+      return -1;
+    }
+  }
+
+  if (!perf_time || !traffic.flow_num || !*port_num) {
+    perf_usage(argv[0]);
+    return -1;
+  }
+
+  return traffic_sizes_parse(&traffic, sizes);
+}
+
+static worker_t *perf_worker(unsigned int lcore_id) {
+  worker_t *worker;
+  int i;
+
+  for (i = 0; i < config->worker_num; i++) {
+    worker = (worker_t *)config->workers + i;
+    if ((worker->lcore_id == (int)lcore_id) && (worker->role != ROLE_MGMT) &&
+        (worker->role != ROLE_NONE)) {
+      return worker;
+    }
+  }
+
+  return NULL;
+}
+
+/** lcores outside worker.json drive the generator and the sink */
+static int perf_lcores_assign(void) {
+  unsigned int lcore_id;
+
+  RTE_LCORE_FOREACH_WORKER(lcore_id) {
+    if (perf_worker(lcore_id)) {
+      continue;
+    }
+
+    if (perf_gen_lcore == RTE_MAX_LCORE) {
+      perf_gen_lcore = lcore_id;
+    } else if (perf_sink_lcore == RTE_MAX_LCORE) {
+      perf_sink_lcore = lcore_id;
+    }
+  }
+
+  if (perf_synthetic && (perf_sink_lcore == RTE_MAX_LCORE)) {
+    printf("need two lcores not in worker.json for generator and sink\n");
+    return -1;
+  }
+
+  return 0;
+}
+
+static int perf_loop(__rte_unused void *arg) {
+  unsigned int lcore_id = rte_lcore_id();
+  worker_t *worker = perf_worker(lcore_id);
+  uint64_t packets = 0;
+  int work;
+
+  if (worker) {
+    while (!perf_quit) {
+      work = worker_run(config, worker);
+      packets += work;
+      worker_idle(worker, work);
+    }
+    perf_packets[lcore_id] = packets;
+  } else if (perf_synthetic && (lcore_id == perf_gen_lcore)) {
+    traffic_gen(&traffic, &perf_quit);
+  } else if (perf_synthetic && (lcore_id == perf_sink_lcore)) {
+    traffic_sink(&traffic, &perf_quit);
+  }
+
+  return 0;
+}
+
+static void perf_report(double secs) {
+  static const double pct[] = {50, 90, 99, 99.9};
+  uint64_t lat[RTE_DIM(pct)], calls, cycles, samples;
+  double hz = rte_get_tsc_hz();
+  worker_t *worker;
+  int i, id, lcore;
+
+  printf("\n== throughput (%.1fs)\n", secs);
+  for (i = 0; i < config->worker_num; i++) {
+    worker = (worker_t *)config->workers + i;
+    if (!perf_worker(worker->lcore_id)) {
+      continue;
+    }
+    printf("lcore %2d role %d %10.3f Mpps\n", worker->lcore_id, worker->role,
+           perf_packets[worker->lcore_id] / secs / 1e6);
+  }
+
+  if (modules_profile) {
+    printf("\n== cycles per packet per module\n");
+    for (id = MOD_ID_NONE + 1; id < MOD_ID_MAX; id++) {
+      calls = 0;
+      cycles = 0;
+      for (lcore = 0; lcore < MAX_WORKER_NUM; lcore++) {
+        calls += modules_prof[lcore][id].calls;
+        cycles += modules_prof[lcore][id].cycles;
+      }
+
+      if (calls && modules[id]) {
+        printf("%-10s %12lu calls %8.1f cycles\n", modules[id]->name, calls,
+               (double)cycles / calls);
+      }
+    }
+  }
+
+  if (!perf_synthetic) {
+    return;
+  }
+
+  printf("\n== traffic\n");
+  printf("generated %lu (%.3f Mpps) ring full %lu no mbuf %lu\n",
+         traffic.generated, traffic.generated / secs / 1e6, traffic.gen_drop,
+         traffic.nombuf);
+  printf("received  %lu (%.3f Mpps) lost or dropped %lu\n", traffic.received,
+         traffic.received / secs / 1e6,
+         traffic.generated > traffic.received
+             ? traffic.generated - traffic.received
+             : 0);
+
+  samples = traffic_latency(&traffic, pct, lat, RTE_DIM(pct));
+  if (samples) {
+    printf("\n== latency (%lu samples)\n", samples);
+    for (i = 0; i < (int)RTE_DIM(pct); i++) {
+      printf("p%-5g %10.2f us\n", pct[i], lat[i] * 1e6 / hz);
+    }
+  }
+}
+
+int main(int argc, char **argv) {
+  uint64_t start;
+  uint16_t port_num;
+  int ret;
+
+  ret = rte_eal_init(argc, argv);
+  if (ret < 0) {
+    rte_exit(EXIT_FAILURE, "rte eal init failed\n");
+  }
+  argc -= ret;
+  argv += ret;
+
+  perf_quit = false;
+  signal(SIGINT, perf_signal_handler);
+  signal(SIGTERM, perf_signal_handler);
+
+  if (perf_parse_args(argc, argv, &port_num)) {
+    rte_exit(EXIT_FAILURE, "invalid arguments\n");
+  }
+
+  ret = worker_init(config);
+  if (ret) {
+    rte_exit(EXIT_FAILURE, "worker init erorr\n");
+  }
+
+  // no ports on the command line, build ring ports and generate traffic
+  perf_synthetic = !rte_eth_dev_count_avail();
+  if (perf_synthetic) {
+    if (traffic_ports_create(&traffic, port_num, config->port_rxq_num,
+                             config->txq_num) ||
+        traffic_setup(&traffic)) {
+      rte_exit(EXIT_FAILURE, "traffic setup erorr\n");
+    }
+  }
+  config->port_num = rte_eth_dev_count_avail();
+
+  // firewall-stat may attach to the benchmark as well
+  if (stats_init(config)) {
+    rte_exit(EXIT_FAILURE, "stats init erorr\n");
+  }
+
+  if (perf_lcores_assign()) {
+    rte_exit(EXIT_FAILURE, "lcore assign erorr\n");
+  }
+
+  modules_load();
+  ret = modules_init(config);
+  if (ret) {
+    rte_exit(EXIT_FAILURE, "module init erorr\n");
+  }
+
+  // mbuf pool is sized and created by interface init
+  stats_publish(config);
+
+  rte_eal_mp_remote_launch(perf_loop, NULL, SKIP_MAIN);
+
+  start = rte_get_tsc_cycles();
+  while (!perf_quit &&
+         (rte_get_tsc_cycles() - start < perf_time * rte_get_tsc_hz())) {
+    usleep(100000);
+  }
+  perf_quit = true;
+
+  rte_eal_mp_wait_lcore();
+  perf_report((double)(rte_get_tsc_cycles() - start) / rte_get_tsc_hz());
+
+  modules_free(config);
+  traffic_free(&traffic);
+  rte_eal_cleanup();
+
+  return 0;
+}
+
+// file format utf-8
+// ident using space
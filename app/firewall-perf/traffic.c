@@ -0,0 +1,314 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <rte_cycles.h>
+#include <rte_eth_ring.h>
+#include <rte_ether.h>
+#include <rte_ip.h>
+#include <rte_lcore.h>
+#include <rte_malloc.h>
+#include <rte_random.h>
+#include <rte_udp.h>
+
+#include "packet.h"
+
+#include "traffic.h"
+
+#define TRAFFIC_HDR_V4                                                         \
+  (sizeof(struct rte_ether_hdr) + sizeof(struct rte_ipv4_hdr) +                \
+   sizeof(struct rte_udp_hdr))
+#define TRAFFIC_HDR_V6                                                         \
+  (sizeof(struct rte_ether_hdr) + sizeof(struct rte_ipv6_hdr) +                \
+   sizeof(struct rte_udp_hdr))
+
+/** "64:7,576:4,1500:1" spreads sizes over the lookup table by weight */
+int traffic_sizes_parse(perf_traffic_t *t, const char *str) {
+  uint32_t size[PERF_SIZE_SLOTS], weight[PERF_SIZE_SLOTS];
+  uint32_t i, j, n = 0, total = 0, slot = 0;
+  char buf[256], *tok, *save = NULL, *w;
+
+  snprintf(buf, sizeof(buf), "%s", str);
+  for (tok = strtok_r(buf, ",", &save); tok && (n < PERF_SIZE_SLOTS);
+       tok = strtok_r(NULL, ",", &save)) {
+    w = strchr(tok, ':');
+    if (w) {
+      *w++ = '\0';
+    }
+    size[n] = atoi(tok);
+    weight[n] = w ? atoi(w) : 1;
+    if ((size[n] < TRAFFIC_HDR_V6) || (size[n] > RTE_ETHER_MAX_LEN) ||
+        !weight[n]) {
+      printf("invalid packet size %s\n", tok);
+      return -1;
+    }
+    total += weight[n];
+    n++;
+  }
+
+  if (!n) {
+    return -1;
+  }
+
+  for (i = 0; i < n; i++) {
+    uint32_t slots = RTE_MAX(weight[i] * PERF_SIZE_SLOTS / total, 1U);
+
+    for (j = 0; (j < slots) && (slot < PERF_SIZE_SLOTS); j++) {
+      t->sizes[slot++] = size[i];
+    }
+  }
+
+  // rounding leftovers take the first size
+  while (slot < PERF_SIZE_SLOTS) {
+    t->sizes[slot++] = size[0];
+  }
+
+  return 0;
+}
+
+int traffic_ports_create(perf_traffic_t *t, uint16_t port_num,
+                         uint16_t rxq_num, uint16_t txq_num) {
+  char name[RTE_RING_NAMESIZE];
+  int i, j, port;
+
+  for (i = 0; i < port_num; i++) {
+    for (j = 0; j < rxq_num; j++) {
+      snprintf(name, sizeof(name), "perf-rx-%d-%d", i, j);
+      t->rx_rings[i][j] = rte_ring_create(name, PERF_RING_SIZE,
+                                          rte_socket_id(), 0);
+      if (!t->rx_rings[i][j]) {
+        printf("create perf ring failed\n");
+        return -1;
+      }
+    }
+
+    for (j = 0; j < txq_num; j++) {
+      snprintf(name, sizeof(name), "perf-tx-%d-%d", i, j);
+      t->tx_rings[i][j] = rte_ring_create(name, PERF_RING_SIZE,
+                                          rte_socket_id(), 0);
+      if (!t->tx_rings[i][j]) {
+        printf("create perf ring failed\n");
+        return -1;
+      }
+    }
+
+    snprintf(name, sizeof(name), "perf%d", i);
+    port = rte_eth_from_rings(name, t->rx_rings[i], rxq_num, t->tx_rings[i],
+                              txq_num, rte_socket_id());
+    if (port < 0) {
+      printf("create ring port %s failed\n", name);
+      return -1;
+    }
+    t->ports[i] = port;
+  }
+
+  t->port_num = port_num;
+  t->rxq_num = rxq_num;
+  t->txq_num = txq_num;
+
+  return 0;
+}
+
+static void traffic_flow_init(perf_traffic_t *t, uint32_t i) {
+  perf_flow_t *f = &t->flows[i];
+
+  memset(f, 0, sizeof(*f));
+  f->is_v6 = (rte_rand() % 100) < t->ipv6;
+  f->sp = rte_cpu_to_be_16(1024 + (i % 60000));
+  if ((rte_rand() % 100) < t->hit) {
+    f->dp = rte_cpu_to_be_16(t->hit_dport);
+  } else {
+    uint16_t dp = 1024 + (rte_rand() % 60000);
+    f->dp = rte_cpu_to_be_16(dp == t->hit_dport ? dp + 1 : dp);
+  }
+
+  if (f->is_v6) {
+    f->sip[0] = rte_cpu_to_be_32(0x20010db8);
+    f->sip[3] = rte_cpu_to_be_32(i);
+    f->dip[0] = rte_cpu_to_be_32(0x20010db8);
+    f->dip[1] = rte_cpu_to_be_32(1);
+    f->dip[3] = rte_cpu_to_be_32(i >> 4);
+  } else {
+    f->sip[0] = rte_cpu_to_be_32(RTE_IPV4(10, 0, 0, 0) + i);
+    f->dip[0] = rte_cpu_to_be_32(RTE_IPV4(192, 168, 0, 0) + (i >> 4));
+  }
+}
+
+int traffic_setup(perf_traffic_t *t) {
+  uint32_t i;
+
+  if (rte_mbuf_dyn_rx_timestamp_register(&t->ts_offset, &t->ts_flag)) {
+    printf("register timestamp field failed\n");
+    return -1;
+  }
+
+  t->pool = rte_pktmbuf_pool_create("perf_pool", PERF_MBUF_NUM, 256,
+                                    sizeof(packet_t), RTE_MBUF_DEFAULT_BUF_SIZE,
+                                    rte_socket_id());
+  if (!t->pool) {
+    printf("create perf pool failed\n");
+    return -1;
+  }
+
+  t->flows = rte_zmalloc("perf_flows", sizeof(perf_flow_t) * t->flow_num,
+                         RTE_CACHE_LINE_SIZE);
+  t->lat = rte_zmalloc("perf_lat", sizeof(uint64_t) * PERF_LAT_MAX,
+                       RTE_CACHE_LINE_SIZE);
+  if (!t->flows || !t->lat) {
+    printf("alloc perf flows failed\n");
+    return -1;
+  }
+
+  for (i = 0; i < t->flow_num; i++) {
+    traffic_flow_init(t, i);
+  }
+
+  return 0;
+}
+
+void traffic_free(perf_traffic_t *t) {
+  rte_free(t->flows);
+  rte_free(t->lat);
+  t->flows = NULL;
+  t->lat = NULL;
+}
+
+static void traffic_build(perf_traffic_t *t, struct rte_mbuf *m,
+                          perf_flow_t *f, uint16_t len) {
+  struct rte_ether_hdr *eh;
+  struct rte_udp_hdr *uh;
+  char *data;
+
+  data = rte_pktmbuf_append(m, len);
+  eh = (struct rte_ether_hdr *)data;
+  memset(&eh->dst_addr, 0x02, RTE_ETHER_ADDR_LEN);
+  memset(&eh->src_addr, 0x04, RTE_ETHER_ADDR_LEN);
+
+  if (f->is_v6) {
+    struct rte_ipv6_hdr *ip6h = (struct rte_ipv6_hdr *)(eh + 1);
+
+    eh->ether_type = rte_cpu_to_be_16(RTE_ETHER_TYPE_IPV6);
+    ip6h->vtc_flow = rte_cpu_to_be_32(6 << 28);
+    ip6h->payload_len = rte_cpu_to_be_16(len - sizeof(*eh) - sizeof(*ip6h));
+    ip6h->proto = IPPROTO_UDP;
+    ip6h->hop_limits = 64;
+    memcpy(&ip6h->src_addr, f->sip, 16);
+    memcpy(&ip6h->dst_addr, f->dip, 16);
+    uh = (struct rte_udp_hdr *)(ip6h + 1);
+  } else {
+    struct rte_ipv4_hdr *iph = (struct rte_ipv4_hdr *)(eh + 1);
+
+    eh->ether_type = rte_cpu_to_be_16(RTE_ETHER_TYPE_IPV4);
+    iph->version_ihl = RTE_IPV4_VHL_DEF;
+    iph->type_of_service = 0;
+    iph->total_length = rte_cpu_to_be_16(len - sizeof(*eh));
+    iph->packet_id = 0;
+    iph->fragment_offset = 0;
+    iph->time_to_live = 64;
+    iph->next_proto_id = IPPROTO_UDP;
+    iph->src_addr = f->sip[0];
+    iph->dst_addr = f->dip[0];
+    iph->hdr_checksum = 0;
+    iph->hdr_checksum = rte_ipv4_cksum(iph);
+    uh = (struct rte_udp_hdr *)(iph + 1);
+  }
+
+  uh->src_port = f->sp;
+  uh->dst_port = f->dp;
+  uh->dgram_len = rte_cpu_to_be_16(len - ((char *)uh - data));
+  uh->dgram_cksum = 0;
+
+  *RTE_MBUF_DYNFIELD(m, t->ts_offset, rte_mbuf_timestamp_t *) = rte_rdtsc();
+  m->ol_flags |= t->ts_flag;
+}
+
+/** round robin over flows and over (port, queue), never wait on a full ring */
+void traffic_gen(perf_traffic_t *t, volatile bool *quit) {
+  struct rte_mbuf *pkts[MAX_PKT_BURST];
+  uint32_t flow = 0, size = 0, i, n;
+  uint16_t port = 0, queue = 0;
+
+  while (!*quit) {
+    if (rte_pktmbuf_alloc_bulk(t->pool, pkts, MAX_PKT_BURST)) {
+      t->nombuf++;
+      continue;
+    }
+
+    for (i = 0; i < MAX_PKT_BURST; i++) {
+      traffic_build(t, pkts[i], &t->flows[flow], t->sizes[size]);
+      flow = (flow + 1 == t->flow_num) ? 0 : flow + 1;
+      size = (size + 1) % PERF_SIZE_SLOTS;
+    }
+
+    n = rte_ring_enqueue_burst(t->rx_rings[port][queue], (void **)pkts,
+                               MAX_PKT_BURST, NULL);
+    if (n < MAX_PKT_BURST) {
+      rte_pktmbuf_free_bulk(&pkts[n], MAX_PKT_BURST - n);
+      t->gen_drop += MAX_PKT_BURST - n;
+    }
+    t->generated += n;
+
+    if (++queue == t->rxq_num) {
+      queue = 0;
+      port = (port + 1) % t->port_num;
+    }
+  }
+}
+
+void traffic_sink(perf_traffic_t *t, volatile bool *quit) {
+  struct rte_mbuf *pkts[MAX_PKT_BURST];
+  uint64_t now, ts;
+  uint32_t i, n;
+  int p, q;
+
+  while (!*quit) {
+    for (p = 0; p < t->port_num; p++) {
+      for (q = 0; q < t->txq_num; q++) {
+        n = rte_ring_dequeue_burst(t->tx_rings[p][q], (void **)pkts,
+                                   MAX_PKT_BURST, NULL);
+        if (!n) {
+          continue;
+        }
+
+        now = rte_rdtsc();
+        for (i = 0; i < n; i++) {
+          if ((pkts[i]->ol_flags & t->ts_flag) &&
+              !((t->received + i) % PERF_LAT_SAMPLE) &&
+              (t->lat_num < PERF_LAT_MAX)) {
+            ts = *RTE_MBUF_DYNFIELD(pkts[i], t->ts_offset,
+                                    rte_mbuf_timestamp_t *);
+            t->lat[t->lat_num++] = now - ts;
+          }
+        }
+
+        t->received += n;
+        rte_pktmbuf_free_bulk(pkts, n);
+      }
+    }
+  }
+}
+
+static int traffic_u64_cmp(const void *a, const void *b) {
+  uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+
+  return (x > y) - (x < y);
+}
+
+uint64_t traffic_latency(perf_traffic_t *t, const double pct[], uint64_t out[],
+                         int n) {
+  int i;
+
+  if (!t->lat_num) {
+    return 0;
+  }
+
+  qsort(t->lat, t->lat_num, sizeof(uint64_t), traffic_u64_cmp);
+  for (i = 0; i < n; i++) {
+    uint64_t idx = (uint64_t)(pct[i] / 100.0 * (t->lat_num - 1));
+    out[i] = t->lat[idx];
+  }
+
+  return t->lat_num;
+}
+
+// file format utf-8
+// ident using space
@@ -0,0 +1,80 @@
+#ifndef _M_PERF_TRAFFIC_H_
+#define _M_PERF_TRAFFIC_H_
+
+#include <rte_mbuf.h>
+#include <rte_mbuf_dyn.h>
+#include <rte_ring.h>
+
+#include "config.h"
+
+#define DEF_PERF_FLOW_NUM 1024
+#define DEF_PERF_HIT_DPORT 80
+#define DEF_PERF_SIZES "64"
+
+#define PERF_RING_SIZE 4096
+#define PERF_MBUF_NUM (1U << 18)
+#define PERF_SIZE_SLOTS 64       // weighted size lookup table
+#define PERF_LAT_SAMPLE 16       // sample one packet out of
+#define PERF_LAT_MAX (1U << 20)  // latency samples kept
+
+typedef struct {
+  uint32_t sip[4];
+  uint32_t dip[4];
+  uint16_t sp;
+  uint16_t dp;
+  uint8_t is_v6;
+  uint8_t pad[3];
+} perf_flow_t;
+
+/** Synthetic traffic is injected into the rx rings of ring ports and drained
+ * from their tx rings, so the real RX, worker and TX roles sit in between.
+ * */
+typedef struct {
+  // generator profile
+  uint32_t flow_num;
+  uint32_t ipv6;            // percent of ipv6 flows
+  uint32_t hit;             // percent of flows sent to hit_dport
+  uint16_t hit_dport;
+  uint16_t sizes[PERF_SIZE_SLOTS];
+
+  // ring ports
+  uint16_t port_num;
+  uint16_t rxq_num;
+  uint16_t txq_num;
+  uint16_t ports[MAX_PORT_NUM];
+  struct rte_ring *rx_rings[MAX_PORT_NUM][MAX_QUEUE_NUM];
+  struct rte_ring *tx_rings[MAX_PORT_NUM][MAX_QUEUE_NUM];
+
+  struct rte_mempool *pool;
+  perf_flow_t *flows;
+  int ts_offset;            // tsc of generation, rx timestamp dynfield
+  uint64_t ts_flag;
+
+  // generator side
+  uint64_t generated;
+  uint64_t gen_drop;        // rx ring full
+  uint64_t nombuf;
+
+  // sink side
+  uint64_t received;
+  uint64_t lat_num;
+  uint64_t *lat;            // cycles
+} perf_traffic_t;
+
+int traffic_sizes_parse(perf_traffic_t *t, const char *str);
+int traffic_ports_create(perf_traffic_t *t, uint16_t port_num,
+                         uint16_t rxq_num, uint16_t txq_num);
+int traffic_setup(perf_traffic_t *t);
+void traffic_free(perf_traffic_t *t);
+
+void traffic_gen(perf_traffic_t *t, volatile bool *quit);
+void traffic_sink(perf_traffic_t *t, volatile bool *quit);
+
+/** sort samples, fill percentiles in cycles, return number of samples */
+uint64_t traffic_latency(perf_traffic_t *t, const double pct[], uint64_t out[],
+                         int n);
+
+#endif
+
+// file format utf-8
+// ident using space
@@ -0,0 +1,342 @@
+/** Live statistics of a running firewall, attached as a DPDK secondary
+ * process to the stats memzone published by the firewall, so it never goes
+ * through the cli nor waits behind a reload.
+ * */
+
+#include <getopt.h>
+#include <signal.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include <rte_common.h>
+#include <rte_cycles.h>
+#include <rte_eal.h>
+#include <rte_hash.h>
+#include <rte_memzone.h>
+#include <rte_mempool.h>
+#include <rte_ring.h>
+
+#include "config.h"
+#include "stats.h"
+#include "worker.h"
+
+#define STAT_SHOW_LCORE (1U << 0)
+#define STAT_SHOW_RING (1U << 1)
+#define STAT_SHOW_POOL (1U << 2)
+#define STAT_SHOW_TABLE (1U << 3)
+#define STAT_SHOW_ACL (1U << 4)
+#define STAT_SHOW_ALL 0x1f
+
+static const char *stat_role_name[] = {
+  [ROLE_NONE] = "none",
+  [ROLE_MGMT] = "mgmt",
+  [ROLE_RX] = "rx",
+  [ROLE_TX] = "tx",
+  [ROLE_RTX] = "rtx",
+  [ROLE_WORKER] = "worker",
+  [ROLE_RTX_WORKER] = "rtx_worker",
+};
+
+static const stats_shm_t *shm;
+static stats_shm_t snap, last;
+static uint32_t stat_interval;
+static uint32_t stat_count;
+static uint32_t stat_show;
+static volatile bool stat_quit;
+
+static void stat_signal_handler(int signum) {
+  if (signum == SIGINT || signum == SIGTERM) {
+    stat_quit = true;
+  }
+}
+
+static void stat_usage(const char *prog) {
+  printf("%s [EAL options] -- [options]\n"
+         "  --interval S  repeat every S seconds and show rates\n"
+         "  --count N     stop after N repeats\n"
+         "  --lcores      per lcore counters\n"
+         "  --rings       ring occupancy\n"
+         "  --pool        mbuf pool usage\n"
+         "  --tables      flow table occupancy\n"
+         "  --acl         acl rule hits\n"
+         "Without a selection everything is shown. Use the --file-prefix of\n"
+         "the firewall when it has one.\n",
+         prog);
+}
+
+static int stat_parse_args(int argc, char **argv) {
+  static const struct option opts[] = {
+    {"interval", required_argument, NULL, 'i'},
+    {"count", required_argument, NULL, 'c'},
+    {"lcores", no_argument, NULL, 'l'},
+    {"rings", no_argument, NULL, 'r'},
+    {"pool", no_argument, NULL, 'p'},
+    {"tables", no_argument, NULL, 't'},
+    {"acl", no_argument, NULL, 'a'},
+    {NULL, 0, NULL, 0},
+  };
+  int opt;
+
+  while ((opt = getopt_long(argc, argv, "", opts, NULL)) != -1) {
+    switch (opt) {
+    case 'i':
+      stat_interval = atoi(optarg);
+      break;
+    case 'c':
+      stat_count = atoi(optarg);
+      break;
+    case 'l':
+      stat_show |= STAT_SHOW_LCORE;
+      break;
+    case 'r':
+      stat_show |= STAT_SHOW_RING;
+      break;
+    case 'p':
+      stat_show |= STAT_SHOW_POOL;
+      break;
+    case 't':
+      stat_show |= STAT_SHOW_TABLE;
+      break;
+    case 'a':
+      stat_show |= STAT_SHOW_ACL;
+      break;
+    default:
+      stat_usage(argv[0]);
+      return -1;
+    }
+  }
+
+  if (!stat_show) {
+    stat_show = STAT_SHOW_ALL;
+  }
+
+  return 0;
+}
+
+/** consistent copy of the shared area, mgmt may be rewriting the directory */
+static void stat_snapshot(void) {
+  uint32_t seq;
+
+  do {
+    seq = shm->seq;
+    rte_smp_rmb();
+    memcpy(&snap, shm, sizeof(snap));
+    rte_smp_rmb();
+  } while ((seq & 1) || (seq != shm->seq));
+}
+
+static double stat_rate(uint64_t now, uint64_t before) {
+  return stat_interval ? (double)(now - before) / stat_interval : 0;
+}
+
+static void stat_lcores(void) {
+  const worker_t *workers = snap.workers;
+  const worker_t *w;
+  const stats_lcore_t *s, *o;
+  int i, j, buckets;
+
+  printf("\n== lcores (config version %u)\n", snap.config_version);
+  printf("%5s %-10s %-6s %7s %12s %12s %10s %12s %10s %6s\n", "lcore", "role",
+         "state", "buckets", "rx", "tx", "tx_drop", "proc", "stolen",
+         "idle%");
+
+  for (i = 0; workers && (i < snap.worker_num); i++) {
+    w = &workers[i];
+    if ((w->role == ROLE_NONE) || (w->role == ROLE_MGMT) ||
+        (w->lcore_id < 0) || (w->lcore_id >= MAX_WORKER_NUM)) {
+      continue;
+    }
+
+    buckets = 0;
+    for (j = 0; (w->work_id >= 0) && (j < MAX_DISPATCH_NUM); j++) {
+      buckets += (snap.dispatch[j] == w->work_id);
+    }
+
+    s = &snap.lcores[w->lcore_id];
+    o = &last.lcores[w->lcore_id];
+    if (stat_interval && last.magic) {
+      printf("%5d %-10s %-6s %7d %10.0f/s %10.0f/s %8.0f/s %10.0f/s %8.0f/s "
+             "%6.1f\n",
+             w->lcore_id, stat_role_name[w->role],
+             w->parked ? "parked" : "active", buckets, stat_rate(s->rx, o->rx),
+             stat_rate(s->tx, o->tx), stat_rate(s->tx_drop, o->tx_drop),
+             stat_rate(s->proc, o->proc), stat_rate(s->stolen, o->stolen),
+             w->idle.polls ? 100.0 * w->idle.empty_polls / w->idle.polls : 0);
+    } else {
+      printf("%5d %-10s %-6s %7d %12lu %12lu %10lu %12lu %10lu %6.1f\n",
+             w->lcore_id, stat_role_name[w->role],
+             w->parked ? "parked" : "active", buckets, s->rx, s->tx,
+             s->tx_drop, s->proc, s->stolen,
+             w->idle.polls ? 100.0 * w->idle.empty_polls / w->idle.polls : 0);
+    }
+  }
+}
+
+static void stat_rings(void) {
+  struct rte_ring *r;
+  uint32_t i, count, cap;
+
+  printf("\n== rings\n");
+  for (i = 0; i < snap.ring_num; i++) {
+    r = rte_ring_lookup(snap.rings[i]);
+    if (!r) {
+      continue;
+    }
+
+    count = rte_ring_count(r);
+    cap = rte_ring_get_capacity(r);
+    printf("%-28s %8u / %-8u %5.1f%%\n", snap.rings[i], count, cap,
+           cap ? 100.0 * count / cap : 0);
+  }
+}
+
+static void stat_pool(void) {
+  struct rte_mempool *mp;
+  uint32_t avail, used;
+
+  if (!snap.pool[0]) {
+    return;
+  }
+
+  mp = rte_mempool_lookup(snap.pool);
+  if (!mp) {
+    return;
+  }
+
+  avail = rte_mempool_avail_count(mp);
+  used = rte_mempool_in_use_count(mp);
+  printf("\n== mbuf pool\n");
+  printf("%-28s size %u in use %u available %u %5.1f%%\n", snap.pool,
+         mp->size, used, avail, mp->size ? 100.0 * used / mp->size : 0);
+}
+
+static void stat_tables(void) {
+  const stats_table_t *t;
+  struct rte_hash *h;
+  int32_t count;
+  uint32_t i;
+
+  printf("\n== flow tables\n");
+  for (i = 0; i < snap.table_num; i++) {
+    t = &snap.tables[i];
+    h = rte_hash_find_existing(t->name);
+    if (!h) {
+      continue;
+    }
+
+    count = rte_hash_count(h);
+    printf("%-10s lcore %2d %-20s %8d / %-8u %5.1f%%\n", t->owner,
+           t->lcore_id, t->name, count, t->entries,
+           t->entries ? 100.0 * count / t->entries : 0);
+  }
+}
+
+static void stat_acl(void) {
+  uint64_t hits, before;
+  char label[16];
+  int i, id;
+
+  printf("\n== acl hits\n");
+  for (id = 0; id < MAX_STATS_ACL_RULE; id++) {
+    hits = 0;
+    before = 0;
+    for (i = 0; i < MAX_WORKER_NUM; i++) {
+      hits += snap.acl_hits[i][id];
+      before += last.acl_hits[i][id];
+    }
+
+    if (!hits) {
+      continue;
+    }
+
+    // slot 0 counts rules whose id is beyond the table
+    if (id) {
+      snprintf(label, sizeof(label), "%d", id);
+    } else {
+      snprintf(label, sizeof(label), ">=%d", MAX_STATS_ACL_RULE);
+    }
+
+    if (stat_interval && last.magic) {
+      printf("rule %-6s %14lu %12.0f/s\n", label, hits,
+             stat_rate(hits, before));
+    } else {
+      printf("rule %-6s %14lu\n", label, hits);
+    }
+  }
+}
+
+int main(int argc, char **argv) {
+  const struct rte_memzone *mz;
+  char mp_flag[] = "--proc-type=secondary";
+  char *argp[argc + 1];
+  uint32_t n = 0;
+  int i, ret;
+
+  argp[0] = argv[0];
+  argp[1] = mp_flag;
+  for (i = 1; i < argc; i++) {
+    argp[i + 1] = argv[i];
+  }
+
+  ret = rte_eal_init(argc + 1, argp);
+  if (ret < 0) {
+    rte_exit(EXIT_FAILURE, "rte eal init failed\n");
+  }
+  argc = argc + 1 - ret;
+  argv = argp + ret;
+
+  if (!rte_eal_primary_proc_alive(NULL)) {
+    rte_exit(EXIT_FAILURE, "no firewall is running\n");
+  }
+
+  if (stat_parse_args(argc, argv)) {
+    rte_exit(EXIT_FAILURE, "invalid arguments\n");
+  }
+
+  mz = rte_memzone_lookup(STATS_MZ_NAME);
+  if (!mz) {
+    rte_exit(EXIT_FAILURE, "firewall stats memzone not found\n");
+  }
+
+  shm = mz->addr;
+  if ((shm->magic != STATS_MAGIC) || (shm->size != sizeof(stats_shm_t))) {
+    rte_exit(EXIT_FAILURE, "firewall stats layout mismatch, rebuild %s\n",
+             argv[0]);
+  }
+
+  signal(SIGINT, stat_signal_handler);
+  signal(SIGTERM, stat_signal_handler);
+
+  while (!stat_quit) {
+    stat_snapshot();
+
+    if (stat_show & STAT_SHOW_LCORE) {
+      stat_lcores();
+    }
+    if (stat_show & STAT_SHOW_RING) {
+      stat_rings();
+    }
+    if (stat_show & STAT_SHOW_POOL) {
+      stat_pool();
+    }
+    if (stat_show & STAT_SHOW_TABLE) {
+      stat_tables();
+    }
+    if (stat_show & STAT_SHOW_ACL) {
+      stat_acl();
+    }
+
+    if (!stat_interval || (stat_count && (++n >= stat_count))) {
+      break;
+    }
+
+    memcpy(&last, &snap, sizeof(last));
+    sleep(stat_interval);
+  }
+
+  rte_eal_cleanup();
+  return 0;
+}
+
+// file format utf-8
+// ident using space
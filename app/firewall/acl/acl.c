@@ -7,7 +7,9 @@
 #include "../json.h"
 #include "../module.h"
 #include "../packet.h"
+#include "../stats.h"
 
+#include "../capture/capture.h"
 #include "acl.h"
 
 struct rte_acl_field_def acl_field_def[5] = {
@@ -53,7 +55,7 @@ struct rte_acl_field_def acl_field_def[5] = {
 };
 
 struct rte_acl_config acl_cfg = {
-    .num_categories = 1,
+    .num_categories = ACL_CATEGORY_NUM,
     .num_fields = RTE_DIM(acl_field_def),
     .max_size = 100000000,
 };
@@ -84,7 +86,8 @@ MODULE_DECLARE(acl) = {.name = "acl",
                        .proc = acl_proc,
                        .conf = acl_conf,
                        .free = acl_free,
-                       .priv = NULL};
+                       .priv = NULL,
+                       .hooks = MOD_HOOK_BIT(MOD_HOOK_INGRESS)};
 
 static int acl_rule_load(config_t *config) {
   struct rte_acl_ctx *acl_ctx;
@@ -173,10 +176,22 @@ static int acl_rule_load(config_t *config) {
     r[j].field[0].value.u8 = JV_I(jv);
     r[j].field[0].mask_range.u8 = 0xff;
 
+    // optional, rules without layer match the inner headers
+    jv = JV(jo, "layer");
+    if (jv && !strcmp(JV_S(jv), "outer")) {
+      r[j].data.category_mask = 1U << ACL_CATEGORY_OUTER;
+    } else {
+      r[j].data.category_mask = 1U << ACL_CATEGORY_INNER;
+    }
+
     ACL_JV("action");
-    r[j].data.category_mask = 1;
     r[j].data.action = JV_I(jv);
 
+    if (r[j].data.action == ACL_ACTION_POLICE) {
+      ACL_JV("police");
+      r[j].data.action = ACL_ACTION_MAKE(ACL_ACTION_POLICE, JV_I(jv));
+    }
+
     j++;
   }
 
@@ -255,6 +270,12 @@ static int acl_show(struct cli_def *cli, const char *command, char *argv[],
     ACL_PRINT("dp");
     ACL_PRINT("proto");
     ACL_PRINT("action");
+    if (JV(jo, "layer")) {
+      ACL_PRINT("layer");
+    }
+    if (JV(jo, "police")) {
+      ACL_PRINT("police");
+    }
     CLI_PRINT(cli, "%s", "");
   }
 
@@ -323,6 +344,12 @@ static int acl_add(struct cli_def *cli, const char *command, char *argv[],
   ACL_SET("proto");
   ACL_SET("action");
   ACL_SET("enabled");
+  if (CLI_OPT_V(cli, "police")) {
+    ACL_SET("police");
+  }
+  if (CLI_OPT_V(cli, "layer")) {
+    ACL_SET("layer");
+  }
 
 #undef ACL_SET
 
@@ -429,6 +456,16 @@ static int acl_set(struct cli_def *cli, const char *command, char *argv[],
       ACL_MOD("proto");
       ACL_MOD("action");
       ACL_MOD("enabled");
+      if (CLI_OPT_V(cli, "police") && !JV(jo, "police")) {
+        JO_ADD(jo, "police", JV_NEW(CLI_OPT_V(cli, "police")));
+      } else {
+        ACL_MOD("police");
+      }
+      if (CLI_OPT_V(cli, "layer") && !JV(jo, "layer")) {
+        JO_ADD(jo, "layer", JV_NEW(CLI_OPT_V(cli, "layer")));
+      } else {
+        ACL_MOD("layer");
+      }
     }
   }
 
@@ -476,6 +513,8 @@ static void acl_cli_register(config_t *config) {
   CLI_OPT_A(c1, "proto", "transport layer protocol");
   CLI_OPT_A(c1, "action", "do action when rule matched");
   CLI_OPT_A(c1, "enabled", "switch of rule");
+  CLI_OPT(c1, "police", "policer id of police action");
+  CLI_OPT(c1, "layer", "inner or outer headers of a tunnel");
 
   c1 = CLI_CMD_C(cli_def, c, "delete", acl_delete, "delete an acl rule");
   CLI_OPT_A(c1, "id", "rule id");
@@ -489,6 +528,8 @@ static void acl_cli_register(config_t *config) {
   CLI_OPT(c1, "proto", "transport layer protocol");
   CLI_OPT(c1, "action", "do action when rule matched");
   CLI_OPT(c1, "enabled", "switch of rule");
+  CLI_OPT(c1, "police", "policer id of police action");
+  CLI_OPT(c1, "layer", "inner or outer headers of a tunnel");
 }
 
 int acl_free(void *config) {
@@ -530,13 +571,28 @@ int acl_init(void *config) {
   return 0;
 }
 
+/** the higher priority of the inner and the outer match wins */
+static inline struct rte_acl_rule_data *
+acl_match(struct rte_acl_ctx *acl_ctx, uint32_t inner, uint32_t outer) {
+  struct rte_acl_rule_data *di, *dout;
+
+  di = rte_acl_rule_data(acl_ctx, inner);
+  dout = rte_acl_rule_data(acl_ctx, outer);
+  if (!di || !dout) {
+    return di ? di : dout;
+  }
+
+  return (dout->priority > di->priority) ? dout : di;
+}
+
 static mod_ret_t acl_proc_ingress(config_t *config, struct rte_mbuf *mbuf) {
 
   struct rte_acl_ctx *acl_ctx;
   struct rte_acl_rule_data *data;
   packet_t *p;
-  ip4_tuple_t *k;
-  uint32_t r;
+  const uint8_t *k[2];
+  uint32_t r[2 * RTE_ACL_RESULTS_MULTIPLIER];
+  uint32_t num = 1, outer;
   int ret;
 
   acl_ctx = config->acl_ctx;
@@ -549,27 +605,46 @@ static mod_ret_t acl_proc_ingress(config_t *config, struct rte_mbuf *mbuf) {
     goto done;
   }
 
-  k = &p->tuple.v4;
+  // verdict of an elephant flow is cached by heavy hitter module
+  if (p->flags & PACKET_FLAG_BYPASS) {
+    goto done;
+  }
 
-  ret = rte_acl_classify(acl_ctx, (const unsigned char **)&k, &r, 1, 1);
+  // inner rules look at the tuple, outer rules at the outer headers of a
+  // tunnel, which are the tuple itself on plain packets. Rules only have
+  // ipv4 fields, so ipv6 outer headers match no outer rule.
+  k[0] = (const uint8_t *)&p->tuple.v4;
+  if ((p->tunnel != PACKET_TUNNEL_NONE) && p->outer_is_v4) {
+    k[1] = (const uint8_t *)&p->outer.v4;
+    num = 2;
+  }
+
+  ret = rte_acl_classify(acl_ctx, k, r, num, RTE_ACL_RESULTS_MULTIPLIER);
   if (ret) {
     goto done;
   }
 
-  if (!r) {
-    goto done;
+  outer = r[(num - 1) * RTE_ACL_RESULTS_MULTIPLIER + ACL_CATEGORY_OUTER];
+  if ((p->tunnel != PACKET_TUNNEL_NONE) && !p->outer_is_v4) {
+    outer = 0;
   }
 
-  data = rte_acl_rule_data(acl_ctx, r);
+  data = acl_match(acl_ctx, r[ACL_CATEGORY_INNER], outer);
   if (!data) {
     goto done;
   }
+  stats_acl_hit(data->userdata);
 
   if (data->action == ACL_ACTION_DENY) {
+    capture_drop(config, mbuf, MOD_ID_ACL);
     rte_pktmbuf_free(mbuf);
     return MOD_RET_STOLEN;
   }
 
+  if (ACL_ACTION_TYPE(data->action) == ACL_ACTION_POLICE) {
+    p->policer = ACL_ACTION_ARG(data->action);
+  }
+
 done:
   return MOD_RET_ACCEPT;
 }
@@ -8,6 +8,21 @@
 
 #define ACL_ACTION_DENY 0
 #define ACL_ACTION_PASS 1
+#define ACL_ACTION_POLICE 2
+
+/** action type lives in the lower 16 bits of rule action, the upper 16 bits
+ * carry its argument (e.g. policer id of police action)
+ * */
+/** a rule matches one layer of a tunneled packet, the inner headers by
+ * default or the outer headers, on plain packets both layers are the same
+ * */
+#define ACL_CATEGORY_INNER 0
+#define ACL_CATEGORY_OUTER 1
+#define ACL_CATEGORY_NUM 2
+
+#define ACL_ACTION_TYPE(a) ((a) & 0xffff)
+#define ACL_ACTION_ARG(a) ((a) >> 16)
+#define ACL_ACTION_MAKE(t, arg) ((((uint32_t)(arg)) << 16) | ((t) & 0xffff))
 
 int acl_init(void *config);
 mod_ret_t acl_proc(void *config, struct rte_mbuf *mbuf, mod_hook_t hook);
@@ -0,0 +1,634 @@
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <rte_bpf.h>
+#include <rte_ethdev.h>
+#include <rte_lcore.h>
+#include <rte_malloc.h>
+#include <rte_pcapng.h>
+
+#ifdef RTE_HAS_LIBPCAP
+#include <pcap/pcap.h>
+#endif
+
+#include "../cli.h"
+#include "../config.h"
+#include "../json.h"
+#include "../module.h"
+#include "../packet.h"
+#include "../worker.h"
+
+#include "capture.h"
+
+MODULE_DECLARE(capture) = {.name = "capture",
+                           .id = MOD_ID_CAPTURE,
+                           .enabled = true,
+                           .log = true,
+                           .init = capture_init,
+                           .proc = capture_proc,
+                           .conf = NULL,
+                           .free = NULL,
+                           .priv = NULL,
+                           .bulk = capture_bulk,
+                           .hooks = MOD_HOOK_BIT(MOD_HOOK_INGRESS) |
+                                    MOD_HOOK_BIT(MOD_HOOK_EGRESS)};
+
+static const char *capture_stat_name[CAPTURE_STAT_MAX] = {
+  [CAPTURE_STAT_MATCHED] = "matched",
+  [CAPTURE_STAT_FILTERED] = "filtered",
+  [CAPTURE_STAT_NOMBUF] = "no mbuf",
+  [CAPTURE_STAT_RING_FULL] = "ring full",
+};
+
+static uint32_t capture_points_str2int(const char *str) {
+  uint32_t points = 0;
+
+  if (strstr(str, "ingress"))
+    points |= CAPTURE_POINT_INGRESS;
+  if (strstr(str, "egress"))
+    points |= CAPTURE_POINT_EGRESS;
+  if (strstr(str, "drop"))
+    points |= CAPTURE_POINT_DROP;
+  return points;
+}
+
+static int capture_load(capture_ctx_t *ctx) {
+  json_object *jr = NULL, *jv;
+  bool enabled = false;
+
+  ctx->points = CAPTURE_POINT_ALL;
+  ctx->snaplen = DEF_CAPTURE_SNAPLEN;
+  ctx->ring_size = DEF_CAPTURE_RING_SIZE;
+  ctx->mbuf_num = DEF_CAPTURE_MBUF_NUM;
+  snprintf(ctx->file, sizeof(ctx->file), "%s", DEF_CAPTURE_FILE);
+
+  jr = JR(CONFIG_PATH, "capture.json");
+  if (!jr) {
+    printf("no capture config, capture disabled\n");
+    return 0;
+  }
+
+  jv = JV(jr, "enabled");
+  if (jv) {
+    enabled = JV_I(jv) ? true : false;
+  }
+
+  jv = JV(jr, "file");
+  if (jv) {
+    snprintf(ctx->file, sizeof(ctx->file), "%s", JV_S(jv));
+  }
+
+  jv = JV(jr, "filter");
+  if (jv) {
+    snprintf(ctx->filter, sizeof(ctx->filter), "%s", JV_S(jv));
+  }
+
+  jv = JV(jr, "points");
+  if (jv) {
+    ctx->points = capture_points_str2int(JV_S(jv));
+  }
+
+  jv = JV(jr, "snaplen");
+  if (jv && (JV_I(jv) > 0)) {
+    ctx->snaplen = JV_I(jv);
+  }
+
+  jv = JV(jr, "ring");
+  if (jv && (JV_I(jv) > 0)) {
+    ctx->ring_size = rte_align32pow2(JV_I(jv));
+  }
+
+  jv = JV(jr, "mbufs");
+  if (jv && (JV_I(jv) > 0)) {
+    ctx->mbuf_num = JV_I(jv);
+  }
+
+  JR_FREE(jr);
+
+  printf("capture enabled %d file %s points 0x%x snaplen %u ring %u\n",
+         enabled, ctx->file, ctx->points, ctx->snaplen, ctx->ring_size);
+
+  return enabled ? 1 : 0;
+}
+
+static int capture_setup(config_t *config, capture_ctx_t *ctx) {
+  worker_t *worker;
+  char name[RTE_RING_NAMESIZE];
+  int i;
+
+  for (i = 0; i < config->worker_num; i++) {
+    capture_lcore_t *lc;
+
+    worker = (worker_t *)config->workers + i;
+    if ((worker->role != ROLE_WORKER) && (worker->role != ROLE_RTX_WORKER)) {
+      continue;
+    }
+
+    lc = &ctx->lcores[worker->lcore_id];
+    snprintf(name, sizeof(name), "capture-ring-%d", worker->lcore_id);
+    lc->ring = rte_ring_create(name, ctx->ring_size,
+                               rte_lcore_to_socket_id(worker->lcore_id),
+                               RING_F_SP_ENQ | RING_F_SC_DEQ);
+    if (!lc->ring) {
+      printf("create capture ring %s failed\n", name);
+      return -1;
+    }
+  }
+
+  return 0;
+}
+
+/** compile a pcap filter expression into a (jit) ebpf program */
+static struct rte_bpf *capture_bpf_compile(const char *filter) {
+#ifdef RTE_HAS_LIBPCAP
+  struct rte_bpf_prm *prm;
+  struct rte_bpf *bpf;
+  struct bpf_program bf;
+  pcap_t *pcap;
+
+  pcap = pcap_open_dead(DLT_EN10MB, UINT16_MAX);
+  if (!pcap) {
+    return NULL;
+  }
+
+  if (pcap_compile(pcap, &bf, filter, 1, PCAP_NETMASK_UNKNOWN)) {
+    printf("invalid capture filter \"%s\": %s\n", filter, pcap_geterr(pcap));
+    pcap_close(pcap);
+    return NULL;
+  }
+
+  prm = rte_bpf_convert(&bf);
+  pcap_freecode(&bf);
+  pcap_close(pcap);
+  if (!prm) {
+    printf("convert capture filter failed: %s\n", rte_strerror(rte_errno));
+    return NULL;
+  }
+
+  bpf = rte_bpf_load(prm);
+  rte_free(prm);
+  if (!bpf) {
+    printf("load capture filter failed: %s\n", rte_strerror(rte_errno));
+  }
+
+  return bpf;
+#else
+  printf("built without libpcap, capture filter \"%s\" not supported\n",
+         filter);
+  return NULL;
+#endif
+}
+
+/** move copies from worker rings to file, return number of packets moved */
+static uint32_t capture_flush(capture_ctx_t *ctx) {
+  struct rte_mbuf *pkts[MAX_PKT_BURST];
+  uint32_t i, n, total = 0;
+
+  for (i = 0; i < MAX_WORKER_NUM; i++) {
+    capture_lcore_t *lc = &ctx->lcores[i];
+
+    if (!lc->ring) {
+      continue;
+    }
+
+    n = rte_ring_sc_dequeue_burst(lc->ring, (void **)pkts, MAX_PKT_BURST,
+                                  NULL);
+    if (!n) {
+      continue;
+    }
+
+    if (rte_pcapng_write_packets(ctx->pcapng, pkts, n) < 0) {
+      ctx->write_fail += n;
+    } else {
+      ctx->written += n;
+    }
+    rte_pktmbuf_free_bulk(pkts, n);
+    total += n;
+  }
+
+  return total;
+}
+
+/** writer runs on a control thread, a slow disk only fills worker rings */
+static uint32_t capture_writer(void *arg) {
+  capture_ctx_t *ctx = arg;
+
+  while (ctx->running) {
+    if (!capture_flush(ctx)) {
+      usleep(CAPTURE_WRITER_IDLE);
+    }
+  }
+
+  return 0;
+}
+
+/** let workers with a ring into the session, everything they use is set up
+ * before */
+static void capture_open(capture_ctx_t *ctx) {
+  int i;
+
+  for (i = 0; i < MAX_WORKER_NUM; i++) {
+    if (ctx->lcores[i].ring) {
+      rte_atomic_store_explicit(&ctx->lcores[i].state, CAPTURE_LCORE_IDLE,
+                                rte_memory_order_release);
+    }
+  }
+}
+
+/** take every worker out of the session, waiting for the bursts in capture,
+ * after that no worker uses the filter, the pool or the rings of it */
+static void capture_close(capture_ctx_t *ctx) {
+  uint32_t state;
+  int i;
+
+  for (i = 0; i < MAX_WORKER_NUM; i++) {
+    capture_lcore_t *lc = &ctx->lcores[i];
+
+    for (;;) {
+      state = CAPTURE_LCORE_IDLE;
+      if (rte_atomic_compare_exchange_strong_explicit(
+              &lc->state, &state, CAPTURE_LCORE_OFF, rte_memory_order_acquire,
+              rte_memory_order_relaxed) ||
+          state == CAPTURE_LCORE_OFF) {
+        break;
+      }
+      rte_pause();
+    }
+  }
+}
+
+static int capture_start(config_t *config, capture_ctx_t *ctx) {
+  char name[RTE_THREAD_NAME_SIZE];
+  uint16_t port;
+  int fd;
+
+  if (ctx->running) {
+    printf("capture already running\n");
+    return -1;
+  }
+
+  ctx->bpf = NULL;
+  ctx->jit.func = NULL;
+  if (ctx->filter[0]) {
+    ctx->bpf = capture_bpf_compile(ctx->filter);
+    if (!ctx->bpf) {
+      goto fail;
+    }
+    rte_bpf_get_jit(ctx->bpf, &ctx->jit);
+  }
+
+  ctx->pool = rte_pktmbuf_pool_create("capture_pool", ctx->mbuf_num, 256, 0,
+                                      rte_pcapng_mbuf_size(ctx->snaplen),
+                                      rte_socket_id());
+  if (!ctx->pool) {
+    printf("create capture pool failed\n");
+    goto fail;
+  }
+
+  fd = open(ctx->file, O_WRONLY | O_CREAT | O_TRUNC, 0640);
+  if (fd < 0) {
+    printf("open capture file %s failed\n", ctx->file);
+    goto fail;
+  }
+
+  ctx->pcapng = rte_pcapng_fdopen(fd, NULL, NULL, "firewall", NULL);
+  if (!ctx->pcapng) {
+    printf("open pcapng %s failed\n", ctx->file);
+    close(fd);
+    goto fail;
+  }
+
+  for (port = 0; port < config->port_num; port++) {
+    rte_pcapng_add_interface(ctx->pcapng, port, NULL, NULL,
+                             ctx->filter[0] ? ctx->filter : NULL);
+  }
+
+  ctx->written = 0;
+  ctx->write_fail = 0;
+  ctx->running = true;
+  capture_open(ctx);
+
+  snprintf(name, sizeof(name), "fw-capture");
+  if (rte_thread_create_control(&ctx->writer, name, capture_writer, ctx)) {
+    printf("create capture writer failed\n");
+    ctx->running = false;
+    capture_close(ctx);
+    goto fail;
+  }
+
+  return 0;
+
+fail:
+  if (ctx->pcapng) {
+    rte_pcapng_close(ctx->pcapng);
+    ctx->pcapng = NULL;
+  }
+  rte_mempool_free(ctx->pool);
+  ctx->pool = NULL;
+  rte_bpf_destroy(ctx->bpf);
+  ctx->bpf = NULL;
+  ctx->jit.func = NULL;
+  return -1;
+}
+
+static int capture_stop(capture_ctx_t *ctx) {
+  if (!ctx->running) {
+    return -1;
+  }
+
+  ctx->running = false;
+  capture_close(ctx);
+
+  rte_thread_join(ctx->writer, NULL);
+  while (capture_flush(ctx))
+    ;
+
+  rte_pcapng_close(ctx->pcapng);
+  ctx->pcapng = NULL;
+  rte_mempool_free(ctx->pool);
+  ctx->pool = NULL;
+  rte_bpf_destroy(ctx->bpf);
+  ctx->bpf = NULL;
+  ctx->jit.func = NULL;
+
+  return 0;
+}
+
+static int capture_cli_start(struct cli_def *cli, const char *command,
+                             char *argv[], int argc) {
+  config_t *c = cli_get_context(cli);
+  capture_ctx_t *ctx = c->capture_ctx;
+  const char *opt;
+
+  CLI_PRINT(cli, "command %s argv[0] %s argc %d", command, argv[0], argc);
+
+  if (!ctx) {
+    CLI_PRINT(cli, "capture disabled");
+    return -1;
+  }
+
+  if (ctx->running) {
+    CLI_PRINT(cli, "capture already running");
+    return -1;
+  }
+
+  opt = CLI_OPT_V(cli, "file");
+  if (opt) {
+    snprintf(ctx->file, sizeof(ctx->file), "%s", opt);
+  }
+
+  opt = CLI_OPT_V(cli, "filter");
+  if (opt) {
+    snprintf(ctx->filter, sizeof(ctx->filter), "%s", opt);
+  }
+
+  opt = CLI_OPT_V(cli, "points");
+  if (opt) {
+    ctx->points = capture_points_str2int(opt);
+  }
+
+  opt = CLI_OPT_V(cli, "snaplen");
+  if (opt && (atoi(opt) > 0)) {
+    ctx->snaplen = atoi(opt);
+  }
+
+  if (capture_start(c, ctx)) {
+    CLI_PRINT(cli, "capture start failed");
+    return -1;
+  }
+
+  CLI_PRINT(cli, "ok!");
+  return 0;
+}
+
+static int capture_cli_stop(struct cli_def *cli, const char *command,
+                            char *argv[], int argc) {
+  config_t *c = cli_get_context(cli);
+  capture_ctx_t *ctx = c->capture_ctx;
+
+  CLI_PRINT(cli, "command %s argv[0] %s argc %d", command, argv[0], argc);
+
+  if (!ctx || capture_stop(ctx)) {
+    CLI_PRINT(cli, "capture not running");
+    return -1;
+  }
+
+  CLI_PRINT(cli, "written %lu write fail %lu", ctx->written,
+            ctx->write_fail);
+  return 0;
+}
+
+static int capture_cli_show(struct cli_def *cli, const char *command,
+                            char *argv[], int argc) {
+  config_t *c = cli_get_context(cli);
+  capture_ctx_t *ctx = c->capture_ctx;
+  int i, j;
+
+  CLI_PRINT(cli, "command %s argv[0] %s argc %d", command, argv[0], argc);
+
+  if (!ctx) {
+    return 0;
+  }
+
+  CLI_PRINT(cli, "running: %d", ctx->running);
+  CLI_PRINT(cli, "file: %s", ctx->file);
+  CLI_PRINT(cli, "filter: %s (jit %d)", ctx->filter, ctx->jit.func != NULL);
+  CLI_PRINT(cli, "points:%s%s%s",
+            (ctx->points & CAPTURE_POINT_INGRESS) ? " ingress" : "",
+            (ctx->points & CAPTURE_POINT_EGRESS) ? " egress" : "",
+            (ctx->points & CAPTURE_POINT_DROP) ? " drop" : "");
+  CLI_PRINT(cli, "snaplen: %u", ctx->snaplen);
+  CLI_PRINT(cli, "written: %lu write fail: %lu", ctx->written,
+            ctx->write_fail);
+
+  for (i = 0; i < MAX_WORKER_NUM; i++) {
+    capture_lcore_t *lc = &ctx->lcores[i];
+
+    if (!lc->ring) {
+      continue;
+    }
+
+    CLI_PRINT(cli, "lcore %d ring %u/%u", i, rte_ring_count(lc->ring),
+              rte_ring_get_capacity(lc->ring));
+    for (j = 0; j < CAPTURE_STAT_MAX; j++) {
+      CLI_PRINT(cli, "  %s: %lu", capture_stat_name[j], lc->stats[j]);
+    }
+  }
+
+  return 0;
+}
+
+static void capture_cli_register(config_t *config) {
+  struct cli_def *cli_def;
+  struct cli_command *c, *c1;
+
+  if (!config) {
+    return;
+  }
+
+  cli_def = config->cli_def;
+  if (!cli_def) {
+    return;
+  }
+
+  c = CLI_CMD_C(cli_def, NULL, "capture", NULL, "packet capture");
+  CLI_CMD_C(cli_def, c, "show", capture_cli_show, "show capture status");
+  CLI_CMD_C(cli_def, c, "stop", capture_cli_stop, "stop capture");
+
+  c1 = CLI_CMD_C(cli_def, c, "start", capture_cli_start, "start capture");
+  CLI_OPT(c1, "file", "pcapng file path");
+  CLI_OPT(c1, "filter", "pcap filter expression");
+  CLI_OPT(c1, "points", "capture points, ingress,egress,drop");
+  CLI_OPT(c1, "snaplen", "bytes captured of each packet");
+}
+
+int capture_init(void *config) {
+  config_t *c = config;
+  capture_ctx_t *ctx;
+  int i;
+
+  ctx = rte_zmalloc("capture_ctx", sizeof(capture_ctx_t), RTE_CACHE_LINE_SIZE);
+  if (!ctx) {
+    printf("alloc capture ctx failed\n");
+    return -1;
+  }
+
+  if (capture_load(ctx) <= 0) {
+    rte_free(ctx);
+    return 0;
+  }
+
+  if (capture_setup(c, ctx)) {
+    for (i = 0; i < MAX_WORKER_NUM; i++) {
+      rte_ring_free(ctx->lcores[i].ring);
+    }
+    rte_free(ctx);
+    return -1;
+  }
+
+  c->capture_ctx = ctx;
+  capture_cli_register(c);
+
+  return 0;
+}
+
+/** copy one matched packet to the ring of the worker */
+static void capture_packet(capture_ctx_t *ctx, capture_lcore_t *lc,
+                           struct rte_mbuf *mbuf, uint32_t point,
+                           mod_id_t id) {
+  packet_t *p = rte_mbuf_to_priv(mbuf);
+  enum rte_pcapng_direction dir = RTE_PCAPNG_DIRECTION_IN;
+  struct rte_mbuf *copy;
+  char comment[64];
+  uint16_t port;
+
+  lc->stats[CAPTURE_STAT_MATCHED]++;
+
+  port = p->port_in;
+  if (point == CAPTURE_POINT_INGRESS) {
+    snprintf(comment, sizeof(comment), "ingress");
+  } else if (point == CAPTURE_POINT_EGRESS) {
+    dir = RTE_PCAPNG_DIRECTION_OUT;
+    port = p->port_out;
+    snprintf(comment, sizeof(comment), "egress verdict accept policer %u%s",
+             p->policer, (p->flags & PACKET_FLAG_BYPASS) ? " bypass" : "");
+  } else {
+    dir = RTE_PCAPNG_DIRECTION_UNKNOWN;
+    snprintf(comment, sizeof(comment), "drop verdict drop by %s",
+             modules[id] ? modules[id]->name : "unknown");
+  }
+
+  copy = rte_pcapng_copy(port, p->queue_id, mbuf, ctx->pool, ctx->snaplen,
+                         dir, comment);
+  if (!copy) {
+    lc->stats[CAPTURE_STAT_NOMBUF]++;
+    return;
+  }
+
+  if (rte_ring_sp_enqueue(lc->ring, copy)) {
+    lc->stats[CAPTURE_STAT_RING_FULL]++;
+    rte_pktmbuf_free(copy);
+  }
+}
+
+/** Capture a burst seen at one point. The worker enters the session once for
+ * the burst and the filter runs once over all of its packets.
+ * */
+static void capture_burst(capture_ctx_t *ctx, struct rte_mbuf **mbufs,
+                          uint16_t n, uint32_t point, mod_id_t id) {
+  capture_lcore_t *lc = &ctx->lcores[rte_lcore_id()];
+  uint64_t rc[MAX_PKT_BURST];
+  uint32_t state = CAPTURE_LCORE_IDLE;
+  uint16_t i;
+
+  if (!lc->ring || !(ctx->points & point)) {
+    return;
+  }
+
+  if (!rte_atomic_compare_exchange_strong_explicit(
+          &lc->state, &state, CAPTURE_LCORE_BUSY, rte_memory_order_acquire,
+          rte_memory_order_relaxed)) {
+    return;
+  }
+
+  if (ctx->bpf) {
+    if (ctx->jit.func) {
+      for (i = 0; i < n; i++) {
+        rc[i] = ctx->jit.func(mbufs[i]);
+      }
+    } else {
+      rte_bpf_exec_burst(ctx->bpf, (void **)mbufs, rc, n);
+    }
+  }
+
+  for (i = 0; i < n; i++) {
+    if (!rte_mbuf_to_priv(mbufs[i])) {
+      continue;
+    }
+    if (ctx->bpf && !rc[i]) {
+      lc->stats[CAPTURE_STAT_FILTERED]++;
+      continue;
+    }
+    capture_packet(ctx, lc, mbufs[i], point, id);
+  }
+
+  rte_atomic_store_explicit(&lc->state, CAPTURE_LCORE_IDLE,
+                            rte_memory_order_release);
+}
+
+void capture_drop(void *config, struct rte_mbuf *mbuf, mod_id_t id) {
+  config_t *c = config;
+  capture_ctx_t *ctx = c->capture_ctx;
+
+  if (!ctx || !ctx->running) {
+    return;
+  }
+
+  capture_burst(ctx, &mbuf, 1, CAPTURE_POINT_DROP, id);
+}
+
+uint16_t capture_bulk(void *config, struct rte_mbuf **mbufs, uint16_t n,
+                      mod_hook_t hook) {
+  config_t *c = config;
+  capture_ctx_t *ctx = c->capture_ctx;
+
+  if (!ctx || !ctx->running) {
+    return n;
+  }
+
+  if (hook == MOD_HOOK_INGRESS) {
+    capture_burst(ctx, mbufs, n, CAPTURE_POINT_INGRESS, MOD_ID_CAPTURE);
+  } else if (hook == MOD_HOOK_EGRESS) {
+    capture_burst(ctx, mbufs, n, CAPTURE_POINT_EGRESS, MOD_ID_CAPTURE);
+  }
+
+  return n;
+}
+
+mod_ret_t capture_proc(void *config, struct rte_mbuf *mbuf, mod_hook_t hook) {
+  capture_bulk(config, &mbuf, 1, hook);
+  return MOD_RET_ACCEPT;
+}
+
+// file format utf-8
+// ident using space
@@ -0,0 +1,85 @@
+#ifndef _M_CAPTURE_H_
+#define _M_CAPTURE_H_
+
+#include <rte_bpf.h>
+#include <rte_pcapng.h>
+#include <rte_ring.h>
+#include <rte_stdatomic.h>
+#include <rte_thread.h>
+
+#include "../config.h"
+#include "../module.h"
+
+#define MAX_CAPTURE_FILTER 256
+
+#define DEF_CAPTURE_SNAPLEN 128
+#define DEF_CAPTURE_RING_SIZE 4096
+#define DEF_CAPTURE_MBUF_NUM 16384
+#define DEF_CAPTURE_FILE "/tmp/firewall.pcapng"
+
+// writer sleeps when all rings are empty (us)
+#define CAPTURE_WRITER_IDLE 1000
+
+#define CAPTURE_POINT_INGRESS (1U << 0)
+#define CAPTURE_POINT_EGRESS (1U << 1)
+#define CAPTURE_POINT_DROP (1U << 2)
+#define CAPTURE_POINT_ALL                                                      \
+  (CAPTURE_POINT_INGRESS | CAPTURE_POINT_EGRESS | CAPTURE_POINT_DROP)
+
+typedef enum {
+  CAPTURE_STAT_MATCHED,
+  CAPTURE_STAT_FILTERED,
+  CAPTURE_STAT_NOMBUF,     // no copy mbuf, packet lost from capture
+  CAPTURE_STAT_RING_FULL,  // writer too slow, packet lost from capture
+  CAPTURE_STAT_MAX,
+} capture_stat_t;
+
+typedef enum {
+  CAPTURE_LCORE_OFF,   // no session, the worker skips capture
+  CAPTURE_LCORE_IDLE,  // session running, the worker is outside capture
+  CAPTURE_LCORE_BUSY,  // the worker uses the filter, the pool and its ring
+} capture_lcore_state_t;
+
+/** Worker side of a capture session. The ring is single producer (the
+ * worker) and single consumer (the writer), a full ring is counted and never
+ * waited on. The state is only taken by compare and swap, by the worker to
+ * enter a burst and by capture_stop to close the session.
+ * */
+typedef struct {
+  struct rte_ring *ring;
+  RTE_ATOMIC(uint32_t) state;  // capture_lcore_state_t
+  uint64_t stats[CAPTURE_STAT_MAX];
+} __rte_cache_aligned capture_lcore_t;
+
+typedef struct {
+  volatile bool running;
+  uint32_t points;
+  uint32_t snaplen;
+  uint32_t ring_size;
+  uint32_t mbuf_num;
+  char file[MAX_FILE_PATH];
+  char filter[MAX_CAPTURE_FILTER];
+
+  struct rte_bpf *bpf;
+  struct rte_bpf_jit jit;
+  struct rte_mempool *pool;
+  rte_pcapng_t *pcapng;
+  rte_thread_t writer;
+  uint64_t written;
+  uint64_t write_fail;
+
+  capture_lcore_t lcores[MAX_WORKER_NUM];
+} capture_ctx_t;
+
+int capture_init(void *config);
+mod_ret_t capture_proc(void *config, struct rte_mbuf *mbuf, mod_hook_t hook);
+uint16_t capture_bulk(void *config, struct rte_mbuf **mbufs, uint16_t n,
+                      mod_hook_t hook);
+
+/** called by a module right before it drops a packet */
+void capture_drop(void *config, struct rte_mbuf *mbuf, mod_id_t id);
+
+#endif
+
+// file format utf-8
+// ident using space
@@ -135,8 +135,9 @@ int _cli_run(void *config) {
   fd_set fds;
   int x, r;
 
-  timeout.tv_sec = 10;
-  timeout.tv_usec = 0;
+  // short, mgmt loop drains the event log between two waits
+  timeout.tv_sec = 0;
+  timeout.tv_usec = 200000;
   FD_ZERO(&fds);
   FD_SET(c->cli_sockfd, &fds);
 
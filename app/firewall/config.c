@@ -5,21 +5,39 @@
 #include "config.h"
 #include "module.h"
 
+const char *config_path = "/opt/firewall/config";
+
 config_t config_a = {
   .pktmbuf_pool = NULL,
   .cli_def = NULL,
   .cli_show = NULL,
   .cli_sockfd = 0,
   .itf_cfg = NULL,
+  .decode_ctx = NULL,
   .acl_ctx = NULL,
+  .police_ctx = NULL,
+  .synproxy_ctx = NULL,
+  .nat_ctx = NULL,
+  .hh_ctx = NULL,
+  .capture_ctx = NULL,
+  .plan = {{0}},
+  .plan_num = {0},
+  .plan_hooks = {0},
+  .plan_hook_num = 0,
+  .version = 0,
   .promiscuous = 1,
   .worker_num = 0,
   .port_num = 0,
   .queue_num = 0,
   .rx_queues = {0},
+  .dispatch = {0},
   .tx_queues = {{0}, {0}, {0}, {0}, {0}, {0}, {0}, {0}},
+  .tx_map = {{0}},
+  .ctrl_queues = {0},
   .rxq_num = 0,
   .txq_num = 0,
+  .port_rxq_num = 0,
+  .ring_size = 0,
   .reload_mark = 0,
   .switch_mark = 0,
 }, config_b;
@@ -31,6 +49,7 @@ int config_reload(config_t *c) {
   config_t *new = (c == &config_a) ? &config_b : &config_a;
 
   memcpy(new, c, sizeof(config_t));
+  new->version = c->version + 1;
   modules_conf(new);
   new->reload_mark = 0;
   new->switch_mark = 0;
@@ -2,14 +2,20 @@
 #define _M_CONFIG_H_
 
 #include <stdbool.h>
+#include <stdint.h>
 
 #define MAX_FILE_PATH 256
 #define MAX_WORKER_NUM 8
 #define MAX_PORT_NUM  32
 #define MAX_QUEUE_NUM 16
 #define MAX_PKT_BURST 32
+#define MAX_DISPATCH_NUM 256  // buckets of rss hash, each owned by one worker
+#define MAX_HOOK_NUM 7
+#define MAX_HOOK_MODULE 16
 
-#define CONFIG_PATH "/opt/firewall/config"
+// default is /opt/firewall/config, tools may point it somewhere else
+extern const char *config_path;
+#define CONFIG_PATH config_path
 #define BINARY_PATH "/opt/firewall/bin"
 #define SCRIPT_PATH "/opt/firewall/script"
 
@@ -27,9 +33,14 @@ typedef struct {
   int worker_num;
   int worker_map[MAX_WORKER_NUM];
   void *rx_queues[MAX_WORKER_NUM];
-  void *tx_queues[MAX_PORT_NUM][MAX_QUEUE_NUM];
+  uint8_t dispatch[MAX_DISPATCH_NUM];  // bucket -> index of rx_queues
+  void *tx_queues[MAX_PORT_NUM][MAX_QUEUE_NUM];  // port, tx queue
+  uint8_t tx_map[MAX_WORKER_NUM][MAX_PORT_NUM];  // work id, port -> tx queue
+  void *ctrl_queues[MAX_PORT_NUM];   // packets generated by firewall itself
   int rxq_num;
-  int txq_num;
+  int txq_num;       // nic tx queues of each port, one per tx lcore
+  int port_rxq_num;  // nic rx queues of each port
+  uint32_t ring_size;  // work and tx rings, 0 for sized by producers
   
   // interface
   void *itf_cfg;
@@ -37,10 +48,36 @@ typedef struct {
   int port_num;
   int queue_num;
 
+  // decode
+  void *decode_ctx;
+
   // acl
   void *acl_ctx;
 
+  // police
+  void *police_ctx;
+
+  // synproxy
+  void *synproxy_ctx;
+
+  // nat
+  void *nat_ctx;
+
+  // heavy hitter
+  void *hh_ctx;
+
+  // packet capture
+  void *capture_ctx;
+
+  // module handlers of each hook compiled from the enabled modules, rebuilt
+  // on each reload so workers switch plans together with the config
+  void *plan[MAX_HOOK_NUM][MAX_HOOK_MODULE];  // module_t
+  uint8_t plan_num[MAX_HOOK_NUM];
+  uint8_t plan_hooks[MAX_HOOK_NUM];  // hooks with any handler, in order
+  uint8_t plan_hook_num;
+
   // configuration
+  uint32_t version;  // bumped on each reload
   int reload_mark;
   int switch_mark;
 } config_t;
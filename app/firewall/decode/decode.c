@@ -1,17 +1,26 @@
 #include <rte_byteorder.h>
 #include <rte_ether.h>
+#include <rte_geneve.h>
 #include <rte_gre.h>
+#include <rte_gtp.h>
 #include <rte_ip.h>
 #include <rte_log.h>
+#include <rte_malloc.h>
 #include <rte_mbuf_ptype.h>
 #include <rte_mpls.h>
 #include <rte_net.h>
 #include <rte_sctp.h>
 #include <rte_tcp.h>
 #include <rte_udp.h>
+#include <rte_vxlan.h>
 
+#include "../cli.h"
+#include "../config.h"
+#include "../evlog.h"
+#include "../json.h"
 #include "../packet.h"
 
+#include "../capture/capture.h"
 #include "decode.h"
 
 MODULE_DECLARE(decode) = {.name = "decode",
@@ -22,7 +31,8 @@ MODULE_DECLARE(decode) = {.name = "decode",
                            .proc = decoder_proc,
                            .conf = NULL,
                            .free = NULL,
-                           .priv = NULL};
+                           .priv = NULL,
+                           .hooks = MOD_HOOK_BIT(MOD_HOOK_INGRESS)};
 
 /* get l3 packet type from ip6 next protocol */
 static uint32_t ptype_l3_ip6(uint8_t ip6_proto) {
@@ -104,14 +114,15 @@ static uint32_t ptype_inner_l4(uint8_t proto) {
       [IPPROTO_UDP] = RTE_PTYPE_INNER_L4_UDP,
       [IPPROTO_TCP] = RTE_PTYPE_INNER_L4_TCP,
       [IPPROTO_SCTP] = RTE_PTYPE_INNER_L4_SCTP,
+      [IPPROTO_ICMP] = RTE_PTYPE_INNER_L4_ICMP,
   };
 
   return ptype_inner_l4_proto[proto];
 }
 
-/* get the tunnel packet type if any, update proto and off. */
+/* get the tunnel packet type if any, update proto, off and id. */
 static uint32_t ptype_tunnel(uint16_t *proto, const struct rte_mbuf *mbuf,
-                             uint32_t *off) {
+                             uint32_t *off, uint32_t *id) {
   switch (*proto) {
   case IPPROTO_GRE: {
     static const uint8_t opt_len[16] = {
@@ -131,6 +142,17 @@ static uint32_t ptype_tunnel(uint16_t *proto, const struct rte_mbuf *mbuf,
     if (opt_len[flags] == 0)
       return 0;
 
+    // key follows the checksum word if any
+    if (flags & 0x2) {
+      const rte_be32_t *key;
+      rte_be32_t key_copy;
+
+      key = rte_pktmbuf_read(mbuf, *off + ((flags & 0x8) ? 8 : 4),
+                             sizeof(*key), &key_copy);
+      if (key != NULL)
+        *id = rte_be_to_cpu_32(*key);
+    }
+
     *off += opt_len[flags];
     *proto = gh->proto;
     if (*proto == rte_cpu_to_be_16(RTE_ETHER_TYPE_TEB))
@@ -149,9 +171,300 @@ static uint32_t ptype_tunnel(uint16_t *proto, const struct rte_mbuf *mbuf,
   }
 }
 
-int decoder_init(__rte_unused void *config) { return 0; }
+/* vxlan, payload is always ethernet */
+static int tunnel_vxlan(const struct rte_mbuf *mbuf, uint32_t *off,
+                        uint16_t *proto, uint32_t *id) {
+  const struct rte_vxlan_hdr *vh;
+  struct rte_vxlan_hdr vh_copy;
+
+  vh = rte_pktmbuf_read(mbuf, *off, sizeof(*vh), &vh_copy);
+  if (unlikely(vh == NULL) || !vh->flag_i) {
+    return -1;
+  }
+
+  *id = rte_be_to_cpu_32(vh->vx_vni) >> 8;
+  *off += sizeof(*vh);
+  *proto = rte_cpu_to_be_16(RTE_ETHER_TYPE_TEB);
+  return 0;
+}
+
+/* vxlan-gpe, payload type comes from the next protocol field */
+static int tunnel_vxlan_gpe(const struct rte_mbuf *mbuf, uint32_t *off,
+                            uint16_t *proto, uint32_t *id) {
+  static const uint16_t gpe_proto[] = {
+      [RTE_VXLAN_GPE_TYPE_IPV4] = RTE_ETHER_TYPE_IPV4,
+      [RTE_VXLAN_GPE_TYPE_IPV6] = RTE_ETHER_TYPE_IPV6,
+      [RTE_VXLAN_GPE_TYPE_ETH] = RTE_ETHER_TYPE_TEB,
+  };
+  const struct rte_vxlan_hdr *vh;
+  struct rte_vxlan_hdr vh_copy;
+
+  vh = rte_pktmbuf_read(mbuf, *off, sizeof(*vh), &vh_copy);
+  if (unlikely(vh == NULL) || !vh->flag_p ||
+      (vh->proto >= RTE_DIM(gpe_proto)) || !gpe_proto[vh->proto]) {
+    return -1;
+  }
+
+  *id = rte_be_to_cpu_32(vh->vx_vni) >> 8;
+  *off += sizeof(*vh);
+  *proto = rte_cpu_to_be_16(gpe_proto[vh->proto]);
+  return 0;
+}
+
+/* geneve, options are skipped */
+static int tunnel_geneve(const struct rte_mbuf *mbuf, uint32_t *off,
+                         uint16_t *proto, uint32_t *id) {
+  const struct rte_geneve_hdr *gh;
+  struct rte_geneve_hdr gh_copy;
+
+  gh = rte_pktmbuf_read(mbuf, *off, sizeof(*gh), &gh_copy);
+  if (unlikely(gh == NULL) || gh->ver) {
+    return -1;
+  }
+
+  *id = (gh->vni[0] << 16) | (gh->vni[1] << 8) | gh->vni[2];
+  *off += sizeof(*gh) + gh->opt_len * 4;
+  *proto = gh->proto;
+  return 0;
+}
+
+#define GTPU_MSG_GPDU 0xff
+#define GTPU_MAX_EXT 4
+
+/* gtp-u, only g-pdu carries user packets, payload type comes from the ip
+ * version of the payload */
+static int tunnel_gtpu(const struct rte_mbuf *mbuf, uint32_t *off,
+                       uint16_t *proto, uint32_t *id) {
+  const struct rte_gtp_hdr *gh;
+  struct rte_gtp_hdr gh_copy;
+  const uint8_t *b;
+  uint8_t b_copy, next = 0;
+  int i;
+
+  gh = rte_pktmbuf_read(mbuf, *off, sizeof(*gh), &gh_copy);
+  if (unlikely(gh == NULL) || (gh->ver != 1) || !gh->pt ||
+      (gh->msg_type != GTPU_MSG_GPDU)) {
+    return -1;
+  }
+
+  *id = rte_be_to_cpu_32(gh->teid);
+  *off += sizeof(*gh);
+
+  // optional word is present if any of E, S, PN is set
+  if (gh->e || gh->s || gh->pn) {
+    const struct rte_gtp_hdr_ext_word *ew;
+    struct rte_gtp_hdr_ext_word ew_copy;
+
+    ew = rte_pktmbuf_read(mbuf, *off, sizeof(*ew), &ew_copy);
+    if (unlikely(ew == NULL)) {
+      return -1;
+    }
+
+    next = gh->e ? ew->next_ext : 0;
+    *off += sizeof(*ew);
+  }
+
+  // extension headers, length in 4 bytes units, last byte is next type
+  for (i = 0; next && (i < GTPU_MAX_EXT); i++) {
+    uint32_t len;
+
+    b = rte_pktmbuf_read(mbuf, *off, 1, &b_copy);
+    if (unlikely(b == NULL) || !*b) {
+      return -1;
+    }
+
+    len = *b * 4;
+    b = rte_pktmbuf_read(mbuf, *off + len - 1, 1, &b_copy);
+    if (unlikely(b == NULL)) {
+      return -1;
+    }
+
+    next = *b;
+    *off += len;
+  }
+
+  if (next) {
+    return -1;
+  }
+
+  b = rte_pktmbuf_read(mbuf, *off, 1, &b_copy);
+  if (unlikely(b == NULL)) {
+    return -1;
+  }
+
+  if ((*b >> 4) == 4) {
+    *proto = rte_cpu_to_be_16(RTE_ETHER_TYPE_IPV4);
+  } else if ((*b >> 4) == 6) {
+    *proto = rte_cpu_to_be_16(RTE_ETHER_TYPE_IPV6);
+  } else {
+    return -1;
+  }
+
+  return 0;
+}
+
+/* udp tunnels the decoder knows, ports of decode.json select among them */
+static const decode_tunnel_t decode_tunnels[] = {
+    {
+        .name = "vxlan",
+        .tunnel = PACKET_TUNNEL_VXLAN,
+        .port = RTE_VXLAN_DEFAULT_PORT,
+        .ptype = RTE_PTYPE_TUNNEL_VXLAN,
+        .parse = tunnel_vxlan,
+    },
+    {
+        .name = "vxlan-gpe",
+        .tunnel = PACKET_TUNNEL_VXLAN_GPE,
+        .port = RTE_VXLAN_GPE_DEFAULT_PORT,
+        .ptype = RTE_PTYPE_TUNNEL_VXLAN_GPE,
+        .parse = tunnel_vxlan_gpe,
+    },
+    {
+        .name = "geneve",
+        .tunnel = PACKET_TUNNEL_GENEVE,
+        .port = RTE_GENEVE_DEFAULT_PORT,
+        .ptype = RTE_PTYPE_TUNNEL_GENEVE,
+        .parse = tunnel_geneve,
+    },
+    {
+        .name = "gtpu",
+        .tunnel = PACKET_TUNNEL_GTPU,
+        .port = RTE_GTPU_UDP_PORT,
+        .ptype = RTE_PTYPE_TUNNEL_GTPU,
+        .parse = tunnel_gtpu,
+    },
+};
+
+static const decode_tunnel_t *decode_tunnel_find(const char *name) {
+  uint32_t i;
+
+  for (i = 0; i < RTE_DIM(decode_tunnels); i++) {
+    if (!strcmp(decode_tunnels[i].name, name)) {
+      return &decode_tunnels[i];
+    }
+  }
+
+  return NULL;
+}
+
+static void decode_tunnel_add(decode_ctx_t *ctx, const decode_tunnel_t *t,
+                              uint16_t port) {
+  if (ctx->tunnel_num == MAX_DECODE_TUNNEL) {
+    printf("too many tunnels, %s port %u ignored\n", t->name, port);
+    return;
+  }
+
+  ctx->ports[ctx->tunnel_num] = rte_cpu_to_be_16(port);
+  ctx->tunnels[ctx->tunnel_num] = t;
+  ctx->tunnel_num++;
+}
 
-static mod_ret_t decoder_proc_ingress(struct rte_mbuf *mbuf) {
+static int decode_load(decode_ctx_t *ctx) {
+  json_object *jr = NULL, *ja, *jo, *jv;
+  const decode_tunnel_t *t;
+  int i, num;
+  uint32_t j;
+
+  jr = JR(CONFIG_PATH, "decode.json");
+  if (!jr) {
+    // every known tunnel on its default port
+    for (j = 0; j < RTE_DIM(decode_tunnels); j++) {
+      decode_tunnel_add(ctx, &decode_tunnels[j], decode_tunnels[j].port);
+    }
+    return 0;
+  }
+
+  num = JA(jr, "tunnels", &ja);
+  for (i = 0; i < num; i++) {
+    jo = JO(ja, i);
+
+    jv = JV(jo, "type");
+    t = jv ? decode_tunnel_find(JV_S(jv)) : NULL;
+    if (!t) {
+      printf("unknown tunnel type %s\n", jv ? JV_S(jv) : "");
+      continue;
+    }
+
+    jv = JV(jo, "port");
+    decode_tunnel_add(ctx, t, jv ? JV_I(jv) : t->port);
+  }
+
+  JR_FREE(jr);
+  return 0;
+}
+
+static int decode_show(struct cli_def *cli, const char *command, char *argv[],
+                       int argc) {
+  config_t *c = cli_get_context(cli);
+  decode_ctx_t *ctx = c->decode_ctx;
+  uint32_t i;
+
+  CLI_PRINT(cli, "command %s argv[0] %s argc %d", command, argv[0], argc);
+
+  if (!ctx) {
+    return 0;
+  }
+
+  for (i = 0; i < ctx->tunnel_num; i++) {
+    CLI_PRINT(cli, "%-10s udp port %u", ctx->tunnels[i]->name,
+              rte_be_to_cpu_16(ctx->ports[i]));
+  }
+
+  return 0;
+}
+
+static void decode_cli_register(config_t *config) {
+  struct cli_def *cli_def;
+  struct cli_command *c;
+
+  if (!config) {
+    return;
+  }
+
+  cli_def = config->cli_def;
+  if (!cli_def) {
+    return;
+  }
+
+  c = CLI_CMD_C(cli_def, NULL, "decode", NULL, "packet decoder");
+  CLI_CMD_C(cli_def, c, "show", decode_show, "show udp tunnel ports");
+}
+
+int decoder_init(void *config) {
+  config_t *c = config;
+  decode_ctx_t *ctx;
+
+  ctx = rte_zmalloc("decode_ctx", sizeof(decode_ctx_t), RTE_CACHE_LINE_SIZE);
+  if (!ctx) {
+    printf("alloc decode ctx failed\n");
+    return -1;
+  }
+
+  decode_load(ctx);
+
+  c->decode_ctx = ctx;
+  decode_cli_register(c);
+
+  return 0;
+}
+
+static inline const decode_tunnel_t *decode_udp_tunnel(decode_ctx_t *ctx,
+                                                       uint16_t port) {
+  uint32_t i;
+
+  for (i = 0; i < ctx->tunnel_num; i++) {
+    if (ctx->ports[i] == port) {
+      return ctx->tunnels[i];
+    }
+  }
+
+  return NULL;
+}
+
+static mod_ret_t decoder_proc_ingress(void *config, struct rte_mbuf *mbuf) {
+  config_t *c = config;
+  decode_ctx_t *ctx = c->decode_ctx;
+  const decode_tunnel_t *t;
   packet_t *p;
   const struct rte_ether_hdr *eh;
   uint32_t pkt_type = RTE_PTYPE_L2_ETHER;
@@ -164,6 +477,9 @@ static mod_ret_t decoder_proc_ingress(struct rte_mbuf *mbuf) {
     goto error;
   }
 
+  p->tunnel = PACKET_TUNNEL_NONE;
+  p->tunnel_id = 0;
+
   // L2:
   if (unlikely(rte_pktmbuf_data_len(mbuf) < sizeof(struct rte_ether_hdr))) {
     goto error;
@@ -244,6 +560,10 @@ static mod_ret_t decoder_proc_ingress(struct rte_mbuf *mbuf) {
   }
 
 L3:
+  // outer header lengths, used by modules which rewrite packets
+  mbuf->l2_len = offset;
+  mbuf->l3_len = 0;
+
   if (proto == rte_cpu_to_be_16(RTE_ETHER_TYPE_IPV4)) {
     const struct rte_ipv4_hdr *ip4h;
 
@@ -259,10 +579,13 @@ static mod_ret_t decoder_proc_ingress(struct rte_mbuf *mbuf) {
     p->tuple.v4.proto = ip4h->next_proto_id;
     p->tuple.v4.sip = ip4h->src_addr;
     p->tuple.v4.dip = ip4h->dst_addr;
+    p->tuple.v4.sp = 0;
+    p->tuple.v4.dp = 0;
     p->is_v4 = true;
 
     pkt_type |= ptype_l3_ip(ip4h->version_ihl);
     offset += rte_ipv4_hdr_len(ip4h);
+    mbuf->l3_len = offset - mbuf->l2_len;
 
     if (ip4h->fragment_offset &
         rte_cpu_to_be_16(RTE_IPV4_HDR_OFFSET_MASK | RTE_IPV4_HDR_MF_FLAG)) {
@@ -287,6 +610,8 @@ static mod_ret_t decoder_proc_ingress(struct rte_mbuf *mbuf) {
     p->tuple.v6.proto = ip6h->proto;
     memcpy(p->tuple.v6.sip, &ip6h->src_addr, 16);
     memcpy(p->tuple.v6.dip, &ip6h->dst_addr, 16);
+    p->tuple.v6.sp = 0;
+    p->tuple.v6.dp = 0;
     p->is_v4 = false;
 
     proto = ip6h->proto;
@@ -300,6 +625,7 @@ static mod_ret_t decoder_proc_ingress(struct rte_mbuf *mbuf) {
       }
       proto = ret;
     }
+    mbuf->l3_len = offset - mbuf->l2_len;
 
     if (proto == 0) {
       goto done;
@@ -334,7 +660,20 @@ static mod_ret_t decoder_proc_ingress(struct rte_mbuf *mbuf) {
       p->tuple.v6.dp = uh->dst_port;
     }
 
-    goto done;
+    // udp tunnels are told apart by destination port
+    t = ctx ? decode_udp_tunnel(ctx, uh->dst_port) : NULL;
+    if (!t) {
+      goto done;
+    }
+
+    offset += sizeof(*uh);
+    if (t->parse(mbuf, &offset, &proto, &p->tunnel_id)) {
+      goto done;
+    }
+
+    pkt_type |= t->ptype;
+    p->tunnel = t->tunnel;
+    goto tunnel;
   } else if ((pkt_type & RTE_PTYPE_L4_MASK) == RTE_PTYPE_L4_TCP) {
     const struct rte_tcp_hdr *th;
 
@@ -390,9 +729,22 @@ static mod_ret_t decoder_proc_ingress(struct rte_mbuf *mbuf) {
 
     goto done;
   } else {
-    pkt_type |= ptype_tunnel(&proto, mbuf, &offset);
+    pkt_type |= ptype_tunnel(&proto, mbuf, &offset, &p->tunnel_id);
+    if (!(pkt_type & RTE_PTYPE_TUNNEL_MASK)) {
+      goto done;
+    }
+
+    p->tunnel = ((pkt_type & RTE_PTYPE_TUNNEL_MASK) == RTE_PTYPE_TUNNEL_IP)
+                    ? PACKET_TUNNEL_IP
+                    : PACKET_TUNNEL_GRE;
   }
 
+tunnel:
+  // policy may match either layer, keep the outer tuple before the inner
+  // headers overwrite it
+  p->outer = p->tuple;
+  p->outer_is_v4 = p->is_v4;
+
   // INNER_L2:
   if (proto == rte_cpu_to_be_16(RTE_ETHER_TYPE_TEB)) {
     if (unlikely(rte_pktmbuf_data_len(mbuf) - offset < sizeof(*eh))) {
@@ -465,6 +817,8 @@ static mod_ret_t decoder_proc_ingress(struct rte_mbuf *mbuf) {
     p->tuple.v4.proto = ip4h->next_proto_id;
     p->tuple.v4.sip = ip4h->src_addr;
     p->tuple.v4.dip = ip4h->dst_addr;
+    p->tuple.v4.sp = 0;
+    p->tuple.v4.dp = 0;
     p->is_v4 = true;
 
     pkt_type |= ptype_inner_l3_ip(ip4h->version_ihl);
@@ -493,6 +847,8 @@ static mod_ret_t decoder_proc_ingress(struct rte_mbuf *mbuf) {
     p->tuple.v6.proto = ip6h->proto;
     memcpy(p->tuple.v6.sip, &ip6h->src_addr, 16);
     memcpy(p->tuple.v6.dip, &ip6h->dst_addr, 16);
+    p->tuple.v6.sp = 0;
+    p->tuple.v6.dp = 0;
     p->is_v4 = false;
 
     proto = ip6h->proto;
@@ -585,33 +941,24 @@ static mod_ret_t decoder_proc_ingress(struct rte_mbuf *mbuf) {
     }
 
     goto done;
-  } else if ((pkt_type & RTE_PTYPE_L4_MASK) == RTE_PTYPE_L4_ICMP) {
-    if (p->is_v4) {
-      p->tuple.v4.sp = 0;
-      p->tuple.v4.dp = 0;
-    } else {
-      p->tuple.v6.sp = 0;
-      p->tuple.v6.dp = 0;
-    }
-
-    goto done;
-  } else {
-    pkt_type |= ptype_tunnel(&proto, mbuf, &offset);
   }
 
+  // nested tunnels are not decoded, tuple holds the first inner headers
+
 done:
   p->ptype = pkt_type;
   return MOD_RET_ACCEPT;
 
 error:
+  EVLOG(EVLOG_DECODE_ERROR, mbuf->port, rte_pktmbuf_pkt_len(mbuf));
+  capture_drop(config, mbuf, MOD_ID_DECODER);
   rte_pktmbuf_free(mbuf);
   return MOD_RET_STOLEN;
 }
 
-mod_ret_t decoder_proc(__rte_unused void *config, struct rte_mbuf *mbuf,
-                       mod_hook_t hook) {
+mod_ret_t decoder_proc(void *config, struct rte_mbuf *mbuf, mod_hook_t hook) {
   if (hook == MOD_HOOK_INGRESS) {
-    return decoder_proc_ingress(mbuf);
+    return decoder_proc_ingress(config, mbuf);
   }
 
   return MOD_RET_ACCEPT;
@@ -3,11 +3,36 @@
 
 #include "../module.h"
 
-int decoder_init(__rte_unused void *config);
-mod_ret_t decoder_proc(__rte_unused void *config, struct rte_mbuf *mbuf,
-                       mod_hook_t hook);
+#define MAX_DECODE_TUNNEL 8
+
+/** parse a tunnel header at *off, on success move *off to the payload, set
+ * *proto to the ether type of the payload and *id to the tunnel id
+ * */
+typedef int (*decode_tunnel_parse_t)(const struct rte_mbuf *mbuf,
+                                     uint32_t *off, uint16_t *proto,
+                                     uint32_t *id);
+
+typedef struct {
+  const char *name;
+  uint8_t tunnel;       // packet_tunnel_t
+  uint16_t port;        // default udp destination port
+  uint32_t ptype;
+  decode_tunnel_parse_t parse;
+} decode_tunnel_t;
+
+/** udp tunnels are recognized by destination port, the table is scanned in
+ * order and is short, so it stays in one or two cache lines
+ * */
+typedef struct {
+  uint32_t tunnel_num;
+  uint16_t ports[MAX_DECODE_TUNNEL];  // network order
+  const decode_tunnel_t *tunnels[MAX_DECODE_TUNNEL];
+} decode_ctx_t;
+
+int decoder_init(void *config);
+mod_ret_t decoder_proc(void *config, struct rte_mbuf *mbuf, mod_hook_t hook);
 
 #endif
 
 // file format utf-8
-// ident using space
\ No newline at end of file
+// ident using space
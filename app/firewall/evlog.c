@@ -0,0 +1,306 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <time.h>
+
+#include <rte_malloc.h>
+#include <rte_spinlock.h>
+
+#include "cli.h"
+#include "config.h"
+
+#include "evlog.h"
+
+typedef struct {
+  const char *name;
+  uint32_t rate;       // default records per second per lcore
+} evlog_def_t;
+
+static const evlog_def_t evlog_defs[EVLOG_MAX] = {
+  [EVLOG_NONE] = {"none", 0},
+  [EVLOG_TX_FAIL] = {"tx-fail", 10},
+  [EVLOG_CTRL_TX_FAIL] = {"ctrl-tx-fail", 10},
+  [EVLOG_TX_RING_FULL] = {"tx-ring-full", 10},
+  [EVLOG_DECODE_ERROR] = {"decode-error", 10},
+};
+
+evlog_lcore_t *evlog_lcores;
+uint32_t evlog_rate[EVLOG_MAX];
+
+// drained records, written by mgmt thread, read by cli threads
+static evlog_rec_t evlog_history[EVLOG_HISTORY_SIZE];
+static uint64_t evlog_history_num;
+static rte_spinlock_t evlog_history_lock = RTE_SPINLOCK_INITIALIZER;
+
+// wall clock of tsc 0, to print records with a date
+static struct timeval evlog_tv0;
+static uint64_t evlog_tsc0;
+
+static int evlog_find(const char *name) {
+  int i;
+
+  for (i = EVLOG_NONE + 1; i < EVLOG_MAX; i++) {
+    if (!strcmp(evlog_defs[i].name, name)) {
+      return i;
+    }
+  }
+
+  return -1;
+}
+
+static void evlog_format(const evlog_rec_t *rec, char *buf, size_t len) {
+  const evlog_def_t *def = &evlog_defs[rec->event];
+  uint64_t hz = rte_get_tsc_hz();
+  uint64_t us = (rec->tsc - evlog_tsc0) * 1000000 / hz + evlog_tv0.tv_usec;
+  time_t sec = evlog_tv0.tv_sec + us / 1000000;
+  struct tm tm;
+  char ts[32];
+  int n;
+
+  localtime_r(&sec, &tm);
+  strftime(ts, sizeof(ts), "%F %T", &tm);
+
+  n = snprintf(buf, len, "%s.%06lu lcore %u %s: ", ts, us % 1000000,
+               rec->lcore, def->name);
+  if ((n <= 0) || ((size_t)n >= len)) {
+    return;
+  }
+
+  // literal formats, so that the compiler checks the arguments
+  buf += n;
+  len -= n;
+  switch (rec->event) {
+  case EVLOG_TX_FAIL:
+    snprintf(buf, len, "port %u queue %u tx failed, %u dropped", rec->args[0],
+             rec->args[1], rec->args[2]);
+    break;
+  case EVLOG_CTRL_TX_FAIL:
+    snprintf(buf, len, "port %u queue %u ctrl tx failed, %u dropped",
+             rec->args[0], rec->args[1], rec->args[2]);
+    break;
+  case EVLOG_TX_RING_FULL:
+    snprintf(buf, len, "port %u queue %u tx ring full, packet dropped",
+             rec->args[0], rec->args[1]);
+    break;
+  case EVLOG_DECODE_ERROR:
+    snprintf(buf, len, "port %u malformed packet length %u dropped",
+             rec->args[0], rec->args[1]);
+    break;
+  default:
+    buf[0] = '\0';
+    break;
+  }
+}
+
+uint32_t evlog_drain(void) {
+  evlog_rec_t rec;
+  uint64_t head;
+  uint32_t num = 0;
+  char buf[256];
+  int i;
+
+  if (!evlog_lcores) {
+    return 0;
+  }
+
+  for (i = 0; i < MAX_WORKER_NUM; i++) {
+    evlog_lcore_t *lc = &evlog_lcores[i];
+
+    head = lc->head;
+    rte_smp_rmb();
+
+    // writer lapped us, the oldest records are gone
+    if (head - lc->tail > EVLOG_RING_SIZE) {
+      lc->lost += head - lc->tail - EVLOG_RING_SIZE;
+      lc->tail = head - EVLOG_RING_SIZE;
+    }
+
+    for (; lc->tail < head; lc->tail++) {
+      rec = lc->recs[lc->tail & (EVLOG_RING_SIZE - 1)];
+      rte_smp_rmb();
+
+      // slot may be rewritten while being copied
+      if (lc->head - lc->tail >= EVLOG_RING_SIZE) {
+        lc->lost++;
+        continue;
+      }
+
+      if ((rec.event == EVLOG_NONE) || (rec.event >= EVLOG_MAX)) {
+        continue;
+      }
+
+      evlog_format(&rec, buf, sizeof(buf));
+      printf("%s\n", buf);
+
+      rte_spinlock_lock(&evlog_history_lock);
+      evlog_history[evlog_history_num++ % EVLOG_HISTORY_SIZE] = rec;
+      rte_spinlock_unlock(&evlog_history_lock);
+      num++;
+    }
+  }
+
+  return num;
+}
+
+static int evlog_show(struct cli_def *cli, const char *command, char *argv[],
+                      int argc) {
+  const char *opt;
+  evlog_rec_t rec;
+  uint64_t i, start, end, suppressed;
+  uint32_t num = DEF_EVLOG_SHOW;
+  int lcore = -1, j, k;
+  char buf[256];
+
+  CLI_PRINT(cli, "command %s argv[0] %s argc %d", command, argv[0], argc);
+
+  opt = CLI_OPT_V(cli, "num");
+  if (opt && (atoi(opt) > 0)) {
+    num = RTE_MIN(atoi(opt), EVLOG_HISTORY_SIZE);
+  }
+
+  opt = CLI_OPT_V(cli, "lcore");
+  if (opt) {
+    lcore = atoi(opt);
+  }
+
+  if (!evlog_lcores) {
+    return 0;
+  }
+
+  for (j = 0; j < MAX_WORKER_NUM; j++) {
+    evlog_lcore_t *lc = &evlog_lcores[j];
+
+    if (!lc->head || ((lcore != -1) && (lcore != j))) {
+      continue;
+    }
+
+    suppressed = 0;
+    for (k = 0; k < EVLOG_MAX; k++) {
+      suppressed += lc->suppressed[k];
+    }
+    CLI_PRINT(cli, "lcore %d logged %lu lost %lu suppressed %lu", j, lc->head,
+              lc->lost, suppressed);
+  }
+
+  // newest last, walk back to find the start of the last num records
+  rte_spinlock_lock(&evlog_history_lock);
+  end = evlog_history_num;
+  start = (end > EVLOG_HISTORY_SIZE) ? end - EVLOG_HISTORY_SIZE : 0;
+  for (i = end; (i > start) && num; i--) {
+    rec = evlog_history[(i - 1) % EVLOG_HISTORY_SIZE];
+    if ((lcore == -1) || (rec.lcore == lcore)) {
+      num--;
+    }
+  }
+  start = i;
+
+  for (i = start; i < end; i++) {
+    rec = evlog_history[i % EVLOG_HISTORY_SIZE];
+    if ((lcore != -1) && (rec.lcore != lcore)) {
+      continue;
+    }
+
+    evlog_format(&rec, buf, sizeof(buf));
+    CLI_PRINT(cli, "%s", buf);
+  }
+  rte_spinlock_unlock(&evlog_history_lock);
+
+  return 0;
+}
+
+static int evlog_rate_set(struct cli_def *cli, const char *command,
+                          char *argv[], int argc) {
+  const char *event = CLI_OPT_V(cli, "event");
+  const char *limit = CLI_OPT_V(cli, "limit");
+  int id;
+
+  CLI_PRINT(cli, "command %s argv[0] %s argc %d", command, argv[0], argc);
+
+  if (!event || !limit) {
+    CLI_PRINT(cli, "event and limit required");
+    return -1;
+  }
+
+  id = evlog_find(event);
+  if (id < 0) {
+    CLI_PRINT(cli, "unknown event %s", event);
+    return -1;
+  }
+
+  evlog_rate[id] = atoi(limit);
+  CLI_PRINT(cli, "ok!");
+  return 0;
+}
+
+static int evlog_rate_show(struct cli_def *cli, const char *command,
+                           char *argv[], int argc) {
+  uint64_t suppressed;
+  int i, j;
+
+  CLI_PRINT(cli, "command %s argv[0] %s argc %d", command, argv[0], argc);
+
+  for (i = EVLOG_NONE + 1; i < EVLOG_MAX; i++) {
+    suppressed = 0;
+    for (j = 0; evlog_lcores && (j < MAX_WORKER_NUM); j++) {
+      suppressed += evlog_lcores[j].suppressed[i];
+    }
+    CLI_PRINT(cli, "%-14s %6u/s suppressed %lu", evlog_defs[i].name,
+              evlog_rate[i], suppressed);
+  }
+
+  return 0;
+}
+
+static void evlog_cli_register(config_t *config) {
+  struct cli_def *cli_def;
+  struct cli_command *c, *c1;
+
+  cli_def = config->cli_def;
+  if (!cli_def) {
+    return;
+  }
+
+  c = CLI_CMD_C(cli_def, config->cli_show, "log", evlog_show,
+                "datapath event log");
+  CLI_OPT(c, "num", "number of latest records");
+  CLI_OPT(c, "lcore", "records of one lcore");
+
+  c = CLI_CMD_C(cli_def, NULL, "log", NULL, "datapath event log");
+  c1 = CLI_CMD_C(cli_def, c, "rate", evlog_rate_set,
+                 "records per second per lcore of an event, 0 unlimited");
+  CLI_OPT_A(c1, "event", "event name");
+  CLI_OPT_A(c1, "limit", "records per second");
+  CLI_CMD_C(cli_def, c, "show", evlog_rate_show, "rate limit of events");
+}
+
+int evlog_init(void *config) {
+  config_t *c = config;
+  int i;
+
+  evlog_lcores = rte_zmalloc("evlog", sizeof(evlog_lcore_t) * MAX_WORKER_NUM,
+                             RTE_CACHE_LINE_SIZE);
+  if (!evlog_lcores) {
+    printf("alloc event log failed\n");
+    return -1;
+  }
+
+  for (i = 0; i < EVLOG_MAX; i++) {
+    evlog_rate[i] = evlog_defs[i].rate;
+  }
+
+  gettimeofday(&evlog_tv0, NULL);
+  evlog_tsc0 = rte_rdtsc();
+
+  evlog_cli_register(c);
+
+  return 0;
+}
+
+void evlog_free(void) {
+  evlog_drain();
+  rte_free(evlog_lcores);
+  evlog_lcores = NULL;
+}
+
+// file format utf-8
+// ident using space
@@ -0,0 +1,108 @@
+#ifndef _M_EVLOG_H_
+#define _M_EVLOG_H_
+
+/** Datapath event log. Each lcore writes fixed size binary records into its
+ * own ring, a full ring overwrites the oldest records, so a lcore never waits
+ * or makes a syscall to log. The mgmt thread drains the rings, formats the
+ * records and keeps the latest of them for "show log".
+ * */
+
+#include <string.h>
+
+#include <rte_branch_prediction.h>
+#include <rte_common.h>
+#include <rte_cycles.h>
+#include <rte_lcore.h>
+
+#include "config.h"
+
+#define EVLOG_RING_SIZE 1024     // records per lcore, power of 2
+#define EVLOG_HISTORY_SIZE 4096  // drained records kept for show log
+#define EVLOG_MAX_ARGS 5
+#define DEF_EVLOG_SHOW 50
+
+typedef enum {
+  EVLOG_NONE,
+  EVLOG_TX_FAIL,        // port, queue, dropped
+  EVLOG_CTRL_TX_FAIL,   // port, queue, dropped
+  EVLOG_TX_RING_FULL,   // port, queue
+  EVLOG_DECODE_ERROR,   // port, length
+  EVLOG_MAX,
+} evlog_event_t;
+
+typedef struct {
+  uint64_t tsc;
+  uint16_t lcore;
+  uint16_t event;
+  uint32_t args[EVLOG_MAX_ARGS];
+} evlog_rec_t;
+
+/** head is written by the owner lcore only, tail and lost by the mgmt
+ * thread only, they live on different cache lines
+ * */
+typedef struct {
+  volatile uint64_t head;
+  uint64_t window[EVLOG_MAX];      // start of rate limit window, tsc
+  uint32_t count[EVLOG_MAX];       // records in current window
+  uint64_t suppressed[EVLOG_MAX];  // over rate limit, not recorded
+
+  uint64_t tail __rte_cache_aligned;
+  uint64_t lost;                   // overwritten before drained
+
+  evlog_rec_t recs[EVLOG_RING_SIZE] __rte_cache_aligned;
+} __rte_cache_aligned evlog_lcore_t;
+
+extern evlog_lcore_t *evlog_lcores;
+extern uint32_t evlog_rate[EVLOG_MAX];  // records per second, 0 unlimited
+
+int evlog_init(void *config);
+void evlog_free(void);
+
+/** drain rings of all lcores, called by mgmt thread, return records drained */
+uint32_t evlog_drain(void);
+
+static inline void evlog_write(uint16_t event,
+                               const uint32_t args[EVLOG_MAX_ARGS]) {
+  unsigned int lcore_id = rte_lcore_id();
+  evlog_lcore_t *lc;
+  evlog_rec_t *rec;
+  uint64_t tsc, head;
+
+  if (unlikely(!evlog_lcores || (lcore_id >= MAX_WORKER_NUM))) {
+    return;
+  }
+
+  lc = &evlog_lcores[lcore_id];
+  tsc = rte_rdtsc();
+
+  // rate limit in windows of one second
+  if (tsc - lc->window[event] > rte_get_tsc_hz()) {
+    lc->window[event] = tsc;
+    lc->count[event] = 0;
+  }
+
+  if (evlog_rate[event] && (lc->count[event] >= evlog_rate[event])) {
+    lc->suppressed[event]++;
+    return;
+  }
+  lc->count[event]++;
+
+  head = lc->head;
+  rec = &lc->recs[head & (EVLOG_RING_SIZE - 1)];
+  rec->tsc = tsc;
+  rec->lcore = lcore_id;
+  rec->event = event;
+  memcpy(rec->args, args, sizeof(rec->args));
+
+  rte_smp_wmb();
+  lc->head = head + 1;
+}
+
+/** EVLOG(EVLOG_TX_FAIL, port, queue, n), missing args are zero */
+#define EVLOG(event, ...)                                                      \
+  evlog_write(event, (const uint32_t[EVLOG_MAX_ARGS]){__VA_ARGS__})
+
+#endif
+
+// file format utf-8
+// ident using space
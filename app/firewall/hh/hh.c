@@ -0,0 +1,516 @@
+#include <arpa/inet.h>
+
+#include <rte_cycles.h>
+#include <rte_hash.h>
+#include <rte_hash_crc.h>
+#include <rte_lcore.h>
+#include <rte_malloc.h>
+#include <rte_member.h>
+#include <rte_telemetry.h>
+
+#include "../cli.h"
+#include "../config.h"
+#include "../json.h"
+#include "../module.h"
+#include "../packet.h"
+#include "../stats.h"
+#include "../worker.h"
+
+#include "hh.h"
+
+MODULE_DECLARE(hh) = {.name = "hh",
+                      .id = MOD_ID_HH,
+                      .enabled = true,
+                      .log = true,
+                      .init = hh_init,
+                      .proc = hh_proc,
+                      .conf = NULL,
+                      .free = NULL,
+                      .priv = NULL,
+                      .move = hh_move,
+                      .hooks = MOD_HOOK_BIT(MOD_HOOK_INGRESS) |
+                               MOD_HOOK_BIT(MOD_HOOK_PREROUTING)};
+
+static const char *hh_stat_name[HH_STAT_MAX] = {
+  [HH_STAT_PROMOTED] = "promoted",
+  [HH_STAT_DEMOTED] = "demoted",
+  [HH_STAT_BYPASSED] = "bypassed",
+  [HH_STAT_FULL] = "bypass full",
+};
+
+static int hh_load(hh_ctx_t *ctx) {
+  json_object *jr = NULL, *jv;
+  uint64_t hz = rte_get_tsc_hz();
+  uint32_t interval = DEF_HH_INTERVAL, idle = DEF_HH_IDLE;
+
+  ctx->enabled = false;
+  ctx->top_k = DEF_HH_TOP_K;
+  ctx->bypass_num = DEF_HH_BYPASS_NUM;
+  ctx->threshold = 0;
+  ctx->error_rate = DEF_HH_ERROR_RATE;
+
+  jr = JR(CONFIG_PATH, "hh.json");
+  if (jr) {
+    jv = JV(jr, "enabled");
+    if (jv) {
+      ctx->enabled = JV_I(jv) ? true : false;
+    }
+
+    jv = JV(jr, "top_k");
+    if (jv && (JV_I(jv) > 0)) {
+      ctx->top_k = RTE_MIN(JV_I(jv), MAX_HH_TOP_K);
+    }
+
+    jv = JV(jr, "interval");
+    if (jv && (JV_I(jv) > 0)) {
+      interval = JV_I(jv);
+    }
+
+    jv = JV(jr, "threshold");
+    if (jv) {
+      ctx->threshold = JV_L(jv);
+    }
+
+    jv = JV(jr, "bypass");
+    if (jv && (JV_I(jv) > 0)) {
+      ctx->bypass_num = JV_I(jv);
+    }
+
+    jv = JV(jr, "idle");
+    if (jv && (JV_I(jv) > 0)) {
+      idle = JV_I(jv);
+    }
+
+    jv = JV(jr, "error_rate");
+    if (jv && (atof(JV_S(jv)) > 0)) {
+      ctx->error_rate = atof(JV_S(jv));
+    }
+
+    JR_FREE(jr);
+  } else {
+    printf("no heavy hitter config, heavy hitter disabled\n");
+  }
+
+  ctx->interval = hz * interval / 1000;
+  ctx->idle = hz * idle;
+
+  printf("heavy hitter enabled %d top_k %u interval %ums threshold %lu "
+         "bypass %u idle %us\n",
+         ctx->enabled, ctx->top_k, interval, ctx->threshold, ctx->bypass_num,
+         idle);
+
+  return 0;
+}
+
+static int hh_setup(config_t *config, hh_ctx_t *ctx) {
+  struct rte_member_parameters mp = {0};
+  struct rte_hash_parameters hp = {0};
+  worker_t *worker;
+  char name[RTE_MEMBER_NAMESIZE];
+  int i;
+
+  for (i = 0; i < config->worker_num; i++) {
+    hh_lcore_t *lc;
+    int socket_id;
+
+    worker = (worker_t *)config->workers + i;
+    if ((worker->role != ROLE_WORKER) && (worker->role != ROLE_RTX_WORKER)) {
+      continue;
+    }
+
+    lc = &ctx->lcores[worker->lcore_id];
+    socket_id = rte_lcore_to_socket_id(worker->lcore_id);
+
+    snprintf(name, sizeof(name), "hh-sketch-%d", worker->lcore_id);
+    mp.name = name;
+    mp.type = RTE_MEMBER_TYPE_SKETCH;
+    mp.key_len = sizeof(hh_key_t);
+    mp.error_rate = ctx->error_rate;
+    mp.sample_rate = 1;
+    mp.top_k = ctx->top_k;
+    mp.prim_hash_seed = 1;
+    mp.sec_hash_seed = 2;
+    mp.extra_flag = RTE_MEMBER_SKETCH_COUNT_BYTE;
+    mp.socket_id = socket_id;
+
+    lc->sketch = rte_member_create(&mp);
+    if (!lc->sketch) {
+      printf("create heavy hitter sketch %s failed\n", name);
+      return -1;
+    }
+
+    snprintf(name, sizeof(name), "hh-bypass-%d", worker->lcore_id);
+    hp.name = name;
+    hp.entries = ctx->bypass_num;
+    hp.key_len = sizeof(hh_key_t);
+    hp.hash_func = rte_hash_crc;
+    hp.hash_func_init_val = 0;
+    hp.socket_id = socket_id;
+
+    lc->bypass = rte_hash_create(&hp);
+    if (!lc->bypass) {
+      printf("create heavy hitter bypass table %s failed\n", name);
+      return -1;
+    }
+    stats_table_add("hh", name, worker->lcore_id, ctx->bypass_num);
+
+    lc->entries = rte_zmalloc_socket(name,
+                                     sizeof(hh_bypass_t) * ctx->bypass_num,
+                                     RTE_CACHE_LINE_SIZE, socket_id);
+    if (!lc->entries) {
+      printf("alloc heavy hitter bypass entries %s failed\n", name);
+      return -1;
+    }
+  }
+
+  return 0;
+}
+
+/** copy the latest top-k report of a lcore, return number of entries */
+static uint32_t hh_top_read(hh_lcore_t *lc, hh_top_t *top) {
+  uint32_t seq, num;
+
+  do {
+    seq = lc->seq;
+    rte_smp_rmb();
+    num = lc->top_num;
+    memcpy(top, lc->top, sizeof(hh_top_t) * num);
+    rte_smp_rmb();
+  } while ((seq & 1) || (seq != lc->seq));
+
+  return num;
+}
+
+static void hh_key_str(hh_key_t *k, char *buf, size_t len) {
+  char sip[INET6_ADDRSTRLEN], dip[INET6_ADDRSTRLEN];
+  int af = k->is_v4 ? AF_INET : AF_INET6;
+
+  inet_ntop(af, k->sip, sip, sizeof(sip));
+  inet_ntop(af, k->dip, dip, sizeof(dip));
+  snprintf(buf, len, "%s:%u > %s:%u proto %u", sip, ntohs(k->sp), dip,
+           ntohs(k->dp), k->proto);
+}
+
+static int hh_show(struct cli_def *cli, const char *command, char *argv[],
+                   int argc) {
+  config_t *c = cli_get_context(cli);
+  hh_ctx_t *ctx = c->hh_ctx;
+  hh_top_t top[MAX_HH_TOP_K];
+  char buf[128];
+  uint32_t i, j, num;
+
+  CLI_PRINT(cli, "command %s argv[0] %s argc %d", command, argv[0], argc);
+
+  if (!ctx) {
+    return 0;
+  }
+
+  CLI_PRINT(cli, "enabled: %d", ctx->enabled);
+
+  for (i = 0; i < MAX_WORKER_NUM; i++) {
+    hh_lcore_t *lc = &ctx->lcores[i];
+
+    if (!lc->sketch) {
+      continue;
+    }
+
+    CLI_PRINT(cli, "lcore %u bypass %u", i, lc->bypass_num);
+    for (j = 0; j < HH_STAT_MAX; j++) {
+      CLI_PRINT(cli, "  %s: %lu", hh_stat_name[j], lc->stats[j]);
+    }
+
+    num = hh_top_read(lc, top);
+    for (j = 0; j < num; j++) {
+      hh_key_str(&top[j].key, buf, sizeof(buf));
+      CLI_PRINT(cli, "  #%u %s bytes %lu", j + 1, buf, top[j].bytes);
+    }
+  }
+
+  return 0;
+}
+
+static int hh_telemetry(const char *cmd __rte_unused,
+                        const char *params __rte_unused, void *arg,
+                        struct rte_tel_data *d) {
+  hh_ctx_t *ctx = arg;
+  hh_top_t top[MAX_HH_TOP_K];
+  char buf[RTE_TEL_MAX_STRING_LEN], key[HH_TEL_KEY_LEN];
+  uint32_t i, j, num;
+
+  rte_tel_data_start_array(d, RTE_TEL_STRING_VAL);
+
+  for (i = 0; i < MAX_WORKER_NUM; i++) {
+    hh_lcore_t *lc = &ctx->lcores[i];
+
+    if (!lc->sketch) {
+      continue;
+    }
+
+    num = hh_top_read(lc, top);
+    for (j = 0; j < num; j++) {
+      hh_key_str(&top[j].key, key, sizeof(key));
+      snprintf(buf, sizeof(buf), "lcore %u %s bytes %lu", i, key,
+               top[j].bytes);
+      rte_tel_data_add_array_string(d, buf);
+    }
+  }
+
+  return 0;
+}
+
+static void hh_cli_register(config_t *config) {
+  struct cli_def *cli_def;
+  struct cli_command *c;
+
+  if (!config) {
+    return;
+  }
+
+  cli_def = config->cli_def;
+  if (!cli_def) {
+    return;
+  }
+
+  c = CLI_CMD_C(cli_def, NULL, "hh", NULL, "heavy hitter detection");
+  CLI_CMD_C(cli_def, c, "show", hh_show, "show top flows and bypass table");
+}
+
+int hh_init(void *config) {
+  config_t *c = config;
+  hh_ctx_t *ctx;
+  int i;
+
+  ctx = rte_zmalloc("hh_ctx", sizeof(hh_ctx_t), RTE_CACHE_LINE_SIZE);
+  if (!ctx) {
+    printf("alloc heavy hitter ctx failed\n");
+    return -1;
+  }
+
+  hh_load(ctx);
+
+  if (ctx->enabled && hh_setup(c, ctx)) {
+    for (i = 0; i < MAX_WORKER_NUM; i++) {
+      rte_member_free(ctx->lcores[i].sketch);
+      rte_hash_free(ctx->lcores[i].bypass);
+      rte_free(ctx->lcores[i].entries);
+    }
+    rte_free(ctx);
+    return -1;
+  }
+
+  c->hh_ctx = ctx;
+  hh_cli_register(c);
+  rte_telemetry_register_cmd_arg("/firewall/hh", hh_telemetry, ctx,
+                                 "Returns top flows of each worker. No parameters");
+
+  return 0;
+}
+
+static inline void hh_key(packet_t *p, hh_key_t *k) {
+  memset(k, 0, sizeof(*k));
+
+  if (p->is_v4) {
+    k->sip[0] = p->tuple.v4.sip;
+    k->dip[0] = p->tuple.v4.dip;
+    k->sp = p->tuple.v4.sp;
+    k->dp = p->tuple.v4.dp;
+    k->proto = p->tuple.v4.proto;
+    k->is_v4 = 1;
+  } else {
+    memcpy(k->sip, p->tuple.v6.sip, 16);
+    memcpy(k->dip, p->tuple.v6.dip, 16);
+    k->sp = p->tuple.v6.sp;
+    k->dp = p->tuple.v6.dp;
+    k->proto = p->tuple.v6.proto;
+  }
+}
+
+/** publish top-k of last interval, promote elephants, restart the sketch */
+static void hh_report(hh_ctx_t *ctx, hh_lcore_t *lc, uint64_t tsc) {
+  void *keys[MAX_HH_TOP_K];
+  uint64_t counts[MAX_HH_TOP_K];
+  int i, num;
+
+  num = rte_member_report_heavyhitter(lc->sketch, keys, counts);
+  if (num < 0) {
+    num = 0;
+  }
+
+  lc->seq++;
+  rte_smp_wmb();
+  for (i = 0; i < num; i++) {
+    memcpy(&lc->top[i].key, keys[i], sizeof(hh_key_t));
+    lc->top[i].bytes = counts[i];
+  }
+  lc->top_num = num;
+  rte_smp_wmb();
+  lc->seq++;
+
+  for (i = 0; ctx->threshold && (i < num); i++) {
+    int32_t pos;
+
+    if (counts[i] < ctx->threshold) {
+      break;
+    }
+
+    if (rte_hash_lookup(lc->bypass, keys[i]) >= 0) {
+      continue;
+    }
+
+    pos = rte_hash_add_key(lc->bypass, keys[i]);
+    if (pos < 0) {
+      lc->stats[HH_STAT_FULL]++;
+      continue;
+    }
+
+    lc->entries[pos].state = HH_BYPASS_LEARN;
+    lc->entries[pos].last = tsc;
+    lc->entries[pos].hits = 0;
+    lc->bypass_num++;
+  }
+
+  rte_member_reset(lc->sketch);
+}
+
+/** drop elephants gone idle, bounded scan per interval */
+static void hh_age(hh_ctx_t *ctx, hh_lcore_t *lc, uint64_t tsc) {
+  const void *key;
+  void *data;
+  int32_t pos;
+  int i;
+
+  for (i = 0; lc->bypass_num && (i < HH_AGE_BUDGET); i++) {
+    pos = rte_hash_iterate(lc->bypass, &key, &data, &lc->age_next);
+    if (pos < 0) {
+      lc->age_next = 0;
+      break;
+    }
+
+    if (lc->entries[pos].last + ctx->idle < tsc) {
+      rte_hash_del_key(lc->bypass, key);
+      lc->bypass_num--;
+      lc->stats[HH_STAT_DEMOTED]++;
+    }
+  }
+}
+
+/** bypass entries are only a cache, drop them when buckets change owner */
+int hh_move(void *config) {
+  config_t *c = config;
+  hh_ctx_t *ctx = c->hh_ctx;
+  int i;
+
+  if (!ctx || !ctx->enabled) {
+    return 0;
+  }
+
+  for (i = 0; i < MAX_WORKER_NUM; i++) {
+    hh_lcore_t *lc = &ctx->lcores[i];
+
+    if (!lc->bypass) {
+      continue;
+    }
+
+    rte_hash_reset(lc->bypass);
+    lc->stats[HH_STAT_DEMOTED] += lc->bypass_num;
+    lc->bypass_num = 0;
+    lc->age_next = 0;
+  }
+
+  return 0;
+}
+
+/** look up the bypass table before acl */
+static mod_ret_t hh_proc_ingress(config_t *config, hh_lcore_t *lc,
+                                 struct rte_mbuf *mbuf) {
+  packet_t *p = rte_mbuf_to_priv(mbuf);
+  hh_bypass_t *e;
+  hh_key_t k;
+  int32_t pos;
+
+  if (!p || !lc->bypass_num) {
+    return MOD_RET_ACCEPT;
+  }
+
+  hh_key(p, &k);
+  pos = rte_hash_lookup(lc->bypass, &k);
+  if (pos < 0) {
+    return MOD_RET_ACCEPT;
+  }
+
+  e = &lc->entries[pos];
+  e->last = rte_rdtsc();
+  e->hits++;
+
+  if ((e->state == HH_BYPASS_ACTIVE) && (e->version == config->version)) {
+    p->policer = e->policer;
+    p->flags |= PACKET_FLAG_BYPASS;
+    lc->stats[HH_STAT_BYPASSED]++;
+  } else {
+    p->flags |= PACKET_FLAG_LEARN;
+    p->bypass_id = pos + 1;
+  }
+
+  return MOD_RET_ACCEPT;
+}
+
+/** packet passed ingress, cache its verdict if asked and feed the sketch */
+static mod_ret_t hh_proc_prerouting(config_t *config, hh_ctx_t *ctx,
+                                    hh_lcore_t *lc, struct rte_mbuf *mbuf) {
+  packet_t *p = rte_mbuf_to_priv(mbuf);
+  hh_key_t k;
+  uint64_t tsc;
+
+  if (!p) {
+    return MOD_RET_ACCEPT;
+  }
+
+  if (p->flags & PACKET_FLAG_LEARN) {
+    hh_bypass_t *e = &lc->entries[p->bypass_id - 1];
+
+    e->policer = p->policer;
+    e->version = config->version;
+    e->state = HH_BYPASS_ACTIVE;
+    lc->stats[HH_STAT_PROMOTED]++;
+  }
+
+  hh_key(p, &k);
+  rte_member_add_byte_count(lc->sketch, &k, rte_pktmbuf_pkt_len(mbuf));
+
+  tsc = rte_rdtsc();
+  if (tsc >= lc->report_tsc) {
+    lc->report_tsc = tsc + ctx->interval;
+    hh_report(ctx, lc, tsc);
+    hh_age(ctx, lc, tsc);
+  }
+
+  return MOD_RET_ACCEPT;
+}
+
+mod_ret_t hh_proc(void *config, struct rte_mbuf *mbuf, mod_hook_t hook) {
+  config_t *c = config;
+  hh_ctx_t *ctx = c->hh_ctx;
+  hh_lcore_t *lc;
+
+  if (!ctx || !ctx->enabled) {
+    return MOD_RET_ACCEPT;
+  }
+
+  lc = &ctx->lcores[rte_lcore_id()];
+  if (!lc->sketch) {
+    return MOD_RET_ACCEPT;
+  }
+
+  if (hook == MOD_HOOK_INGRESS) {
+    return hh_proc_ingress(c, lc, mbuf);
+  }
+
+  if (hook == MOD_HOOK_PREROUTING) {
+    return hh_proc_prerouting(c, ctx, lc, mbuf);
+  }
+
+  return MOD_RET_ACCEPT;
+}
+
+// file format utf-8
+// ident using space
@@ -0,0 +1,94 @@
+#ifndef _M_HH_H_
+#define _M_HH_H_
+
+#include <rte_hash.h>
+#include <rte_member.h>
+
+#include "../config.h"
+#include "../module.h"
+
+#define MAX_HH_TOP_K 64
+
+#define DEF_HH_TOP_K 16
+#define DEF_HH_INTERVAL 1000          // ms
+#define DEF_HH_BYPASS_NUM 4096
+#define DEF_HH_IDLE 10                // s
+#define DEF_HH_ERROR_RATE 0.0001
+
+// bypass table aging, scan at most budget entries every report interval
+#define HH_AGE_BUDGET 256
+
+// telemetry key length, leaves room for "lcore %u " and " bytes %lu"
+#define HH_TEL_KEY_LEN (RTE_TEL_MAX_STRING_LEN - 44)
+
+typedef enum {
+  HH_BYPASS_LEARN,   // promoted, wait for next packet to cache its verdict
+  HH_BYPASS_ACTIVE,  // verdict cached, packets skip acl
+} hh_bypass_state_t;
+
+typedef enum {
+  HH_STAT_PROMOTED,
+  HH_STAT_DEMOTED,
+  HH_STAT_BYPASSED,
+  HH_STAT_FULL,
+  HH_STAT_MAX,
+} hh_stat_t;
+
+typedef struct {
+  uint32_t sip[4];
+  uint32_t dip[4];
+  uint16_t sp;
+  uint16_t dp;
+  uint8_t proto;
+  uint8_t is_v4;
+  uint8_t pad[2];
+} hh_key_t;
+
+typedef struct {
+  hh_key_t key;
+  uint64_t bytes;
+} hh_top_t;
+
+typedef struct {
+  uint32_t state;
+  uint32_t version;  // config version the verdict was cached with
+  uint16_t policer;  // cached acl police action
+  uint64_t last;     // tsc of last hit
+  uint64_t hits;
+} hh_bypass_t;
+
+/** Sketch, top-k report and bypass table are owned by one lcore. Reports are
+ * published through a sequence counter so readers never block the worker.
+ * */
+typedef struct {
+  struct rte_member_setsum *sketch;
+  struct rte_hash *bypass;
+  hh_bypass_t *entries;      // indexed by key position of bypass
+  uint32_t bypass_num;
+  uint32_t age_next;
+  uint64_t report_tsc;
+  volatile uint32_t seq;     // odd while top is being written
+  uint32_t top_num;
+  hh_top_t top[MAX_HH_TOP_K];
+  uint64_t stats[HH_STAT_MAX];
+} __rte_cache_aligned hh_lcore_t;
+
+typedef struct {
+  bool enabled;
+  uint32_t top_k;
+  uint32_t bypass_num;
+  uint64_t threshold;        // bytes per interval to promote, 0 disables
+  uint64_t interval;         // tsc
+  uint64_t idle;             // tsc
+  float error_rate;
+  hh_lcore_t lcores[MAX_WORKER_NUM];
+} hh_ctx_t;
+
+int hh_init(void *config);
+mod_ret_t hh_proc(void *config, struct rte_mbuf *mbuf, mod_hook_t hook);
+int hh_move(void *config);
+
+#endif
+
+// file format utf-8
+// ident using space
@@ -1,3 +1,5 @@
+#include <arpa/inet.h>
+
 #include <rte_ethdev.h>
 #include <rte_lcore.h>
 #include <rte_log.h>
@@ -9,6 +11,7 @@
 #include "../packet.h"
 
 #include "interface.h"
+#include "route.h"
 
 MODULE_DECLARE(interface) = {
   .name = "interface",
@@ -19,12 +22,17 @@ MODULE_DECLARE(interface) = {
   .proc = interface_proc,
   .conf = NULL,
   .free = NULL,
-  .priv = NULL
+  .priv = NULL,
+  .bulk = interface_bulk,
+  .hooks = MOD_HOOK_BIT(MOD_HOOK_PREROUTING) | MOD_HOOK_BIT(MOD_HOOK_FORWARD) |
+           MOD_HOOK_BIT(MOD_HOOK_EGRESS)
 };
 
 static int interface_type_str2int(const char *str) {
   if (!strcmp("vwire", str))
     return PORT_TYPE_VWIRE;
+  if (!strcmp("l3", str))
+    return PORT_TYPE_L3;
   return PORT_TYPE_NONE;
 }
 
@@ -100,6 +108,29 @@ static uint16_t interface_vwire_pair(interface_config_t *itfc,
   return port_in;
 }
 
+/** "addr/depth" of a l3 port, depth is required */
+static int interface_addr(const char *str, int af, void *addr,
+                          uint8_t *depth) {
+  char buf[INET6_ADDRSTRLEN] = {0};
+  const char *p;
+  int len;
+
+  p = strchr(str, '/');
+  if (!p || ((p - str) >= (int)sizeof(buf))) {
+    return -1;
+  }
+  memcpy(buf, str, p - str);
+  len = atoi(p + 1);
+
+  if ((len <= 0) || (len > ((af == AF_INET) ? 32 : 128)) ||
+      (inet_pton(af, buf, addr) != 1)) {
+    return -1;
+  }
+
+  *depth = len;
+  return 0;
+}
+
 static int interface_load(config_t *config) {
   interface_config_t *itfc = config->itf_cfg;
   json_object *jr = NULL, *ja;
@@ -147,8 +178,33 @@ static int interface_load(config_t *config) {
     INTF_JV("mac");
     sprintf(portc->mac, "%s", JV_S(jv));
 
-    INTF_JV("vwire");
-    portc->vwire = JV_I(jv);
+    if (portc->type == PORT_TYPE_VWIRE) {
+      INTF_JV("vwire");
+      portc->vwire = JV_I(jv);
+    }
+
+    // optional, checked against the nic limits at setup
+    jv = JV(jo, "rx_desc");
+    portc->rx_desc = jv ? JV_I(jv) : 0;
+    jv = JV(jo, "tx_desc");
+    portc->tx_desc = jv ? JV_I(jv) : 0;
+
+    if (portc->type == PORT_TYPE_L3) {
+      jv = JV(jo, "ip");
+      if (jv && interface_addr(JV_S(jv), AF_INET, &portc->ip, &portc->depth)) {
+        printf("parse ip of port %u failed\n", portc->id);
+        ret = -1;
+        goto done;
+      }
+
+      jv = JV(jo, "ip6");
+      if (jv &&
+          interface_addr(JV_S(jv), AF_INET6, portc->ip6, &portc->depth6)) {
+        printf("parse ip6 of port %u failed\n", portc->id);
+        ret = -1;
+        goto done;
+      }
+    }
 
     itfc->port_num++;
 
@@ -173,6 +229,147 @@ static int interface_load(config_t *config) {
   return ret;
 }
 
+/** A toeplitz key made of a repeated 16-bit pattern hashes (src, dst) and
+ * (dst, src) to the same value, so both directions of a flow land in the same
+ * queue index on every port and therefore on the same worker.
+ * */
+static uint8_t interface_rss_key[64];
+
+static void interface_rss_setup(struct rte_eth_dev_info *dev_info,
+                                struct rte_eth_conf *port_conf) {
+  uint16_t i;
+
+  for (i = 0; i < sizeof(interface_rss_key); i += 2) {
+    interface_rss_key[i] = 0x6d;
+    interface_rss_key[i + 1] = 0x5a;
+  }
+
+  port_conf->rx_adv_conf.rss_conf.rss_hf =
+      (RTE_ETH_RSS_IP | RTE_ETH_RSS_TCP | RTE_ETH_RSS_UDP) &
+      dev_info->flow_type_rss_offloads;
+
+  // rx dispatches to workers by the hash, see worker_dispatch_update
+  if (dev_info->rx_offload_capa & RTE_ETH_RX_OFFLOAD_RSS_HASH) {
+    port_conf->rxmode.offloads |= RTE_ETH_RX_OFFLOAD_RSS_HASH;
+  }
+
+  if (dev_info->hash_key_size &&
+      (dev_info->hash_key_size <= sizeof(interface_rss_key))) {
+    port_conf->rx_adv_conf.rss_conf.rss_key = interface_rss_key;
+    port_conf->rx_adv_conf.rss_conf.rss_key_len = dev_info->hash_key_size;
+  } else {
+    port_conf->rx_adv_conf.rss_conf.rss_key = NULL;
+    port_conf->rx_adv_conf.rss_conf.rss_key_len = 0;
+  }
+}
+
+static port_config_t *interface_port(interface_config_t *itfc,
+                                     uint16_t port_id) {
+  int i;
+
+  for (i = 0; i < itfc->port_num; i++) {
+    if (itfc->ports[i].id == port_id) {
+      return &itfc->ports[i];
+    }
+  }
+  return NULL;
+}
+
+static int interface_desc_check(const struct rte_eth_desc_lim *lim,
+                                uint16_t nb) {
+  return (nb < lim->nb_min) || (nb > lim->nb_max) ||
+         (lim->nb_align && (nb % lim->nb_align));
+}
+
+/** Descriptors of every port are settled against the nic limits before any
+ * port is configured. The mbuf pool then covers everything that holds mbufs
+ * at the same time: rx and tx descriptors, work, tx and ctrl rings, bursts
+ * in flight and the cache of each lcore, so a full ring never starves rx.
+ * */
+static int interface_pool_create(config_t *c) {
+  interface_config_t *itfc = c->itf_cfg;
+  struct rte_eth_dev_info dev_info;
+  port_config_t *portc;
+  uint16_t port_id, nb_rx, nb_tx;
+  uint32_t mbuf_num = 0;
+  int i, j;
+
+  RTE_ETH_FOREACH_DEV(port_id) {
+    if (port_id >= MAX_PORT_NUM) {
+      printf("port %u out of range\n", port_id);
+      return -1;
+    }
+
+    if (rte_eth_dev_info_get(port_id, &dev_info)) {
+      printf("rte eth dev info get failed\n");
+      return -1;
+    }
+
+    portc = interface_port(itfc, port_id);
+    nb_rx = (portc && portc->rx_desc) ? portc->rx_desc : DEF_RX_DESC_NUM;
+    nb_tx = (portc && portc->tx_desc) ? portc->tx_desc : DEF_TX_DESC_NUM;
+
+    // configured counts must fit, defaults are adjusted silently
+    if (portc && portc->rx_desc &&
+        interface_desc_check(&dev_info.rx_desc_lim, nb_rx)) {
+      printf("port %u rx desc %u out of [%u, %u] align %u\n", port_id, nb_rx,
+             dev_info.rx_desc_lim.nb_min, dev_info.rx_desc_lim.nb_max,
+             dev_info.rx_desc_lim.nb_align);
+      return -1;
+    }
+    if (portc && portc->tx_desc &&
+        interface_desc_check(&dev_info.tx_desc_lim, nb_tx)) {
+      printf("port %u tx desc %u out of [%u, %u] align %u\n", port_id, nb_tx,
+             dev_info.tx_desc_lim.nb_min, dev_info.tx_desc_lim.nb_max,
+             dev_info.tx_desc_lim.nb_align);
+      return -1;
+    }
+    if (rte_eth_dev_adjust_nb_rx_tx_desc(port_id, &nb_rx, &nb_tx)) {
+      printf("port %u adjust desc failed\n", port_id);
+      return -1;
+    }
+
+    itfc->rx_desc[port_id] = nb_rx;
+    itfc->tx_desc[port_id] = nb_tx;
+    mbuf_num += c->port_rxq_num * nb_rx + c->txq_num * nb_tx;
+
+    printf("port %u rx desc %u tx desc %u\n", port_id, nb_rx, nb_tx);
+  }
+
+  for (i = 0; i < c->rxq_num; i++) {
+    mbuf_num += rte_ring_get_capacity(c->rx_queues[i]);
+  }
+  for (i = 0; i < MAX_PORT_NUM; i++) {
+    for (j = 0; j < MAX_QUEUE_NUM; j++) {
+      if (c->tx_queues[i][j]) {
+        mbuf_num += rte_ring_get_capacity(c->tx_queues[i][j]);
+      }
+    }
+    if (c->ctrl_queues[i]) {
+      mbuf_num += rte_ring_get_capacity(c->ctrl_queues[i]);
+    }
+  }
+
+  // a cache may grow to 1.5 times its size before flushing
+  mbuf_num += rte_lcore_count() *
+              (DEF_POOL_CACHE * 3 / 2 + DEF_POOL_BURSTS * MAX_PKT_BURST);
+
+  // mempool ring is a power of 2, one slot is never used
+  mbuf_num = rte_align32pow2(mbuf_num + 1) - 1;
+  printf("mbuf pool size %u\n", mbuf_num);
+
+  c->pktmbuf_pool = rte_pktmbuf_pool_create("mbuf_pool", mbuf_num,
+                                            DEF_POOL_CACHE, sizeof(packet_t),
+                                            RTE_MBUF_DEFAULT_BUF_SIZE,
+                                            rte_socket_id());
+  if (!c->pktmbuf_pool) {
+    printf("create pktmbuf pool failed\n");
+    return -1;
+  }
+
+  return 0;
+}
+
 static int interface_setup(config_t *config) {
   struct rte_eth_dev_info dev_info;
   struct rte_eth_conf port_conf;
@@ -187,31 +384,43 @@ static int interface_setup(config_t *config) {
 
   c->queue_num = 0;
 
+  if (!c->pktmbuf_pool && interface_pool_create(c)) {
+    return -1;
+  }
+
   RTE_ETH_FOREACH_DEV(port_id) {
+    interface_config_t *itfc = c->itf_cfg;
+
     ret = rte_eth_dev_info_get(port_id, &dev_info);
     if (ret) {
       printf("rte eth dev info get failed\n");
       return -1;
     }
 
-    if ((c->txq_num > dev_info.max_tx_queues)
-    || (c->txq_num > dev_info.max_rx_queues)) {
+    // rx queues follow the queues lcores read, tx queues the tx lcores
+    if ((c->port_rxq_num > dev_info.max_rx_queues) || !c->port_rxq_num) {
+      printf("worker rx queue num out of range\n");
+      return -1;
+    }
+    if ((c->txq_num > dev_info.max_tx_queues) || !c->txq_num) {
       printf("worker tx queue num out of range\n");
       return -1;
     }
-    c->queue_num = c->txq_num;
+    c->queue_num = c->port_rxq_num;
+
+    interface_rss_setup(&dev_info, &port_conf);
 
-    ret = rte_eth_dev_configure(port_id, c->queue_num, c->queue_num, &port_conf);
+    ret = rte_eth_dev_configure(port_id, c->port_rxq_num, c->txq_num, &port_conf);
     if (ret < 0) {
       printf("rte eth dev configure failed\n");
       return -1;
     }
 
-    for (i = 0; i < c->queue_num; i++) {
+    for (i = 0; i < c->port_rxq_num; i++) {
       ret = rte_eth_rx_queue_setup(
         port_id, 
         i, 
-        DEF_RX_DESC_NUM, 
+        itfc->rx_desc[port_id],
         rte_eth_dev_socket_id(port_id),
         &dev_info.default_rxconf, 
         c->pktmbuf_pool
@@ -222,11 +431,11 @@ static int interface_setup(config_t *config) {
       }
     }
 
-    for (i = 0; i < c->queue_num; i++) {
+    for (i = 0; i < c->txq_num; i++) {
       ret = rte_eth_tx_queue_setup(
         port_id, 
         i, 
-        DEF_TX_DESC_NUM,
+        itfc->tx_desc[port_id],
         rte_eth_dev_socket_id(port_id),
         &dev_info.default_txconf
       );
@@ -242,6 +451,13 @@ static int interface_setup(config_t *config) {
       return -1;
     }
 
+    // source mac of routed packets
+    if ((port_id < MAX_PORT_NUM) &&
+        rte_eth_macaddr_get(port_id, &itfc->ports[port_id].ea)) {
+      printf("get mac of port %u failed\n", port_id);
+      return -1;
+    }
+
     ret = rte_eth_dev_start(port_id);
     if (ret < 0) {
       printf("port startup failed\n");
@@ -289,6 +505,12 @@ int interface_init(void *config) {
     goto done;
   }
 
+  ret = route_init(c);
+  if (ret) {
+    printf("route init failed\n");
+    goto done;
+  }
+
   ret = 0;
 
 done:
@@ -312,10 +534,18 @@ static int interface_proc_prerouting(config_t *config, struct rte_mbuf *mbuf) {
   }
 
   port_in = p->port_in;
+  p->nh = 0;
   switch (itfc->ports[port_in].type) {
   case PORT_TYPE_VWIRE:
     p->port_out = interface_vwire_pair(itfc, port_in);
     break;
+  case PORT_TYPE_L3:
+    // output port is chosen by route lookup at forward
+    p->port_out = port_in;
+    if (route_input(config, mbuf)) {
+      return -1;
+    }
+    break;
   default:
     break;
   }
@@ -324,10 +554,37 @@ static int interface_proc_prerouting(config_t *config, struct rte_mbuf *mbuf) {
 }
 
 mod_ret_t interface_proc(void *config, struct rte_mbuf *mbuf, mod_hook_t hook) {
-  if (hook == MOD_HOOK_PREROUTING)
-    interface_proc_prerouting(config, mbuf);
+  if (hook == MOD_HOOK_PREROUTING) {
+    if (interface_proc_prerouting(config, mbuf))
+      return MOD_RET_STOLEN;
+    return MOD_RET_ACCEPT;
+  }
+
+  if (interface_bulk(config, &mbuf, 1, hook) == 0)
+    return MOD_RET_STOLEN;
   return MOD_RET_ACCEPT;
 }
 
+/** route lookup and l2 rewrite of l3 ports work on the whole burst */
+uint16_t interface_bulk(void *config, struct rte_mbuf **mbufs, uint16_t n,
+                        mod_hook_t hook) {
+  uint16_t i, k;
+
+  switch (hook) {
+  case MOD_HOOK_PREROUTING:
+    for (i = 0, k = 0; i < n; i++) {
+      if (!interface_proc_prerouting(config, mbufs[i]))
+        mbufs[k++] = mbufs[i];
+    }
+    return k;
+  case MOD_HOOK_FORWARD:
+    return route_lookup(config, mbufs, n);
+  case MOD_HOOK_EGRESS:
+    return route_rewrite(config, mbufs, n);
+  default:
+    return n;
+  }
+}
+
 // file-format: utf-8
 // ident using spaces
\ No newline at end of file
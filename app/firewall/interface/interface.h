@@ -1,17 +1,24 @@
 #ifndef _M_INTERFACE_H_
 #define _M_INTERFACE_H_
 
+#include <rte_ether.h>
+
 #include "../module.h"
 
 #define MAX_PORT_NUM 32
 
-// default rx and tx descriptor number
+// default rx and tx descriptor number, adjusted to the nic limits
 #define DEF_RX_DESC_NUM 512
 #define DEF_TX_DESC_NUM 512
 
+// mbuf pool is sized at setup, see interface_pool_create
+#define DEF_POOL_CACHE 256
+#define DEF_POOL_BURSTS 2  // bursts held outside of rings by each lcore
+
 typedef enum {
   PORT_TYPE_NONE,
   PORT_TYPE_VWIRE,
+  PORT_TYPE_L3,     // routed, packets are forwarded by route table
 } port_type_t;
 
 typedef struct {
@@ -20,6 +27,15 @@ typedef struct {
   char bus[16];
   char mac[32];
   uint16_t vwire;
+  uint16_t rx_desc;  // 0 for default
+  uint16_t tx_desc;
+
+  // l3 only, addresses in network order, depth 0 for none
+  uint32_t ip;
+  uint8_t depth;
+  uint8_t ip6[16];
+  uint8_t depth6;
+  struct rte_ether_addr ea;  // mac of the nic, source of routed packets
 } port_config_t;
 
 typedef struct {
@@ -33,11 +49,16 @@ typedef struct {
   vwire_pair_t *vwire_pairs;
   uint16_t port_num;
   uint16_t vwire_pair_num;
+  uint16_t rx_desc[MAX_PORT_NUM];  // in use, by port id
+  uint16_t tx_desc[MAX_PORT_NUM];
+  void *route;  // route_ctx_t, l3 ports only
   void *priv;
 } interface_config_t;
 
 int interface_init(void *config);
 mod_ret_t interface_proc(void *config, struct rte_mbuf *mbuf, mod_hook_t hook);
+uint16_t interface_bulk(void *config, struct rte_mbuf **mbufs, uint16_t n,
+                        mod_hook_t hook);
 
 #endif
 
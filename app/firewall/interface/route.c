@@ -0,0 +1,1082 @@
+#include <arpa/inet.h>
+
+#include <rte_arp.h>
+#include <rte_cycles.h>
+#include <rte_ethdev.h>
+#include <rte_hash_crc.h>
+#include <rte_ip.h>
+#include <rte_lcore.h>
+#include <rte_malloc.h>
+#include <rte_rib.h>
+#include <rte_rib6.h>
+#include <rte_ring.h>
+
+#include "../cli.h"
+#include "../config.h"
+#include "../json.h"
+#include "../module.h"
+#include "../packet.h"
+#include "../worker.h"
+
+#include "../capture/capture.h"
+#include "interface.h"
+#include "route.h"
+
+#define ROUTE_ND_NS 135
+#define ROUTE_ND_NA 136
+#define ROUTE_ND_OPT_SLLA 1
+#define ROUTE_ND_OPT_TLLA 2
+#define ROUTE_ND_NA_FLAGS 0x60000000  // solicited, override
+
+// neighbor solicitation and advertisement with a link layer address option
+#pragma pack(1)
+
+typedef struct {
+  uint8_t type;
+  uint8_t code;
+  uint16_t cksum;
+  uint32_t flags;
+  uint8_t target[16];
+  uint8_t opt_type;
+  uint8_t opt_len;  // in 8 bytes
+  uint8_t opt_mac[RTE_ETHER_ADDR_LEN];
+} route_nd_t;
+
+#pragma pack()
+
+static const char *route_stat_name[ROUTE_STAT_MAX] = {
+  [ROUTE_STAT_FORWARD] = "forward",
+  [ROUTE_STAT_NO_ROUTE] = "no route",
+  [ROUTE_STAT_LOCAL] = "local",
+  [ROUTE_STAT_TTL_EXCEEDED] = "ttl exceeded",
+  [ROUTE_STAT_NEIGH_MISS] = "neighbor miss",
+  [ROUTE_STAT_ARP] = "arp",
+  [ROUTE_STAT_ND] = "nd",
+  [ROUTE_STAT_SOLICIT] = "solicit",
+  [ROUTE_STAT_TX_FAIL] = "tx fail",
+};
+
+static inline route_ctx_t *route_ctx(config_t *config) {
+  interface_config_t *itfc = config->itf_cfg;
+
+  return itfc ? itfc->route : NULL;
+}
+
+static inline port_config_t *route_port(config_t *config, uint16_t port) {
+  interface_config_t *itfc = config->itf_cfg;
+
+  return (port < MAX_PORT_NUM) ? &itfc->ports[port] : NULL;
+}
+
+/** next hops and neighbors only live on configured l3 ports, the datapath
+ * uses the port without checking it */
+static inline bool route_port_l3(config_t *config, int port) {
+  interface_config_t *itfc = config->itf_cfg;
+
+  return (port >= 0) && (port < itfc->port_num) &&
+         (itfc->ports[port].type == PORT_TYPE_L3);
+}
+
+/** "a.b.c.d/n" or "x::y/n", a missing depth means a host */
+static int route_prefix(const char *str, uint8_t ip[16], uint8_t *depth,
+                        bool *is_v4) {
+  char buf[INET6_ADDRSTRLEN] = {0};
+  const char *p;
+  int len = -1;
+
+  p = strchr(str, '/');
+  if (p) {
+    if ((p - str) >= (int)sizeof(buf)) {
+      return -1;
+    }
+    memcpy(buf, str, p - str);
+    len = atoi(p + 1);
+  } else {
+    snprintf(buf, sizeof(buf), "%s", str);
+  }
+
+  memset(ip, 0, 16);
+  if (inet_pton(AF_INET, buf, ip) == 1) {
+    *is_v4 = true;
+    *depth = (len < 0) ? 32 : len;
+    return (*depth > 32) ? -1 : 0;
+  }
+
+  if (inet_pton(AF_INET6, buf, ip) == 1) {
+    *is_v4 = false;
+    *depth = (len < 0) ? 128 : len;
+    return (*depth > 128) ? -1 : 0;
+  }
+
+  return -1;
+}
+
+static inline uint32_t route_ip4(const uint8_t ip[16]) {
+  uint32_t v;
+
+  memcpy(&v, ip, sizeof(v));
+  return v;
+}
+
+static void route_ntop(const uint8_t ip[16], bool is_v4, char *buf,
+                       size_t len) {
+  inet_ntop(is_v4 ? AF_INET : AF_INET6, ip, buf, len);
+}
+
+/** find or create the next hop, return its index, -1 if table is full */
+static int route_nh_get(route_ctx_t *ctx, uint16_t port, bool is_v4,
+                        const uint8_t gw[16], bool direct) {
+  route_nh_t *nh;
+  uint32_t i;
+
+  for (i = ROUTE_NH_LOCAL + 1; i < ctx->nh_num; i++) {
+    nh = &ctx->nhs[i];
+    if ((nh->port == port) && (nh->is_v4 == is_v4) &&
+        (nh->direct == direct) && !memcmp(nh->gw, gw, sizeof(nh->gw))) {
+      return i;
+    }
+  }
+
+  if (ctx->nh_num == MAX_ROUTE_NH_NUM) {
+    printf("too many next hops\n");
+    return -1;
+  }
+
+  nh = &ctx->nhs[ctx->nh_num];
+  nh->port = port;
+  nh->is_v4 = is_v4;
+  nh->direct = direct;
+  memcpy(nh->gw, gw, sizeof(nh->gw));
+
+  // published before any route refers to it
+  rte_smp_wmb();
+  return ctx->nh_num++;
+}
+
+static int route_add(route_ctx_t *ctx, const uint8_t ip[16], uint8_t depth,
+                     bool is_v4, uint64_t nh) {
+  if (is_v4) {
+    return rte_fib_add(ctx->fib, rte_be_to_cpu_32(route_ip4(ip)), depth, nh);
+  }
+
+  return rte_fib6_add(ctx->fib6, (const struct rte_ipv6_addr *)ip, depth, nh);
+}
+
+static int route_del(route_ctx_t *ctx, const uint8_t ip[16], uint8_t depth,
+                     bool is_v4) {
+  if (is_v4) {
+    return rte_fib_delete(ctx->fib, rte_be_to_cpu_32(route_ip4(ip)), depth);
+  }
+
+  return rte_fib6_delete(ctx->fib6, (const struct rte_ipv6_addr *)ip, depth);
+}
+
+static inline void route_neigh_key(route_neigh_key_t *k, uint16_t port,
+                                   bool is_v4, const void *ip) {
+  memset(k, 0, sizeof(*k));
+  memcpy(k->ip, ip, is_v4 ? 4 : 16);
+  k->port = port;
+  k->is_v4 = is_v4;
+}
+
+/** the mac is the data of the key, an update is a single atomic store */
+static int route_neigh_set(route_ctx_t *ctx, uint16_t port, bool is_v4,
+                           const void *ip, const uint8_t *ea) {
+  route_neigh_key_t k;
+  uint64_t mac = 0;
+
+  route_neigh_key(&k, port, is_v4, ip);
+  memcpy(&mac, ea, RTE_ETHER_ADDR_LEN);
+
+  return rte_hash_add_key_data(ctx->neigh, &k, (void *)(uintptr_t)mac);
+}
+
+static int route_connected(config_t *config, route_ctx_t *ctx) {
+  interface_config_t *itfc = config->itf_cfg;
+  uint8_t zero[16] = {0}, ip[16];
+  port_config_t *portc;
+  int i, nh;
+
+  for (i = 0; i < itfc->port_num; i++) {
+    portc = &itfc->ports[i];
+    if (portc->type != PORT_TYPE_L3) {
+      continue;
+    }
+
+    if (portc->depth) {
+      memset(ip, 0, sizeof(ip));
+      memcpy(ip, &portc->ip, sizeof(portc->ip));
+
+      nh = route_nh_get(ctx, portc->id, true, zero, true);
+      if ((nh < 0) || route_add(ctx, ip, portc->depth, true, nh) ||
+          route_add(ctx, ip, 32, true, ROUTE_NH_LOCAL)) {
+        printf("add connected route of port %u failed\n", portc->id);
+        return -1;
+      }
+    }
+
+    if (portc->depth6) {
+      nh = route_nh_get(ctx, portc->id, false, zero, true);
+      if ((nh < 0) || route_add(ctx, portc->ip6, portc->depth6, false, nh) ||
+          route_add(ctx, portc->ip6, 128, false, ROUTE_NH_LOCAL)) {
+        printf("add connected route6 of port %u failed\n", portc->id);
+        return -1;
+      }
+    }
+  }
+
+  return 0;
+}
+
+static int route_load(config_t *config, route_ctx_t *ctx) {
+  json_object *jr, *ja, *jo, *jv;
+  struct rte_ether_addr ea;
+  uint8_t ip[16], gw[16], depth, gw_depth;
+  bool is_v4, gw_v4;
+  int i, num, nh, port;
+
+  jr = JR(CONFIG_PATH, "route.json");
+  if (!jr) {
+    printf("no route config, connected routes only\n");
+    return 0;
+  }
+
+  num = JA(jr, "routes", &ja);
+  for (i = 0; i < num; i++) {
+    jo = JO(ja, i);
+    jv = JV(jo, "prefix");
+    if (!jv || route_prefix(JV_S(jv), ip, &depth, &is_v4)) {
+      printf("invalid route %d ignored\n", i);
+      continue;
+    }
+
+    jv = JV(jo, "port");
+    if (!jv) {
+      printf("route %d without port ignored\n", i);
+      continue;
+    }
+    port = JV_I(jv);
+    if (!route_port_l3(config, port)) {
+      printf("route %d to port %d which is not l3 ignored\n", i, port);
+      continue;
+    }
+
+    memset(gw, 0, sizeof(gw));
+    jv = JV(jo, "via");
+    if (jv && (route_prefix(JV_S(jv), gw, &gw_depth, &gw_v4) ||
+               (gw_v4 != is_v4))) {
+      printf("invalid gateway of route %d ignored\n", i);
+      continue;
+    }
+
+    nh = route_nh_get(ctx, port, is_v4, gw, !jv);
+    if ((nh < 0) || route_add(ctx, ip, depth, is_v4, nh)) {
+      printf("add route %d failed\n", i);
+    }
+  }
+
+  num = JA(jr, "neighbors", &ja);
+  for (i = 0; i < num; i++) {
+    jo = JO(ja, i);
+    jv = JV(jo, "ip");
+    if (!jv || route_prefix(JV_S(jv), ip, &depth, &is_v4)) {
+      printf("invalid neighbor %d ignored\n", i);
+      continue;
+    }
+
+    jv = JV(jo, "mac");
+    if (!jv || rte_ether_unformat_addr(JV_S(jv), &ea)) {
+      printf("invalid mac of neighbor %d ignored\n", i);
+      continue;
+    }
+
+    jv = JV(jo, "port");
+    if (!jv) {
+      printf("neighbor %d without port ignored\n", i);
+      continue;
+    }
+    port = JV_I(jv);
+    if (!route_port_l3(config, port)) {
+      printf("neighbor %d on port %d which is not l3 ignored\n", i, port);
+      continue;
+    }
+
+    if (route_neigh_set(ctx, port, is_v4, ip, ea.addr_bytes)) {
+      printf("add neighbor %d failed\n", i);
+    }
+  }
+
+  JR_FREE(jr);
+  return 0;
+}
+
+static void route_send(config_t *config, route_lcore_t *lc,
+                       struct rte_mbuf *mbuf, uint16_t port) {
+  if (!config->ctrl_queues[port] ||
+      rte_ring_enqueue(config->ctrl_queues[port], mbuf)) {
+    lc->stats[ROUTE_STAT_TX_FAIL]++;
+    rte_pktmbuf_free(mbuf);
+  }
+}
+
+/** answer requests for the address of the port in place, learn senders of
+ * requests to us and of replies, only from the subnet of the port
+ * */
+static void route_arp(config_t *config, route_ctx_t *ctx, route_lcore_t *lc,
+                      struct rte_mbuf *mbuf, port_config_t *portc) {
+  struct rte_ether_hdr *eh;
+  struct rte_arp_hdr *ah;
+  uint32_t mask;
+  uint16_t op;
+
+  lc->stats[ROUTE_STAT_ARP]++;
+
+  if (!portc->depth ||
+      (rte_pktmbuf_data_len(mbuf) < mbuf->l2_len + sizeof(*ah))) {
+    goto free;
+  }
+
+  ah = rte_pktmbuf_mtod_offset(mbuf, struct rte_arp_hdr *, mbuf->l2_len);
+  if ((ah->arp_hardware != rte_cpu_to_be_16(RTE_ARP_HRD_ETHER)) ||
+      (ah->arp_protocol != rte_cpu_to_be_16(RTE_ETHER_TYPE_IPV4))) {
+    goto free;
+  }
+
+  op = rte_be_to_cpu_16(ah->arp_opcode);
+  mask = rte_cpu_to_be_32(~0U << (32 - portc->depth));
+  if ((((ah->arp_data.arp_sip ^ portc->ip) & mask) == 0) &&
+      ((op == RTE_ARP_OP_REPLY) ||
+       ((op == RTE_ARP_OP_REQUEST) && (ah->arp_data.arp_tip == portc->ip)))) {
+    route_neigh_set(ctx, portc->id, true, &ah->arp_data.arp_sip,
+                    ah->arp_data.arp_sha.addr_bytes);
+  }
+
+  if ((op != RTE_ARP_OP_REQUEST) || (ah->arp_data.arp_tip != portc->ip)) {
+    goto free;
+  }
+
+  ah->arp_opcode = rte_cpu_to_be_16(RTE_ARP_OP_REPLY);
+  ah->arp_data.arp_tha = ah->arp_data.arp_sha;
+  ah->arp_data.arp_tip = ah->arp_data.arp_sip;
+  ah->arp_data.arp_sha = portc->ea;
+  ah->arp_data.arp_sip = portc->ip;
+
+  eh = rte_pktmbuf_mtod(mbuf, struct rte_ether_hdr *);
+  eh->dst_addr = eh->src_addr;
+  eh->src_addr = portc->ea;
+
+  route_send(config, lc, mbuf, portc->id);
+  return;
+
+free:
+  rte_pktmbuf_free(mbuf);
+}
+
+/** answer solicitations for the address of the port in place, learn from
+ * link layer address options
+ * */
+static void route_nd(config_t *config, route_ctx_t *ctx, route_lcore_t *lc,
+                     struct rte_mbuf *mbuf, port_config_t *portc) {
+  struct rte_ether_hdr *eh;
+  struct rte_ipv6_hdr *ip6h;
+  route_nd_t *nd;
+  uint32_t len;
+
+  lc->stats[ROUTE_STAT_ND]++;
+
+  if (!portc->depth6 || (mbuf->l3_len != sizeof(*ip6h)) ||
+      (rte_pktmbuf_data_len(mbuf) < mbuf->l2_len + mbuf->l3_len + sizeof(*nd))) {
+    goto free;
+  }
+
+  ip6h = rte_pktmbuf_mtod_offset(mbuf, struct rte_ipv6_hdr *, mbuf->l2_len);
+  nd = rte_pktmbuf_mtod_offset(mbuf, route_nd_t *,
+                               mbuf->l2_len + mbuf->l3_len);
+
+  // nd from beyond the link is forged, see rfc 4861
+  if ((ip6h->hop_limits != 255) || nd->code) {
+    goto free;
+  }
+
+  if (nd->type == ROUTE_ND_NA) {
+    if (nd->opt_type == ROUTE_ND_OPT_TLLA) {
+      route_neigh_set(ctx, portc->id, false, nd->target, nd->opt_mac);
+    }
+    goto free;
+  }
+
+  if (memcmp(nd->target, portc->ip6, sizeof(nd->target))) {
+    goto free;
+  }
+
+  // duplicate address detection comes from the unspecified address
+  if (rte_ipv6_addr_is_unspec(&ip6h->src_addr) ||
+      (nd->opt_type != ROUTE_ND_OPT_SLLA)) {
+    goto free;
+  }
+  route_neigh_set(ctx, portc->id, false, &ip6h->src_addr, nd->opt_mac);
+
+  nd->type = ROUTE_ND_NA;
+  nd->code = 0;
+  nd->flags = rte_cpu_to_be_32(ROUTE_ND_NA_FLAGS);
+  nd->opt_type = ROUTE_ND_OPT_TLLA;
+  nd->opt_len = 1;
+  memcpy(nd->opt_mac, portc->ea.addr_bytes, RTE_ETHER_ADDR_LEN);
+
+  ip6h->dst_addr = ip6h->src_addr;
+  memcpy(&ip6h->src_addr, portc->ip6, sizeof(ip6h->src_addr));
+  ip6h->payload_len = rte_cpu_to_be_16(sizeof(*nd));
+  ip6h->hop_limits = 255;
+  nd->cksum = 0;
+  nd->cksum = rte_ipv6_udptcp_cksum(ip6h, nd);
+
+  eh = rte_pktmbuf_mtod(mbuf, struct rte_ether_hdr *);
+  eh->dst_addr = eh->src_addr;
+  eh->src_addr = portc->ea;
+
+  len = mbuf->l2_len + mbuf->l3_len + sizeof(*nd);
+  rte_pktmbuf_trim(mbuf, rte_pktmbuf_pkt_len(mbuf) - len);
+
+  route_send(config, lc, mbuf, portc->id);
+  return;
+
+free:
+  rte_pktmbuf_free(mbuf);
+}
+
+/** arp request or neighbor solicitation for an unresolved next hop, rate
+ * limited per lcore so a burst to a dead neighbor does not flood the link
+ * */
+static void route_solicit(config_t *config, route_lcore_t *lc, uint16_t port,
+                          bool is_v4, const uint8_t ip[16]) {
+  port_config_t *portc = route_port(config, port);
+  struct rte_ether_hdr *eh;
+  struct rte_mbuf *mbuf;
+  uint64_t tsc = rte_rdtsc();
+
+  if (!portc || (is_v4 ? !portc->depth : !portc->depth6)) {
+    return;
+  }
+
+  if (tsc - lc->solicit_window > rte_get_tsc_hz()) {
+    lc->solicit_window = tsc;
+    lc->solicit_count = 0;
+  }
+  if (lc->solicit_count >= ROUTE_SOLICIT_RATE) {
+    return;
+  }
+  lc->solicit_count++;
+
+  mbuf = rte_pktmbuf_alloc(config->pktmbuf_pool);
+  if (!mbuf) {
+    return;
+  }
+
+  eh = rte_pktmbuf_mtod(mbuf, struct rte_ether_hdr *);
+  eh->src_addr = portc->ea;
+
+  if (is_v4) {
+    struct rte_arp_hdr *ah = (struct rte_arp_hdr *)(eh + 1);
+
+    memset(&eh->dst_addr, 0xff, sizeof(eh->dst_addr));
+    eh->ether_type = rte_cpu_to_be_16(RTE_ETHER_TYPE_ARP);
+
+    ah->arp_hardware = rte_cpu_to_be_16(RTE_ARP_HRD_ETHER);
+    ah->arp_protocol = rte_cpu_to_be_16(RTE_ETHER_TYPE_IPV4);
+    ah->arp_hlen = RTE_ETHER_ADDR_LEN;
+    ah->arp_plen = sizeof(uint32_t);
+    ah->arp_opcode = rte_cpu_to_be_16(RTE_ARP_OP_REQUEST);
+    ah->arp_data.arp_sha = portc->ea;
+    ah->arp_data.arp_sip = portc->ip;
+    memset(&ah->arp_data.arp_tha, 0, sizeof(ah->arp_data.arp_tha));
+    ah->arp_data.arp_tip = route_ip4(ip);
+
+    mbuf->data_len = RTE_ETHER_MIN_LEN - RTE_ETHER_CRC_LEN;
+    memset((uint8_t *)(ah + 1), 0,
+           mbuf->data_len - sizeof(*eh) - sizeof(*ah));
+  } else {
+    struct rte_ipv6_hdr *ip6h = (struct rte_ipv6_hdr *)(eh + 1);
+    route_nd_t *nd = (route_nd_t *)(ip6h + 1);
+
+    ip6h->vtc_flow = rte_cpu_to_be_32(6 << 28);
+    ip6h->payload_len = rte_cpu_to_be_16(sizeof(*nd));
+    ip6h->proto = IPPROTO_ICMPV6;
+    ip6h->hop_limits = 255;
+    memcpy(&ip6h->src_addr, portc->ip6, sizeof(ip6h->src_addr));
+    rte_ipv6_solnode_from_addr(&ip6h->dst_addr,
+                               (const struct rte_ipv6_addr *)ip);
+
+    rte_ether_mcast_from_ipv6(&eh->dst_addr, &ip6h->dst_addr);
+    eh->ether_type = rte_cpu_to_be_16(RTE_ETHER_TYPE_IPV6);
+
+    nd->type = ROUTE_ND_NS;
+    nd->code = 0;
+    nd->flags = 0;
+    memcpy(nd->target, ip, sizeof(nd->target));
+    nd->opt_type = ROUTE_ND_OPT_SLLA;
+    nd->opt_len = 1;
+    memcpy(nd->opt_mac, portc->ea.addr_bytes, RTE_ETHER_ADDR_LEN);
+    nd->cksum = 0;
+    nd->cksum = rte_ipv6_udptcp_cksum(ip6h, nd);
+
+    mbuf->data_len = sizeof(*eh) + sizeof(*ip6h) + sizeof(*nd);
+  }
+
+  mbuf->pkt_len = mbuf->data_len;
+  lc->stats[ROUTE_STAT_SOLICIT]++;
+  route_send(config, lc, mbuf, port);
+}
+
+static inline void route_drop(config_t *config, route_lcore_t *lc,
+                              struct rte_mbuf *mbuf, route_stat_t stat) {
+  lc->stats[stat]++;
+  capture_drop(config, mbuf, MOD_ID_INTERFACE);
+  rte_pktmbuf_free(mbuf);
+}
+
+/** destination of the outermost ip header, routing never looks inside a
+ * tunnel
+ * */
+static inline bool route_dst(packet_t *p, const uint8_t **dst) {
+  if (p->tunnel != PACKET_TUNNEL_NONE) {
+    *dst = p->outer_is_v4 ? (const uint8_t *)&p->outer.v4.dip
+                          : (const uint8_t *)p->outer.v6.dip;
+    return p->outer_is_v4;
+  }
+
+  *dst = p->is_v4 ? (const uint8_t *)&p->tuple.v4.dip
+                  : (const uint8_t *)p->tuple.v6.dip;
+  return p->is_v4;
+}
+
+int route_input(config_t *config, struct rte_mbuf *mbuf) {
+  route_ctx_t *ctx = route_ctx(config);
+  packet_t *p = rte_mbuf_to_priv(mbuf);
+  port_config_t *portc;
+  route_lcore_t *lc;
+  uint16_t type;
+  uint8_t icmp;
+
+  if (!ctx || (mbuf->l2_len < sizeof(struct rte_ether_hdr))) {
+    return 0;
+  }
+
+  portc = route_port(config, p->port_in);
+  lc = &ctx->lcores[rte_lcore_id()];
+
+  type = *rte_pktmbuf_mtod_offset(mbuf, uint16_t *, mbuf->l2_len - 2);
+  if (type == rte_cpu_to_be_16(RTE_ETHER_TYPE_ARP)) {
+    route_arp(config, ctx, lc, mbuf, portc);
+    return 1;
+  }
+
+  if (!p->is_v4 && (p->tunnel == PACKET_TUNNEL_NONE) &&
+      (p->tuple.v6.proto == IPPROTO_ICMPV6) &&
+      (rte_pktmbuf_data_len(mbuf) > mbuf->l2_len + mbuf->l3_len)) {
+    icmp = *rte_pktmbuf_mtod_offset(mbuf, uint8_t *,
+                                    mbuf->l2_len + mbuf->l3_len);
+    if ((icmp == ROUTE_ND_NS) || (icmp == ROUTE_ND_NA)) {
+      route_nd(config, ctx, lc, mbuf, portc);
+      return 1;
+    }
+  }
+
+  // anything else that is not ip can not be routed
+  if (!(p->ptype & RTE_PTYPE_L3_MASK)) {
+    route_drop(config, lc, mbuf, ROUTE_STAT_NO_ROUTE);
+    return 1;
+  }
+
+  return 0;
+}
+
+uint16_t route_lookup(config_t *config, struct rte_mbuf **mbufs, uint16_t n) {
+  route_ctx_t *ctx = route_ctx(config);
+  interface_config_t *itfc = config->itf_cfg;
+  uint32_t ips[MAX_PKT_BURST];
+  struct rte_ipv6_addr ip6s[MAX_PKT_BURST];
+  uint64_t nh4[MAX_PKT_BURST], nh6[MAX_PKT_BURST];
+  uint16_t idx4[MAX_PKT_BURST], idx6[MAX_PKT_BURST];
+  uint64_t nhs[MAX_PKT_BURST];
+  uint16_t i, k, n4 = 0, n6 = 0;
+  const uint8_t *dst;
+  route_lcore_t *lc;
+  packet_t *p;
+
+  if (!ctx) {
+    return n;
+  }
+  lc = &ctx->lcores[rte_lcore_id()];
+
+  // gather destinations of routed packets, one bulk lookup per family
+  for (i = 0; i < n; i++) {
+    p = rte_mbuf_to_priv(mbufs[i]);
+    nhs[i] = UINT64_MAX;
+    if (itfc->ports[p->port_in].type != PORT_TYPE_L3) {
+      continue;
+    }
+
+    if (route_dst(p, &dst)) {
+      ips[n4] = rte_be_to_cpu_32(route_ip4(dst));
+      idx4[n4++] = i;
+    } else {
+      memcpy(&ip6s[n6], dst, sizeof(ip6s[n6]));
+      idx6[n6++] = i;
+    }
+  }
+
+  if (n4) {
+    rte_fib_lookup_bulk(ctx->fib, ips, nh4, n4);
+    for (i = 0; i < n4; i++) {
+      nhs[idx4[i]] = nh4[i];
+    }
+  }
+
+  if (n6) {
+    rte_fib6_lookup_bulk(ctx->fib6, ip6s, nh6, n6);
+    for (i = 0; i < n6; i++) {
+      nhs[idx6[i]] = nh6[i];
+    }
+  }
+
+  for (i = 0, k = 0; i < n; i++) {
+    if (nhs[i] == UINT64_MAX) {
+      mbufs[k++] = mbufs[i];
+      continue;
+    }
+
+    if (nhs[i] == ROUTE_NH_NONE) {
+      route_drop(config, lc, mbufs[i], ROUTE_STAT_NO_ROUTE);
+      continue;
+    }
+
+    if (nhs[i] == ROUTE_NH_LOCAL) {
+      route_drop(config, lc, mbufs[i], ROUTE_STAT_LOCAL);
+      continue;
+    }
+
+    p = rte_mbuf_to_priv(mbufs[i]);
+    p->nh = nhs[i];
+    p->port_out = ctx->nhs[p->nh].port;
+    mbufs[k++] = mbufs[i];
+  }
+
+  return k;
+}
+
+/** ttl is checked at egress so that a dropped packet never got a rewrite */
+static inline bool route_ttl(struct rte_mbuf *mbuf, bool is_v4) {
+  if (is_v4) {
+    struct rte_ipv4_hdr *ip4h =
+        rte_pktmbuf_mtod_offset(mbuf, struct rte_ipv4_hdr *, mbuf->l2_len);
+    uint32_t cksum;
+
+    if (ip4h->time_to_live <= 1) {
+      return false;
+    }
+
+    // ttl is the high byte of its 16-bit word, see rfc 1624
+    cksum = ip4h->hdr_checksum + rte_cpu_to_be_16(0x0100);
+    cksum += cksum >= 0xffff;
+    ip4h->hdr_checksum = cksum;
+    ip4h->time_to_live--;
+  } else {
+    struct rte_ipv6_hdr *ip6h =
+        rte_pktmbuf_mtod_offset(mbuf, struct rte_ipv6_hdr *, mbuf->l2_len);
+
+    if (ip6h->hop_limits <= 1) {
+      return false;
+    }
+    ip6h->hop_limits--;
+  }
+
+  return true;
+}
+
+uint16_t route_rewrite(config_t *config, struct rte_mbuf **mbufs, uint16_t n) {
+  route_ctx_t *ctx = route_ctx(config);
+  route_neigh_key_t keys[MAX_PKT_BURST];
+  const void *kptrs[MAX_PKT_BURST];
+  void *data[MAX_PKT_BURST];
+  uint16_t idx[MAX_PKT_BURST];
+  uint64_t hits = 0, mac;
+  uint16_t i, j, k, m = 0;
+  struct rte_ether_hdr *eh;
+  const uint8_t *dst;
+  route_lcore_t *lc;
+  route_nh_t *nh;
+  packet_t *p;
+  bool is_v4;
+
+  if (!ctx) {
+    return n;
+  }
+  lc = &ctx->lcores[rte_lcore_id()];
+
+  for (i = 0; i < n; i++) {
+    p = rte_mbuf_to_priv(mbufs[i]);
+    if (!p->nh) {
+      continue;
+    }
+
+    nh = &ctx->nhs[p->nh];
+    if (nh->direct) {
+      route_dst(p, &dst);
+    } else {
+      dst = nh->gw;
+    }
+    route_neigh_key(&keys[m], nh->port, nh->is_v4, dst);
+    kptrs[m] = &keys[m];
+    idx[m++] = i;
+  }
+
+  if (m) {
+    rte_hash_lookup_bulk_data(ctx->neigh, kptrs, m, &hits, data);
+  }
+
+  for (i = 0, j = 0, k = 0; i < n; i++) {
+    if ((j == m) || (idx[j] != i)) {
+      mbufs[k++] = mbufs[i];
+      continue;
+    }
+
+    p = rte_mbuf_to_priv(mbufs[i]);
+    nh = &ctx->nhs[p->nh];
+    is_v4 = nh->is_v4;
+
+    if (!(hits & (1ULL << j))) {
+      route_solicit(config, lc, nh->port, is_v4, keys[j].ip);
+      route_drop(config, lc, mbufs[i], ROUTE_STAT_NEIGH_MISS);
+      j++;
+      continue;
+    }
+
+    if (!route_ttl(mbufs[i], is_v4)) {
+      route_drop(config, lc, mbufs[i], ROUTE_STAT_TTL_EXCEEDED);
+      j++;
+      continue;
+    }
+
+    mac = (uintptr_t)data[j++];
+    eh = rte_pktmbuf_mtod(mbufs[i], struct rte_ether_hdr *);
+    memcpy(eh->dst_addr.addr_bytes, &mac, RTE_ETHER_ADDR_LEN);
+    eh->src_addr = route_port(config, nh->port)->ea;
+
+    lc->stats[ROUTE_STAT_FORWARD]++;
+    mbufs[k++] = mbufs[i];
+  }
+
+  return k;
+}
+
+static void route_show_nh(route_ctx_t *ctx, uint64_t id, char *buf,
+                          size_t len) {
+  char gw[INET6_ADDRSTRLEN];
+  route_nh_t *nh;
+
+  if (id == ROUTE_NH_LOCAL) {
+    snprintf(buf, len, "local");
+    return;
+  }
+
+  if ((id == ROUTE_NH_NONE) || (id >= ctx->nh_num)) {
+    snprintf(buf, len, "none");
+    return;
+  }
+
+  nh = &ctx->nhs[id];
+  if (nh->direct) {
+    snprintf(buf, len, "port %u connected", nh->port);
+  } else {
+    route_ntop(nh->gw, nh->is_v4, gw, sizeof(gw));
+    snprintf(buf, len, "port %u via %s", nh->port, gw);
+  }
+}
+
+static int route_show(struct cli_def *cli, const char *command, char *argv[],
+                      int argc) {
+  config_t *c = cli_get_context(cli);
+  route_ctx_t *ctx = route_ctx(c);
+  uint64_t stats[ROUTE_STAT_MAX] = {0};
+  struct rte_rib_node *node = NULL;
+  struct rte_rib6_node *node6 = NULL;
+  struct rte_ipv6_addr ip6, any6 = {0};
+  char ip[INET6_ADDRSTRLEN], nh[64];
+  uint32_t ip4;
+  uint64_t id;
+  uint8_t depth;
+  int i, j;
+
+  CLI_PRINT(cli, "command %s argv[0] %s argc %d", command, argv[0], argc);
+
+  if (!ctx) {
+    CLI_PRINT(cli, "no l3 port");
+    return 0;
+  }
+
+  while ((node = rte_rib_get_nxt(rte_fib_get_rib(ctx->fib), 0, 0, node,
+                                 RTE_RIB_GET_NXT_ALL))) {
+    rte_rib_get_ip(node, &ip4);
+    rte_rib_get_depth(node, &depth);
+    rte_rib_get_nh(node, &id);
+    ip4 = rte_cpu_to_be_32(ip4);
+    inet_ntop(AF_INET, &ip4, ip, sizeof(ip));
+    route_show_nh(ctx, id, nh, sizeof(nh));
+    CLI_PRINT(cli, "%s/%u %s", ip, depth, nh);
+  }
+
+  while ((node6 = rte_rib6_get_nxt(rte_fib6_get_rib(ctx->fib6), &any6, 0,
+                                   node6, RTE_RIB6_GET_NXT_ALL))) {
+    rte_rib6_get_ip(node6, &ip6);
+    rte_rib6_get_depth(node6, &depth);
+    rte_rib6_get_nh(node6, &id);
+    inet_ntop(AF_INET6, &ip6, ip, sizeof(ip));
+    route_show_nh(ctx, id, nh, sizeof(nh));
+    CLI_PRINT(cli, "%s/%u %s", ip, depth, nh);
+  }
+
+  for (i = 0; i < MAX_WORKER_NUM; i++) {
+    for (j = 0; j < ROUTE_STAT_MAX; j++) {
+      stats[j] += ctx->lcores[i].stats[j];
+    }
+  }
+
+  CLI_PRINT(cli, "next hops: %u/%u", ctx->nh_num, MAX_ROUTE_NH_NUM);
+  for (j = 0; j < ROUTE_STAT_MAX; j++) {
+    CLI_PRINT(cli, "%s: %lu", route_stat_name[j], stats[j]);
+  }
+
+  return 0;
+}
+
+static int route_cli_add(struct cli_def *cli, const char *command,
+                         char *argv[], int argc) {
+  config_t *c = cli_get_context(cli);
+  route_ctx_t *ctx = route_ctx(c);
+  const char *prefix = CLI_OPT_V(cli, "prefix");
+  const char *via = CLI_OPT_V(cli, "via");
+  const char *port = CLI_OPT_V(cli, "port");
+  uint8_t ip[16], gw[16] = {0}, depth, gw_depth;
+  bool is_v4, gw_v4;
+  int nh, ret;
+
+  CLI_PRINT(cli, "command %s argv[0] %s argc %d", command, argv[0], argc);
+
+  if (!ctx || !prefix || !port) {
+    CLI_PRINT(cli, "prefix and port required");
+    return -1;
+  }
+
+  if (route_prefix(prefix, ip, &depth, &is_v4) ||
+      (via && (route_prefix(via, gw, &gw_depth, &gw_v4) ||
+               (gw_v4 != is_v4)))) {
+    CLI_PRINT(cli, "invalid address");
+    return -1;
+  }
+
+  if (!route_port_l3(c, atoi(port))) {
+    CLI_PRINT(cli, "port %s is not l3", port);
+    return -1;
+  }
+
+  nh = route_nh_get(ctx, atoi(port), is_v4, gw, !via);
+  if (nh < 0) {
+    CLI_PRINT(cli, "too many next hops");
+    return -1;
+  }
+
+  // fib updates are not safe against concurrent lookups
+  worker_pause(c);
+  ret = route_add(ctx, ip, depth, is_v4, nh);
+  worker_resume();
+
+  CLI_PRINT(cli, ret ? "failed!" : "ok!");
+  return ret;
+}
+
+static int route_cli_del(struct cli_def *cli, const char *command,
+                         char *argv[], int argc) {
+  config_t *c = cli_get_context(cli);
+  route_ctx_t *ctx = route_ctx(c);
+  const char *prefix = CLI_OPT_V(cli, "prefix");
+  uint8_t ip[16], depth;
+  bool is_v4;
+  int ret;
+
+  CLI_PRINT(cli, "command %s argv[0] %s argc %d", command, argv[0], argc);
+
+  if (!ctx || !prefix || route_prefix(prefix, ip, &depth, &is_v4)) {
+    CLI_PRINT(cli, "valid prefix required");
+    return -1;
+  }
+
+  worker_pause(c);
+  ret = route_del(ctx, ip, depth, is_v4);
+  worker_resume();
+
+  CLI_PRINT(cli, ret ? "failed!" : "ok!");
+  return ret;
+}
+
+static int route_neigh_show(struct cli_def *cli, const char *command,
+                            char *argv[], int argc) {
+  config_t *c = cli_get_context(cli);
+  route_ctx_t *ctx = route_ctx(c);
+  const route_neigh_key_t *k;
+  struct rte_ether_addr ea;
+  char ip[INET6_ADDRSTRLEN], mac[RTE_ETHER_ADDR_FMT_SIZE];
+  uint64_t v;
+  uint32_t next = 0;
+  void *data;
+
+  CLI_PRINT(cli, "command %s argv[0] %s argc %d", command, argv[0], argc);
+
+  if (!ctx) {
+    return 0;
+  }
+
+  while (rte_hash_iterate(ctx->neigh, (const void **)&k, &data, &next) >= 0) {
+    v = (uintptr_t)data;
+    memcpy(ea.addr_bytes, &v, RTE_ETHER_ADDR_LEN);
+    rte_ether_format_addr(mac, sizeof(mac), &ea);
+    route_ntop(k->ip, k->is_v4, ip, sizeof(ip));
+    CLI_PRINT(cli, "%-40s %s port %u", ip, mac, k->port);
+  }
+
+  return 0;
+}
+
+static int route_neigh_add(struct cli_def *cli, const char *command,
+                           char *argv[], int argc) {
+  config_t *c = cli_get_context(cli);
+  route_ctx_t *ctx = route_ctx(c);
+  const char *ip = CLI_OPT_V(cli, "ip");
+  const char *mac = CLI_OPT_V(cli, "mac");
+  const char *port = CLI_OPT_V(cli, "port");
+  struct rte_ether_addr ea;
+  uint8_t addr[16], depth;
+  bool is_v4;
+
+  CLI_PRINT(cli, "command %s argv[0] %s argc %d", command, argv[0], argc);
+
+  if (!ctx || !ip || !mac || !port ||
+      route_prefix(ip, addr, &depth, &is_v4) ||
+      rte_ether_unformat_addr(mac, &ea)) {
+    CLI_PRINT(cli, "valid ip, mac and port required");
+    return -1;
+  }
+
+  if (!route_port_l3(c, atoi(port))) {
+    CLI_PRINT(cli, "port %s is not l3", port);
+    return -1;
+  }
+
+  if (route_neigh_set(ctx, atoi(port), is_v4, addr, ea.addr_bytes)) {
+    CLI_PRINT(cli, "neighbor table full");
+    return -1;
+  }
+
+  CLI_PRINT(cli, "ok!");
+  return 0;
+}
+
+static void route_cli_register(config_t *config) {
+  struct cli_def *cli_def;
+  struct cli_command *c, *c1;
+
+  cli_def = config->cli_def;
+  if (!cli_def) {
+    return;
+  }
+
+  c = CLI_CMD_C(cli_def, NULL, "route", NULL, "route table of l3 ports");
+  CLI_CMD_C(cli_def, c, "show", route_show, "show routes and counters");
+  c1 = CLI_CMD_C(cli_def, c, "add", route_cli_add, "add or replace a route");
+  CLI_OPT_A(c1, "prefix", "destination prefix, ipv4 or ipv6");
+  CLI_OPT(c1, "via", "gateway, connected route without it");
+  CLI_OPT_A(c1, "port", "output port");
+  c1 = CLI_CMD_C(cli_def, c, "del", route_cli_del, "delete a route");
+  CLI_OPT_A(c1, "prefix", "destination prefix, ipv4 or ipv6");
+
+  c = CLI_CMD_C(cli_def, NULL, "neigh", NULL, "neighbors of l3 ports");
+  CLI_CMD_C(cli_def, c, "show", route_neigh_show, "show neighbors");
+  c1 = CLI_CMD_C(cli_def, c, "add", route_neigh_add, "add a static neighbor");
+  CLI_OPT_A(c1, "ip", "neighbor address");
+  CLI_OPT_A(c1, "mac", "neighbor mac");
+  CLI_OPT_A(c1, "port", "port of the neighbor");
+}
+
+static void route_free(route_ctx_t *ctx) {
+  rte_fib_free(ctx->fib);
+  rte_fib6_free(ctx->fib6);
+  rte_hash_free(ctx->neigh);
+  rte_free(ctx);
+}
+
+int route_init(config_t *config) {
+  interface_config_t *itfc = config->itf_cfg;
+  struct rte_hash_parameters params = {0};
+  struct rte_fib_conf conf = {0};
+  struct rte_fib6_conf conf6 = {0};
+  route_ctx_t *ctx;
+  int i;
+
+  for (i = 0; i < itfc->port_num; i++) {
+    if (itfc->ports[i].type == PORT_TYPE_L3) {
+      break;
+    }
+  }
+  if (i == itfc->port_num) {
+    return 0;
+  }
+
+  ctx = rte_zmalloc("route_ctx", sizeof(route_ctx_t), RTE_CACHE_LINE_SIZE);
+  if (!ctx) {
+    printf("alloc route ctx failed\n");
+    return -1;
+  }
+  ctx->nh_num = ROUTE_NH_LOCAL + 1;
+
+  conf.type = RTE_FIB_DIR24_8;
+  conf.default_nh = ROUTE_NH_NONE;
+  conf.max_routes = DEF_ROUTE_NUM;
+  conf.dir24_8.nh_sz = RTE_FIB_DIR24_8_2B;
+  conf.dir24_8.num_tbl8 = DEF_ROUTE_TBL8_NUM;
+  ctx->fib = rte_fib_create("route", SOCKET_ID_ANY, &conf);
+
+  conf6.type = RTE_FIB6_TRIE;
+  conf6.default_nh = ROUTE_NH_NONE;
+  conf6.max_routes = DEF_ROUTE_NUM;
+  conf6.trie.nh_sz = RTE_FIB6_TRIE_2B;
+  conf6.trie.num_tbl8 = DEF_ROUTE_TBL8_NUM;
+  ctx->fib6 = rte_fib6_create("route6", SOCKET_ID_ANY, &conf6);
+
+  // learned by every worker, looked up by every worker
+  params.name = "neigh";
+  params.entries = DEF_ROUTE_NEIGH_NUM;
+  params.key_len = sizeof(route_neigh_key_t);
+  params.hash_func = rte_hash_crc;
+  params.socket_id = SOCKET_ID_ANY;
+  params.extra_flag = RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY_LF |
+                      RTE_HASH_EXTRA_FLAGS_MULTI_WRITER_ADD;
+  ctx->neigh = rte_hash_create(&params);
+
+  if (!ctx->fib || !ctx->fib6 || !ctx->neigh) {
+    printf("create route tables failed\n");
+    route_free(ctx);
+    return -1;
+  }
+
+  if (route_connected(config, ctx) || route_load(config, ctx)) {
+    route_free(ctx);
+    return -1;
+  }
+
+  itfc->route = ctx;
+  route_cli_register(config);
+
+  return 0;
+}
+
+// file format utf-8
+// ident using space
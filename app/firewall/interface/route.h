@@ -0,0 +1,85 @@
+#ifndef _M_ROUTE_H_
+#define _M_ROUTE_H_
+
+/** Route and neighbor tables of l3 ports. Routes are kept in rte_fib and
+ * rte_fib6 whose next hop is an index of route_ctx_t.nhs, neighbors learned
+ * by arp and nd are kept in a lock free rte_hash whose data is the mac.
+ * */
+
+#include <rte_ether.h>
+#include <rte_fib.h>
+#include <rte_fib6.h>
+#include <rte_hash.h>
+#include <rte_mbuf.h>
+
+#include "../config.h"
+
+#define DEF_ROUTE_NUM (1U << 16)
+#define DEF_ROUTE_TBL8_NUM (1U << 15)
+#define MAX_ROUTE_NH_NUM 1024
+#define DEF_ROUTE_NEIGH_NUM (1U << 14)
+
+// arp requests and neighbor solicitations sent per second per lcore
+#define ROUTE_SOLICIT_RATE 100
+
+// reserved next hops
+#define ROUTE_NH_NONE 0   // no route, packet is dropped
+#define ROUTE_NH_LOCAL 1  // address of a port, there is no local stack
+
+typedef enum {
+  ROUTE_STAT_FORWARD,
+  ROUTE_STAT_NO_ROUTE,
+  ROUTE_STAT_LOCAL,
+  ROUTE_STAT_TTL_EXCEEDED,
+  ROUTE_STAT_NEIGH_MISS,
+  ROUTE_STAT_ARP,
+  ROUTE_STAT_ND,
+  ROUTE_STAT_SOLICIT,
+  ROUTE_STAT_TX_FAIL,
+  ROUTE_STAT_MAX,
+} route_stat_t;
+
+typedef struct {
+  uint16_t port;
+  uint8_t is_v4;
+  uint8_t direct;  // connected, the neighbor is the packet destination
+  uint8_t gw[16];  // network order, ipv4 in the first 4 bytes
+} route_nh_t;
+
+typedef struct {
+  uint8_t ip[16];  // network order, ipv4 in the first 4 bytes
+  uint16_t port;
+  uint8_t is_v4;
+  uint8_t pad;
+} route_neigh_key_t;
+
+typedef struct {
+  uint64_t solicit_window;  // tsc
+  uint32_t solicit_count;
+  uint64_t stats[ROUTE_STAT_MAX];
+} __rte_cache_aligned route_lcore_t;
+
+typedef struct {
+  struct rte_fib *fib;
+  struct rte_fib6 *fib6;
+  struct rte_hash *neigh;  // written by workers and mgmt, read by workers
+  volatile uint32_t nh_num;
+  route_nh_t nhs[MAX_ROUTE_NH_NUM];
+  route_lcore_t lcores[MAX_WORKER_NUM];
+} route_ctx_t;
+
+int route_init(config_t *config);
+
+/** arp and nd of a l3 port, return 1 if the packet is consumed */
+int route_input(config_t *config, struct rte_mbuf *mbuf);
+
+/** select next hop and output port, return survivors packed in front */
+uint16_t route_lookup(config_t *config, struct rte_mbuf **mbufs, uint16_t n);
+
+/** rewrite l2 header to next hop, return survivors packed in front */
+uint16_t route_rewrite(config_t *config, struct rte_mbuf **mbufs, uint16_t n);
+
+#endif
+
+// file format utf-8
+// ident using space
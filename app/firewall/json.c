@@ -83,6 +83,8 @@ json_object *JV(json_object *jo, const char *tag) {
 
 int JV_I(json_object *jv) { return json_object_get_int(jv); }
 
+int64_t JV_L(json_object *jv) { return json_object_get_int64(jv); }
+
 const char *JV_S(json_object *jv) { return json_object_get_string(jv); }
 
 json_object *JV_NEW(const char *val) { return json_object_new_string(val); }
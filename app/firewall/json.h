@@ -127,6 +127,7 @@ json_object *JV(json_object *jo, const char *tag);
 /** Get value from JV in various type
  * */
 int JV_I(json_object *jv);
+int64_t JV_L(json_object *jv);
 const char *JV_S(json_object *jv);
 
 /** Create a new json value object of type string
@@ -1,5 +1,6 @@
 #include <signal.h>
 #include <stdio.h>
+#include <unistd.h>
 
 #include <rte_common.h>
 #include <rte_eal.h>
@@ -10,9 +11,11 @@
 
 #include "cli.h"
 #include "config.h"
+#include "evlog.h"
 #include "interface/interface.h"
 #include "module.h"
 #include "packet.h"
+#include "stats.h"
 #include "worker.h"
 
 extern config_t config_a, config_b;
@@ -55,17 +58,98 @@ static int cli_show_conf(struct cli_def *cli, const char *command, char *argv[],
   CLI_PRINT(cli, "tx queues %p", c->tx_queues);
   CLI_PRINT(cli, "rx queue num %d", c->rxq_num);
   CLI_PRINT(cli, "tx queue num %d", c->txq_num);
+  CLI_PRINT(cli, "port rx queue num %d", c->port_rxq_num);
+  CLI_PRINT(cli, "ring size %u", c->ring_size);
   CLI_PRINT(cli, "interface config %p", c->itf_cfg);
   CLI_PRINT(cli, "acl context %p", c->acl_ctx);
+  CLI_PRINT(cli, "police context %p", c->police_ctx);
+  CLI_PRINT(cli, "synproxy context %p", c->synproxy_ctx);
+  CLI_PRINT(cli, "nat context %p", c->nat_ctx);
+  CLI_PRINT(cli, "heavy hitter context %p", c->hh_ctx);
+  CLI_PRINT(cli, "capture context %p", c->capture_ctx);
+  CLI_PRINT(cli, "version %u", c->version);
   CLI_PRINT(cli, "reload mark %d", c->reload_mark);
   CLI_PRINT(cli, "switch mark %d", c->switch_mark);
   return 0;
 }
 
+static int cli_show_worker(struct cli_def *cli, const char *command,
+                           char *argv[], int argc) {
+  config_t *c = cli_get_context(cli);
+  worker_t *worker;
+  int i;
+
+  CLI_PRINT(cli, "command %s argv[0] %s argc %d", command, argv[0], argc);
+
+  for (i = 0; i < c->worker_num; i++) {
+    int buckets = 0, j;
+
+    worker = (worker_t *)c->workers + i;
+    for (j = 0; (worker->work_id >= 0) && (j < MAX_DISPATCH_NUM); j++) {
+      buckets += (c->dispatch[j] == worker->work_id);
+    }
+
+    CLI_PRINT(cli, "lcore %d role %d idle %s%s buckets %d", worker->lcore_id,
+              worker->role,
+              (worker->idle.mode == IDLE_ADAPTIVE) ? "adaptive" : "poll",
+              worker->parked ? " parked" : "", buckets);
+    CLI_PRINT(cli, "  polls %lu empty %lu pauses %lu sleeps %lu",
+              worker->idle.polls, worker->idle.empty_polls,
+              worker->idle.pauses, worker->idle.sleeps);
+  }
+
+  return 0;
+}
+
+static int cli_worker_scale(struct cli_def *cli, const char *command,
+                            bool park) {
+  config_t *c = cli_get_context(cli);
+  const char *lcore = CLI_OPT_V(cli, "lcore");
+
+  if (!lcore) {
+    CLI_PRINT(cli, "lcore required");
+    return -1;
+  }
+
+  if (worker_scale(c, atoi(lcore), park)) {
+    CLI_PRINT(cli, "%s lcore %s failed", command, lcore);
+    return -1;
+  }
+  stats_publish(c);
+
+  CLI_PRINT(cli, "ok!");
+  return 0;
+}
+
+static int cli_worker_park(struct cli_def *cli, const char *command,
+                           char *argv[], int argc) {
+  CLI_PRINT(cli, "command %s argv[0] %s argc %d", command, argv[0], argc);
+  return cli_worker_scale(cli, command, true);
+}
+
+static int cli_worker_unpark(struct cli_def *cli, const char *command,
+                             char *argv[], int argc) {
+  CLI_PRINT(cli, "command %s argv[0] %s argc %d", command, argv[0], argc);
+  return cli_worker_scale(cli, command, false);
+}
+
+static void cli_worker_register(config_t *c) {
+  struct cli_command *cmd, *c1;
+
+  cmd = CLI_CMD_C(c->cli_def, NULL, "worker", NULL, "worker lcores");
+  c1 = CLI_CMD_C(c->cli_def, cmd, "park", cli_worker_park,
+                 "stop dispatching to a worker and park its lcore");
+  CLI_OPT_A(c1, "lcore", "lcore id");
+  c1 = CLI_CMD_C(c->cli_def, cmd, "unpark", cli_worker_unpark,
+                 "wake a parked worker and give it buckets back");
+  CLI_OPT_A(c1, "lcore", "lcore id");
+}
+
 static int main_loop(__rte_unused void *arg) {
   int lcore_id = rte_lcore_id();
   worker_t *worker = (worker_t *)config->workers + config->worker_map[lcore_id];
   role_t role = worker->role;
+  int work = 0;
 
   printf("lcore %d start, role %d\n", lcore_id, role);
 
@@ -77,16 +161,18 @@ static int main_loop(__rte_unused void *arg) {
       _config = config_switch(_config, lcore_id);
     }
 
-    if (role == ROLE_RX)
-      RX(_config);
-    else if (role == ROLE_TX)
-      TX(_config);
-    else if (role == ROLE_RTX)
-      RTX(_config);
-    else if (role == ROLE_RTX_WORKER)
-      RTX_WORKER(_config);
-    else if (role == ROLE_WORKER)
-      WORKER(_config);
+    if (unlikely(worker_hold)) {
+      worker_hold_wait(_config, worker);
+      continue;
+    }
+
+    if (worker->parked) {
+      usleep(WORKER_PARK_SLEEP);
+      continue;
+    }
+
+    work = worker_run(_config, worker);
+    worker_idle(worker, work);
   }
 
   return 0;
@@ -109,9 +195,11 @@ static void mgmt_loop(__rte_unused config_t *c) {
         _c = config_switch(_c, -1);
         cli_set_context(_c->cli_def, _c);
         config = _c;
+        stats_publish(_c);
       }
     }
     _cli_run(_c);
+    evlog_drain();
   }
 }
 
@@ -129,18 +217,6 @@ int main(int argc, char **argv) {
   signal(SIGINT, signal_handler);
   signal(SIGTERM, signal_handler);
 
-  config->pktmbuf_pool = rte_pktmbuf_pool_create(
-    "mbuf_pool", 
-    81920, 
-    256, 
-    sizeof(packet_t), 
-    128 + 2048, 
-    rte_socket_id()
-  );
-  if (!config->pktmbuf_pool) {
-    rte_exit(EXIT_FAILURE, "create pktmbuf pool failed\n");
-  }
-
   config->port_num = rte_eth_dev_count_avail();
 
   ret = _cli_init(config);
@@ -150,24 +226,41 @@ int main(int argc, char **argv) {
 
   CLI_CMD_C(config->cli_def, config->cli_show, "config",
             cli_show_conf, "global configuration");
+  CLI_CMD_C(config->cli_def, config->cli_show, "worker",
+            cli_show_worker, "worker lcores and idle statistics");
+  cli_worker_register(config);
+
+  ret = evlog_init(config);
+  if (ret) {
+    rte_exit(EXIT_FAILURE, "event log init erorr\n");
+  }
 
   ret = worker_init(config);
   if (ret) {
     rte_exit(EXIT_FAILURE, "worker init erorr\n");
   }
 
+  ret = stats_init(config);
+  if (ret) {
+    rte_exit(EXIT_FAILURE, "stats init erorr\n");
+  }
+
   modules_load();
   ret = modules_init(config);
   if (ret) {
     rte_exit(EXIT_FAILURE, "module init erorr\n");
   }
 
+  // mbuf pool is sized and created by interface init
+  stats_publish(config);
+
   rte_eal_mp_remote_launch(main_loop, (void *)config, SKIP_MAIN);
   mgmt_loop(config);
 
   ret = 0;
   rte_eal_mp_wait_lcore();
   modules_free(config);
+  evlog_free();
   rte_eal_cleanup();
 
   return ret;
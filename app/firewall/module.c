@@ -1,3 +1,7 @@
+#include <rte_cycles.h>
+#include <rte_lcore.h>
+
+#include "config.h"
 #include "module.h"
 
 // module secetion start and end point, see module_section.lds
@@ -6,21 +10,30 @@ module_t __module_end__;
 
 module_t *modules[MAX_MODULE_NUM] = {0};
 
+bool modules_profile = false;
+module_prof_t modules_prof[MAX_WORKER_NUM][MOD_ID_MAX];
+
 mod_id_t hook_ingress[] = {
+  MOD_ID_CAPTURE,
   MOD_ID_DECODER, 
-  MOD_ID_ACL
+  MOD_ID_HH,
+  MOD_ID_ACL,
+  MOD_ID_SYNPROXY,
+  MOD_ID_POLICE
 };
 
 mod_id_t hook_prerouting[] = {
-  MOD_ID_INTERFACE
+  MOD_ID_INTERFACE,
+  MOD_ID_HH,
+  MOD_ID_NAT
 };
 
 mod_id_t hook_forward[] = {
-  MOD_ID_NONE
+  MOD_ID_INTERFACE
 };
 
 mod_id_t hook_postrouting[] = {
-  MOD_ID_NONE
+  MOD_ID_NAT
 };
 
 mod_id_t hook_localin[] = {
@@ -32,8 +45,8 @@ mod_id_t hook_localout[] = {
 };
 
 mod_id_t hook_egress[] = {
-  MOD_ID_DECODER, 
-  MOD_ID_ACL
+  MOD_ID_INTERFACE,
+  MOD_ID_CAPTURE
 };
 
 mod_id_t *hooks[] = {
@@ -60,7 +73,7 @@ int hook_size[] = {
   for (id = MOD_ID_NONE, m = modules[id]; id < MOD_ID_MAX; id++, m = modules[id])
 
 #define MODULE_FOREACH_HOOK(m, id, hook) \
-  for (id = 0, m = modules[hooks[hook][id]]; id < hook_size[hook]; id++, m = modules[hooks[hook][id]])
+  for (id = 0; (id < hook_size[hook]) && ((m = modules[hooks[hook][id]]) || 1); id++)
 
 int modules_load(void) {
   module_t *m;
@@ -73,6 +86,44 @@ int modules_load(void) {
   return 0;
 }
 
+int modules_plan(void *config) {
+  config_t *c = config;
+  module_t *m;
+  int hook, id, num;
+
+  RTE_BUILD_BUG_ON(MOD_HOOK_MAX != MAX_HOOK_NUM);
+
+  c->plan_hook_num = 0;
+  for (hook = 0; hook < MOD_HOOK_MAX; hook++) {
+    num = 0;
+    MODULE_FOREACH_HOOK(m, id, hook) {
+      if (!m || !m->enabled || !(m->hooks & MOD_HOOK_BIT(hook)) ||
+          (!m->proc && !m->bulk)) {
+        continue;
+      }
+
+      if (num == MAX_HOOK_MODULE) {
+        printf("too many modules on hook %d\n", hook);
+        return -1;
+      }
+      c->plan[hook][num++] = m;
+    }
+
+    c->plan_num[hook] = num;
+    if (num) {
+      c->plan_hooks[c->plan_hook_num++] = hook;
+    }
+
+    printf("== module plan hook %d:", hook);
+    for (id = 0; id < num; id++) {
+      printf(" %s", ((module_t *)c->plan[hook][id])->name);
+    }
+    printf("\n");
+  }
+
+  return 0;
+}
+
 int modules_init(void *config) {
   __rte_unused module_t *m;
   __rte_unused int id;
@@ -86,7 +137,7 @@ int modules_init(void *config) {
     }
   }
 
-  return 0;
+  return modules_plan(config);
 }
 
 int modules_conf(void *config) {
@@ -102,7 +153,7 @@ int modules_conf(void *config) {
     }
   }
 
-  return 0;
+  return modules_plan(config);
 }
 
 int modules_free(void *config) {
@@ -121,27 +172,107 @@ int modules_free(void *config) {
   return 0;
 }
 
+/** called with all workers held, see worker_scale */
+int modules_move(void *config) {
+  __rte_unused module_t *m;
+  __rte_unused int id;
+
+  MODULE_FOREACH(m, id) {
+    if (m && m->move && m->enabled) {
+      printf("== module move %s\n", m->name);
+      if (m->move(config)) {
+        return -1;
+      }
+    }
+  }
+
+  return 0;
+}
+
+static mod_ret_t module_proc_profile(void *config, module_t *m,
+                                     struct rte_mbuf *pkt, mod_hook_t hook) {
+  module_prof_t *prof = &modules_prof[rte_lcore_id()][m->id];
+  uint64_t tsc = rte_rdtsc();
+  mod_ret_t ret;
+
+  ret = m->proc(config, pkt, hook);
+  prof->cycles += rte_rdtsc() - tsc;
+  prof->calls++;
+
+  return ret;
+}
+
 int modules_proc(void *config, struct rte_mbuf *pkt, mod_hook_t hook) {
+  config_t *c = config;
   module_t *m;
-  int id;
+  mod_ret_t ret;
+  int i;
+
+  for (i = 0; i < c->plan_num[hook]; i++) {
+    m = c->plan[hook][i];
 
-  MODULE_FOREACH_HOOK(m, id, hook) {
-    mod_ret_t ret;
+    if (!m->proc) {
+      if (!m->bulk(config, &pkt, 1, hook)) {
+        return MOD_RET_STOLEN;
+      }
+      continue;
+    }
 
-    if (m && m->proc && m->enabled) {
+    if (unlikely(modules_profile)) {
+      ret = module_proc_profile(config, m, pkt, hook);
+    } else {
       ret = m->proc(config, pkt, hook);
+    }
+
+    if (ret == MOD_RET_STOLEN) {
+      return ret;
+    }
+  }
+
+  return MOD_RET_ACCEPT;
+}
+
+uint16_t modules_proc_burst(void *config, struct rte_mbuf **pkts, uint16_t n,
+                            mod_hook_t hook) {
+  config_t *c = config;
+  module_t *m;
+  uint16_t i, k;
+  int id;
 
-      if (ret == MOD_RET_STOLEN) {
-        return ret;
+  for (id = 0; n && (id < c->plan_num[hook]); id++) {
+    m = c->plan[hook][id];
+
+    if (m->bulk) {
+      if (unlikely(modules_profile)) {
+        module_prof_t *prof = &modules_prof[rte_lcore_id()][m->id];
+        uint64_t tsc = rte_rdtsc();
+
+        prof->calls += n;
+        n = m->bulk(config, pkts, n, hook);
+        prof->cycles += rte_rdtsc() - tsc;
+      } else {
+        n = m->bulk(config, pkts, n, hook);
       }
+      continue;
+    }
 
-      if (ret == MOD_RET_ACCEPT) {
-        continue;
+    for (i = 0, k = 0; i < n; i++) {
+      mod_ret_t ret;
+
+      if (unlikely(modules_profile)) {
+        ret = module_proc_profile(config, m, pkts[i], hook);
+      } else {
+        ret = m->proc(config, pkts[i], hook);
+      }
+
+      if (ret != MOD_RET_STOLEN) {
+        pkts[k++] = pkts[i];
       }
     }
+    n = k;
   }
 
-  return MOD_RET_ACCEPT;
+  return n;
 }
 
 // file-format: utf-8
@@ -18,6 +18,11 @@ typedef enum {
   MOD_ID_INTERFACE,
   MOD_ID_DECODER,
   MOD_ID_ACL,
+  MOD_ID_POLICE,
+  MOD_ID_SYNPROXY,
+  MOD_ID_HH,
+  MOD_ID_CAPTURE,
+  MOD_ID_NAT,
   MOD_ID_MAX,
 } mod_id_t;
 
@@ -29,8 +34,11 @@ typedef enum {
   MOD_HOOK_LOCALIN,
   MOD_HOOK_LOCALOUT,
   MOD_HOOK_EGRESS,
+  MOD_HOOK_MAX,
 } mod_hook_t;
 
+#define MOD_HOOK_BIT(hook) (1U << (hook))
+
 typedef enum {
   MOD_RET_ACCEPT,
   MOD_RET_STOLEN,
@@ -41,6 +49,9 @@ typedef mod_ret_t (*mod_func_t)(void *config, struct rte_mbuf *mbuf,
 typedef int (*mod_init_t)(void *config);
 typedef int (*mod_conf_t)(void *config);
 typedef int (*mod_free_t)(void *config);
+typedef int (*mod_move_t)(void *config);
+typedef uint16_t (*mod_bulk_t)(void *config, struct rte_mbuf **mbufs,
+                               uint16_t n, mod_hook_t hook);
 
 #pragma pack(1)
 
@@ -54,7 +65,10 @@ typedef struct {
   mod_conf_t conf;   /** reload config */
   mod_free_t free;   /** free unused resource */
   void *priv;        /** private use */
-  char reserved[12]; /** reserved */
+  mod_move_t move;   /** redistribute per lcore state after worker scaling */
+  mod_bulk_t bulk;   /** process a burst, return survivors packed in front */
+  uint8_t hooks;     /** MOD_HOOK_BIT of the hooks proc or bulk handles */
+  char reserved[3];  /** reserved */
 } module_t;
 
 #pragma pack()
@@ -64,6 +78,16 @@ extern module_t *modules[MAX_MODULE_NUM];
 
 #define MODULE_DECLARE(m) module_t m __module__
 
+/** per lcore per module cost, only collected when modules_profile is set
+ * */
+typedef struct {
+  uint64_t calls;
+  uint64_t cycles;
+} module_prof_t;
+
+extern bool modules_profile;
+extern module_prof_t modules_prof[][MOD_ID_MAX];
+
 #define MODULE_REGISTER(m)                                                            \
   do {                                                                                \
     if (((m)->id > MOD_ID_NONE) && ((m)->id < MOD_ID_MAX) && (!modules[(m)->id])) {   \
@@ -74,8 +98,22 @@ extern module_t *modules[MAX_MODULE_NUM];
 int modules_load(void);
 int modules_init(void *config);
 int modules_proc(void *config, struct rte_mbuf *pkt, mod_hook_t hook);
+
+/** Run a burst through the modules of one hook, module by module so that a
+ * module with bulk sees the whole burst. Stolen packets are removed, return
+ * the number of packets left in pkts.
+ * */
+uint16_t modules_proc_burst(void *config, struct rte_mbuf **pkts, uint16_t n,
+                            mod_hook_t hook);
 int modules_conf(void *config);
+
+/** Compile the handlers of each hook into config, only enabled modules that
+ * declare the hook are kept and hooks without any are skipped by workers.
+ * Called by modules_init and modules_conf.
+ * */
+int modules_plan(void *config);
 int modules_free(void *config);
+int modules_move(void *config);
 
 #endif
 
@@ -0,0 +1,804 @@
+#include <arpa/inet.h>
+
+#include <rte_cycles.h>
+#include <rte_ether.h>
+#include <rte_hash.h>
+#include <rte_hash_crc.h>
+#include <rte_ip.h>
+#include <rte_lcore.h>
+#include <rte_malloc.h>
+#include <rte_tcp.h>
+#include <rte_udp.h>
+
+#include "../cli.h"
+#include "../config.h"
+#include "../json.h"
+#include "../module.h"
+#include "../packet.h"
+#include "../stats.h"
+#include "../worker.h"
+
+#include "../capture/capture.h"
+#include "nat.h"
+
+MODULE_DECLARE(nat) = {.name = "nat",
+                       .id = MOD_ID_NAT,
+                       .enabled = true,
+                       .log = true,
+                       .init = nat_init,
+                       .proc = nat_proc,
+                       .conf = NULL,
+                       .free = NULL,
+                       .priv = NULL,
+                       .move = nat_move,
+                       .hooks = MOD_HOOK_BIT(MOD_HOOK_PREROUTING) |
+                                MOD_HOOK_BIT(MOD_HOOK_POSTROUTING)};
+
+static const char *nat_stat_name[NAT_STAT_MAX] = {
+  [NAT_STAT_NEW] = "new",
+  [NAT_STAT_ORIGINAL] = "original",
+  [NAT_STAT_REPLY] = "reply",
+  [NAT_STAT_EXPIRED] = "expired",
+  [NAT_STAT_SESSION_FULL] = "session full",
+  [NAT_STAT_PORT_EXHAUSTED] = "port exhausted",
+  [NAT_STAT_MOVED] = "moved",
+  [NAT_STAT_SPLIT] = "split",
+};
+
+#define NAT_TCP_CLOSE_FLAGS (RTE_TCP_RST_FLAG | RTE_TCP_FIN_FLAG)
+
+static int nat_prefix(const char *str, uint32_t *net, uint32_t *mask) {
+  char ip[16] = {0};
+  int len = 32;
+  const char *p;
+
+  p = strchr(str, '/');
+  if (p) {
+    if ((p - str) >= (int)sizeof(ip)) {
+      return -1;
+    }
+    memcpy(ip, str, p - str);
+    len = atoi(p + 1);
+  } else {
+    snprintf(ip, sizeof(ip), "%s", str);
+  }
+
+  if ((len < 0) || (len > 32) || (inet_pton(AF_INET, ip, net) != 1)) {
+    return -1;
+  }
+
+  *mask = len ? htonl(~0U << (32 - len)) : 0;
+  *net &= *mask;
+  return 0;
+}
+
+static int nat_load_rule(nat_rule_t *rule, json_object *jo) {
+  json_object *jv;
+  int lo, hi;
+
+  rule->port = UINT16_MAX;
+  jv = JV(jo, "port");
+  if (jv) {
+    rule->port = JV_I(jv);
+  }
+
+  jv = JV(jo, "src");
+  if (!jv || nat_prefix(JV_S(jv), &rule->net, &rule->mask)) {
+    return -1;
+  }
+
+  jv = JV(jo, "addr");
+  if (!jv || (inet_pton(AF_INET, JV_S(jv), &rule->addr) != 1)) {
+    return -1;
+  }
+
+  lo = 1024;
+  hi = 65535;
+  jv = JV(jo, "ports");
+  if (jv && (sscanf(JV_S(jv), "%d-%d", &lo, &hi) != 2)) {
+    return -1;
+  }
+  if ((lo < 1) || (hi > 65535) || (lo > hi)) {
+    return -1;
+  }
+  rule->lo = lo;
+  rule->hi = hi;
+
+  return 0;
+}
+
+static int nat_load(nat_ctx_t *ctx) {
+  json_object *jr = NULL, *ja, *jv;
+  int i, rule_num;
+
+  ctx->enabled = false;
+  ctx->session_num = DEF_NAT_SESSION_NUM;
+
+  jr = JR(CONFIG_PATH, "nat.json");
+  if (!jr) {
+    printf("no nat config, nat disabled\n");
+    return 0;
+  }
+
+  jv = JV(jr, "enabled");
+  if (jv) {
+    ctx->enabled = JV_I(jv) ? true : false;
+  }
+
+  jv = JV(jr, "sessions");
+  if (jv && (JV_I(jv) > 0)) {
+    ctx->session_num = JV_I(jv);
+  }
+
+  rule_num = JA(jr, "rules", &ja);
+  for (i = 0; i < rule_num; i++) {
+    if (ctx->rule_num == MAX_NAT_RULE_NUM) {
+      printf("too many nat rules, only %d loaded\n", MAX_NAT_RULE_NUM);
+      break;
+    }
+
+    if (nat_load_rule(&ctx->rules[ctx->rule_num], JO(ja, i))) {
+      printf("invalid nat rule %d ignored\n", i);
+      continue;
+    }
+    ctx->rule_num++;
+  }
+
+  if (!ctx->rule_num) {
+    ctx->enabled = false;
+  }
+
+  printf("nat enabled %d sessions %u rules %u\n", ctx->enabled,
+         ctx->session_num, ctx->rule_num);
+
+  JR_FREE(jr);
+  return 0;
+}
+
+static int nat_setup(config_t *config, nat_ctx_t *ctx) {
+  struct rte_hash_parameters params = {0};
+  worker_t *worker;
+  char name[RTE_HASH_NAMESIZE];
+  uint32_t j;
+  int i;
+
+  for (i = 0; i < config->worker_num; i++) {
+    nat_lcore_t *lc;
+
+    worker = (worker_t *)config->workers + i;
+    if ((worker->role != ROLE_WORKER) && (worker->role != ROLE_RTX_WORKER)) {
+      continue;
+    }
+
+    lc = &ctx->lcores[worker->lcore_id];
+
+    // both keys of every session
+    snprintf(name, sizeof(name), "nat-%d", worker->lcore_id);
+    params.name = name;
+    params.entries = ctx->session_num * NAT_DIR_MAX;
+    params.key_len = sizeof(nat_key_t);
+    params.hash_func = rte_hash_crc;
+    params.hash_func_init_val = 0;
+    params.socket_id = rte_lcore_to_socket_id(worker->lcore_id);
+
+    lc->table = rte_hash_create(&params);
+    if (!lc->table) {
+      printf("create nat session table %s failed\n", name);
+      return -1;
+    }
+    stats_table_add("nat", name, worker->lcore_id, params.entries);
+
+    lc->sessions = rte_zmalloc_socket(name,
+                                      sizeof(nat_session_t) * ctx->session_num,
+                                      RTE_CACHE_LINE_SIZE, params.socket_id);
+    lc->free = rte_malloc_socket(name, sizeof(uint32_t) * ctx->session_num,
+                                 RTE_CACHE_LINE_SIZE, params.socket_id);
+    if (!lc->sessions || !lc->free) {
+      printf("alloc nat sessions %s failed\n", name);
+      return -1;
+    }
+
+    for (j = 0; j < ctx->session_num; j++) {
+      lc->free[j] = ctx->session_num - 1 - j;
+    }
+    lc->free_num = ctx->session_num;
+  }
+
+  return 0;
+}
+
+/** each lcore hands out ports of the buckets dispatched to it only */
+static void nat_buckets_update(config_t *config, nat_ctx_t *ctx) {
+  nat_lcore_t *lc;
+  int i, b, owner;
+
+  for (i = 0; i < MAX_WORKER_NUM; i++) {
+    ctx->lcores[i].bucket_num = 0;
+  }
+
+  for (b = 0; b < MAX_DISPATCH_NUM; b++) {
+    owner = worker_bucket_owner(config, b);
+    if ((owner < 0) || (owner >= MAX_WORKER_NUM)) {
+      continue;
+    }
+
+    lc = &ctx->lcores[owner];
+    lc->buckets[lc->bucket_num++] = b;
+  }
+}
+
+static inline int32_t nat_session_new(nat_lcore_t *lc) {
+  if (!lc->free_num) {
+    lc->stats[NAT_STAT_SESSION_FULL]++;
+    return -1;
+  }
+
+  return lc->free[--lc->free_num];
+}
+
+static inline void nat_session_del(nat_lcore_t *lc, uint32_t idx) {
+  nat_session_t *s = &lc->sessions[idx];
+  int dir;
+
+  for (dir = 0; dir < NAT_DIR_MAX; dir++) {
+    if (s->dirs & (1U << dir)) {
+      rte_hash_del_key(lc->table, &s->key[dir]);
+    }
+  }
+
+  s->dirs = 0;
+  lc->free[lc->free_num++] = idx;
+}
+
+/** pick a port of the rule range whose reply key is unused, the reply key
+ * decides uniqueness so a port is reused towards different remote endpoints
+ * */
+static int nat_port_alloc(nat_ctx_t *ctx, nat_lcore_t *lc, uint8_t r,
+                          nat_key_t *rk) {
+  nat_rule_t *rule = &ctx->rules[r];
+  uint32_t idx, span = (rule->hi >> 8) - (rule->lo >> 8) + 1;
+  uint16_t port;
+  int i;
+
+  if (!lc->bucket_num) {
+    return -1;
+  }
+
+  for (i = 0; i < NAT_PORT_TRIES; i++) {
+    idx = lc->cursor[r]++;
+    port = (((rule->lo >> 8) + (idx / lc->bucket_num) % span) << 8) |
+           lc->buckets[idx % lc->bucket_num];
+    if ((port < rule->lo) || (port > rule->hi)) {
+      continue;
+    }
+
+    rk->dp = rte_cpu_to_be_16(port);
+    if (rte_hash_lookup(lc->table, rk) < 0) {
+      return 0;
+    }
+  }
+
+  return -1;
+}
+
+static inline uint16_t nat_cksum_adjust16(uint16_t cksum, uint16_t old,
+                                          uint16_t new) {
+  uint32_t sum;
+
+  sum = (uint16_t)~cksum;
+  sum += (uint16_t)~old + new;
+  sum = (sum & 0xffff) + (sum >> 16);
+  sum = (sum & 0xffff) + (sum >> 16);
+  return (uint16_t)~sum;
+}
+
+/** rewrite source or destination in place, checksums are adjusted
+ * incrementally instead of being recomputed over the payload
+ * */
+static void nat_rewrite(struct rte_mbuf *mbuf, packet_t *p, bool src,
+                        uint32_t addr, uint16_t port) {
+  struct rte_ipv4_hdr *ip4h;
+  uint32_t old_addr;
+  uint16_t old_port, c;
+
+  ip4h = rte_pktmbuf_mtod_offset(mbuf, struct rte_ipv4_hdr *, mbuf->l2_len);
+  old_addr = src ? ip4h->src_addr : ip4h->dst_addr;
+  ip4h->hdr_checksum =
+      packet_cksum_adjust(ip4h->hdr_checksum, old_addr, addr);
+  if (src) {
+    ip4h->src_addr = addr;
+  } else {
+    ip4h->dst_addr = addr;
+  }
+
+  if (p->tuple.v4.proto == IPPROTO_TCP) {
+    struct rte_tcp_hdr *th = rte_pktmbuf_mtod_offset(
+        mbuf, struct rte_tcp_hdr *, mbuf->l2_len + mbuf->l3_len);
+
+    old_port = src ? th->src_port : th->dst_port;
+    c = packet_cksum_adjust(th->cksum, old_addr, addr);
+    th->cksum = nat_cksum_adjust16(c, old_port, port);
+    if (src) {
+      th->src_port = port;
+    } else {
+      th->dst_port = port;
+    }
+  } else {
+    struct rte_udp_hdr *uh = rte_pktmbuf_mtod_offset(
+        mbuf, struct rte_udp_hdr *, mbuf->l2_len + mbuf->l3_len);
+
+    // zero udp checksum means none, a computed zero is sent as all ones
+    old_port = src ? uh->src_port : uh->dst_port;
+    if (uh->dgram_cksum) {
+      c = packet_cksum_adjust(uh->dgram_cksum, old_addr, addr);
+      c = nat_cksum_adjust16(c, old_port, port);
+      uh->dgram_cksum = c ? c : 0xffff;
+    }
+    if (src) {
+      uh->src_port = port;
+    } else {
+      uh->dst_port = port;
+    }
+  }
+
+  if (src) {
+    p->tuple.v4.sip = addr;
+    p->tuple.v4.sp = port;
+  } else {
+    p->tuple.v4.dip = addr;
+    p->tuple.v4.dp = port;
+  }
+}
+
+static inline void nat_refresh(nat_ctx_t *ctx, struct rte_mbuf *mbuf,
+                               packet_t *p, nat_session_t *s, uint64_t tsc) {
+  if (p->tuple.v4.proto == IPPROTO_TCP) {
+    struct rte_tcp_hdr *th = rte_pktmbuf_mtod_offset(
+        mbuf, struct rte_tcp_hdr *, mbuf->l2_len + mbuf->l3_len);
+
+    if (th->tcp_flags & NAT_TCP_CLOSE_FLAGS) {
+      s->state = NAT_STATE_TCP_CLOSING;
+    }
+  }
+
+  s->expire = tsc + ctx->timeout[s->state];
+}
+
+/** scan a bounded number of sessions per interval, cost never depends on
+ * table size
+ * */
+static void nat_age(nat_ctx_t *ctx, nat_lcore_t *lc, uint64_t tsc) {
+  nat_session_t *s;
+  int i;
+
+  if (tsc < lc->age_tsc) {
+    return;
+  }
+  lc->age_tsc = tsc + ctx->age_interval;
+
+  for (i = 0; i < NAT_AGE_BUDGET; i++) {
+    if (lc->age_next >= ctx->session_num) {
+      lc->age_next = 0;
+    }
+
+    s = &lc->sessions[lc->age_next];
+    if (s->dirs && (s->expire < tsc)) {
+      nat_session_del(lc, lc->age_next);
+      lc->stats[NAT_STAT_EXPIRED]++;
+    }
+    lc->age_next++;
+  }
+}
+
+/** hand each direction of a session over to the worker now owning its
+ * bucket, all workers are held while this runs. A session whose directions
+ * end up on different workers is split in two halves holding one key each.
+ * */
+int nat_move(void *config) {
+  config_t *c = config;
+  nat_ctx_t *ctx = c->nat_ctx;
+  nat_lcore_t *src, *dst;
+  nat_session_t *s;
+  int32_t idx;
+  uint32_t j;
+  int i, dir, owner[NAT_DIR_MAX];
+
+  if (!ctx || !ctx->enabled) {
+    return 0;
+  }
+
+  for (i = 0; i < MAX_WORKER_NUM; i++) {
+    src = &ctx->lcores[i];
+    if (!src->table) {
+      continue;
+    }
+
+    for (j = 0; j < ctx->session_num; j++) {
+      s = &src->sessions[j];
+      if (!s->dirs) {
+        continue;
+      }
+
+      owner[NAT_DIR_ORIGINAL] = worker_bucket_owner(c, s->bucket);
+      owner[NAT_DIR_REPLY] = worker_bucket_owner(
+          c, NAT_PORT_BUCKET(rte_be_to_cpu_16(s->key[NAT_DIR_REPLY].dp)));
+
+      for (dir = 0; dir < NAT_DIR_MAX; dir++) {
+        if (!(s->dirs & (1U << dir)) || (owner[dir] < 0) ||
+            (owner[dir] == i) || !ctx->lcores[owner[dir]].table) {
+          continue;
+        }
+
+        rte_hash_del_key(src->table, &s->key[dir]);
+        s->dirs &= ~(1U << dir);
+
+        dst = &ctx->lcores[owner[dir]];
+        idx = nat_session_new(dst);
+        if (idx < 0) {
+          continue;
+        }
+
+        if (rte_hash_add_key_data(dst->table, &s->key[dir],
+                                  (void *)(uintptr_t)idx)) {
+          dst->free[dst->free_num++] = idx;
+          dst->stats[NAT_STAT_SESSION_FULL]++;
+          continue;
+        }
+
+        dst->sessions[idx] = *s;
+        dst->sessions[idx].dirs = 1U << dir;
+        src->stats[NAT_STAT_MOVED]++;
+        if (owner[NAT_DIR_ORIGINAL] != owner[NAT_DIR_REPLY]) {
+          src->stats[NAT_STAT_SPLIT]++;
+        }
+      }
+
+      if (!s->dirs) {
+        src->free[src->free_num++] = j;
+      }
+    }
+    src->age_next = 0;
+  }
+
+  nat_buckets_update(c, ctx);
+  return 0;
+}
+
+/** called by RX for every packet while nat is enabled, replies to an
+ * external address are dispatched by the slice of their destination port
+ * */
+static void nat_steer(config_t *config, struct rte_mbuf *mbuf,
+                      uint16_t *bucket) {
+  nat_ctx_t *ctx = config->nat_ctx;
+  struct rte_ether_hdr *eh;
+  struct rte_ipv4_hdr *ip4h;
+  const uint16_t *ports;
+  uint16_t type, dport;
+  uint32_t off, i;
+
+  if (!ctx || !ctx->enabled ||
+      (rte_pktmbuf_data_len(mbuf) < sizeof(*eh) + sizeof(struct rte_vlan_hdr) +
+                                        sizeof(*ip4h) + 4)) {
+    return;
+  }
+
+  eh = rte_pktmbuf_mtod(mbuf, struct rte_ether_hdr *);
+  type = eh->ether_type;
+  off = sizeof(*eh);
+  if (type == rte_cpu_to_be_16(RTE_ETHER_TYPE_VLAN)) {
+    struct rte_vlan_hdr *vh =
+        rte_pktmbuf_mtod_offset(mbuf, struct rte_vlan_hdr *, off);
+
+    type = vh->eth_proto;
+    off += sizeof(*vh);
+  }
+
+  if (type != rte_cpu_to_be_16(RTE_ETHER_TYPE_IPV4)) {
+    return;
+  }
+
+  ip4h = rte_pktmbuf_mtod_offset(mbuf, struct rte_ipv4_hdr *, off);
+  if (((ip4h->next_proto_id != IPPROTO_TCP) &&
+       (ip4h->next_proto_id != IPPROTO_UDP)) ||
+      (ip4h->fragment_offset &
+       rte_cpu_to_be_16(RTE_IPV4_HDR_OFFSET_MASK | RTE_IPV4_HDR_MF_FLAG))) {
+    return;
+  }
+
+  off += rte_ipv4_hdr_len(ip4h);
+  if (rte_pktmbuf_data_len(mbuf) < off + 4) {
+    return;
+  }
+  ports = rte_pktmbuf_mtod_offset(mbuf, const uint16_t *, off);
+  dport = rte_be_to_cpu_16(ports[1]);
+
+  for (i = 0; i < ctx->rule_num; i++) {
+    nat_rule_t *rule = &ctx->rules[i];
+
+    if ((rule->addr == ip4h->dst_addr) &&
+        ((rule->port == UINT16_MAX) || (rule->port == mbuf->port)) &&
+        (dport >= rule->lo) && (dport <= rule->hi)) {
+      *bucket = NAT_PORT_BUCKET(dport);
+      return;
+    }
+  }
+}
+
+static int nat_show(struct cli_def *cli, const char *command, char *argv[],
+                    int argc) {
+  config_t *c = cli_get_context(cli);
+  nat_ctx_t *ctx = c->nat_ctx;
+  uint64_t stats[NAT_STAT_MAX] = {0};
+  char net[INET_ADDRSTRLEN], addr[INET_ADDRSTRLEN];
+  uint32_t r;
+  int i, j, sessions = 0;
+
+  CLI_PRINT(cli, "command %s argv[0] %s argc %d", command, argv[0], argc);
+
+  if (!ctx) {
+    return 0;
+  }
+
+  for (r = 0; r < ctx->rule_num; r++) {
+    nat_rule_t *rule = &ctx->rules[r];
+
+    inet_ntop(AF_INET, &rule->net, net, sizeof(net));
+    inet_ntop(AF_INET, &rule->addr, addr, sizeof(addr));
+    CLI_PRINT(cli, "rule %u port %d src %s/%d to %s:%u-%u", r,
+              rule->port == UINT16_MAX ? -1 : rule->port, net,
+              __builtin_popcount(rule->mask), addr, rule->lo, rule->hi);
+  }
+
+  for (i = 0; i < MAX_WORKER_NUM; i++) {
+    nat_lcore_t *lc = &ctx->lcores[i];
+
+    if (!lc->table) {
+      continue;
+    }
+
+    CLI_PRINT(cli, "lcore %d sessions %u buckets %u", i,
+              ctx->session_num - lc->free_num, lc->bucket_num);
+    sessions += ctx->session_num - lc->free_num;
+
+    for (j = 0; j < NAT_STAT_MAX; j++) {
+      stats[j] += lc->stats[j];
+    }
+  }
+
+  CLI_PRINT(cli, "enabled: %d", ctx->enabled);
+  CLI_PRINT(cli, "sessions: %d/%u per lcore", sessions, ctx->session_num);
+  for (j = 0; j < NAT_STAT_MAX; j++) {
+    CLI_PRINT(cli, "%s: %lu", nat_stat_name[j], stats[j]);
+  }
+
+  return 0;
+}
+
+static void nat_cli_register(config_t *config) {
+  struct cli_def *cli_def;
+  struct cli_command *c;
+
+  if (!config) {
+    return;
+  }
+
+  cli_def = config->cli_def;
+  if (!cli_def) {
+    return;
+  }
+
+  c = CLI_CMD_C(cli_def, NULL, "nat", NULL, "source nat");
+  CLI_CMD_C(cli_def, c, "show", nat_show, "show nat rules and counters");
+}
+
+int nat_init(void *config) {
+  config_t *c = config;
+  nat_ctx_t *ctx;
+  uint64_t hz = rte_get_tsc_hz();
+  int i;
+
+  ctx = rte_zmalloc("nat_ctx", sizeof(nat_ctx_t), RTE_CACHE_LINE_SIZE);
+  if (!ctx) {
+    printf("alloc nat ctx failed\n");
+    return -1;
+  }
+
+  nat_load(ctx);
+
+  ctx->age_interval = hz * NAT_AGE_INTERVAL / 1000;
+  ctx->timeout[NAT_STATE_TCP] = hz * 300;
+  ctx->timeout[NAT_STATE_TCP_CLOSING] = hz * 10;
+  ctx->timeout[NAT_STATE_UDP] = hz * 60;
+
+  if (ctx->enabled && nat_setup(c, ctx)) {
+    for (i = 0; i < MAX_WORKER_NUM; i++) {
+      rte_hash_free(ctx->lcores[i].table);
+      rte_free(ctx->lcores[i].sessions);
+      rte_free(ctx->lcores[i].free);
+    }
+    rte_free(ctx);
+    return -1;
+  }
+
+  c->nat_ctx = ctx;
+  if (ctx->enabled) {
+    nat_buckets_update(c, ctx);
+    worker_steer = nat_steer;
+  }
+  nat_cli_register(c);
+
+  return 0;
+}
+
+/** plain ipv4 tcp/udp only, headers must be in the first segment */
+static inline bool nat_supported(struct rte_mbuf *mbuf, packet_t *p) {
+  uint32_t l4 = (p->tuple.v4.proto == IPPROTO_TCP) ? sizeof(struct rte_tcp_hdr)
+                                                   : sizeof(struct rte_udp_hdr);
+
+  return p->is_v4 && !(p->ptype & RTE_PTYPE_TUNNEL_MASK) &&
+         (((p->ptype & RTE_PTYPE_L4_MASK) == RTE_PTYPE_L4_TCP) ||
+          ((p->ptype & RTE_PTYPE_L4_MASK) == RTE_PTYPE_L4_UDP)) &&
+         (rte_pktmbuf_data_len(mbuf) >= mbuf->l2_len + mbuf->l3_len + l4);
+}
+
+static mod_ret_t nat_proc_original(config_t *config, nat_ctx_t *ctx,
+                                   nat_lcore_t *lc, struct rte_mbuf *mbuf,
+                                   packet_t *p) {
+  nat_session_t *s;
+  nat_key_t k = {0}, rk = {0};
+  uint64_t tsc = rte_rdtsc();
+  void *data;
+  int32_t idx;
+  uint32_t r;
+
+  nat_age(ctx, lc, tsc);
+
+  k.sip = p->tuple.v4.sip;
+  k.dip = p->tuple.v4.dip;
+  k.sp = p->tuple.v4.sp;
+  k.dp = p->tuple.v4.dp;
+  k.proto = p->tuple.v4.proto;
+  k.dir = NAT_DIR_ORIGINAL;
+
+  if (rte_hash_lookup_data(lc->table, &k, &data) >= 0) {
+    s = &lc->sessions[(uintptr_t)data];
+    goto translate;
+  }
+
+  for (r = 0; r < ctx->rule_num; r++) {
+    nat_rule_t *rule = &ctx->rules[r];
+
+    if (((rule->port == UINT16_MAX) || (rule->port == p->port_out)) &&
+        ((k.sip & rule->mask) == rule->net)) {
+      break;
+    }
+  }
+
+  if (r == ctx->rule_num) {
+    return MOD_RET_ACCEPT;
+  }
+
+  rk.sip = k.dip;
+  rk.dip = ctx->rules[r].addr;
+  rk.sp = k.dp;
+  rk.proto = k.proto;
+  rk.dir = NAT_DIR_REPLY;
+  if (nat_port_alloc(ctx, lc, r, &rk)) {
+    lc->stats[NAT_STAT_PORT_EXHAUSTED]++;
+    goto drop;
+  }
+
+  idx = nat_session_new(lc);
+  if (idx < 0) {
+    goto drop;
+  }
+
+  s = &lc->sessions[idx];
+  s->key[NAT_DIR_ORIGINAL] = k;
+  s->key[NAT_DIR_REPLY] = rk;
+  s->bucket = p->bucket;
+  s->rule = r;
+  s->state = (k.proto == IPPROTO_TCP) ? NAT_STATE_TCP : NAT_STATE_UDP;
+  s->dirs = 1U << NAT_DIR_ORIGINAL;
+  if (rte_hash_add_key_data(lc->table, &k, (void *)(uintptr_t)idx)) {
+    s->dirs = 0;
+    lc->free[lc->free_num++] = idx;
+    lc->stats[NAT_STAT_SESSION_FULL]++;
+    goto drop;
+  }
+
+  s->dirs |= 1U << NAT_DIR_REPLY;
+  if (rte_hash_add_key_data(lc->table, &rk, (void *)(uintptr_t)idx)) {
+    s->dirs &= ~(1U << NAT_DIR_REPLY);
+    nat_session_del(lc, idx);
+    lc->stats[NAT_STAT_SESSION_FULL]++;
+    goto drop;
+  }
+  lc->stats[NAT_STAT_NEW]++;
+
+translate:
+  nat_refresh(ctx, mbuf, p, s, tsc);
+  nat_rewrite(mbuf, p, true, s->key[NAT_DIR_REPLY].dip,
+              s->key[NAT_DIR_REPLY].dp);
+  lc->stats[NAT_STAT_ORIGINAL]++;
+  return MOD_RET_ACCEPT;
+
+drop:
+  capture_drop(config, mbuf, MOD_ID_NAT);
+  rte_pktmbuf_free(mbuf);
+  return MOD_RET_STOLEN;
+}
+
+static mod_ret_t nat_proc_reply(nat_ctx_t *ctx, nat_lcore_t *lc,
+                                struct rte_mbuf *mbuf, packet_t *p) {
+  nat_session_t *s;
+  nat_key_t k = {0};
+  void *data;
+  uint32_t r;
+
+  // only packets to an external address may be replies
+  for (r = 0; r < ctx->rule_num; r++) {
+    if (ctx->rules[r].addr == p->tuple.v4.dip) {
+      break;
+    }
+  }
+
+  if (r == ctx->rule_num) {
+    return MOD_RET_ACCEPT;
+  }
+
+  k.sip = p->tuple.v4.sip;
+  k.dip = p->tuple.v4.dip;
+  k.sp = p->tuple.v4.sp;
+  k.dp = p->tuple.v4.dp;
+  k.proto = p->tuple.v4.proto;
+  k.dir = NAT_DIR_REPLY;
+
+  if (rte_hash_lookup_data(lc->table, &k, &data) < 0) {
+    return MOD_RET_ACCEPT;
+  }
+
+  s = &lc->sessions[(uintptr_t)data];
+  nat_refresh(ctx, mbuf, p, s, rte_rdtsc());
+  nat_rewrite(mbuf, p, false, s->key[NAT_DIR_ORIGINAL].sip,
+              s->key[NAT_DIR_ORIGINAL].sp);
+  p->flags |= PACKET_FLAG_NAT;
+  lc->stats[NAT_STAT_REPLY]++;
+
+  return MOD_RET_ACCEPT;
+}
+
+mod_ret_t nat_proc(void *config, struct rte_mbuf *mbuf, mod_hook_t hook) {
+  config_t *c = config;
+  nat_ctx_t *ctx = c->nat_ctx;
+  nat_lcore_t *lc;
+  packet_t *p;
+
+  if (!ctx || !ctx->enabled) {
+    return MOD_RET_ACCEPT;
+  }
+
+  p = rte_mbuf_to_priv(mbuf);
+  if (!p || !nat_supported(mbuf, p)) {
+    return MOD_RET_ACCEPT;
+  }
+
+  lc = &ctx->lcores[rte_lcore_id()];
+  if (!lc->table) {
+    return MOD_RET_ACCEPT;
+  }
+
+  if (hook == MOD_HOOK_PREROUTING) {
+    return nat_proc_reply(ctx, lc, mbuf, p);
+  }
+
+  // replies translated back at prerouting are never translated again
+  if ((hook == MOD_HOOK_POSTROUTING) && !(p->flags & PACKET_FLAG_NAT)) {
+    return nat_proc_original(c, ctx, lc, mbuf, p);
+  }
+
+  return MOD_RET_ACCEPT;
+}
+
+// file format utf-8
+// ident using space
@@ -0,0 +1,116 @@
+#ifndef _M_NAT_H_
+#define _M_NAT_H_
+
+#include <rte_hash.h>
+
+#include "../config.h"
+#include "../module.h"
+
+#define DEF_NAT_SESSION_NUM (1U << 18)
+#define MAX_NAT_RULE_NUM 16
+
+// session aging, scan at most budget sessions every interval (ms)
+#define NAT_AGE_INTERVAL 10
+#define NAT_AGE_BUDGET 256
+
+// candidate ports tried before a new session is dropped
+#define NAT_PORT_TRIES 64
+
+/** The external port space is cut into slices by the low byte of the port,
+ * slice n belongs to dispatch bucket n. A worker only hands out ports of the
+ * buckets dispatched to it and replies are steered to the bucket of their
+ * destination port, so no port is ever shared between workers.
+ * */
+#define NAT_PORT_BUCKET(port) ((port) & (MAX_DISPATCH_NUM - 1))
+
+typedef enum {
+  NAT_DIR_ORIGINAL,  // inside to outside, source is translated
+  NAT_DIR_REPLY,     // outside to inside, destination is translated back
+  NAT_DIR_MAX,
+} nat_dir_t;
+
+typedef enum {
+  NAT_STATE_NONE,
+  NAT_STATE_TCP,
+  NAT_STATE_TCP_CLOSING,  // fin or rst seen
+  NAT_STATE_UDP,
+  NAT_STATE_MAX,
+} nat_state_t;
+
+typedef enum {
+  NAT_STAT_NEW,
+  NAT_STAT_ORIGINAL,       // packets translated inside to outside
+  NAT_STAT_REPLY,          // packets translated outside to inside
+  NAT_STAT_EXPIRED,
+  NAT_STAT_SESSION_FULL,
+  NAT_STAT_PORT_EXHAUSTED,
+  NAT_STAT_MOVED,          // handed over to another worker
+  NAT_STAT_SPLIT,          // directions owned by different workers
+  NAT_STAT_MAX,
+} nat_stat_t;
+
+/** addresses and ports in network order, as seen on the wire */
+typedef struct {
+  uint32_t sip;
+  uint32_t dip;
+  uint16_t sp;
+  uint16_t dp;
+  uint8_t proto;
+  uint8_t dir;
+  uint8_t pad[2];
+} nat_key_t;
+
+typedef struct {
+  nat_key_t key[NAT_DIR_MAX];  // reply key holds the external address/port
+  uint16_t bucket;             // dispatch bucket of the original direction
+  uint8_t dirs;                // keys held by the table of this lcore
+  uint8_t state;
+  uint8_t rule;
+  uint8_t pad[3];
+  uint64_t expire;             // tsc
+} nat_session_t;
+
+/** sources of a prefix leaving port are translated to addr:[lo, hi] */
+typedef struct {
+  uint16_t port;  // port_out, UINT16_MAX for any
+  uint32_t net;   // network order
+  uint32_t mask;  // network order
+  uint32_t addr;  // external address, network order
+  uint16_t lo;    // external port range, host order
+  uint16_t hi;
+} nat_rule_t;
+
+/** Sessions are owned by one lcore. The table holds both keys of a session,
+ * data of a key is the index of the session in the sessions array.
+ * */
+typedef struct {
+  struct rte_hash *table;
+  nat_session_t *sessions;
+  uint32_t *free;                       // stack of unused session index
+  uint32_t free_num;
+  uint16_t buckets[MAX_DISPATCH_NUM];   // buckets dispatched to this lcore
+  uint16_t bucket_num;
+  uint32_t cursor[MAX_NAT_RULE_NUM];    // next candidate port per rule
+  uint32_t age_next;
+  uint64_t age_tsc;
+  uint64_t stats[NAT_STAT_MAX];
+} __rte_cache_aligned nat_lcore_t;
+
+typedef struct {
+  bool enabled;
+  uint32_t session_num;                 // per lcore
+  uint32_t rule_num;
+  nat_rule_t rules[MAX_NAT_RULE_NUM];
+  uint64_t age_interval;                // tsc
+  uint64_t timeout[NAT_STATE_MAX];      // tsc
+  nat_lcore_t lcores[MAX_WORKER_NUM];
+} nat_ctx_t;
+
+int nat_init(void *config);
+mod_ret_t nat_proc(void *config, struct rte_mbuf *mbuf, mod_hook_t hook);
+int nat_move(void *config);
+
+#endif
+
+// file format utf-8
+// ident using space
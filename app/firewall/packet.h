@@ -1,6 +1,22 @@
 #ifndef _M_PACKET_H_
 #define _M_PACKET_H_
 
+// packet flags
+#define PACKET_FLAG_BYPASS (1U << 0)  // acl verdict is cached, skip classify
+#define PACKET_FLAG_LEARN  (1U << 1)  // cache acl verdict into bypass table
+#define PACKET_FLAG_NAT    (1U << 2)  // destination translated back by nat
+
+typedef enum {
+  PACKET_TUNNEL_NONE,
+  PACKET_TUNNEL_IP,         // ipip, ip6ip
+  PACKET_TUNNEL_GRE,        // gre, nvgre
+  PACKET_TUNNEL_VXLAN,
+  PACKET_TUNNEL_VXLAN_GPE,
+  PACKET_TUNNEL_GENEVE,
+  PACKET_TUNNEL_GTPU,
+  PACKET_TUNNEL_MAX,
+} packet_tunnel_t;
+
 typedef struct {
   uint8_t proto;
   uint32_t sip;
@@ -17,6 +33,11 @@ typedef struct {
   uint16_t dp;
 } ip6_tuple_t;
 
+typedef union {
+  ip4_tuple_t v4;
+  ip6_tuple_t v6;
+} ip_tuple_t;
+
 // must align to 8 bytes
 #pragma pack(1)
 
@@ -25,20 +46,40 @@ typedef struct {
   uint16_t port_out;
   uint32_t ptype;
   uint32_t flags;
-  uint16_t queue_id;    // which queue the packet come from (also send to)
+  uint16_t queue_id;    // which rx queue the packet come from
+  uint16_t policer;     // policer selected by acl, 0 for none
+  uint32_t bypass_id;   // bypass table slot + 1, 0 for none
+  uint16_t bucket;      // dispatch bucket, selects the worker
 
   uint8_t smac[6];      // source mac
   uint8_t dmac[6];      // destination mac
 
   bool is_v4;
-  union {
-    ip4_tuple_t v4;
-    ip6_tuple_t v6;
-  } tuple;
+  ip_tuple_t tuple;     // innermost headers, of the payload if tunneled
+
+  uint8_t tunnel;       // packet_tunnel_t, outer fields are valid if not none
+  bool outer_is_v4;
+  uint32_t tunnel_id;   // vni of vxlan/geneve, key of gre, teid of gtp-u
+  ip_tuple_t outer;     // outer headers of a tunnel
 
-  uint8_t reserved[189];
+  uint16_t nh;          // next hop of a routed packet, 0 for none
+
+  uint8_t reserved[133];
 } packet_t;
 
 #pragma pack()
 
+/** RFC 1624 incremental checksum update for a 32-bit field */
+static inline uint16_t packet_cksum_adjust(uint16_t cksum, uint32_t old,
+                                           uint32_t new) {
+  uint32_t sum;
+
+  sum = (uint16_t)~cksum;
+  sum += (uint16_t)~old + (uint16_t)~(old >> 16);
+  sum += (uint16_t)new + (uint16_t)(new >> 16);
+  sum = (sum & 0xffff) + (sum >> 16);
+  sum = (sum & 0xffff) + (sum >> 16);
+  return (uint16_t)~sum;
+}
+
 #endif
\ No newline at end of file
@@ -0,0 +1,448 @@
+#include <rte_cycles.h>
+#include <rte_lcore.h>
+#include <rte_malloc.h>
+#include <rte_meter.h>
+
+#include "../cli.h"
+#include "../config.h"
+#include "../json.h"
+#include "../module.h"
+#include "../packet.h"
+#include "../worker.h"
+
+#include "../capture/capture.h"
+#include "police.h"
+
+MODULE_DECLARE(police) = {.name = "police",
+                          .id = MOD_ID_POLICE,
+                          .enabled = true,
+                          .log = true,
+                          .init = police_init,
+                          .proc = police_proc,
+                          .conf = police_conf,
+                          .free = police_free,
+                          .priv = NULL,
+                          .move = police_move,
+                          .hooks = MOD_HOOK_BIT(MOD_HOOK_INGRESS)};
+
+static int police_type_str2int(const char *str) {
+  if (!strcmp("srtcm", str))
+    return POLICE_TYPE_SRTCM;
+  if (!strcmp("trtcm", str))
+    return POLICE_TYPE_TRTCM;
+  return POLICE_TYPE_NONE;
+}
+
+static const char *police_type_int2str(police_type_t type) {
+  if (type == POLICE_TYPE_SRTCM)
+    return "srtcm";
+  if (type == POLICE_TYPE_TRTCM)
+    return "trtcm";
+  return "none";
+}
+
+static int police_action_str2int(const char *str) {
+  if (!strcmp("drop", str))
+    return POLICE_ACTION_DROP;
+  return POLICE_ACTION_PASS;
+}
+
+static const char *police_action_int2str(uint8_t action) {
+  return (action == POLICE_ACTION_DROP) ? "drop" : "pass";
+}
+
+/** count lcores which run the module chain, rates are split among them */
+static uint16_t police_lcore_num(config_t *config) {
+  worker_t *worker;
+  uint16_t i, n = 0;
+
+  for (i = 0; i < config->worker_num; i++) {
+    worker = (worker_t *)config->workers + i;
+    if (((worker->role == ROLE_WORKER) || (worker->role == ROLE_RTX_WORKER)) &&
+        !worker->parked)
+      n++;
+  }
+
+  return n ? n : 1;
+}
+
+static int police_profile_config(police_ctx_t *ctx, policer_t *pl) {
+  uint16_t n = ctx->lcore_num;
+  int ret = -1;
+
+  if (pl->type == POLICE_TYPE_SRTCM) {
+    struct rte_meter_srtcm_params params = {
+      .cir = pl->params.srtcm.cir / n,
+      .cbs = pl->params.srtcm.cbs / n,
+      .ebs = pl->params.srtcm.ebs / n,
+    };
+    ret = rte_meter_srtcm_profile_config(&pl->profile.srtcm, &params);
+  } else if (pl->type == POLICE_TYPE_TRTCM) {
+    struct rte_meter_trtcm_params params = {
+      .cir = pl->params.trtcm.cir / n,
+      .pir = pl->params.trtcm.pir / n,
+      .cbs = pl->params.trtcm.cbs / n,
+      .pbs = pl->params.trtcm.pbs / n,
+    };
+    ret = rte_meter_trtcm_profile_config(&pl->profile.trtcm, &params);
+  }
+
+  return ret;
+}
+
+static int police_meter_config(police_ctx_t *ctx, policer_t *pl) {
+  int i, ret = 0;
+
+  for (i = 0; i < MAX_WORKER_NUM; i++) {
+    police_lcore_t *lc = &ctx->lcores[i];
+
+    if (pl->type == POLICE_TYPE_SRTCM)
+      ret = rte_meter_srtcm_config(&lc->meters[pl->id].srtcm,
+                                   &pl->profile.srtcm);
+    else if (pl->type == POLICE_TYPE_TRTCM)
+      ret = rte_meter_trtcm_config(&lc->meters[pl->id].trtcm,
+                                   &pl->profile.trtcm);
+    if (ret)
+      return ret;
+  }
+
+  return 0;
+}
+
+static int police_load(config_t *config) {
+  police_ctx_t *ctx = config->police_ctx;
+  json_object *jr = NULL, *ja;
+  int i, num;
+  int ret = 0;
+
+  jr = JR(CONFIG_PATH, "police.json");
+  if (!jr) {
+    printf("no police config, policing disabled\n");
+    return 0;
+  }
+
+#define POLICE_JV(item)                                                        \
+  jv = JV(jo, item);                                                           \
+  if (!jv) {                                                                   \
+    printf("parse %s failed\n", item);                                         \
+    ret = -1;                                                                  \
+    goto done;                                                                 \
+  }
+
+  num = JA(jr, "policers", &ja);
+  for (i = 0; i < num; i++) {
+    json_object *jo, *jv;
+    policer_t *pl;
+    int id;
+
+    jo = JO(ja, i);
+
+    POLICE_JV("id");
+    id = JV_I(jv);
+    if ((id <= 0) || (id >= MAX_POLICER_NUM)) {
+      printf("policer id %d out of range\n", id);
+      ret = -1;
+      goto done;
+    }
+
+    pl = &ctx->policers[id];
+    pl->id = id;
+
+    POLICE_JV("type");
+    pl->type = police_type_str2int(JV_S(jv));
+    if (pl->type == POLICE_TYPE_SRTCM) {
+      POLICE_JV("cir");
+      pl->params.srtcm.cir = JV_L(jv);
+      POLICE_JV("cbs");
+      pl->params.srtcm.cbs = JV_L(jv);
+      POLICE_JV("ebs");
+      pl->params.srtcm.ebs = JV_L(jv);
+    } else if (pl->type == POLICE_TYPE_TRTCM) {
+      POLICE_JV("cir");
+      pl->params.trtcm.cir = JV_L(jv);
+      POLICE_JV("pir");
+      pl->params.trtcm.pir = JV_L(jv);
+      POLICE_JV("cbs");
+      pl->params.trtcm.cbs = JV_L(jv);
+      POLICE_JV("pbs");
+      pl->params.trtcm.pbs = JV_L(jv);
+    } else {
+      printf("policer %d unknown type\n", id);
+      ret = -1;
+      goto done;
+    }
+
+    POLICE_JV("green");
+    pl->actions[RTE_COLOR_GREEN] = police_action_str2int(JV_S(jv));
+    POLICE_JV("yellow");
+    pl->actions[RTE_COLOR_YELLOW] = police_action_str2int(JV_S(jv));
+    POLICE_JV("red");
+    pl->actions[RTE_COLOR_RED] = police_action_str2int(JV_S(jv));
+
+    if (police_profile_config(ctx, pl) || police_meter_config(ctx, pl)) {
+      printf("policer %d profile config failed\n", id);
+      ret = -1;
+      goto done;
+    }
+
+    printf("policer %d type %s green %s yellow %s red %s\n", id,
+           police_type_int2str(pl->type),
+           police_action_int2str(pl->actions[RTE_COLOR_GREEN]),
+           police_action_int2str(pl->actions[RTE_COLOR_YELLOW]),
+           police_action_int2str(pl->actions[RTE_COLOR_RED]));
+  }
+
+  num = JA(jr, "zones", &ja);
+  for (i = 0; i < num; i++) {
+    json_object *jo, *jv;
+    int port, id;
+
+    jo = JO(ja, i);
+
+    POLICE_JV("port");
+    port = JV_I(jv);
+    POLICE_JV("policer");
+    id = JV_I(jv);
+
+    if ((port < 0) || (port >= MAX_PORT_NUM) || (id <= 0) ||
+        (id >= MAX_POLICER_NUM) || !ctx->policers[id].type) {
+      printf("zone port %d policer %d invalid\n", port, id);
+      ret = -1;
+      goto done;
+    }
+
+    ctx->zones[port] = id;
+    printf("zone port %d bind policer %d\n", port, id);
+  }
+
+#undef POLICE_JV
+
+done:
+  if (jr)
+    JR_FREE(jr);
+  return ret;
+}
+
+static int police_show(struct cli_def *cli, const char *command, char *argv[],
+                       int argc) {
+  config_t *c = cli_get_context(cli);
+  police_ctx_t *ctx = c->police_ctx;
+  int i, j, k;
+
+  CLI_PRINT(cli, "command %s argv[0] %s argc %d", command, argv[0], argc);
+
+  if (!ctx) {
+    return 0;
+  }
+
+  for (i = 1; i < MAX_POLICER_NUM; i++) {
+    policer_t *pl = &ctx->policers[i];
+    uint64_t stats[RTE_COLORS] = {0};
+
+    if (!pl->type) {
+      continue;
+    }
+
+    for (j = 0; j < MAX_WORKER_NUM; j++) {
+      for (k = 0; k < RTE_COLORS; k++) {
+        stats[k] += ctx->lcores[j].stats[i][k];
+      }
+    }
+
+    CLI_PRINT(cli, "id: %d", i);
+    CLI_PRINT(cli, "type: %s", police_type_int2str(pl->type));
+    if (pl->type == POLICE_TYPE_SRTCM) {
+      CLI_PRINT(cli, "cir: %lu cbs: %lu ebs: %lu", pl->params.srtcm.cir,
+                pl->params.srtcm.cbs, pl->params.srtcm.ebs);
+    } else {
+      CLI_PRINT(cli, "cir: %lu pir: %lu cbs: %lu pbs: %lu",
+                pl->params.trtcm.cir, pl->params.trtcm.pir,
+                pl->params.trtcm.cbs, pl->params.trtcm.pbs);
+    }
+    CLI_PRINT(cli, "green: %s %lu", police_action_int2str(pl->actions[RTE_COLOR_GREEN]),
+              stats[RTE_COLOR_GREEN]);
+    CLI_PRINT(cli, "yellow: %s %lu", police_action_int2str(pl->actions[RTE_COLOR_YELLOW]),
+              stats[RTE_COLOR_YELLOW]);
+    CLI_PRINT(cli, "red: %s %lu", police_action_int2str(pl->actions[RTE_COLOR_RED]),
+              stats[RTE_COLOR_RED]);
+    CLI_PRINT(cli, "%s", "");
+  }
+
+  for (i = 0; i < MAX_PORT_NUM; i++) {
+    if (ctx->zones[i]) {
+      CLI_PRINT(cli, "zone port %d policer %d", i, ctx->zones[i]);
+    }
+  }
+
+  return 0;
+}
+
+static void police_cli_register(config_t *config) {
+  struct cli_def *cli_def;
+  struct cli_command *c;
+
+  if (!config) {
+    return;
+  }
+
+  cli_def = config->cli_def;
+  if (!cli_def) {
+    return;
+  }
+
+  c = CLI_CMD_C(cli_def, NULL, "police", NULL, "traffic policing");
+  CLI_CMD_C(cli_def, c, "show", police_show, "show policers and color counters");
+}
+
+int police_free(void *config) {
+  config_t *c = config;
+
+  if (c->police_ctx) {
+    rte_free(c->police_ctx);
+    c->police_ctx = NULL;
+  }
+
+  return 0;
+}
+
+int police_conf(void *config) {
+  config_t *c = config;
+  police_ctx_t *ctx;
+
+  ctx = rte_zmalloc("police_ctx", sizeof(police_ctx_t), RTE_CACHE_LINE_SIZE);
+  if (!ctx) {
+    printf("alloc police ctx failed\n");
+    return -1;
+  }
+
+  ctx->lcore_num = police_lcore_num(c);
+  c->police_ctx = ctx;
+
+  if (police_load(c)) {
+    printf("police load config failed\n");
+    c->police_ctx = NULL;
+    rte_free(ctx);
+    return -1;
+  }
+
+  return 0;
+}
+
+/** active workers changed, split the rates again */
+int police_move(void *config) {
+  config_t *c = config;
+  police_ctx_t *ctx = c->police_ctx;
+  int i;
+
+  if (!ctx) {
+    return 0;
+  }
+
+  ctx->lcore_num = police_lcore_num(c);
+  for (i = 1; i < MAX_POLICER_NUM; i++) {
+    policer_t *pl = &ctx->policers[i];
+
+    if (!pl->type) {
+      continue;
+    }
+
+    if (police_profile_config(ctx, pl) || police_meter_config(ctx, pl)) {
+      printf("policer %d profile config failed\n", i);
+      return -1;
+    }
+  }
+
+  return 0;
+}
+
+int police_init(void *config) {
+  if (police_conf(config)) {
+    printf("police conf failed\n");
+    return -1;
+  }
+
+  police_cli_register(config);
+
+  return 0;
+}
+
+static inline enum rte_color police_check(police_ctx_t *ctx,
+                                          police_lcore_t *lc, uint16_t id,
+                                          uint64_t tsc, uint32_t len) {
+  policer_t *pl = &ctx->policers[id];
+  enum rte_color color;
+
+  if (pl->type == POLICE_TYPE_TRTCM) {
+    color = rte_meter_trtcm_color_blind_check(&lc->meters[id].trtcm,
+                                              &pl->profile.trtcm, tsc, len);
+  } else if (pl->type == POLICE_TYPE_SRTCM) {
+    color = rte_meter_srtcm_color_blind_check(&lc->meters[id].srtcm,
+                                              &pl->profile.srtcm, tsc, len);
+  } else {
+    return RTE_COLOR_GREEN;
+  }
+
+  lc->stats[id][color]++;
+  return color;
+}
+
+static mod_ret_t police_proc_ingress(config_t *config, struct rte_mbuf *mbuf) {
+  police_ctx_t *ctx = config->police_ctx;
+  police_lcore_t *lc;
+  packet_t *p;
+  uint16_t zone;
+  uint32_t len;
+  uint64_t tsc;
+  enum rte_color color;
+
+  if (!ctx) {
+    goto done;
+  }
+
+  p = rte_mbuf_to_priv(mbuf);
+  if (!p) {
+    goto done;
+  }
+
+  zone = ctx->zones[p->port_in];
+  if (!zone && !p->policer) {
+    goto done;
+  }
+
+  lc = &ctx->lcores[rte_lcore_id()];
+  len = rte_pktmbuf_pkt_len(mbuf);
+  tsc = rte_rdtsc();
+
+  if (zone) {
+    color = police_check(ctx, lc, zone, tsc, len);
+    if (ctx->policers[zone].actions[color] == POLICE_ACTION_DROP) {
+      goto drop;
+    }
+  }
+
+  if (p->policer && (p->policer < MAX_POLICER_NUM)) {
+    color = police_check(ctx, lc, p->policer, tsc, len);
+    if (ctx->policers[p->policer].actions[color] == POLICE_ACTION_DROP) {
+      goto drop;
+    }
+  }
+
+done:
+  return MOD_RET_ACCEPT;
+
+drop:
+  capture_drop(config, mbuf, MOD_ID_POLICE);
+  rte_pktmbuf_free(mbuf);
+  return MOD_RET_STOLEN;
+}
+
+mod_ret_t police_proc(void *config, struct rte_mbuf *mbuf, mod_hook_t hook) {
+  if (hook == MOD_HOOK_INGRESS) {
+    return police_proc_ingress(config, mbuf);
+  }
+
+  return MOD_RET_ACCEPT;
+}
+
+// file format utf-8
+// ident using space
@@ -0,0 +1,65 @@
+#ifndef _M_POLICE_H_
+#define _M_POLICE_H_
+
+#include <rte_meter.h>
+
+#include "../config.h"
+#include "../module.h"
+
+/** policer id 0 is reserved for "no policer" */
+#define MAX_POLICER_NUM 256
+
+typedef enum {
+  POLICE_TYPE_NONE,
+  POLICE_TYPE_SRTCM,
+  POLICE_TYPE_TRTCM,
+} police_type_t;
+
+typedef enum {
+  POLICE_ACTION_PASS,
+  POLICE_ACTION_DROP,
+} police_action_t;
+
+typedef struct {
+  uint16_t id;
+  police_type_t type;
+  union {
+    struct rte_meter_srtcm_params srtcm;
+    struct rte_meter_trtcm_params trtcm;
+  } params;                               /** configured (per box) rates */
+  union {
+    struct rte_meter_srtcm_profile srtcm;
+    struct rte_meter_trtcm_profile trtcm;
+  } profile;                              /** per lcore share of the rates */
+  uint8_t actions[RTE_COLORS];            /** color to action mapping */
+} policer_t;
+
+/** Meter state is kept per lcore, so the hot path never touches a cache line
+ * written by another lcore and no atomics are needed. Each lcore polices its
+ * own share of the configured rate.
+ * */
+typedef struct {
+  union {
+    struct rte_meter_srtcm srtcm;
+    struct rte_meter_trtcm trtcm;
+  } meters[MAX_POLICER_NUM];
+  uint64_t stats[MAX_POLICER_NUM][RTE_COLORS];
+} __rte_cache_aligned police_lcore_t;
+
+typedef struct {
+  policer_t policers[MAX_POLICER_NUM];
+  uint16_t zones[MAX_PORT_NUM];           /** policer of each ingress port */
+  uint16_t lcore_num;                     /** lcores sharing the rates */
+  police_lcore_t lcores[MAX_WORKER_NUM];
+} police_ctx_t;
+
+int police_init(void *config);
+mod_ret_t police_proc(void *config, struct rte_mbuf *mbuf, mod_hook_t hook);
+int police_conf(void *config);
+int police_free(void *config);
+int police_move(void *config);
+
+#endif
+
+// file format utf-8
+// ident using space
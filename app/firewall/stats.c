@@ -0,0 +1,110 @@
+#include <stdio.h>
+
+#include <rte_memzone.h>
+
+#include "config.h"
+#include "worker.h"
+
+#include "stats.h"
+
+stats_shm_t *stats_shm;
+
+static void stats_ring_add(struct rte_ring *r) {
+  if (!r || (stats_shm->ring_num == MAX_STATS_RING)) {
+    return;
+  }
+
+  snprintf(stats_shm->rings[stats_shm->ring_num++], RTE_RING_NAMESIZE, "%s",
+           r->name);
+}
+
+void stats_table_add(const char *owner, const char *name, int lcore_id,
+                     uint32_t entries) {
+  stats_table_t *t;
+  uint32_t i;
+
+  if (!stats_shm) {
+    return;
+  }
+
+  // modules without conf keep their tables across reloads
+  for (i = 0; i < stats_shm->table_num; i++) {
+    if (!strcmp(stats_shm->tables[i].name, name)) {
+      return;
+    }
+  }
+
+  if (stats_shm->table_num == MAX_STATS_TABLE) {
+    printf("too many stats tables, %s ignored\n", name);
+    return;
+  }
+
+  stats_shm->seq++;
+  rte_smp_wmb();
+
+  t = &stats_shm->tables[stats_shm->table_num];
+  snprintf(t->name, sizeof(t->name), "%s", name);
+  snprintf(t->owner, sizeof(t->owner), "%s", owner);
+  t->lcore_id = lcore_id;
+  t->entries = entries;
+  stats_shm->table_num++;
+
+  rte_smp_wmb();
+  stats_shm->seq++;
+}
+
+void stats_publish(void *config) {
+  config_t *c = config;
+  int p, q;
+
+  if (!stats_shm) {
+    return;
+  }
+
+  stats_shm->seq++;
+  rte_smp_wmb();
+
+  stats_shm->config_version = c->version;
+  stats_shm->worker_num = c->worker_num;
+  stats_shm->workers = c->workers;
+  memcpy(stats_shm->dispatch, c->dispatch, sizeof(stats_shm->dispatch));
+  snprintf(stats_shm->pool, sizeof(stats_shm->pool), "%s",
+           c->pktmbuf_pool ? c->pktmbuf_pool->name : "");
+
+  stats_shm->ring_num = 0;
+  for (q = 0; q < c->rxq_num; q++) {
+    stats_ring_add(c->rx_queues[q]);
+  }
+  for (p = 0; p < MAX_PORT_NUM; p++) {
+    for (q = 0; q < MAX_QUEUE_NUM; q++) {
+      stats_ring_add(c->tx_queues[p][q]);
+    }
+    stats_ring_add(c->ctrl_queues[p]);
+  }
+
+  rte_smp_wmb();
+  stats_shm->seq++;
+}
+
+int stats_init(void *config) {
+  const struct rte_memzone *mz;
+
+  mz = rte_memzone_reserve(STATS_MZ_NAME, sizeof(stats_shm_t), SOCKET_ID_ANY,
+                           RTE_MEMZONE_SIZE_HINT_ONLY);
+  if (!mz) {
+    printf("reserve stats memzone failed\n");
+    return -1;
+  }
+
+  stats_shm = mz->addr;
+  memset(stats_shm, 0, sizeof(stats_shm_t));
+  stats_shm->magic = STATS_MAGIC;
+  stats_shm->size = sizeof(stats_shm_t);
+
+  stats_publish(config);
+
+  return 0;
+}
+
+// file format utf-8
+// ident using space
@@ -0,0 +1,91 @@
+#ifndef _M_STATS_H_
+#define _M_STATS_H_
+
+/** Counters and a directory of shared objects published in a memzone, so a
+ * secondary process (firewall-stat) reads them without the cli. Everything
+ * referenced from here lives in hugepage memory, rings and hash tables are
+ * published by name and looked up by the reader.
+ * */
+
+#include <rte_branch_prediction.h>
+#include <rte_common.h>
+#include <rte_hash.h>
+#include <rte_lcore.h>
+#include <rte_mempool.h>
+#include <rte_ring.h>
+
+#include "config.h"
+
+#define STATS_MZ_NAME "firewall_stats"
+#define STATS_MAGIC 0x46575354  // "FWST"
+
+#define MAX_STATS_RING 128
+#define MAX_STATS_TABLE 32
+#define MAX_STATS_ACL_RULE 4096  // hits of rule id 0 count larger ids
+
+/** written by its own lcore only */
+typedef struct {
+  uint64_t rx;       // packets read from nic
+  uint64_t tx;       // packets sent to nic
+  uint64_t tx_drop;  // nic tx failed or tx ring full
+  uint64_t proc;     // packets through the module chain
+  uint64_t stolen;   // dropped or consumed by a module
+} __rte_cache_aligned stats_lcore_t;
+
+typedef struct {
+  char name[RTE_HASH_NAMESIZE];
+  char owner[16];    // module name
+  int lcore_id;
+  uint32_t entries;  // capacity
+} stats_table_t;
+
+/** seq is odd while mgmt rewrites the directory, readers retry */
+typedef struct {
+  uint32_t magic;
+  uint32_t size;                 // sizeof(stats_shm_t), layout check
+  volatile uint32_t seq;
+  uint32_t config_version;
+
+  // directory
+  int worker_num;
+  void *workers;                 // worker_t array, hugepage memory
+  uint8_t dispatch[MAX_DISPATCH_NUM];
+  char pool[RTE_MEMPOOL_NAMESIZE];
+  uint32_t ring_num;
+  char rings[MAX_STATS_RING][RTE_RING_NAMESIZE];
+  uint32_t table_num;
+  stats_table_t tables[MAX_STATS_TABLE];
+
+  // counters
+  stats_lcore_t lcores[MAX_WORKER_NUM];
+  uint64_t acl_hits[MAX_WORKER_NUM][MAX_STATS_ACL_RULE];
+} stats_shm_t;
+
+extern stats_shm_t *stats_shm;
+
+int stats_init(void *config);
+
+/** refresh the directory after reload, switch or worker scaling */
+void stats_publish(void *config);
+
+/** hash table of a module, shown with its occupancy */
+void stats_table_add(const char *owner, const char *name, int lcore_id,
+                     uint32_t entries);
+
+#define STATS_ADD(field, n)                                                    \
+  do {                                                                         \
+    if (likely(stats_shm != NULL)) {                                           \
+      stats_shm->lcores[rte_lcore_id()].field += (n);                          \
+    }                                                                          \
+  } while (0)
+
+static inline void stats_acl_hit(uint32_t id) {
+  if (likely(stats_shm != NULL)) {
+    stats_shm->acl_hits[rte_lcore_id()][id < MAX_STATS_ACL_RULE ? id : 0]++;
+  }
+}
+
+#endif
+
+// file format utf-8
+// ident using space
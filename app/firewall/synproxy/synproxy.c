@@ -0,0 +1,708 @@
+#include <rte_cycles.h>
+#include <rte_ether.h>
+#include <rte_hash.h>
+#include <rte_hash_crc.h>
+#include <rte_ip.h>
+#include <rte_lcore.h>
+#include <rte_malloc.h>
+#include <rte_random.h>
+#include <rte_ring.h>
+#include <rte_tcp.h>
+
+#include "../cli.h"
+#include "../config.h"
+#include "../json.h"
+#include "../module.h"
+#include "../packet.h"
+#include "../stats.h"
+#include "../worker.h"
+
+#include "../capture/capture.h"
+#include "synproxy.h"
+
+MODULE_DECLARE(synproxy) = {.name = "synproxy",
+                            .id = MOD_ID_SYNPROXY,
+                            .enabled = true,
+                            .log = true,
+                            .init = synproxy_init,
+                            .proc = synproxy_proc,
+                            .conf = NULL,
+                            .free = NULL,
+                            .priv = NULL,
+                            .move = synproxy_move,
+                            .hooks = MOD_HOOK_BIT(MOD_HOOK_INGRESS)};
+
+// mss values encoded in the lower 3 bits of a cookie
+static const uint16_t synproxy_mss_table[8] = {
+  536, 1220, 1360, 1440, 1452, 1460, 4312, 8960,
+};
+
+static const char *synproxy_stat_name[SYNPROXY_STAT_MAX] = {
+  [SYNPROXY_STAT_SYN] = "syn",
+  [SYNPROXY_STAT_COOKIE_SENT] = "cookie sent",
+  [SYNPROXY_STAT_COOKIE_VALID] = "cookie valid",
+  [SYNPROXY_STAT_COOKIE_INVALID] = "cookie invalid",
+  [SYNPROXY_STAT_ESTABLISHED] = "established",
+  [SYNPROXY_STAT_EXPIRED] = "expired",
+  [SYNPROXY_STAT_FLOW_FULL] = "flow full",
+  [SYNPROXY_STAT_TX_FAIL] = "tx fail",
+  [SYNPROXY_STAT_MOVED] = "moved",
+};
+
+#define SYNPROXY_TCP_FLAGS                                                     \
+  (RTE_TCP_SYN_FLAG | RTE_TCP_ACK_FLAG | RTE_TCP_RST_FLAG | RTE_TCP_FIN_FLAG)
+
+#define SYNPROXY_TCP_HDR_LEN(th) (((th)->data_off >> 4) << 2)
+
+static int synproxy_load(synproxy_ctx_t *ctx) {
+  json_object *jr = NULL, *jv;
+
+  ctx->enabled = false;
+  ctx->flow_num = DEF_SYNPROXY_FLOW_NUM;
+
+  jr = JR(CONFIG_PATH, "synproxy.json");
+  if (!jr) {
+    printf("no synproxy config, synproxy disabled\n");
+    return 0;
+  }
+
+  jv = JV(jr, "enabled");
+  if (jv) {
+    ctx->enabled = JV_I(jv) ? true : false;
+  }
+
+  jv = JV(jr, "flows");
+  if (jv && (JV_I(jv) > 0)) {
+    ctx->flow_num = JV_I(jv);
+  }
+
+  printf("synproxy enabled %d flows %u\n", ctx->enabled, ctx->flow_num);
+
+  JR_FREE(jr);
+  return 0;
+}
+
+static int synproxy_setup(config_t *config, synproxy_ctx_t *ctx) {
+  struct rte_hash_parameters params = {0};
+  worker_t *worker;
+  char name[RTE_HASH_NAMESIZE];
+  int i;
+
+  for (i = 0; i < config->worker_num; i++) {
+    synproxy_lcore_t *lc;
+
+    worker = (worker_t *)config->workers + i;
+    if ((worker->role != ROLE_WORKER) && (worker->role != ROLE_RTX_WORKER)) {
+      continue;
+    }
+
+    lc = &ctx->lcores[worker->lcore_id];
+
+    snprintf(name, sizeof(name), "synproxy-%d", worker->lcore_id);
+    params.name = name;
+    params.entries = ctx->flow_num;
+    params.key_len = sizeof(synproxy_key_t);
+    params.hash_func = rte_hash_crc;
+    params.hash_func_init_val = 0;
+    params.socket_id = rte_lcore_to_socket_id(worker->lcore_id);
+
+    lc->flows = rte_hash_create(&params);
+    if (!lc->flows) {
+      printf("create synproxy flow table %s failed\n", name);
+      return -1;
+    }
+    stats_table_add("synproxy", name, worker->lcore_id, ctx->flow_num);
+
+    lc->entries = rte_zmalloc_socket(name,
+                                     sizeof(synproxy_flow_t) * ctx->flow_num,
+                                     RTE_CACHE_LINE_SIZE, params.socket_id);
+    if (!lc->entries) {
+      printf("alloc synproxy flow entries %s failed\n", name);
+      return -1;
+    }
+  }
+
+  return 0;
+}
+
+static int synproxy_show(struct cli_def *cli, const char *command,
+                         char *argv[], int argc) {
+  config_t *c = cli_get_context(cli);
+  synproxy_ctx_t *ctx = c->synproxy_ctx;
+  uint64_t stats[SYNPROXY_STAT_MAX] = {0};
+  int i, j, flows = 0;
+
+  CLI_PRINT(cli, "command %s argv[0] %s argc %d", command, argv[0], argc);
+
+  if (!ctx) {
+    return 0;
+  }
+
+  for (i = 0; i < MAX_WORKER_NUM; i++) {
+    synproxy_lcore_t *lc = &ctx->lcores[i];
+
+    if (!lc->flows) {
+      continue;
+    }
+
+    CLI_PRINT(cli, "lcore %d flows %d", i, rte_hash_count(lc->flows));
+    flows += rte_hash_count(lc->flows);
+
+    for (j = 0; j < SYNPROXY_STAT_MAX; j++) {
+      stats[j] += lc->stats[j];
+    }
+  }
+
+  CLI_PRINT(cli, "enabled: %d", ctx->enabled);
+  CLI_PRINT(cli, "flows: %d/%u per lcore", flows, ctx->flow_num);
+  for (j = 0; j < SYNPROXY_STAT_MAX; j++) {
+    CLI_PRINT(cli, "%s: %lu", synproxy_stat_name[j], stats[j]);
+  }
+
+  return 0;
+}
+
+static void synproxy_cli_register(config_t *config) {
+  struct cli_def *cli_def;
+  struct cli_command *c;
+
+  if (!config) {
+    return;
+  }
+
+  cli_def = config->cli_def;
+  if (!cli_def) {
+    return;
+  }
+
+  c = CLI_CMD_C(cli_def, NULL, "synproxy", NULL, "syn flood protection");
+  CLI_CMD_C(cli_def, c, "show", synproxy_show, "show synproxy counters");
+}
+
+int synproxy_init(void *config) {
+  config_t *c = config;
+  synproxy_ctx_t *ctx;
+  uint64_t hz = rte_get_tsc_hz();
+  int i;
+
+  ctx = rte_zmalloc("synproxy_ctx", sizeof(synproxy_ctx_t),
+                    RTE_CACHE_LINE_SIZE);
+  if (!ctx) {
+    printf("alloc synproxy ctx failed\n");
+    return -1;
+  }
+
+  synproxy_load(ctx);
+
+  ctx->secret = (uint32_t)rte_rand();
+  ctx->cookie_period = hz * SYNPROXY_COOKIE_PERIOD;
+  ctx->age_interval = hz * SYNPROXY_AGE_INTERVAL / 1000;
+  ctx->timeout[SYNPROXY_STATE_SYN_SENT] = hz * 5;
+  ctx->timeout[SYNPROXY_STATE_ESTABLISHED] = hz * 300;
+  ctx->timeout[SYNPROXY_STATE_CLOSING] = hz * 10;
+
+  if (ctx->enabled && synproxy_setup(c, ctx)) {
+    for (i = 0; i < MAX_WORKER_NUM; i++) {
+      rte_hash_free(ctx->lcores[i].flows);
+      rte_free(ctx->lcores[i].entries);
+    }
+    rte_free(ctx);
+    return -1;
+  }
+
+  c->synproxy_ctx = ctx;
+  synproxy_cli_register(c);
+
+  return 0;
+}
+
+/** build the flow key, return 1 if source endpoint of packet comes first */
+static inline int synproxy_key(packet_t *p, synproxy_key_t *k) {
+  int first;
+
+  memset(k, 0, sizeof(*k));
+
+  if (p->is_v4) {
+    uint32_t sip = rte_be_to_cpu_32(p->tuple.v4.sip);
+    uint32_t dip = rte_be_to_cpu_32(p->tuple.v4.dip);
+
+    first = (sip < dip) || ((sip == dip) && (p->tuple.v4.sp <= p->tuple.v4.dp));
+    k->ip[!first][0] = p->tuple.v4.sip;
+    k->ip[first][0] = p->tuple.v4.dip;
+    k->port[!first] = p->tuple.v4.sp;
+    k->port[first] = p->tuple.v4.dp;
+    k->is_v4 = 1;
+  } else {
+    int r = memcmp(p->tuple.v6.sip, p->tuple.v6.dip, 16);
+
+    first = (r < 0) || ((r == 0) && (p->tuple.v6.sp <= p->tuple.v6.dp));
+    memcpy(k->ip[!first], p->tuple.v6.sip, 16);
+    memcpy(k->ip[first], p->tuple.v6.dip, 16);
+    k->port[!first] = p->tuple.v6.sp;
+    k->port[first] = p->tuple.v6.dp;
+  }
+
+  return first;
+}
+
+static inline uint32_t synproxy_cookie_hash(synproxy_ctx_t *ctx, packet_t *p,
+                                            uint32_t slot) {
+  uint32_t h = ctx->secret ^ slot;
+
+  if (p->is_v4) {
+    h = rte_hash_crc_4byte(p->tuple.v4.sip, h);
+    h = rte_hash_crc_4byte(p->tuple.v4.dip, h);
+    h = rte_hash_crc_2byte(p->tuple.v4.sp, h);
+    h = rte_hash_crc_2byte(p->tuple.v4.dp, h);
+  } else {
+    h = rte_hash_crc(p->tuple.v6.sip, 16, h);
+    h = rte_hash_crc(p->tuple.v6.dip, 16, h);
+    h = rte_hash_crc_2byte(p->tuple.v6.sp, h);
+    h = rte_hash_crc_2byte(p->tuple.v6.dp, h);
+  }
+
+  return h;
+}
+
+static inline uint32_t synproxy_cookie_make(synproxy_ctx_t *ctx, packet_t *p,
+                                            uint64_t tsc, uint32_t isn,
+                                            uint8_t mss_idx) {
+  uint32_t slot = tsc / ctx->cookie_period;
+  return ((synproxy_cookie_hash(ctx, p, slot) + isn) & ~0x7U) | mss_idx;
+}
+
+/** check cookie against current and previous time slot, return mss index on
+ * success, -1 for a failure
+ * */
+static inline int synproxy_cookie_check(synproxy_ctx_t *ctx, packet_t *p,
+                                        uint64_t tsc, uint32_t isn,
+                                        uint32_t cookie) {
+  uint32_t slot = tsc / ctx->cookie_period;
+
+  if (!(((synproxy_cookie_hash(ctx, p, slot) + isn) ^ cookie) & ~0x7U))
+    return cookie & 0x7;
+
+  if (!(((synproxy_cookie_hash(ctx, p, slot - 1) + isn) ^ cookie) & ~0x7U))
+    return cookie & 0x7;
+
+  return -1;
+}
+
+/** pick the largest mss in table not above the one client announced */
+static uint8_t synproxy_mss_idx(struct rte_tcp_hdr *th) {
+  uint8_t *opt = (uint8_t *)(th + 1);
+  int len = SYNPROXY_TCP_HDR_LEN(th) - sizeof(*th);
+  uint16_t mss = synproxy_mss_table[0];
+  uint8_t i;
+
+  while (len > 0) {
+    if (opt[0] == 0)
+      break;
+    if (opt[0] == 1) {
+      opt++;
+      len--;
+      continue;
+    }
+    if ((len < 2) || (opt[1] < 2) || (opt[1] > len))
+      break;
+    if ((opt[0] == 2) && (opt[1] == 4)) {
+      mss = (opt[2] << 8) | opt[3];
+      break;
+    }
+    len -= opt[1];
+    opt += opt[1];
+  }
+
+  for (i = RTE_DIM(synproxy_mss_table) - 1; i > 0; i--) {
+    if (synproxy_mss_table[i] <= mss)
+      break;
+  }
+
+  return i;
+}
+
+/** Rewrite tcp packet in place, no extra mbuf is needed so a syn flood can
+ * never exhaust the pool. If reverse is set, the packet is turned around
+ * and sent back to where it came from.
+ * */
+static int synproxy_rewrite(struct rte_mbuf *mbuf, packet_t *p, uint32_t seq,
+                            uint32_t ack, uint8_t flags, uint16_t mss,
+                            bool reverse) {
+  struct rte_tcp_hdr *th;
+  uint16_t tcp_len = sizeof(*th) + (mss ? 4 : 0);
+  uint32_t len = mbuf->l2_len + mbuf->l3_len + tcp_len;
+
+  if (rte_pktmbuf_data_len(mbuf) > len) {
+    rte_pktmbuf_trim(mbuf, rte_pktmbuf_data_len(mbuf) - len);
+  } else if (rte_pktmbuf_data_len(mbuf) < len) {
+    if (!rte_pktmbuf_append(mbuf, len - rte_pktmbuf_data_len(mbuf)))
+      return -1;
+  }
+
+  if (reverse) {
+    struct rte_ether_hdr *eh = rte_pktmbuf_mtod(mbuf, struct rte_ether_hdr *);
+    struct rte_ether_addr addr;
+
+    rte_ether_addr_copy(&eh->src_addr, &addr);
+    rte_ether_addr_copy(&eh->dst_addr, &eh->src_addr);
+    rte_ether_addr_copy(&addr, &eh->dst_addr);
+  }
+
+  th = rte_pktmbuf_mtod_offset(mbuf, struct rte_tcp_hdr *,
+                               mbuf->l2_len + mbuf->l3_len);
+  if (reverse) {
+    uint16_t port = th->src_port;
+    th->src_port = th->dst_port;
+    th->dst_port = port;
+  }
+  th->sent_seq = rte_cpu_to_be_32(seq);
+  th->recv_ack = rte_cpu_to_be_32(ack);
+  th->data_off = (tcp_len >> 2) << 4;
+  th->tcp_flags = flags;
+  th->tcp_urp = 0;
+  th->cksum = 0;
+
+  if (mss) {
+    uint8_t *opt = (uint8_t *)(th + 1);
+    opt[0] = 2;
+    opt[1] = 4;
+    opt[2] = mss >> 8;
+    opt[3] = mss & 0xff;
+  }
+
+  if (p->is_v4) {
+    struct rte_ipv4_hdr *ip4h = rte_pktmbuf_mtod_offset(
+        mbuf, struct rte_ipv4_hdr *, mbuf->l2_len);
+
+    if (reverse) {
+      uint32_t addr = ip4h->src_addr;
+      ip4h->src_addr = ip4h->dst_addr;
+      ip4h->dst_addr = addr;
+      ip4h->time_to_live = 64;
+    }
+    ip4h->total_length = rte_cpu_to_be_16(mbuf->l3_len + tcp_len);
+    ip4h->hdr_checksum = 0;
+    ip4h->hdr_checksum = rte_ipv4_cksum(ip4h);
+    th->cksum = rte_ipv4_udptcp_cksum(ip4h, th);
+  } else {
+    struct rte_ipv6_hdr *ip6h = rte_pktmbuf_mtod_offset(
+        mbuf, struct rte_ipv6_hdr *, mbuf->l2_len);
+
+    if (reverse) {
+      struct rte_ipv6_addr addr = ip6h->src_addr;
+      ip6h->src_addr = ip6h->dst_addr;
+      ip6h->dst_addr = addr;
+      ip6h->hop_limits = 64;
+    }
+    ip6h->payload_len = rte_cpu_to_be_16(tcp_len);
+    th->cksum = rte_ipv6_udptcp_cksum(ip6h, th);
+  }
+
+  mbuf->ol_flags = 0;
+  return 0;
+}
+
+static mod_ret_t synproxy_send_back(config_t *config, synproxy_lcore_t *lc,
+                                    struct rte_mbuf *mbuf, packet_t *p) {
+  if (!config->ctrl_queues[p->port_in] ||
+      rte_ring_enqueue(config->ctrl_queues[p->port_in], mbuf)) {
+    lc->stats[SYNPROXY_STAT_TX_FAIL]++;
+    rte_pktmbuf_free(mbuf);
+  }
+  return MOD_RET_STOLEN;
+}
+
+/** answer a syn with a cookie encoded syn-ack, keep no state */
+static mod_ret_t synproxy_syn(config_t *config, synproxy_ctx_t *ctx,
+                              synproxy_lcore_t *lc, struct rte_mbuf *mbuf,
+                              packet_t *p, struct rte_tcp_hdr *th,
+                              uint64_t tsc) {
+  uint32_t isn = rte_be_to_cpu_32(th->sent_seq);
+  uint8_t mss_idx = synproxy_mss_idx(th);
+  uint32_t cookie = synproxy_cookie_make(ctx, p, tsc, isn, mss_idx);
+
+  lc->stats[SYNPROXY_STAT_SYN]++;
+
+  if (synproxy_rewrite(mbuf, p, cookie, isn + 1,
+                       RTE_TCP_SYN_FLAG | RTE_TCP_ACK_FLAG,
+                       synproxy_mss_table[mss_idx], true)) {
+    rte_pktmbuf_free(mbuf);
+    return MOD_RET_STOLEN;
+  }
+
+  lc->stats[SYNPROXY_STAT_COOKIE_SENT]++;
+  return synproxy_send_back(config, lc, mbuf, p);
+}
+
+/** validate the returning ack statelessly, only a valid cookie creates state
+ * and the ack is turned into a syn towards the server
+ * */
+static mod_ret_t synproxy_ack(config_t *config, synproxy_ctx_t *ctx,
+                              synproxy_lcore_t *lc, struct rte_mbuf *mbuf,
+                              packet_t *p,
+                              struct rte_tcp_hdr *th, synproxy_key_t *k,
+                              int first, uint64_t tsc) {
+  uint32_t isn = rte_be_to_cpu_32(th->sent_seq) - 1;
+  uint32_t cookie = rte_be_to_cpu_32(th->recv_ack) - 1;
+  synproxy_flow_t *flow;
+  int32_t pos;
+  int mss_idx;
+
+  mss_idx = synproxy_cookie_check(ctx, p, tsc, isn, cookie);
+  if (mss_idx < 0) {
+    lc->stats[SYNPROXY_STAT_COOKIE_INVALID]++;
+    goto drop;
+  }
+
+  lc->stats[SYNPROXY_STAT_COOKIE_VALID]++;
+
+  pos = rte_hash_add_key(lc->flows, k);
+  if (pos < 0) {
+    lc->stats[SYNPROXY_STAT_FLOW_FULL]++;
+    goto drop;
+  }
+
+  flow = &lc->entries[pos];
+  flow->state = SYNPROXY_STATE_SYN_SENT;
+  flow->client_first = first;
+  flow->mss = synproxy_mss_table[mss_idx];
+  flow->bucket = p->bucket;
+  flow->client_isn = isn;
+  flow->cookie = cookie;
+  flow->delta = 0;
+  flow->expire = tsc + ctx->timeout[SYNPROXY_STATE_SYN_SENT];
+
+  if (synproxy_rewrite(mbuf, p, isn, 0, RTE_TCP_SYN_FLAG, flow->mss, false)) {
+    rte_hash_del_key(lc->flows, k);
+    goto drop;
+  }
+
+  return MOD_RET_ACCEPT;
+
+drop:
+  capture_drop(config, mbuf, MOD_ID_SYNPROXY);
+  rte_pktmbuf_free(mbuf);
+  return MOD_RET_STOLEN;
+}
+
+static mod_ret_t synproxy_flow(config_t *config, synproxy_ctx_t *ctx,
+                               synproxy_lcore_t *lc, struct rte_mbuf *mbuf,
+                               packet_t *p, struct rte_tcp_hdr *th,
+                               synproxy_key_t *k, synproxy_flow_t *flow,
+                               int first, uint64_t tsc) {
+  uint8_t flags = th->tcp_flags & SYNPROXY_TCP_FLAGS;
+  bool from_client = (first == flow->client_first);
+
+  if (flow->state == SYNPROXY_STATE_SYN_SENT) {
+    uint32_t server_isn;
+
+    // anything but the server's syn-ack is dropped, client will retransmit
+    if (from_client || (flags != (RTE_TCP_SYN_FLAG | RTE_TCP_ACK_FLAG)) ||
+        (rte_be_to_cpu_32(th->recv_ack) != flow->client_isn + 1)) {
+      goto drop;
+    }
+
+    server_isn = rte_be_to_cpu_32(th->sent_seq);
+    flow->delta = server_isn - flow->cookie;
+    flow->state = SYNPROXY_STATE_ESTABLISHED;
+    flow->expire = tsc + ctx->timeout[SYNPROXY_STATE_ESTABLISHED];
+    lc->stats[SYNPROXY_STAT_ESTABLISHED]++;
+
+    // complete the server side handshake on behalf of client
+    if (synproxy_rewrite(mbuf, p, flow->client_isn + 1, server_isn + 1,
+                         RTE_TCP_ACK_FLAG, 0, true)) {
+      goto drop;
+    }
+
+    return synproxy_send_back(config, lc, mbuf, p);
+  }
+
+  // a new connection reuses the tuple of an old one
+  if (from_client && (flags == RTE_TCP_SYN_FLAG)) {
+    rte_hash_del_key(lc->flows, k);
+    return synproxy_syn(config, ctx, lc, mbuf, p, th, tsc);
+  }
+
+  // translate sequence between cookie and server isn space
+  if (from_client) {
+    if (flags & RTE_TCP_ACK_FLAG) {
+      uint32_t old = th->recv_ack;
+      th->recv_ack =
+          rte_cpu_to_be_32(rte_be_to_cpu_32(th->recv_ack) + flow->delta);
+      th->cksum = packet_cksum_adjust(th->cksum, old, th->recv_ack);
+    }
+  } else {
+    uint32_t old = th->sent_seq;
+    th->sent_seq =
+        rte_cpu_to_be_32(rte_be_to_cpu_32(th->sent_seq) - flow->delta);
+    th->cksum = packet_cksum_adjust(th->cksum, old, th->sent_seq);
+  }
+
+  if (flags & (RTE_TCP_RST_FLAG | RTE_TCP_FIN_FLAG)) {
+    flow->state = SYNPROXY_STATE_CLOSING;
+  }
+  flow->expire = tsc + ctx->timeout[flow->state];
+
+  return MOD_RET_ACCEPT;
+
+drop:
+  capture_drop(config, mbuf, MOD_ID_SYNPROXY);
+  rte_pktmbuf_free(mbuf);
+  return MOD_RET_STOLEN;
+}
+
+/** scan a bounded number of entries per interval, cost never depends on
+ * table size
+ * */
+static void synproxy_age(synproxy_ctx_t *ctx, synproxy_lcore_t *lc,
+                         uint64_t tsc) {
+  const void *key;
+  void *data;
+  int32_t pos;
+  int i;
+
+  if (tsc < lc->age_tsc) {
+    return;
+  }
+  lc->age_tsc = tsc + ctx->age_interval;
+
+  for (i = 0; i < SYNPROXY_AGE_BUDGET; i++) {
+    pos = rte_hash_iterate(lc->flows, &key, &data, &lc->age_next);
+    if (pos < 0) {
+      lc->age_next = 0;
+      break;
+    }
+
+    if (lc->entries[pos].expire < tsc) {
+      rte_hash_del_key(lc->flows, key);
+      lc->stats[SYNPROXY_STAT_EXPIRED]++;
+    }
+  }
+}
+
+/** hand flows over to the worker now owning their bucket, all workers are
+ * held while this runs
+ * */
+int synproxy_move(void *config) {
+  config_t *c = config;
+  synproxy_ctx_t *ctx = c->synproxy_ctx;
+  synproxy_lcore_t *src, *dst;
+  const void *key;
+  void *data;
+  uint32_t next;
+  int32_t pos, npos;
+  int i, owner;
+
+  if (!ctx || !ctx->enabled) {
+    return 0;
+  }
+
+  for (i = 0; i < MAX_WORKER_NUM; i++) {
+    src = &ctx->lcores[i];
+    if (!src->flows) {
+      continue;
+    }
+
+    next = 0;
+    while ((pos = rte_hash_iterate(src->flows, &key, &data, &next)) >= 0) {
+      owner = worker_bucket_owner(c, src->entries[pos].bucket);
+      if ((owner < 0) || (owner == i) || !ctx->lcores[owner].flows) {
+        continue;
+      }
+
+      dst = &ctx->lcores[owner];
+      npos = rte_hash_add_key(dst->flows, key);
+      if (npos < 0) {
+        dst->stats[SYNPROXY_STAT_FLOW_FULL]++;
+      } else {
+        dst->entries[npos] = src->entries[pos];
+        src->stats[SYNPROXY_STAT_MOVED]++;
+      }
+      rte_hash_del_key(src->flows, key);
+    }
+    src->age_next = 0;
+  }
+
+  return 0;
+}
+
+static mod_ret_t synproxy_proc_ingress(config_t *config,
+                                       struct rte_mbuf *mbuf) {
+  synproxy_ctx_t *ctx = config->synproxy_ctx;
+  synproxy_lcore_t *lc;
+  struct rte_tcp_hdr *th;
+  synproxy_key_t k;
+  packet_t *p;
+  uint64_t tsc;
+  uint8_t flags;
+  int32_t pos;
+  int first;
+
+  if (!ctx || !ctx->enabled) {
+    return MOD_RET_ACCEPT;
+  }
+
+  p = rte_mbuf_to_priv(mbuf);
+  if (!p) {
+    return MOD_RET_ACCEPT;
+  }
+
+  // only plain tcp is proxied, packet must be rewritable in place
+  if (((p->ptype & RTE_PTYPE_L4_MASK) != RTE_PTYPE_L4_TCP) ||
+      (p->ptype & RTE_PTYPE_TUNNEL_MASK) || (mbuf->nb_segs > 1) ||
+      (!p->is_v4 && (mbuf->l3_len != sizeof(struct rte_ipv6_hdr)))) {
+    return MOD_RET_ACCEPT;
+  }
+
+  lc = &ctx->lcores[rte_lcore_id()];
+  if (!lc->flows) {
+    return MOD_RET_ACCEPT;
+  }
+
+  if (rte_pktmbuf_data_len(mbuf) < mbuf->l2_len + mbuf->l3_len + sizeof(*th)) {
+    goto drop;
+  }
+
+  th = rte_pktmbuf_mtod_offset(mbuf, struct rte_tcp_hdr *,
+                               mbuf->l2_len + mbuf->l3_len);
+  if (rte_pktmbuf_data_len(mbuf) <
+      mbuf->l2_len + mbuf->l3_len + SYNPROXY_TCP_HDR_LEN(th)) {
+    goto drop;
+  }
+
+  tsc = rte_rdtsc();
+  synproxy_age(ctx, lc, tsc);
+
+  first = synproxy_key(p, &k);
+  pos = rte_hash_lookup(lc->flows, &k);
+  if (pos >= 0) {
+    return synproxy_flow(config, ctx, lc, mbuf, p, th, &k, &lc->entries[pos],
+                         first, tsc);
+  }
+
+  flags = th->tcp_flags & SYNPROXY_TCP_FLAGS;
+  if (flags == RTE_TCP_SYN_FLAG) {
+    return synproxy_syn(config, ctx, lc, mbuf, p, th, tsc);
+  }
+
+  if (flags == RTE_TCP_ACK_FLAG) {
+    return synproxy_ack(config, ctx, lc, mbuf, p, th, &k, first, tsc);
+  }
+
+  // no state and not part of a handshake
+drop:
+  capture_drop(config, mbuf, MOD_ID_SYNPROXY);
+  rte_pktmbuf_free(mbuf);
+  return MOD_RET_STOLEN;
+}
+
+mod_ret_t synproxy_proc(void *config, struct rte_mbuf *mbuf, mod_hook_t hook) {
+  if (hook == MOD_HOOK_INGRESS) {
+    return synproxy_proc_ingress(config, mbuf);
+  }
+
+  return MOD_RET_ACCEPT;
+}
+
+// file format utf-8
+// ident using space
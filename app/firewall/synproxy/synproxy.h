@@ -0,0 +1,88 @@
+#ifndef _M_SYNPROXY_H_
+#define _M_SYNPROXY_H_
+
+#include <rte_hash.h>
+
+#include "../config.h"
+#include "../module.h"
+
+#define DEF_SYNPROXY_FLOW_NUM (1U << 18)
+
+// cookie time slot is 64 seconds, a cookie is valid for one to two slots
+#define SYNPROXY_COOKIE_PERIOD 64
+
+// flow table aging, scan at most budget entries every interval (ms)
+#define SYNPROXY_AGE_INTERVAL 100
+#define SYNPROXY_AGE_BUDGET 64
+
+typedef enum {
+  SYNPROXY_STATE_NONE,
+  SYNPROXY_STATE_SYN_SENT,     // cookie validated, syn sent to server
+  SYNPROXY_STATE_ESTABLISHED,  // server answered, sequence translated
+  SYNPROXY_STATE_CLOSING,      // fin or rst seen
+  SYNPROXY_STATE_MAX,
+} synproxy_state_t;
+
+typedef enum {
+  SYNPROXY_STAT_SYN,
+  SYNPROXY_STAT_COOKIE_SENT,
+  SYNPROXY_STAT_COOKIE_VALID,
+  SYNPROXY_STAT_COOKIE_INVALID,
+  SYNPROXY_STAT_ESTABLISHED,
+  SYNPROXY_STAT_EXPIRED,
+  SYNPROXY_STAT_FLOW_FULL,
+  SYNPROXY_STAT_TX_FAIL,
+  SYNPROXY_STAT_MOVED,         // handed over to another worker
+  SYNPROXY_STAT_MAX,
+} synproxy_stat_t;
+
+/** Both directions of a flow share one key, endpoints are sorted so that
+ * the lower (ip, port) pair always comes first.
+ * */
+typedef struct {
+  uint32_t ip[2][4];
+  uint16_t port[2];
+  uint8_t is_v4;
+  uint8_t pad[3];
+} synproxy_key_t;
+
+typedef struct {
+  uint8_t state;
+  uint8_t client_first;  // client is the first endpoint of the key
+  uint16_t mss;
+  uint16_t bucket;       // dispatch bucket, tells the owner worker
+  uint32_t client_isn;
+  uint32_t cookie;       // isn we answered the client with
+  uint32_t delta;        // server isn - cookie
+  uint64_t expire;       // tsc
+} synproxy_flow_t;
+
+/** Flow state is owned by one lcore, symmetric rss keeps both directions of a
+ * flow on the same worker.
+ * */
+typedef struct {
+  struct rte_hash *flows;
+  synproxy_flow_t *entries;  // indexed by key position of flows
+  uint32_t age_next;
+  uint64_t age_tsc;
+  uint64_t stats[SYNPROXY_STAT_MAX];
+} __rte_cache_aligned synproxy_lcore_t;
+
+typedef struct {
+  bool enabled;
+  uint32_t secret;
+  uint32_t flow_num;
+  uint64_t cookie_period;                   // tsc
+  uint64_t age_interval;                    // tsc
+  uint64_t timeout[SYNPROXY_STATE_MAX];     // tsc
+  synproxy_lcore_t lcores[MAX_WORKER_NUM];
+} synproxy_ctx_t;
+
+int synproxy_init(void *config);
+mod_ret_t synproxy_proc(void *config, struct rte_mbuf *mbuf, mod_hook_t hook);
+int synproxy_move(void *config);
+
+#endif
+
+// file format utf-8
+// ident using space
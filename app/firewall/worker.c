@@ -1,14 +1,20 @@
 #include <stdio.h>
 #include <unistd.h>
 
+#include <rte_cpuflags.h>
+#include <rte_cycles.h>
 #include <rte_lcore.h>
+#include <rte_malloc.h>
 #include <rte_mbuf.h>
+#include <rte_power_intrinsics.h>
 #include <rte_ring.h>
 #include <rte_ethdev.h>
 
 #include "config.h"
+#include "evlog.h"
 #include "module.h"
 #include "packet.h"
+#include "stats.h"
 #include "worker.h"
 #include "json.h"
 
@@ -46,6 +52,28 @@ static int worker_split_queue_by_comma(const char *str, uint16_t queues[], int m
   return worker_split_port_by_comma(str, queues, max);
 }
 
+static void worker_idle_load(worker_t *worker, json_object *jo) {
+  struct rte_cpu_intrinsics intrinsics;
+  json_object *jv;
+  uint32_t us = WORKER_IDLE_SLEEP;
+
+  rte_cpu_get_intrinsics_support(&intrinsics);
+  worker->idle.monitor = intrinsics.power_monitor ? true : false;
+  worker->idle.power_pause = intrinsics.power_pause ? true : false;
+
+  worker->idle.mode = IDLE_POLL;
+  jv = JV(jo, "idle");
+  if (jv && (strcmp(JV_S(jv), "adaptive") == 0)) {
+    worker->idle.mode = IDLE_ADAPTIVE;
+  }
+
+  jv = JV(jo, "idle_us");
+  if (jv && (JV_I(jv) > 0)) {
+    us = JV_I(jv);
+  }
+  worker->idle.sleep_tsc = rte_get_tsc_hz() * us / 1000000;
+}
+
 static int worker_load(config_t *config) {
   worker_t *workers = NULL;
   json_object *jr = NULL, *ja;
@@ -66,12 +94,27 @@ static int worker_load(config_t *config) {
     goto done;
   }
 
-  workers = (worker_t *)malloc(sizeof(worker_t) * worker_num);
+  // optional, fixed size of work and tx rings
+  if (JV(jr, "ring_size")) {
+    config->ring_size = JV_I(JV(jr, "ring_size"));
+    if (!rte_is_power_of_2(config->ring_size)) {
+      printf("ring size %u is not power of 2\n", config->ring_size);
+      goto done;
+    }
+  }
+
+  // hugepage memory, firewall-stat reads idle counters of workers
+  workers = (worker_t *)rte_zmalloc("workers", sizeof(worker_t) * worker_num,
+                                    RTE_CACHE_LINE_SIZE);
   if (!workers) {
     goto done;
   }
 
   memset(workers, 0, sizeof(worker_t) * worker_num);
+  for (i = 0; i < worker_num; i++) {
+    workers[i].work_id = -1;
+    workers[i].txq_id = -1;
+  }
 
 #define WORKER_JV(item)                                                        \
   jv = JV(jo, item);                                                           \
@@ -116,6 +159,12 @@ static int worker_load(config_t *config) {
         goto done;
       }
 
+    }
+
+    // tx lcores own their nic tx queue, only receiving lcores list queues
+    if ((workers[i].role == ROLE_RX)
+    ||  (workers[i].role == ROLE_RTX)
+    ||  (workers[i].role == ROLE_RTX_WORKER)) {
       WORKER_JV("queues");
       workers[i].queue_num = worker_split_queue_by_comma(JV_S(jv), workers[i].queues, MAX_QUEUE_NUM);
       if (!workers[i].queue_num) {
@@ -124,10 +173,13 @@ static int worker_load(config_t *config) {
       }
     }
 
+    worker_idle_load(&workers[i], jo);
+
     config->worker_map[workers[i].lcore_id] = i;
 
-    printf("worker %d lcore_id %d role %d port_num %d queue_num %d\n", 
-           i, workers[i].lcore_id, workers[i].role, workers[i].port_num, workers[i].queue_num);
+    printf("worker %d lcore_id %d role %d port_num %d queue_num %d idle %d\n", 
+           i, workers[i].lcore_id, workers[i].role, workers[i].port_num, workers[i].queue_num,
+           workers[i].idle.mode);
   }
 
 #undef WORKER_JV
@@ -144,19 +196,94 @@ static int worker_load(config_t *config) {
   
   if (ret) {
     if (workers) {
-      free(workers);
+      rte_free(workers);
     }
   }
 
   return ret;
 }
 
+/** Pick the tx lcore of each worker and output port. A lcore that also
+ * transmits keeps its own packets, others are spread over the tx lcores of
+ * the port by work id, independent of the rx queue a packet came from.
+ * */
+static void worker_tx_map(config_t *config) {
+  worker_t *worker, *tx;
+  uint8_t txqs[MAX_WORKER_NUM];
+  int i, j, k, n, p;
+
+  memset(config->tx_map, WORKER_TX_NONE, sizeof(config->tx_map));
+
+  for (p = 0; p < MAX_PORT_NUM; p++) {
+    n = 0;
+    for (i = 0; i < config->worker_num; i++) {
+      tx = (worker_t *)config->workers + i;
+      if (tx->txq_id < 0) {
+        continue;
+      }
+      for (j = 0; j < tx->port_num; j++) {
+        if (tx->ports[j] == p) {
+          txqs[n++] = tx->txq_id;
+          break;
+        }
+      }
+    }
+
+    if (!n) {
+      continue;
+    }
+
+    for (i = 0; i < config->worker_num; i++) {
+      worker = (worker_t *)config->workers + i;
+      if (worker->work_id < 0) {
+        continue;
+      }
+
+      config->tx_map[worker->work_id][p] = txqs[worker->work_id % n];
+      for (k = 0; k < n; k++) {
+        if (txqs[k] == worker->txq_id) {
+          config->tx_map[worker->work_id][p] = txqs[k];
+        }
+      }
+    }
+  }
+}
+
+/** a ring holds WORKER_RING_BURSTS bursts of each lcore feeding it, rx lcores
+ * feed work rings and workers feed tx rings
+ * */
+static void worker_ring_size(config_t *config, uint32_t *work_size,
+                             uint32_t *tx_size) {
+  worker_t *worker;
+  uint32_t rx = 0, work = 0;
+  int i;
+
+  for (i = 0; i < config->worker_num; i++) {
+    worker = (worker_t *)config->workers + i;
+    rx += (worker->role == ROLE_RX) || (worker->role == ROLE_RTX) ||
+          (worker->role == ROLE_RTX_WORKER);
+    work += (worker->role == ROLE_WORKER) ||
+            (worker->role == ROLE_RTX_WORKER);
+  }
+
+  *work_size = rte_align32pow2(RTE_MAX(rx, 1U) * WORKER_RING_BURSTS * MAX_PKT_BURST);
+  *tx_size = rte_align32pow2(RTE_MAX(work, 1U) * WORKER_RING_BURSTS * MAX_PKT_BURST);
+  if (config->ring_size) {
+    *work_size = config->ring_size;
+    *tx_size = config->ring_size;
+  }
+}
+
 static int worker_setup(config_t *config) {
   worker_t *worker;
-  int i, j, rxq = 0, txq = 0;
+  int i, j, rxq = 0, txq = 0, prxq = 0;
+  uint32_t work_size, tx_size;
   char queue[128];
   int ret = -1;
 
+  worker_ring_size(config, &work_size, &tx_size);
+  printf("work ring size %u tx ring size %u\n", work_size, tx_size);
+
   for (i = 0; i < config->worker_num; i++) {
     worker = (worker_t *)config->workers + i;
     
@@ -166,63 +293,103 @@ static int worker_setup(config_t *config) {
       if (!config->rx_queues[rxq]) {
         memset(queue, 0, 128);
         sprintf(queue, "%s-%d", "worker-rx-queue", rxq);
-        config->rx_queues[rxq] = rte_ring_create(queue, 1024, rte_socket_id(), 0);
+        config->rx_queues[rxq] = rte_ring_create(queue, work_size, rte_socket_id(), 0);
         if (!config->rx_queues[rxq]) {
           printf("create rx queue failed\n");
           goto done;
         }
         worker->work_queue = config->rx_queues[rxq];
+        worker->work_id = rxq;
         rxq++;
       }
     }
 
-    // setup tx queues for each port-queue pair (as output buffer)
-    if ((worker->role == ROLE_RX)
-    || (worker->role == ROLE_TX)
+    // every tx lcore owns one nic tx queue on each of its ports, so no two
+    // lcores ever call tx burst on the same queue
+    if ((worker->role == ROLE_TX)
     || (worker->role == ROLE_RTX)
     || (worker->role == ROLE_RTX_WORKER)) {
-      int k, p, q;
+      int p;
+
+      if (txq >= MAX_QUEUE_NUM) {
+        printf("tx lcore num out of range\n");
+        goto done;
+      }
+      worker->txq_id = txq++;
+
       for (j = 0; j < worker->port_num; j++) {
-        for (k = 0; k < worker->queue_num; k++) {
-          p = worker->ports[j];
-          q = worker->queues[k];
-
-          if (!config->tx_queues[p][q]) {
-            memset(queue, 0, 128);
-            sprintf(queue, "%s-%d-%d", "worker-tx-queue", p, q);
-            config->tx_queues[p][q] = rte_ring_create(queue, 1024, rte_socket_id(), 0);
-            if (!config->tx_queues[p][q]) {
-              printf("create tx queue failed\n");
-              goto done;
-            }
-            txq = txq < q ? q : txq;
+        p = worker->ports[j];
+
+        // filled by any worker, drained only by the owner
+        memset(queue, 0, 128);
+        sprintf(queue, "%s-%d-%d", "worker-tx-queue", p, worker->txq_id);
+        config->tx_queues[p][worker->txq_id] =
+          rte_ring_create(queue, tx_size, rte_socket_id(), RING_F_SC_DEQ);
+        if (!config->tx_queues[p][worker->txq_id]) {
+          printf("create tx queue failed\n");
+          goto done;
+        }
+
+        // setup ctrl queue for each port (as output buffer of packets
+        // generated by firewall, e.g. syn-ack of synproxy)
+        if (!config->ctrl_queues[p]) {
+          memset(queue, 0, 128);
+          sprintf(queue, "%s-%d", "worker-ctrl-queue", p);
+          config->ctrl_queues[p] = rte_ring_create(queue, tx_size, rte_socket_id(), 0);
+          if (!config->ctrl_queues[p]) {
+            printf("create ctrl queue failed\n");
+            goto done;
           }
         }
       }
     }
+
+    // nic rx queues are only those some lcore reads
+    if ((worker->role == ROLE_RX)
+    || (worker->role == ROLE_RTX)
+    || (worker->role == ROLE_RTX_WORKER)) {
+      for (j = 0; j < worker->queue_num; j++) {
+        prxq = prxq <= worker->queues[j] ? worker->queues[j] + 1 : prxq;
+      }
+    }
   }
 
   config->rxq_num = rxq;
-  config->txq_num = txq + 1;
+  config->txq_num = txq;
+  config->port_rxq_num = prxq;
+  worker_tx_map(config);
+
+  // spread buckets evenly, worker_scale moves them later
+  for (i = 0; rxq && (i < MAX_DISPATCH_NUM); i++) {
+    config->dispatch[i] = i % rxq;
+  }
+
   ret = 0;
 
 done:
   if (ret) {
-    for (i = 0; i < config->rxq_num; i++) {
+    for (i = 0; i < MAX_WORKER_NUM; i++) {
       if (config->rx_queues[i]) {
         rte_ring_free(config->rx_queues[i]);
         config->rx_queues[i] = NULL;
       }
     }
 
-    for (i = 0; i < config->port_num; i++) {
-      for (j = 0; j < config->txq_num; j++) {
+    for (i = 0; i < MAX_PORT_NUM; i++) {
+      for (j = 0; j < MAX_QUEUE_NUM; j++) {
         if (config->tx_queues[i][j]) {
           rte_ring_free(config->tx_queues[i][j]);
           config->tx_queues[i][j] = NULL;
         }
       }
     }
+
+    for (i = 0; i < MAX_PORT_NUM; i++) {
+      if (config->ctrl_queues[i]) {
+        rte_ring_free(config->ctrl_queues[i]);
+        config->ctrl_queues[i] = NULL;
+      }
+    }
   }
 
   return ret;
@@ -251,17 +418,338 @@ int worker_init(config_t *config) {
 done:
   if (ret) {
     if (config->workers) {
-      free(config->workers);
+      rte_free(config->workers);
       config->workers = NULL;
     }
   }
   return ret;
 }
 
+/** abort the sleep if ring tail moved since the ring was found empty */
+static int worker_ring_wake(const uint64_t val,
+                            const uint64_t opaque[RTE_POWER_MONITOR_OPAQUE_SZ]) {
+  return (val != opaque[0]) ? -1 : 0;
+}
+
+/** sleep until new work shows up or tsc is reached, the monitored address is
+ * the producer tail of work queue for WORKER and the next rx descriptor for a
+ * RX which owns a single queue, anything else sleeps for the bound only
+ * */
+static int worker_idle_sleep(worker_t *worker, uint64_t tsc) {
+  struct rte_power_monitor_cond pmc;
+
+  if (worker->idle.monitor) {
+    if (worker->role == ROLE_WORKER) {
+      struct rte_ring *r = worker->work_queue;
+
+      pmc.addr = &r->prod.tail;
+      pmc.size = sizeof(uint32_t);
+      pmc.fn = worker_ring_wake;
+      pmc.opaque[0] = r->prod.tail;
+      if (!rte_ring_empty(r)) {
+        return -1;
+      }
+      return rte_power_monitor(&pmc, tsc);
+    }
+
+    if ((worker->role == ROLE_RX) && (worker->port_num == 1) &&
+        (worker->queue_num == 1)) {
+      if (!rte_eth_get_monitor_addr(worker->ports[0], worker->queues[0],
+                                    &pmc)) {
+        return rte_power_monitor(&pmc, tsc);
+      }
+    }
+  }
+
+  if (worker->idle.power_pause) {
+    return rte_power_pause(tsc);
+  }
+
+  return -1;
+}
+
+void worker_idle(worker_t *worker, int work) {
+  worker_idle_t *idle = &worker->idle;
+
+  idle->polls++;
+  if (work) {
+    idle->empty = 0;
+    return;
+  }
+  idle->empty_polls++;
+
+  if (idle->mode == IDLE_POLL) {
+    return;
+  }
+
+  idle->empty++;
+  if (idle->empty <= WORKER_IDLE_SPIN) {
+    return;
+  }
+
+  if (idle->empty <= WORKER_IDLE_PAUSE) {
+    rte_pause();
+    idle->pauses++;
+    return;
+  }
+
+  if (worker_idle_sleep(worker, rte_rdtsc() + idle->sleep_tsc)) {
+    rte_pause();
+    idle->pauses++;
+  } else {
+    idle->sleeps++;
+  }
+}
+
+volatile worker_hold_t worker_hold = WORKER_HOLD_NONE;
+worker_steer_t worker_steer;
+static volatile worker_hold_t worker_held[MAX_WORKER_NUM];
+
+/** datapath side of hold, spin here until mgmt releases */
+void worker_hold_wait(config_t *config, worker_t *worker) {
+  worker_hold_t hold;
+
+  while ((hold = worker_hold) != WORKER_HOLD_NONE) {
+    worker_held[worker->lcore_id] = hold;
+
+    if (hold == WORKER_HOLD_RX) {
+      if (worker->work_queue) {
+        WORKER(config);
+      }
+      if ((worker->role == ROLE_TX) || (worker->role == ROLE_RTX) ||
+          (worker->role == ROLE_RTX_WORKER)) {
+        TX(config);
+      }
+    } else {
+      rte_pause();
+    }
+  }
+
+  worker_held[worker->lcore_id] = WORKER_HOLD_NONE;
+}
+
+static void worker_hold_set(config_t *config, worker_hold_t hold) {
+  worker_t *worker;
+  int i;
+
+  worker_hold = hold;
+  rte_smp_mb();
+
+  for (i = 0; i < config->worker_num; i++) {
+    worker = (worker_t *)config->workers + i;
+    if ((worker->role == ROLE_NONE) || (worker->role == ROLE_MGMT) ||
+        !rte_lcore_is_enabled(worker->lcore_id)) {
+      continue;
+    }
+
+    while (worker_held[worker->lcore_id] != hold) {
+      usleep(10);
+    }
+  }
+}
+
+static void worker_hold_drain(config_t *config) {
+  int i;
+
+  for (i = 0; i < config->rxq_num; i++) {
+    while (!rte_ring_empty(config->rx_queues[i])) {
+      usleep(10);
+    }
+  }
+}
+
+void worker_pause(config_t *config) {
+  worker_hold_set(config, WORKER_HOLD_ALL);
+}
+
+void worker_resume(void) {
+  worker_hold = WORKER_HOLD_NONE;
+  rte_smp_mb();
+}
+
+int worker_bucket_owner(config_t *config, uint16_t bucket) {
+  worker_t *worker;
+  int i, w = config->dispatch[bucket & (MAX_DISPATCH_NUM - 1)];
+
+  for (i = 0; i < config->worker_num; i++) {
+    worker = (worker_t *)config->workers + i;
+    if (worker->work_id == w) {
+      return worker->lcore_id;
+    }
+  }
+
+  return -1;
+}
+
+/** give every active work queue an even share of buckets, buckets stay where
+ * they are as long as their owner is active and within its share
+ * */
+static void worker_dispatch_update(config_t *config) {
+  int count[MAX_WORKER_NUM] = {0}, quota[MAX_WORKER_NUM] = {0};
+  bool active[MAX_WORKER_NUM] = {0}, kept[MAX_DISPATCH_NUM];
+  worker_t *worker;
+  int i, w, n = 0;
+
+  for (i = 0; i < config->worker_num; i++) {
+    worker = (worker_t *)config->workers + i;
+    if ((worker->work_id >= 0) && !worker->parked) {
+      active[worker->work_id] = true;
+      n++;
+    }
+  }
+
+  if (!n) {
+    return;
+  }
+
+  for (w = 0, i = 0; w < config->rxq_num; w++) {
+    if (active[w]) {
+      quota[w] = MAX_DISPATCH_NUM / n + ((i++ < MAX_DISPATCH_NUM % n) ? 1 : 0);
+    }
+  }
+
+  for (i = 0; i < MAX_DISPATCH_NUM; i++) {
+    w = config->dispatch[i];
+    kept[i] = active[w] && (count[w] < quota[w]);
+    if (kept[i]) {
+      count[w]++;
+    }
+  }
+
+  for (i = 0; i < MAX_DISPATCH_NUM; i++) {
+    if (kept[i]) {
+      continue;
+    }
+
+    for (w = 0; w < config->rxq_num; w++) {
+      if (active[w] && (count[w] < quota[w])) {
+        config->dispatch[i] = w;
+        count[w]++;
+        break;
+      }
+    }
+  }
+}
+
+/** spread RETA of every port over the queues polled by active lcores */
+static void worker_reta_update(config_t *config, int exclude) {
+  struct rte_eth_rss_reta_entry64
+      reta[RTE_ETH_RSS_RETA_SIZE_512 / RTE_ETH_RETA_GROUP_SIZE];
+  struct rte_eth_dev_info dev_info;
+  uint16_t queues[MAX_QUEUE_NUM];
+  bool used[MAX_QUEUE_NUM];
+  worker_t *worker;
+  int i, j, k, n, port, ret;
+
+  for (port = 0; port < config->port_num; port++) {
+    if (rte_eth_dev_info_get(port, &dev_info) || !dev_info.reta_size ||
+        (dev_info.reta_size > RTE_ETH_RSS_RETA_SIZE_512)) {
+      continue;
+    }
+
+    n = 0;
+    memset(used, 0, sizeof(used));
+    for (i = 0; i < config->worker_num; i++) {
+      worker = (worker_t *)config->workers + i;
+      if (((worker->role != ROLE_RX) && (worker->role != ROLE_RTX) &&
+           (worker->role != ROLE_RTX_WORKER)) ||
+          worker->parked || (worker->lcore_id == exclude)) {
+        continue;
+      }
+
+      for (j = 0; j < worker->port_num; j++) {
+        if (worker->ports[j] != port) {
+          continue;
+        }
+        for (k = 0; k < worker->queue_num; k++) {
+          if (!used[worker->queues[k]]) {
+            used[worker->queues[k]] = true;
+            queues[n++] = worker->queues[k];
+          }
+        }
+      }
+    }
+
+    if (!n) {
+      printf("port %d has no active rx queue, reta unchanged\n", port);
+      continue;
+    }
+
+    memset(reta, 0, sizeof(reta));
+    for (i = 0; i < dev_info.reta_size; i++) {
+      reta[i / RTE_ETH_RETA_GROUP_SIZE].mask |= 1ULL << (i % RTE_ETH_RETA_GROUP_SIZE);
+      reta[i / RTE_ETH_RETA_GROUP_SIZE].reta[i % RTE_ETH_RETA_GROUP_SIZE] = queues[i % n];
+    }
+
+    ret = rte_eth_dev_rss_reta_update(port, reta, dev_info.reta_size);
+    if (ret && (ret != -ENOTSUP)) {
+      printf("port %d reta update failed %d\n", port, ret);
+    }
+  }
+}
+
+int worker_scale(config_t *config, int lcore_id, bool park) {
+  worker_t *worker = NULL, *w;
+  int i, active = 0, ret;
+
+  for (i = 0; i < config->worker_num; i++) {
+    w = (worker_t *)config->workers + i;
+    if (w->lcore_id == lcore_id) {
+      worker = w;
+    }
+    if ((w->work_id >= 0) && !w->parked) {
+      active++;
+    }
+  }
+
+  if (!worker || (worker->work_id < 0)) {
+    printf("lcore %d is not a worker\n", lcore_id);
+    return -1;
+  }
+
+  if (worker->parked == park) {
+    return 0;
+  }
+
+  if (park && (active <= 1)) {
+    printf("can not park the last worker\n");
+    return -1;
+  }
+
+  // steer the nic away first and let the lcore drain what is already queued
+  if (park && (worker->role == ROLE_RTX_WORKER)) {
+    worker_reta_update(config, lcore_id);
+    usleep(WORKER_RETA_DRAIN);
+  }
+
+  worker_hold_set(config, WORKER_HOLD_RX);
+  worker_hold_drain(config);
+  worker_hold_set(config, WORKER_HOLD_ALL);
+
+  // every lcore is stopped, dispatch and per worker state are ours now
+  worker->parked = park;
+  worker_dispatch_update(config);
+  ret = modules_move(config);
+  if (!park && (worker->role == ROLE_RTX_WORKER)) {
+    worker_reta_update(config, -1);
+  }
+
+  worker_hold = WORKER_HOLD_NONE;
+  rte_smp_mb();
+
+  printf("lcore %d %s, %d workers active\n", lcore_id,
+         park ? "parked" : "unparked", park ? active - 1 : active + 1);
+
+  return ret;
+}
+
 int RX(__rte_unused config_t *config) {
   struct rte_mbuf *pkts_burst[MAX_PKT_BURST] = {0};
+  struct rte_mbuf *works[MAX_WORKER_NUM][MAX_PKT_BURST];
+  uint16_t work_num[MAX_WORKER_NUM] = {0};
   worker_t *worker;
-  int i, j, port_id, queue_id, nb_rx;
+  int i, j, k, w, port_id, queue_id, nb_rx, total = 0;
+  uint16_t bucket;
   packet_t *p;
 
   worker = (worker_t *)config->workers + config->worker_map[rte_lcore_id()];
@@ -273,102 +761,178 @@ int RX(__rte_unused config_t *config) {
       
       nb_rx = rte_eth_rx_burst(port_id, queue_id, pkts_burst, MAX_PKT_BURST);
       if (nb_rx) {
-        for (i = 0; i < nb_rx; i++) {
-          p = rte_mbuf_to_priv(pkts_burst[i]);
+        // symmetric rss hash selects the bucket, nics without hash fall back
+        // to queue id which is symmetric as well
+        for (k = 0; k < nb_rx; k++) {
+          if (pkts_burst[k]->ol_flags & RTE_MBUF_F_RX_RSS_HASH) {
+            bucket = pkts_burst[k]->hash.rss & (MAX_DISPATCH_NUM - 1);
+          } else {
+            bucket = queue_id & (MAX_DISPATCH_NUM - 1);
+          }
+
+          if (worker_steer) {
+            worker_steer(config, pkts_burst[k], &bucket);
+          }
+
+          p = rte_mbuf_to_priv(pkts_burst[k]);
           if (p) {
             p->port_in = port_id;
             p->queue_id = queue_id;
+            p->flags = 0;
+            p->policer = 0;
+            p->bypass_id = 0;
+            p->bucket = bucket;
           }
+
+          w = config->dispatch[bucket];
+          works[w][work_num[w]++] = pkts_burst[k];
         }
 
-        queue_id = queue_id % config->rxq_num;
-        while (!rte_ring_enqueue_bulk(config->rx_queues[queue_id], (void *const *)pkts_burst, nb_rx, NULL))
-          ; // must success
+        for (w = 0; w < config->rxq_num; w++) {
+          if (!work_num[w]) {
+            continue;
+          }
+          while (!rte_ring_enqueue_bulk(config->rx_queues[w], (void *const *)works[w], work_num[w], NULL))
+            ; // must success
+          work_num[w] = 0;
+        }
+        total += nb_rx;
       }
     }
   }
-  return 0;
+
+  if (total) {
+    STATS_ADD(rx, total);
+  }
+  return total;
 }
 
 int TX(__rte_unused config_t *config) {
   struct rte_mbuf *pkts_burst[MAX_PKT_BURST] = {0};
   worker_t *worker;
-  int i, j, port_id, queue_id, nb_tx;
+  int i, port_id, queue_id, nb_tx, total = 0;
 
   worker = (worker_t *)config->workers + config->worker_map[rte_lcore_id()];
+  queue_id = worker->txq_id;
 
   for (i = 0; i < worker->port_num; i++) {
-    for (j = 0; j < worker->queue_num; j++) {
-      port_id = worker->ports[i];
-      queue_id = worker->queues[j];
-
-      if (!config->tx_queues[port_id][queue_id])
-        continue;
+    port_id = worker->ports[i];
 
-      nb_tx = rte_ring_count(config->tx_queues[port_id][queue_id]);
-      if (!nb_tx) {
-        continue;
-      }
-      nb_tx = nb_tx > MAX_PKT_BURST ? MAX_PKT_BURST : nb_tx;
-      
-      nb_tx = rte_ring_dequeue_bulk(config->tx_queues[port_id][queue_id], (void **)pkts_burst, nb_tx, NULL);
+    // packets generated by firewall go out through our own queue as well
+    if (config->ctrl_queues[port_id]) {
+      nb_tx = rte_ring_dequeue_burst(config->ctrl_queues[port_id], (void **)pkts_burst, MAX_PKT_BURST, NULL);
       if (nb_tx) {
         int tx = rte_eth_tx_burst(port_id, queue_id, pkts_burst, nb_tx);
         if (tx < nb_tx) {
-          printf("port %d queue %d tx %d failed\n", port_id, queue_id, nb_tx - tx);
+          EVLOG(EVLOG_CTRL_TX_FAIL, port_id, queue_id, nb_tx - tx);
+          rte_pktmbuf_free_bulk(&pkts_burst[tx], nb_tx - tx);
+          STATS_ADD(tx_drop, nb_tx - tx);
         }
+        STATS_ADD(tx, tx);
+        total += nb_tx;
       }
     }
+
+    nb_tx = rte_ring_dequeue_burst(config->tx_queues[port_id][queue_id], (void **)pkts_burst, MAX_PKT_BURST, NULL);
+    if (nb_tx) {
+      int tx = rte_eth_tx_burst(port_id, queue_id, pkts_burst, nb_tx);
+      if (tx < nb_tx) {
+        EVLOG(EVLOG_TX_FAIL, port_id, queue_id, nb_tx - tx);
+        rte_pktmbuf_free_bulk(&pkts_burst[tx], nb_tx - tx);
+        STATS_ADD(tx_drop, nb_tx - tx);
+      }
+      STATS_ADD(tx, tx);
+      total += nb_tx;
+    }
   }
-  return 0;
+  return total;
 }
 
 int RTX(config_t *config) {
-  RX(config);
-  TX(config);
-  return 0;
+  int n;
+
+  n = RX(config);
+  n += TX(config);
+  return n;
 }
 
+/** a burst goes through the hooks one hook at a time, like the nodes of a
+ * graph, so modules with bulk callbacks amortize table lookups over it
+ * */
 int WORKER(config_t *config) {
-  struct rte_mbuf *mbuf;
+  struct rte_mbuf *pkts[MAX_PKT_BURST];
   worker_t *worker;
   packet_t *p;
   int ret, hook, port_id, queue_id;
+  uint16_t i, n, nb;
 
   worker = (worker_t *)config->workers + config->worker_map[rte_lcore_id()];
-  ret = rte_ring_dequeue(worker->work_queue, (void **)&mbuf);
-  if (ret || !mbuf) {
+  nb = rte_ring_dequeue_burst(worker->work_queue, (void **)pkts, MAX_PKT_BURST,
+                              NULL);
+  if (!nb) {
     return 0;
   }
 
-  for (hook = MOD_HOOK_INGRESS; hook <= MOD_HOOK_EGRESS; hook++) {
-    if (modules_proc(config, mbuf, hook)) {
-      return 0;
-    }
+  STATS_ADD(proc, nb);
+  n = nb;
+  for (hook = 0; n && (hook < config->plan_hook_num); hook++) {
+    n = modules_proc_burst(config, pkts, n, config->plan_hooks[hook]);
   }
-
-  p = rte_mbuf_to_priv(mbuf);
-  if (!p) {
-    rte_pktmbuf_free(mbuf);
-    return -1;
+  if (n != nb) {
+    STATS_ADD(stolen, nb - n);
   }
-  port_id = p->port_out;
-  queue_id = p->queue_id;
 
-  ret = rte_ring_enqueue(config->tx_queues[port_id][queue_id], mbuf);
-  if (ret) {
-    rte_pktmbuf_free(mbuf);
-    return -1;
+  for (i = 0; i < n; i++) {
+    p = rte_mbuf_to_priv(pkts[i]);
+    if (!p) {
+      rte_pktmbuf_free(pkts[i]);
+      continue;
+    }
+    port_id = p->port_out;
+    queue_id = config->tx_map[worker->work_id][port_id];
+
+    // no tx lcore sends on the port
+    if (queue_id == WORKER_TX_NONE) {
+      STATS_ADD(tx_drop, 1);
+      rte_pktmbuf_free(pkts[i]);
+      continue;
+    }
+
+    ret = rte_ring_enqueue(config->tx_queues[port_id][queue_id], pkts[i]);
+    if (ret) {
+      EVLOG(EVLOG_TX_RING_FULL, port_id, queue_id);
+      STATS_ADD(tx_drop, 1);
+      rte_pktmbuf_free(pkts[i]);
+    }
   }
 
-  return 0;
+  return nb;
 }
 
 int RTX_WORKER(config_t *config) {
-  RX(config);
-  WORKER(config);
-  TX(config);
-  return 0;
+  int n;
+
+  n = RX(config);
+  n += WORKER(config);
+  n += TX(config);
+  return n;
+}
+
+int worker_run(config_t *config, worker_t *worker) {
+  switch (worker->role) {
+  case ROLE_RX:
+    return RX(config);
+  case ROLE_TX:
+    return TX(config);
+  case ROLE_RTX:
+    return RTX(config);
+  case ROLE_WORKER:
+    return WORKER(config);
+  case ROLE_RTX_WORKER:
+    return RTX_WORKER(config);
+  default:
+    return 0;
+  }
 }
 
 // file-format utf-8
@@ -1,8 +1,56 @@
 #ifndef _M_WORKER__H_
 #define _M_WORKER__H_
 
+#include <rte_mbuf.h>
+
 #include "config.h"
 
+// adaptive idle: spin, then pause, then sleep on the queue until new work or
+// the sleep bound (us) expires
+#define WORKER_IDLE_SPIN 256
+#define WORKER_IDLE_PAUSE 1024
+#define WORKER_IDLE_SLEEP 10
+
+// parked lcores only wake up to answer config switch and hold (us)
+#define WORKER_PARK_SLEEP 1000
+
+// time given to a RTX_WORKER to drain its nic queues after RETA update (us)
+#define WORKER_RETA_DRAIN 10000
+
+// tx_map entry of a port that no tx lcore sends on
+#define WORKER_TX_NONE UINT8_MAX
+
+// bursts a work or tx ring absorbs per producer lcore, rounded up to power
+// of 2, unless worker.json sets ring_size
+#define WORKER_RING_BURSTS 8
+
+/** Hold stops the datapath for a quiesced handover of per worker state:
+ * HOLD_RX stops reading nics while work and tx queues keep draining,
+ * HOLD_ALL stops every lcore at a loop boundary.
+ * */
+typedef enum {
+  WORKER_HOLD_NONE,
+  WORKER_HOLD_RX,
+  WORKER_HOLD_ALL,
+} worker_hold_t;
+
+typedef enum {
+  IDLE_POLL,      // busy poll forever
+  IDLE_ADAPTIVE,
+} idle_mode_t;
+
+typedef struct {
+  idle_mode_t mode;
+  bool monitor;         // rte_power_monitor supported
+  bool power_pause;     // rte_power_pause supported
+  uint32_t empty;       // consecutive empty polls
+  uint64_t sleep_tsc;
+  uint64_t polls;
+  uint64_t empty_polls;
+  uint64_t pauses;
+  uint64_t sleeps;
+} worker_idle_t;
+
 typedef enum {
   ROLE_NONE,
   ROLE_MGMT,
@@ -21,9 +69,37 @@ typedef struct {
   uint16_t port_num;
   uint16_t queue_num;
   void *work_queue;
+  int work_id;          // index of work_queue in rx_queues, -1 for none
+  int txq_id;           // nic tx queue owned on each of its ports, -1 for none
+  volatile bool parked; // no bucket dispatched to it, lcore sleeps
+  worker_idle_t idle;
 } worker_t;
 
+extern volatile worker_hold_t worker_hold;
+
+/** Lets a module override the dispatch bucket of a packet before it is
+ * queued to a worker, the packet is not decoded yet. Used by nat so that
+ * replies reach the worker owning their translated port.
+ * */
+typedef void (*worker_steer_t)(config_t *config, struct rte_mbuf *mbuf,
+                               uint16_t *bucket);
+extern worker_steer_t worker_steer;
+
 int worker_init(config_t *config);
+void worker_idle(worker_t *worker, int work);
+void worker_hold_wait(config_t *config, worker_t *worker);
+
+/** park or unpark a WORKER/RTX_WORKER lcore, called by mgmt only */
+int worker_scale(config_t *config, int lcore_id, bool park);
+
+/** stop every lcore at a loop boundary while mgmt updates tables which are
+ * not safe for concurrent readers, called by mgmt only
+ * */
+void worker_pause(config_t *config);
+void worker_resume(void);
+
+/** lcore owning the bucket, -1 for none */
+int worker_bucket_owner(config_t *config, uint16_t bucket);
 
 int RX(__rte_unused config_t *config);
 int TX(__rte_unused config_t *config);
@@ -31,6 +107,9 @@ int RTX(config_t *config);
 int WORKER(config_t *config);
 int RTX_WORKER(config_t *config);
 
+/** run one loop of the worker role, return number of packets handled */
+int worker_run(config_t *config, worker_t *worker);
+
 #endif
 
 // file-format utf-8
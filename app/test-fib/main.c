@@ -42,7 +42,9 @@
 #define FIB_RIB_TYPE		(1 << 3)
 #define FIB_V4_DIR_TYPE		(1 << 4)
 #define FIB_V6_TRIE_TYPE	(1 << 4)
-#define FIB_TYPE_MASK		(FIB_RIB_TYPE|FIB_V4_DIR_TYPE|FIB_V6_TRIE_TYPE)
+#define FIB_V6_POPTRIE_TYPE	(1 << 5)
+#define FIB_TYPE_MASK		(FIB_RIB_TYPE|FIB_V4_DIR_TYPE|FIB_V6_TRIE_TYPE|\
+				FIB_V6_POPTRIE_TYPE)
 #define SHUFFLE_FLAG		(1 << 7)
 #define DRY_RUN_FLAG		(1 << 8)
 
@@ -138,6 +140,8 @@ get_fib_type(void)
 	if (config.flags & IPV6_FLAG) {
 		if ((config.flags & FIB_TYPE_MASK) == FIB_V6_TRIE_TYPE)
 			return RTE_FIB6_TRIE;
+		else if ((config.flags & FIB_TYPE_MASK) == FIB_V6_POPTRIE_TYPE)
+			return RTE_FIB6_POPTRIE;
 		else
 			return RTE_FIB6_DUMMY;
 	} else {
@@ -616,16 +620,19 @@ print_usage(void)
 		"\tavailable options for ipv6:\n"
 		"\t\trib - RIB based FIB\n"
 		"\t\ttrie - TRIE based FIB\n"
+		"\t\tpoptrie - POPTRIE based FIB\n"
 		"defaults are: dir for ipv4 and trie for ipv6\n"
-		"[-e <entry size (valid only for dir and trie fib types): "
-		"1/2/4/8 (default 4)>]\n"
-		"[-g <number of tbl8's for dir24_8 or trie FIBs>]\n"
+		"[-e <entry size (valid only for dir, trie and poptrie fib "
+		"types): 1/2/4/8 (default 4)>]\n"
+		"[-g <number of tbl8's for dir24_8 or trie FIBs, "
+		"of nodes for poptrie FIB>]\n"
 		"[-w <path to the file to dump routing table>]\n"
 		"[-u <path to the file to dump ip's for lookup>]\n"
 		"[-v <type of lookup function:"
-		"\ts1, s2, s3 (3 types of scalar), v (vector) -"
-		" for DIR24_8 based FIB\n"
-		"\ts, v - for TRIE based ipv6 FIB>]\n",
+		"\ts1, s2, s3 (3 types of scalar), v (vector),"
+		" v2 (avx2 vector) - for DIR24_8 based FIB\n"
+		"\ts, v, v2 - for TRIE based ipv6 FIB\n"
+		"\ts - for POPTRIE based ipv6 FIB>]\n",
 		config.prgname);
 }
 
@@ -741,6 +748,9 @@ parse_opts(int argc, char **argv)
 			} else if (strcmp(optarg, "trie") == 0) {
 				config.flags &= ~FIB_TYPE_MASK;
 				config.flags |= FIB_V6_TRIE_TYPE;
+			} else if (strcmp(optarg, "poptrie") == 0) {
+				config.flags &= ~FIB_TYPE_MASK;
+				config.flags |= FIB_V6_POPTRIE_TYPE;
 			} else
 				rte_exit(-EINVAL, "Invalid option -b\n");
 			break;
@@ -774,6 +784,9 @@ parse_opts(int argc, char **argv)
 			} else if (strcmp(optarg, "s3") == 0) {
 				config.lookup_fn = 4;
 				break;
+			} else if (strcmp(optarg, "v2") == 0) {
+				config.lookup_fn = 5;
+				break;
 			}
 			print_usage();
 			rte_exit(-EINVAL, "Invalid option -v %s\n", optarg);
@@ -868,6 +881,9 @@ run_v4(void)
 		else if (config.lookup_fn == 4)
 			ret = rte_fib_select_lookup(fib,
 				RTE_FIB_LOOKUP_DIR24_8_SCALAR_UNI);
+		else if (config.lookup_fn == 5)
+			ret = rte_fib_select_lookup(fib,
+				RTE_FIB_LOOKUP_DIR24_8_VECTOR_AVX2);
 		else
 			ret = -EINVAL;
 		if (ret != 0) {
@@ -896,6 +912,7 @@ run_v4(void)
 		lpm_conf.max_rules = config.nb_routes * 2;
 		lpm_conf.number_tbl8s = RTE_MAX(conf.dir24_8.num_tbl8,
 			config.tbl8);
+		lpm_conf.flags = 0;
 
 		lpm = rte_lpm_create("test_lpm", -1, &lpm_conf);
 		if (lpm == NULL) {
@@ -1048,6 +1065,9 @@ run_v6(void)
 		conf.trie.nh_sz = rte_ctz32(config.ent_sz);
 		conf.trie.num_tbl8 = RTE_MIN(config.tbl8,
 			get_max_nh(conf.trie.nh_sz));
+	} else if (conf.type == RTE_FIB6_POPTRIE) {
+		conf.poptrie.nh_sz = rte_ctz32(config.ent_sz);
+		conf.poptrie.num_nodes = config.tbl8;
 	}
 
 	fib = rte_fib6_create("test", -1, &conf);
@@ -1057,12 +1077,18 @@ run_v6(void)
 	}
 
 	if (config.lookup_fn != 0) {
-		if (config.lookup_fn == 1)
+		if ((config.lookup_fn == 1) && (conf.type == RTE_FIB6_POPTRIE))
+			ret = rte_fib6_select_lookup(fib,
+				RTE_FIB6_LOOKUP_POPTRIE_SCALAR);
+		else if (config.lookup_fn == 1)
 			ret = rte_fib6_select_lookup(fib,
 				RTE_FIB6_LOOKUP_TRIE_SCALAR);
 		else if (config.lookup_fn == 2)
 			ret = rte_fib6_select_lookup(fib,
 				RTE_FIB6_LOOKUP_TRIE_VECTOR_AVX512);
+		else if (config.lookup_fn == 5)
+			ret = rte_fib6_select_lookup(fib,
+				RTE_FIB6_LOOKUP_TRIE_VECTOR_AVX2);
 		else
 			ret = -EINVAL;
 		if (ret != 0) {
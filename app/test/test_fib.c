@@ -6,11 +6,15 @@
 #include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include <rte_ip.h>
 #include <rte_log.h>
+#include <rte_rib.h>
 #include <rte_fib.h>
 #include <rte_malloc.h>
+#include <rte_random.h>
+#include <rte_byteorder.h>
 
 #include "test.h"
 
@@ -22,11 +26,17 @@ static int32_t test_free_null(void);
 static int32_t test_add_del_invalid(void);
 static int32_t test_get_invalid(void);
 static int32_t test_lookup(void);
+static int32_t test_add_bulk(void);
+static int32_t test_vector_lookup(void);
+static int32_t test_nh_group(void);
 static int32_t test_invalid_rcu(void);
 static int32_t test_fib_rcu_sync_rw(void);
 
 #define MAX_ROUTES	(1 << 16)
 #define MAX_TBL8	(1 << 15)
+#define BULK_ROUTES	4096
+#define NH_GROUPS	16
+#define NH_GROUP_BUCKETS	256
 
 /*
  * Check that rte_fib_create fails gracefully for incorrect user input
@@ -379,6 +389,552 @@ test_lookup(void)
 	return TEST_SUCCESS;
 }
 
+static uint32_t bulk_ips[BULK_ROUTES];
+static uint8_t bulk_depths[BULK_ROUTES];
+static uint64_t bulk_nhs[BULK_ROUTES];
+
+static void
+generate_bulk_routes(void)
+{
+	uint32_t i;
+
+	/* Few first octets, so that prefixes nest into each other */
+	for (i = 0; i < BULK_ROUTES; i++) {
+		bulk_ips[i] = RTE_IPV4(10 + rte_rand_max(4), rte_rand_max(256),
+			rte_rand_max(256), rte_rand_max(256));
+		bulk_depths[i] = 8 + rte_rand_max(RTE_FIB_MAXDEPTH - 7);
+		bulk_nhs[i] = 1 + rte_rand_max(1000);
+	}
+}
+
+/*
+ * Check that two FIBs return the same next hops for the first, the last
+ * and the next address of every bulk route, and for random addresses
+ */
+static int
+compare_fibs(struct rte_fib *fib1, struct rte_fib *fib2)
+{
+	static uint32_t ips[4 * BULK_ROUTES];
+	static uint64_t nh1[4 * BULK_ROUTES];
+	static uint64_t nh2[4 * BULK_ROUTES];
+	uint32_t i, mask;
+	int ret;
+
+	for (i = 0; i < BULK_ROUTES; i++) {
+		mask = rte_rib_depth_to_mask(bulk_depths[i]);
+		ips[4 * i] = bulk_ips[i] & mask;
+		ips[4 * i + 1] = bulk_ips[i] | ~mask;
+		ips[4 * i + 2] = (bulk_ips[i] | ~mask) + 1;
+		ips[4 * i + 3] = rte_rand();
+	}
+
+	ret = rte_fib_lookup_bulk(fib1, ips, nh1, RTE_DIM(ips));
+	RTE_TEST_ASSERT(ret == 0, "Failed to lookup\n");
+	ret = rte_fib_lookup_bulk(fib2, ips, nh2, RTE_DIM(ips));
+	RTE_TEST_ASSERT(ret == 0, "Failed to lookup\n");
+
+	for (i = 0; i < RTE_DIM(ips); i++)
+		RTE_TEST_ASSERT(nh1[i] == nh2[i],
+			"Next hop mismatch for %08x: %"PRIu64" != %"PRIu64"\n",
+			ips[i], nh1[i], nh2[i]);
+
+	return TEST_SUCCESS;
+}
+
+static int
+add_seq(struct rte_fib *fib, uint32_t start, uint32_t n)
+{
+	uint32_t i;
+	int ret;
+
+	for (i = start; i < start + n; i++) {
+		ret = rte_fib_add(fib, bulk_ips[i], bulk_depths[i],
+			bulk_nhs[i]);
+		RTE_TEST_ASSERT(ret == 0, "Failed to add a route\n");
+	}
+
+	return TEST_SUCCESS;
+}
+
+/*
+ * Add the same routes to one FIB with rte_fib_add_bulk and to another one
+ * with rte_fib_add, into an empty FIB and on top of existing routes,
+ * and check they both return the same next hops
+ */
+static int
+check_add_bulk(struct rte_fib_conf *config)
+{
+	struct rte_fib *fib1, *fib2;
+	uint8_t depth;
+	uint32_t i;
+	int ret;
+
+	fib1 = rte_fib_create("test_add_bulk1", SOCKET_ID_ANY, config);
+	RTE_TEST_ASSERT(fib1 != NULL, "Failed to create FIB\n");
+	fib2 = rte_fib_create("test_add_bulk2", SOCKET_ID_ANY, config);
+	RTE_TEST_ASSERT(fib2 != NULL, "Failed to create FIB\n");
+
+	generate_bulk_routes();
+
+	ret = rte_fib_add_bulk(fib1, bulk_ips, bulk_depths, bulk_nhs, 0);
+	RTE_TEST_ASSERT(ret == 0, "Failed to add no route\n");
+
+	/* Load into an empty FIB */
+	ret = rte_fib_add_bulk(fib1, bulk_ips, bulk_depths, bulk_nhs,
+		BULK_ROUTES / 2);
+	RTE_TEST_ASSERT(ret == BULK_ROUTES / 2, "Failed to add routes\n");
+	RTE_TEST_ASSERT(add_seq(fib2, 0, BULK_ROUTES / 2) == TEST_SUCCESS,
+		"Failed to add routes\n");
+	RTE_TEST_ASSERT(compare_fibs(fib1, fib2) == TEST_SUCCESS,
+		"Bulk and single adds differ\n");
+
+	/* Add on top of existing routes */
+	RTE_TEST_ASSERT(add_seq(fib2, BULK_ROUTES / 2, BULK_ROUTES / 2) ==
+		TEST_SUCCESS, "Failed to add routes\n");
+	ret = rte_fib_add_bulk(fib1, &bulk_ips[BULK_ROUTES / 2],
+		&bulk_depths[BULK_ROUTES / 2], &bulk_nhs[BULK_ROUTES / 2],
+		BULK_ROUTES / 2);
+	RTE_TEST_ASSERT(ret == BULK_ROUTES / 2, "Failed to add routes\n");
+	RTE_TEST_ASSERT(compare_fibs(fib1, fib2) == TEST_SUCCESS,
+		"Bulk and single adds differ\n");
+
+	/* Change the next hop of existing routes */
+	for (i = 0; i < BULK_ROUTES; i += 2)
+		bulk_nhs[i] = 1 + rte_rand_max(1000);
+	ret = rte_fib_add_bulk(fib1, bulk_ips, bulk_depths, bulk_nhs,
+		BULK_ROUTES);
+	RTE_TEST_ASSERT(ret == BULK_ROUTES, "Failed to add routes\n");
+	RTE_TEST_ASSERT(add_seq(fib2, 0, BULK_ROUTES) == TEST_SUCCESS,
+		"Failed to add routes\n");
+	RTE_TEST_ASSERT(compare_fibs(fib1, fib2) == TEST_SUCCESS,
+		"Bulk and single adds differ\n");
+
+	/* Routes after an invalid one are not added */
+	for (i = 0; i < BULK_ROUTES; i++)
+		bulk_nhs[i] = 1 + rte_rand_max(1000);
+	depth = bulk_depths[16];
+	bulk_depths[16] = RTE_FIB_MAXDEPTH + 1;
+	ret = rte_fib_add_bulk(fib1, bulk_ips, bulk_depths, bulk_nhs,
+		BULK_ROUTES);
+	RTE_TEST_ASSERT(ret == 16, "Added routes after an invalid one\n");
+	RTE_TEST_ASSERT(add_seq(fib2, 0, 16) == TEST_SUCCESS,
+		"Failed to add routes\n");
+	bulk_depths[16] = depth;
+	RTE_TEST_ASSERT(compare_fibs(fib1, fib2) == TEST_SUCCESS,
+		"Bulk and single adds differ\n");
+
+	/* Routes added in bulk are deleted as usual */
+	for (i = 0; i < BULK_ROUTES; i += 2) {
+		rte_fib_delete(fib1, bulk_ips[i], bulk_depths[i]);
+		rte_fib_delete(fib2, bulk_ips[i], bulk_depths[i]);
+	}
+	RTE_TEST_ASSERT(compare_fibs(fib1, fib2) == TEST_SUCCESS,
+		"Bulk and single adds differ after delete\n");
+
+	rte_fib_free(fib1);
+	rte_fib_free(fib2);
+
+	return TEST_SUCCESS;
+}
+
+int32_t
+test_add_bulk(void)
+{
+	struct rte_fib_conf config = { 0 };
+	int ret;
+
+	config.max_routes = MAX_ROUTES;
+	config.rib_ext_sz = 0;
+	config.default_nh = 0;
+	config.type = RTE_FIB_DUMMY;
+
+	ret = rte_fib_add_bulk(NULL, bulk_ips, bulk_depths, bulk_nhs, 1);
+	RTE_TEST_ASSERT(ret == -EINVAL,
+		"Call succeeded with invalid parameters\n");
+
+	ret = check_add_bulk(&config);
+	RTE_TEST_ASSERT(ret == TEST_SUCCESS,
+		"Bulk add fails for DUMMY type\n");
+
+	config.type = RTE_FIB_DIR24_8;
+
+	config.dir24_8.nh_sz = RTE_FIB_DIR24_8_2B;
+	config.dir24_8.num_tbl8 = MAX_TBL8 - 1;
+	ret = check_add_bulk(&config);
+	RTE_TEST_ASSERT(ret == TEST_SUCCESS,
+		"Bulk add fails for DIR24_8_2B type\n");
+
+	config.dir24_8.nh_sz = RTE_FIB_DIR24_8_8B;
+	config.dir24_8.num_tbl8 = MAX_TBL8;
+	ret = check_add_bulk(&config);
+	RTE_TEST_ASSERT(ret == TEST_SUCCESS,
+		"Bulk add fails for DIR24_8_8B type\n");
+
+	return TEST_SUCCESS;
+}
+
+/*
+ * Check that every vector lookup supported on this machine returns the
+ * same next hops as the scalar one, for all next hop sizes and both
+ * address byte orders
+ */
+static int
+check_vector_lookup(struct rte_fib_conf *config)
+{
+	static const enum rte_fib_lookup_type types[] = {
+		RTE_FIB_LOOKUP_DIR24_8_VECTOR_AVX2,
+		RTE_FIB_LOOKUP_DIR24_8_VECTOR_AVX512,
+	};
+	static uint32_t ips[4 * BULK_ROUTES + 7];
+	static uint64_t nh_scalar[RTE_DIM(ips)];
+	static uint64_t nh_vec[RTE_DIM(ips)];
+	uint64_t max_nh = (1ULL << ((8 << config->dir24_8.nh_sz) - 1)) - 1;
+	struct rte_fib *fib;
+	uint32_t i, j, mask;
+	int ret;
+
+	fib = rte_fib_create(__func__, SOCKET_ID_ANY, config);
+	RTE_TEST_ASSERT(fib != NULL, "Failed to create FIB\n");
+
+	generate_bulk_routes();
+	for (i = 0; i < BULK_ROUTES; i++)
+		bulk_nhs[i] %= max_nh + 1;
+	/* small tables run out of tbl8 before the end, it does not matter */
+	ret = rte_fib_add_bulk(fib, bulk_ips, bulk_depths, bulk_nhs,
+		BULK_ROUTES);
+	RTE_TEST_ASSERT(ret > 0, "Failed to add routes\n");
+
+	/* Edges of the routes, tail not multiple of the vector size */
+	for (i = 0; i < BULK_ROUTES; i++) {
+		mask = rte_rib_depth_to_mask(bulk_depths[i]);
+		ips[4 * i] = bulk_ips[i] & mask;
+		ips[4 * i + 1] = bulk_ips[i] | ~mask;
+		ips[4 * i + 2] = (bulk_ips[i] | ~mask) + 1;
+		ips[4 * i + 3] = rte_rand();
+	}
+	for (i = 4 * BULK_ROUTES; i < RTE_DIM(ips); i++)
+		ips[i] = bulk_ips[i % BULK_ROUTES];
+	if (config->flags & RTE_FIB_F_LOOKUP_NETWORK_ORDER)
+		for (i = 0; i < RTE_DIM(ips); i++)
+			ips[i] = rte_cpu_to_be_32(ips[i]);
+
+	ret = rte_fib_select_lookup(fib, RTE_FIB_LOOKUP_DIR24_8_SCALAR_MACRO);
+	RTE_TEST_ASSERT(ret == 0, "Failed to select scalar lookup\n");
+	ret = rte_fib_lookup_bulk(fib, ips, nh_scalar, RTE_DIM(ips));
+	RTE_TEST_ASSERT(ret == 0, "Failed to lookup\n");
+
+	for (j = 0; j < RTE_DIM(types); j++) {
+		/* not supported by the CPU or the build */
+		if (rte_fib_select_lookup(fib, types[j]) != 0)
+			continue;
+		ret = rte_fib_lookup_bulk(fib, ips, nh_vec, RTE_DIM(ips));
+		RTE_TEST_ASSERT(ret == 0, "Failed to lookup\n");
+		for (i = 0; i < RTE_DIM(ips); i++)
+			RTE_TEST_ASSERT(nh_vec[i] == nh_scalar[i],
+				"Lookup type %d mismatch for %08x: %"PRIu64
+				" != %"PRIu64"\n", types[j], ips[i],
+				nh_vec[i], nh_scalar[i]);
+	}
+
+	rte_fib_free(fib);
+
+	return TEST_SUCCESS;
+}
+
+int32_t
+test_vector_lookup(void)
+{
+	struct rte_fib_conf config = { 0 };
+	enum rte_fib_dir24_8_nh_sz nh_sz;
+	int ret;
+
+	config.max_routes = MAX_ROUTES;
+	config.rib_ext_sz = 0;
+	config.default_nh = 0;
+	config.type = RTE_FIB_DIR24_8;
+	config.dir24_8.num_tbl8 = MAX_TBL8 - 1;
+
+	for (nh_sz = RTE_FIB_DIR24_8_1B; nh_sz <= RTE_FIB_DIR24_8_8B;
+			nh_sz++) {
+		config.dir24_8.nh_sz = nh_sz;
+		/* 1 byte next hops can not index more tbl8 */
+		if (nh_sz == RTE_FIB_DIR24_8_1B)
+			config.dir24_8.num_tbl8 = 127;
+		else
+			config.dir24_8.num_tbl8 = MAX_TBL8 - 1;
+		config.flags = 0;
+		ret = check_vector_lookup(&config);
+		RTE_TEST_ASSERT(ret == TEST_SUCCESS,
+			"Vector lookup fails for nh_sz %d\n", nh_sz);
+		config.flags = RTE_FIB_F_LOOKUP_NETWORK_ORDER;
+		ret = check_vector_lookup(&config);
+		RTE_TEST_ASSERT(ret == TEST_SUCCESS,
+			"Vector lookup fails for nh_sz %d, network order\n",
+			nh_sz);
+	}
+
+	return TEST_SUCCESS;
+}
+
+/* Resolve ip with every hash selecting a different bucket */
+static int
+lookup_nh_group(struct rte_fib *fib, uint32_t ip, uint64_t *nhs)
+{
+	uint32_t ips[NH_GROUP_BUCKETS];
+	uint32_t hashes[NH_GROUP_BUCKETS];
+	unsigned int i;
+
+	for (i = 0; i < NH_GROUP_BUCKETS; i++) {
+		ips[i] = ip;
+		/* upper bits must not matter */
+		hashes[i] = i | (rte_rand() << 16);
+	}
+
+	return rte_fib_lookup_bulk_hash(fib, ips, hashes, nhs,
+		NH_GROUP_BUCKETS);
+}
+
+static unsigned int
+count_nh(const uint64_t *nhs, uint64_t nh)
+{
+	unsigned int i, cnt = 0;
+
+	for (i = 0; i < NH_GROUP_BUCKETS; i++)
+		cnt += (nhs[i] == nh);
+	return cnt;
+}
+
+static int
+check_nh_group(struct rte_fib_conf *config)
+{
+	struct rte_fib *fib = NULL;
+	struct rte_fib_nh_group_conf grp_conf = { 0 };
+	uint64_t members[] = { 1, 2, 3, 4 };
+	uint64_t dup_members[] = { 1, 2, 1 };
+	uint32_t weights[] = { 3, 1, 0 };
+	uint32_t ip = RTE_IPV4(192, 0, 2, 0);
+	uint32_t plain_ip = RTE_IPV4(198, 51, 100, 0);
+	uint64_t old_nhs[NH_GROUP_BUCKETS];
+	uint64_t nhs[NH_GROUP_BUCKETS];
+	uint64_t ref, bad_ref, nh;
+	unsigned int i, changed;
+	int ret;
+
+	fib = rte_fib_create(__func__, SOCKET_ID_ANY, config);
+	RTE_TEST_ASSERT(fib != NULL, "Failed to create FIB\n");
+
+	ret = rte_fib_nh_group_set(fib, 0, members, NULL, 1);
+	RTE_TEST_ASSERT(ret == -EINVAL,
+		"Call succeeded with groups disabled\n");
+
+	ret = rte_fib_nh_group_init(fib, NULL);
+	RTE_TEST_ASSERT(ret == -EINVAL,
+		"Call succeeded with invalid parameters\n");
+	grp_conf.num_groups = NH_GROUPS;
+	grp_conf.num_buckets = NH_GROUP_BUCKETS - 1;
+	ret = rte_fib_nh_group_init(fib, &grp_conf);
+	RTE_TEST_ASSERT(ret == -EINVAL,
+		"Call succeeded with invalid parameters\n");
+	grp_conf.num_groups = 0;
+	grp_conf.num_buckets = NH_GROUP_BUCKETS;
+	ret = rte_fib_nh_group_init(fib, &grp_conf);
+	RTE_TEST_ASSERT(ret == -EINVAL,
+		"Call succeeded with invalid parameters\n");
+
+	grp_conf.num_groups = NH_GROUPS;
+	ret = rte_fib_nh_group_init(fib, &grp_conf);
+	RTE_TEST_ASSERT(ret == 0, "Failed to enable next hop groups\n");
+	ret = rte_fib_nh_group_init(fib, &grp_conf);
+	RTE_TEST_ASSERT(ret == -EEXIST, "Next hop groups enabled twice\n");
+
+	ret = rte_fib_nh_group_get_nh(fib, NH_GROUPS, &ref);
+	RTE_TEST_ASSERT(ret == -EINVAL,
+		"Call succeeded with invalid parameters\n");
+	ret = rte_fib_nh_group_get_nh(fib, NH_GROUPS - 1, &bad_ref);
+	RTE_TEST_ASSERT(ret == 0, "Failed to get group next hop\n");
+	bad_ref++;
+	ret = rte_fib_nh_group_get_nh(fib, 0, &ref);
+	RTE_TEST_ASSERT(ret == 0, "Failed to get group next hop\n");
+
+	/* invalid members */
+	ret = rte_fib_nh_group_set(fib, NH_GROUPS, members, NULL, 1);
+	RTE_TEST_ASSERT(ret == -EINVAL,
+		"Call succeeded with invalid parameters\n");
+	ret = rte_fib_nh_group_set(fib, 0, NULL, NULL, 1);
+	RTE_TEST_ASSERT(ret == -EINVAL,
+		"Call succeeded with invalid parameters\n");
+	ret = rte_fib_nh_group_set(fib, 0, members, NULL,
+		NH_GROUP_BUCKETS + 1);
+	RTE_TEST_ASSERT(ret == -EINVAL,
+		"Call succeeded with invalid parameters\n");
+	ret = rte_fib_nh_group_set(fib, 0, dup_members, NULL,
+		RTE_DIM(dup_members));
+	RTE_TEST_ASSERT(ret == -EINVAL,
+		"Call succeeded with duplicate members\n");
+	ret = rte_fib_nh_group_set(fib, 0, &ref, NULL, 1);
+	RTE_TEST_ASSERT(ret == -EINVAL,
+		"Call succeeded with a group as member\n");
+	ret = rte_fib_nh_group_set(fib, 0, members, weights, 3);
+	RTE_TEST_ASSERT(ret == -EINVAL,
+		"Call succeeded with a zero weight\n");
+
+	ret = rte_fib_add(fib, ip, 24, bad_ref);
+	RTE_TEST_ASSERT(ret == -EINVAL,
+		"Added route to a missing group\n");
+	ret = rte_fib_add_bulk(fib, &ip, (uint8_t []){ 24 }, &bad_ref, 1);
+	RTE_TEST_ASSERT(ret == 0, "Added route to a missing group\n");
+	ret = rte_fib_add(fib, ip, 24, ref);
+	RTE_TEST_ASSERT(ret == 0, "Failed to add route to a group\n");
+	ret = rte_fib_add(fib, plain_ip, 24, 5);
+	RTE_TEST_ASSERT(ret == 0, "Failed to add route\n");
+
+	/* empty groups resolve to the default next hop */
+	ret = lookup_nh_group(fib, ip, nhs);
+	RTE_TEST_ASSERT((ret == 0) &&
+		(count_nh(nhs, config->default_nh) == NH_GROUP_BUCKETS),
+		"Empty group does not resolve to the default next hop\n");
+
+	ret = rte_fib_nh_group_set(fib, 0, members, NULL, RTE_DIM(members));
+	RTE_TEST_ASSERT(ret == 0, "Failed to set group members\n");
+
+	ret = rte_fib_lookup_bulk(fib, &ip, &nh, 1);
+	RTE_TEST_ASSERT((ret == 0) && (nh == ref),
+		"Lookup does not return the group\n");
+	ret = lookup_nh_group(fib, plain_ip, nhs);
+	RTE_TEST_ASSERT((ret == 0) && (count_nh(nhs, 5) == NH_GROUP_BUCKETS),
+		"Lookup of a plain route changed\n");
+
+	ret = lookup_nh_group(fib, ip, nhs);
+	RTE_TEST_ASSERT(ret == 0, "Failed to lookup\n");
+	for (i = 0; i < RTE_DIM(members); i++)
+		RTE_TEST_ASSERT(count_nh(nhs, members[i]) ==
+			NH_GROUP_BUCKETS / RTE_DIM(members),
+			"Members do not share the buckets equally\n");
+	memcpy(old_nhs, nhs, sizeof(nhs));
+
+	/* removing a member only moves its own buckets */
+	members[2] = members[3];
+	ret = rte_fib_nh_group_set(fib, 0, members, NULL, 3);
+	RTE_TEST_ASSERT(ret == 0, "Failed to set group members\n");
+	ret = lookup_nh_group(fib, ip, nhs);
+	RTE_TEST_ASSERT(ret == 0, "Failed to lookup\n");
+	for (i = 0; i < NH_GROUP_BUCKETS; i++)
+		RTE_TEST_ASSERT((old_nhs[i] == 3) || (nhs[i] == old_nhs[i]),
+			"Bucket of a kept member moved\n");
+	for (i = 0; i < 3; i++)
+		RTE_TEST_ASSERT((count_nh(nhs, members[i]) ==
+			NH_GROUP_BUCKETS / 3) || (count_nh(nhs, members[i]) ==
+			NH_GROUP_BUCKETS / 3 + 1),
+			"Members do not share the buckets equally\n");
+	memcpy(old_nhs, nhs, sizeof(nhs));
+
+	/* adding a member only moves the buckets it takes */
+	members[3] = 6;
+	ret = rte_fib_nh_group_set(fib, 0, members, NULL, 4);
+	RTE_TEST_ASSERT(ret == 0, "Failed to set group members\n");
+	ret = lookup_nh_group(fib, ip, nhs);
+	RTE_TEST_ASSERT(ret == 0, "Failed to lookup\n");
+	for (i = 0, changed = 0; i < NH_GROUP_BUCKETS; i++) {
+		if (nhs[i] == old_nhs[i])
+			continue;
+		RTE_TEST_ASSERT(nhs[i] == 6, "Bucket moved to a kept member\n");
+		changed++;
+	}
+	RTE_TEST_ASSERT(changed == NH_GROUP_BUCKETS / 4,
+		"New member did not get its share\n");
+
+	/* weighted members */
+	ret = rte_fib_nh_group_set(fib, 0, members, weights, 2);
+	RTE_TEST_ASSERT(ret == 0, "Failed to set group members\n");
+	ret = lookup_nh_group(fib, ip, nhs);
+	RTE_TEST_ASSERT((ret == 0) &&
+		(count_nh(nhs, members[0]) == NH_GROUP_BUCKETS * 3 / 4) &&
+		(count_nh(nhs, members[1]) == NH_GROUP_BUCKETS / 4),
+		"Members do not share the buckets by weight\n");
+
+	/* the largest weights do not overflow the shares */
+	ret = rte_fib_nh_group_set(fib, 0, members,
+		(uint32_t []){ UINT32_MAX, UINT32_MAX / 3 }, 2);
+	RTE_TEST_ASSERT(ret == 0, "Failed to set group members\n");
+	ret = lookup_nh_group(fib, ip, nhs);
+	RTE_TEST_ASSERT((ret == 0) &&
+		(count_nh(nhs, members[0]) == NH_GROUP_BUCKETS * 3 / 4) &&
+		(count_nh(nhs, members[1]) == NH_GROUP_BUCKETS / 4),
+		"Members do not share the buckets by large weights\n");
+
+	ret = rte_fib_nh_group_set(fib, 0, NULL, NULL, 0);
+	RTE_TEST_ASSERT(ret == 0, "Failed to empty group\n");
+	ret = lookup_nh_group(fib, ip, nhs);
+	RTE_TEST_ASSERT((ret == 0) &&
+		(count_nh(nhs, config->default_nh) == NH_GROUP_BUCKETS),
+		"Empty group does not resolve to the default next hop\n");
+
+	rte_fib_free(fib);
+
+	return TEST_SUCCESS;
+}
+
+/*
+ * Check next hop groups: invalid parameters, resolution of the group
+ * members by hash, weights and resilient changes of the members
+ */
+int32_t
+test_nh_group(void)
+{
+	struct rte_fib *fib = NULL;
+	struct rte_fib_conf config = { 0 };
+	struct rte_fib_nh_group_conf grp_conf = { 0 };
+	int ret;
+
+	config.max_routes = MAX_ROUTES;
+	config.rib_ext_sz = 0;
+	config.default_nh = 10;
+	config.type = RTE_FIB_DUMMY;
+
+	ret = check_nh_group(&config);
+	RTE_TEST_ASSERT(ret == TEST_SUCCESS,
+		"Next hop groups fail for DUMMY FIB\n");
+
+	config.type = RTE_FIB_DIR24_8;
+	config.dir24_8.nh_sz = RTE_FIB_DIR24_8_2B;
+	config.dir24_8.num_tbl8 = 127;
+	ret = check_nh_group(&config);
+	RTE_TEST_ASSERT(ret == TEST_SUCCESS,
+		"Next hop groups fail for DIR24_8 FIB\n");
+
+	/* 1 byte next hops leave room for 64 groups */
+	config.dir24_8.nh_sz = RTE_FIB_DIR24_8_1B;
+	fib = rte_fib_create(__func__, SOCKET_ID_ANY, &config);
+	RTE_TEST_ASSERT(fib != NULL, "Failed to create FIB\n");
+	grp_conf.num_groups = 65;
+	grp_conf.num_buckets = NH_GROUP_BUCKETS;
+	ret = rte_fib_nh_group_init(fib, &grp_conf);
+	RTE_TEST_ASSERT(ret == -EINVAL,
+		"Call succeeded with too many groups\n");
+
+	/* existing routes must not look like groups */
+	ret = rte_fib_add(fib, RTE_IPV4(192, 0, 2, 0), 24, 64);
+	RTE_TEST_ASSERT(ret == 0, "Failed to add route\n");
+	grp_conf.num_groups = 64;
+	ret = rte_fib_nh_group_init(fib, &grp_conf);
+	RTE_TEST_ASSERT(ret == -EINVAL,
+		"Call succeeded with a route in the group range\n");
+	ret = rte_fib_delete(fib, RTE_IPV4(192, 0, 2, 0), 24);
+	RTE_TEST_ASSERT(ret == 0, "Failed to delete route\n");
+	ret = rte_fib_add(fib, 0, 0, 64);
+	RTE_TEST_ASSERT(ret == 0, "Failed to add default route\n");
+	ret = rte_fib_nh_group_init(fib, &grp_conf);
+	RTE_TEST_ASSERT(ret == -EINVAL,
+		"Call succeeded with a default route in the group range\n");
+	ret = rte_fib_delete(fib, 0, 0);
+	RTE_TEST_ASSERT(ret == 0, "Failed to delete default route\n");
+	ret = rte_fib_nh_group_init(fib, &grp_conf);
+	RTE_TEST_ASSERT(ret == 0, "Failed to enable next hop groups\n");
+	rte_fib_free(fib);
+
+	return TEST_SUCCESS;
+}
+
 /*
  * rte_fib_rcu_qsbr_add positive and negative tests.
  *  - Add RCU QSBR variable to FIB
@@ -598,6 +1154,9 @@ static struct unit_test_suite fib_fast_tests = {
 	TEST_CASE(test_add_del_invalid),
 	TEST_CASE(test_get_invalid),
 	TEST_CASE(test_lookup),
+	TEST_CASE(test_add_bulk),
+	TEST_CASE(test_vector_lookup),
+	TEST_CASE(test_nh_group),
 	TEST_CASE(test_invalid_rcu),
 	TEST_CASE(test_fib_rcu_sync_rw),
 	TEST_CASES_END()
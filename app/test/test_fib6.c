@@ -6,11 +6,14 @@
 #include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include <rte_memory.h>
 #include <rte_log.h>
+#include <rte_malloc.h>
 #include <rte_rib6.h>
 #include <rte_fib6.h>
+#include <rte_random.h>
 
 #include "test.h"
 
@@ -22,10 +25,19 @@ static int32_t test_free_null(void);
 static int32_t test_add_del_invalid(void);
 static int32_t test_get_invalid(void);
 static int32_t test_lookup(void);
+static int32_t test_add_bulk(void);
+static int32_t test_vector_lookup(void);
+static int32_t test_poptrie(void);
+static int32_t test_invalid_rcu(void);
+static int32_t test_poptrie_rcu_dq(void);
+static int32_t test_nh_group(void);
 
 #define MAX_ROUTES	(1 << 16)
 /** Maximum number of tbl8 for 2-byte entries */
 #define MAX_TBL8	(1 << 15)
+#define BULK_ROUTES	1024
+#define NH_GROUPS	16
+#define NH_GROUP_BUCKETS	256
 
 /*
  * Check that rte_fib6_create fails gracefully for incorrect user input
@@ -64,7 +76,7 @@ test_create_invalid(void)
 		"Call succeeded with invalid parameters\n");
 	config.max_routes = MAX_ROUTES;
 
-	config.type = RTE_FIB6_TRIE + 1;
+	config.type = RTE_FIB6_POPTRIE + 1;
 	fib = rte_fib6_create(__func__, SOCKET_ID_ANY, &config);
 	RTE_TEST_ASSERT(fib == NULL,
 		"Call succeeded with invalid parameters\n");
@@ -83,6 +95,26 @@ test_create_invalid(void)
 	RTE_TEST_ASSERT(fib == NULL,
 		"Call succeeded with invalid parameters\n");
 
+	config.type = RTE_FIB6_POPTRIE;
+	config.poptrie.num_nodes = MAX_ROUTES;
+
+	config.poptrie.nh_sz = RTE_FIB6_TRIE_8B + 1;
+	fib = rte_fib6_create(__func__, SOCKET_ID_ANY, &config);
+	RTE_TEST_ASSERT(fib == NULL,
+		"Call succeeded with invalid parameters\n");
+	config.poptrie.nh_sz = RTE_FIB6_TRIE_2B;
+
+	config.default_nh = UINT16_MAX + 1;
+	fib = rte_fib6_create(__func__, SOCKET_ID_ANY, &config);
+	RTE_TEST_ASSERT(fib == NULL,
+		"Call succeeded with invalid parameters\n");
+	config.default_nh = 0;
+
+	config.poptrie.num_nodes = 0;
+	fib = rte_fib6_create(__func__, SOCKET_ID_ANY, &config);
+	RTE_TEST_ASSERT(fib == NULL,
+		"Call succeeded with invalid parameters\n");
+
 	return TEST_SUCCESS;
 }
 
@@ -384,6 +416,788 @@ test_lookup(void)
 		"Check_fib fails for TRIE_8B type\n");
 	rte_fib6_free(fib);
 
+	config.type = RTE_FIB6_POPTRIE;
+	config.poptrie.num_nodes = MAX_ROUTES;
+
+	config.poptrie.nh_sz = RTE_FIB6_TRIE_2B;
+	fib = rte_fib6_create(__func__, SOCKET_ID_ANY, &config);
+	RTE_TEST_ASSERT(fib != NULL, "Failed to create FIB\n");
+	ret = check_fib(fib);
+	RTE_TEST_ASSERT(ret == TEST_SUCCESS,
+		"Check_fib fails for POPTRIE_2B type\n");
+	rte_fib6_free(fib);
+
+	config.poptrie.nh_sz = RTE_FIB6_TRIE_4B;
+	fib = rte_fib6_create(__func__, SOCKET_ID_ANY, &config);
+	RTE_TEST_ASSERT(fib != NULL, "Failed to create FIB\n");
+	ret = check_fib(fib);
+	RTE_TEST_ASSERT(ret == TEST_SUCCESS,
+		"Check_fib fails for POPTRIE_4B type\n");
+	rte_fib6_free(fib);
+
+	config.poptrie.nh_sz = RTE_FIB6_TRIE_8B;
+	fib = rte_fib6_create(__func__, SOCKET_ID_ANY, &config);
+	RTE_TEST_ASSERT(fib != NULL, "Failed to create FIB\n");
+	ret = check_fib(fib);
+	RTE_TEST_ASSERT(ret == TEST_SUCCESS,
+		"Check_fib fails for POPTRIE_8B type\n");
+	rte_fib6_free(fib);
+
+	return TEST_SUCCESS;
+}
+
+static struct rte_ipv6_addr bulk_ips[BULK_ROUTES];
+static uint8_t bulk_depths[BULK_ROUTES];
+static uint64_t bulk_nhs[BULK_ROUTES];
+
+static void
+generate_bulk_routes(void)
+{
+	uint32_t i, j;
+
+	/* Few first bytes, so that prefixes nest into each other */
+	for (i = 0; i < BULK_ROUTES; i++) {
+		bulk_ips[i].a[0] = 0x20;
+		bulk_ips[i].a[1] = rte_rand_max(4);
+		for (j = 2; j < RTE_IPV6_ADDR_SIZE; j++)
+			bulk_ips[i].a[j] = rte_rand_max(256);
+		bulk_depths[i] = 16 + rte_rand_max(RTE_IPV6_MAX_DEPTH - 15);
+		bulk_nhs[i] = 1 + rte_rand_max(1000);
+	}
+}
+
+/*
+ * Check that two FIBs return the same next hops for the first, the last
+ * and the next address of every bulk route, and for random addresses
+ */
+static int
+compare_fibs(struct rte_fib6 *fib1, struct rte_fib6 *fib2)
+{
+	static struct rte_ipv6_addr ips[4 * BULK_ROUTES];
+	static uint64_t nh1[4 * BULK_ROUTES];
+	static uint64_t nh2[4 * BULK_ROUTES];
+	struct rte_ipv6_addr last;
+	uint32_t i;
+	int j, ret;
+
+	for (i = 0; i < BULK_ROUTES; i++) {
+		ips[4 * i] = bulk_ips[i];
+		rte_ipv6_addr_mask(&ips[4 * i], bulk_depths[i]);
+		last = bulk_ips[i];
+		for (j = 0; j < RTE_IPV6_ADDR_SIZE; j++) {
+			if (bulk_depths[i] <= j * CHAR_BIT)
+				last.a[j] = UINT8_MAX;
+			else if (bulk_depths[i] < (j + 1) * CHAR_BIT)
+				last.a[j] |= UINT8_MAX >>
+					(bulk_depths[i] - j * CHAR_BIT);
+		}
+		ips[4 * i + 1] = last;
+		for (j = RTE_IPV6_ADDR_SIZE - 1; j >= 0; j--)
+			if (++last.a[j] != 0)
+				break;
+		ips[4 * i + 2] = last;
+		for (j = 0; j < RTE_IPV6_ADDR_SIZE; j++)
+			ips[4 * i + 3].a[j] = rte_rand_max(256);
+		ips[4 * i + 3].a[0] = 0x20;
+	}
+
+	ret = rte_fib6_lookup_bulk(fib1, ips, nh1, RTE_DIM(ips));
+	RTE_TEST_ASSERT(ret == 0, "Failed to lookup\n");
+	ret = rte_fib6_lookup_bulk(fib2, ips, nh2, RTE_DIM(ips));
+	RTE_TEST_ASSERT(ret == 0, "Failed to lookup\n");
+
+	for (i = 0; i < RTE_DIM(ips); i++)
+		RTE_TEST_ASSERT(nh1[i] == nh2[i],
+			"Next hop mismatch for " RTE_IPV6_ADDR_FMT
+			": %"PRIu64" != %"PRIu64"\n",
+			RTE_IPV6_ADDR_SPLIT(&ips[i]), nh1[i], nh2[i]);
+
+	return TEST_SUCCESS;
+}
+
+static int
+add_seq(struct rte_fib6 *fib, uint32_t start, uint32_t n)
+{
+	uint32_t i;
+	int ret;
+
+	for (i = start; i < start + n; i++) {
+		ret = rte_fib6_add(fib, &bulk_ips[i], bulk_depths[i],
+			bulk_nhs[i]);
+		RTE_TEST_ASSERT(ret == 0, "Failed to add a route\n");
+	}
+
+	return TEST_SUCCESS;
+}
+
+/*
+ * Add the same routes to one FIB with rte_fib6_add_bulk and to another one
+ * with rte_fib6_add, into an empty FIB and on top of existing routes,
+ * and check they both return the same next hops
+ */
+static int
+check_add_bulk(struct rte_fib6_conf *config)
+{
+	struct rte_fib6 *fib1, *fib2;
+	uint8_t depth;
+	uint32_t i;
+	int ret;
+
+	fib1 = rte_fib6_create("test_add_bulk1", SOCKET_ID_ANY, config);
+	RTE_TEST_ASSERT(fib1 != NULL, "Failed to create FIB\n");
+	fib2 = rte_fib6_create("test_add_bulk2", SOCKET_ID_ANY, config);
+	RTE_TEST_ASSERT(fib2 != NULL, "Failed to create FIB\n");
+
+	generate_bulk_routes();
+
+	ret = rte_fib6_add_bulk(fib1, bulk_ips, bulk_depths, bulk_nhs, 0);
+	RTE_TEST_ASSERT(ret == 0, "Failed to add no route\n");
+
+	/* Load into an empty FIB */
+	ret = rte_fib6_add_bulk(fib1, bulk_ips, bulk_depths, bulk_nhs,
+		BULK_ROUTES / 2);
+	RTE_TEST_ASSERT(ret == BULK_ROUTES / 2, "Failed to add routes\n");
+	RTE_TEST_ASSERT(add_seq(fib2, 0, BULK_ROUTES / 2) == TEST_SUCCESS,
+		"Failed to add routes\n");
+	RTE_TEST_ASSERT(compare_fibs(fib1, fib2) == TEST_SUCCESS,
+		"Bulk and single adds differ\n");
+
+	/* Add on top of existing routes */
+	RTE_TEST_ASSERT(add_seq(fib2, BULK_ROUTES / 2, BULK_ROUTES / 2) ==
+		TEST_SUCCESS, "Failed to add routes\n");
+	ret = rte_fib6_add_bulk(fib1, &bulk_ips[BULK_ROUTES / 2],
+		&bulk_depths[BULK_ROUTES / 2], &bulk_nhs[BULK_ROUTES / 2],
+		BULK_ROUTES / 2);
+	RTE_TEST_ASSERT(ret == BULK_ROUTES / 2, "Failed to add routes\n");
+	RTE_TEST_ASSERT(compare_fibs(fib1, fib2) == TEST_SUCCESS,
+		"Bulk and single adds differ\n");
+
+	/* Change the next hop of existing routes */
+	for (i = 0; i < BULK_ROUTES; i += 2)
+		bulk_nhs[i] = 1 + rte_rand_max(1000);
+	ret = rte_fib6_add_bulk(fib1, bulk_ips, bulk_depths, bulk_nhs,
+		BULK_ROUTES);
+	RTE_TEST_ASSERT(ret == BULK_ROUTES, "Failed to add routes\n");
+	RTE_TEST_ASSERT(add_seq(fib2, 0, BULK_ROUTES) == TEST_SUCCESS,
+		"Failed to add routes\n");
+	RTE_TEST_ASSERT(compare_fibs(fib1, fib2) == TEST_SUCCESS,
+		"Bulk and single adds differ\n");
+
+	/* Routes after an invalid one are not added */
+	for (i = 0; i < BULK_ROUTES; i++)
+		bulk_nhs[i] = 1 + rte_rand_max(1000);
+	depth = bulk_depths[16];
+	bulk_depths[16] = RTE_IPV6_MAX_DEPTH + 1;
+	ret = rte_fib6_add_bulk(fib1, bulk_ips, bulk_depths, bulk_nhs,
+		BULK_ROUTES);
+	RTE_TEST_ASSERT(ret == 16, "Added routes after an invalid one\n");
+	RTE_TEST_ASSERT(add_seq(fib2, 0, 16) == TEST_SUCCESS,
+		"Failed to add routes\n");
+	bulk_depths[16] = depth;
+	RTE_TEST_ASSERT(compare_fibs(fib1, fib2) == TEST_SUCCESS,
+		"Bulk and single adds differ\n");
+
+	/* Routes added in bulk are deleted as usual */
+	for (i = 0; i < BULK_ROUTES; i += 2) {
+		rte_fib6_delete(fib1, &bulk_ips[i], bulk_depths[i]);
+		rte_fib6_delete(fib2, &bulk_ips[i], bulk_depths[i]);
+	}
+	RTE_TEST_ASSERT(compare_fibs(fib1, fib2) == TEST_SUCCESS,
+		"Bulk and single adds differ after delete\n");
+
+	rte_fib6_free(fib1);
+	rte_fib6_free(fib2);
+
+	return TEST_SUCCESS;
+}
+
+int32_t
+test_add_bulk(void)
+{
+	struct rte_fib6_conf config = { 0 };
+	int ret;
+
+	config.max_routes = MAX_ROUTES;
+	config.rib_ext_sz = 0;
+	config.default_nh = 0;
+	config.type = RTE_FIB6_DUMMY;
+
+	ret = rte_fib6_add_bulk(NULL, bulk_ips, bulk_depths, bulk_nhs, 1);
+	RTE_TEST_ASSERT(ret == -EINVAL,
+		"Call succeeded with invalid parameters\n");
+
+	ret = check_add_bulk(&config);
+	RTE_TEST_ASSERT(ret == TEST_SUCCESS,
+		"Bulk add fails for DUMMY type\n");
+
+	config.type = RTE_FIB6_TRIE;
+
+	config.trie.nh_sz = RTE_FIB6_TRIE_2B;
+	config.trie.num_tbl8 = MAX_TBL8 - 1;
+	ret = check_add_bulk(&config);
+	RTE_TEST_ASSERT(ret == TEST_SUCCESS,
+		"Bulk add fails for TRIE_2B type\n");
+
+	config.trie.nh_sz = RTE_FIB6_TRIE_8B;
+	config.trie.num_tbl8 = MAX_TBL8;
+	ret = check_add_bulk(&config);
+	RTE_TEST_ASSERT(ret == TEST_SUCCESS,
+		"Bulk add fails for TRIE_8B type\n");
+
+	config.type = RTE_FIB6_POPTRIE;
+	config.poptrie.num_nodes = MAX_ROUTES;
+
+	config.poptrie.nh_sz = RTE_FIB6_TRIE_2B;
+	ret = check_add_bulk(&config);
+	RTE_TEST_ASSERT(ret == TEST_SUCCESS,
+		"Bulk add fails for POPTRIE_2B type\n");
+
+	config.poptrie.nh_sz = RTE_FIB6_TRIE_8B;
+	ret = check_add_bulk(&config);
+	RTE_TEST_ASSERT(ret == TEST_SUCCESS,
+		"Bulk add fails for POPTRIE_8B type\n");
+
+	return TEST_SUCCESS;
+}
+
+/*
+ * Check that every vector lookup supported on this machine returns the
+ * same next hops as the scalar one, for all next hop sizes
+ */
+static int
+check_vector_lookup(struct rte_fib6_conf *config)
+{
+	static const enum rte_fib6_lookup_type types[] = {
+		RTE_FIB6_LOOKUP_TRIE_VECTOR_AVX2,
+		RTE_FIB6_LOOKUP_TRIE_VECTOR_AVX512,
+	};
+	static struct rte_ipv6_addr ips[BULK_ROUTES + 7];
+	static uint64_t nh_scalar[RTE_DIM(ips)];
+	static uint64_t nh_vec[RTE_DIM(ips)];
+	struct rte_fib6 *fib;
+	uint32_t i, j;
+	int ret;
+
+	fib = rte_fib6_create(__func__, SOCKET_ID_ANY, config);
+	RTE_TEST_ASSERT(fib != NULL, "Failed to create FIB\n");
+
+	generate_bulk_routes();
+	ret = rte_fib6_add_bulk(fib, bulk_ips, bulk_depths, bulk_nhs,
+		BULK_ROUTES);
+	RTE_TEST_ASSERT(ret == BULK_ROUTES, "Failed to add routes\n");
+
+	/* Routes and random addresses, tail not multiple of the vector size */
+	for (i = 0; i < RTE_DIM(ips); i++) {
+		if (i & 1) {
+			ips[i] = bulk_ips[i % BULK_ROUTES];
+			continue;
+		}
+		for (j = 0; j < RTE_IPV6_ADDR_SIZE; j++)
+			ips[i].a[j] = rte_rand_max(256);
+		ips[i].a[0] = 0x20;
+		ips[i].a[1] = rte_rand_max(4);
+	}
+
+	ret = rte_fib6_select_lookup(fib, RTE_FIB6_LOOKUP_TRIE_SCALAR);
+	RTE_TEST_ASSERT(ret == 0, "Failed to select scalar lookup\n");
+	ret = rte_fib6_lookup_bulk(fib, ips, nh_scalar, RTE_DIM(ips));
+	RTE_TEST_ASSERT(ret == 0, "Failed to lookup\n");
+
+	for (j = 0; j < RTE_DIM(types); j++) {
+		/* not supported by the CPU or the build */
+		if (rte_fib6_select_lookup(fib, types[j]) != 0)
+			continue;
+		ret = rte_fib6_lookup_bulk(fib, ips, nh_vec, RTE_DIM(ips));
+		RTE_TEST_ASSERT(ret == 0, "Failed to lookup\n");
+		for (i = 0; i < RTE_DIM(ips); i++)
+			RTE_TEST_ASSERT(nh_vec[i] == nh_scalar[i],
+				"Lookup type %d mismatch for " RTE_IPV6_ADDR_FMT
+				": %"PRIu64" != %"PRIu64"\n", types[j],
+				RTE_IPV6_ADDR_SPLIT(&ips[i]), nh_vec[i],
+				nh_scalar[i]);
+	}
+
+	rte_fib6_free(fib);
+
+	return TEST_SUCCESS;
+}
+
+int32_t
+test_vector_lookup(void)
+{
+	struct rte_fib6_conf config = { 0 };
+	int ret;
+
+	config.max_routes = MAX_ROUTES;
+	config.rib_ext_sz = 0;
+	config.default_nh = 0;
+	config.type = RTE_FIB6_TRIE;
+
+	config.trie.nh_sz = RTE_FIB6_TRIE_2B;
+	config.trie.num_tbl8 = MAX_TBL8 - 1;
+	ret = check_vector_lookup(&config);
+	RTE_TEST_ASSERT(ret == TEST_SUCCESS,
+		"Vector lookup fails for TRIE_2B type\n");
+
+	config.trie.nh_sz = RTE_FIB6_TRIE_4B;
+	config.trie.num_tbl8 = MAX_TBL8;
+	ret = check_vector_lookup(&config);
+	RTE_TEST_ASSERT(ret == TEST_SUCCESS,
+		"Vector lookup fails for TRIE_4B type\n");
+
+	config.trie.nh_sz = RTE_FIB6_TRIE_8B;
+	config.trie.num_tbl8 = MAX_TBL8;
+	ret = check_vector_lookup(&config);
+	RTE_TEST_ASSERT(ret == TEST_SUCCESS,
+		"Vector lookup fails for TRIE_8B type\n");
+
+	return TEST_SUCCESS;
+}
+
+/*
+ * Check that a POPTRIE FIB returns the same next hops as a TRIE one while
+ * routes of any depth are added, changed and deleted, and that a route
+ * which does not fit leaves the POPTRIE unchanged
+ */
+static int
+check_poptrie(enum rte_fib_trie_nh_sz nh_sz)
+{
+	struct rte_fib6_conf config = { 0 };
+	struct rte_fib6 *trie, *poptrie;
+	uint32_t i, j, nospc = 0;
+	int ret;
+
+	config.max_routes = MAX_ROUTES;
+	config.rib_ext_sz = 0;
+	config.default_nh = 0;
+	config.type = RTE_FIB6_TRIE;
+	config.trie.nh_sz = nh_sz;
+	config.trie.num_tbl8 = MAX_TBL8 - 1;
+	trie = rte_fib6_create("test_poptrie1", SOCKET_ID_ANY, &config);
+	RTE_TEST_ASSERT(trie != NULL, "Failed to create FIB\n");
+
+	config.type = RTE_FIB6_POPTRIE;
+	config.poptrie.nh_sz = nh_sz;
+	config.poptrie.num_nodes = MAX_ROUTES;
+	poptrie = rte_fib6_create("test_poptrie2", SOCKET_ID_ANY, &config);
+	RTE_TEST_ASSERT(poptrie != NULL, "Failed to create FIB\n");
+
+	/* Some prefixes span several direct table entries */
+	generate_bulk_routes();
+	for (i = 0; i < BULK_ROUTES; i += 64)
+		bulk_depths[i] = rte_rand_max(17);
+
+	RTE_TEST_ASSERT(add_seq(trie, 0, BULK_ROUTES) == TEST_SUCCESS,
+		"Failed to add routes\n");
+	RTE_TEST_ASSERT(add_seq(poptrie, 0, BULK_ROUTES) == TEST_SUCCESS,
+		"Failed to add routes\n");
+	RTE_TEST_ASSERT(compare_fibs(trie, poptrie) == TEST_SUCCESS,
+		"POPTRIE and TRIE differ after add\n");
+
+	for (i = 0; i < BULK_ROUTES; i += 3)
+		bulk_nhs[i] = 1 + rte_rand_max(1000);
+	RTE_TEST_ASSERT(add_seq(trie, 0, BULK_ROUTES) == TEST_SUCCESS,
+		"Failed to add routes\n");
+	RTE_TEST_ASSERT(add_seq(poptrie, 0, BULK_ROUTES) == TEST_SUCCESS,
+		"Failed to add routes\n");
+	RTE_TEST_ASSERT(compare_fibs(trie, poptrie) == TEST_SUCCESS,
+		"POPTRIE and TRIE differ after next hop change\n");
+
+	for (i = 0; i < BULK_ROUTES; i += 2) {
+		rte_fib6_delete(trie, &bulk_ips[i], bulk_depths[i]);
+		rte_fib6_delete(poptrie, &bulk_ips[i], bulk_depths[i]);
+	}
+	RTE_TEST_ASSERT(compare_fibs(trie, poptrie) == TEST_SUCCESS,
+		"POPTRIE and TRIE differ after delete\n");
+
+	/* Updates must give their old nodes back */
+	for (j = 0; j < 32; j++) {
+		for (i = 0; i < BULK_ROUTES; i += 2) {
+			ret = rte_fib6_add(poptrie, &bulk_ips[i],
+				bulk_depths[i], bulk_nhs[i]);
+			RTE_TEST_ASSERT(ret == 0, "Failed to add a route\n");
+		}
+		for (i = 0; i < BULK_ROUTES; i += 2)
+			rte_fib6_delete(poptrie, &bulk_ips[i], bulk_depths[i]);
+	}
+	RTE_TEST_ASSERT(compare_fibs(trie, poptrie) == TEST_SUCCESS,
+		"POPTRIE and TRIE differ after updates\n");
+
+	rte_fib6_free(poptrie);
+	rte_fib6_free(trie);
+
+	/* Only add to the TRIE the routes the POPTRIE has room for */
+	config.type = RTE_FIB6_TRIE;
+	config.trie.num_tbl8 = MAX_TBL8 - 1;
+	trie = rte_fib6_create("test_poptrie1", SOCKET_ID_ANY, &config);
+	RTE_TEST_ASSERT(trie != NULL, "Failed to create FIB\n");
+	config.type = RTE_FIB6_POPTRIE;
+	config.poptrie.num_nodes = 64;
+	poptrie = rte_fib6_create("test_poptrie2", SOCKET_ID_ANY, &config);
+	RTE_TEST_ASSERT(poptrie != NULL, "Failed to create FIB\n");
+
+	for (i = 0; i < BULK_ROUTES; i++) {
+		ret = rte_fib6_add(poptrie, &bulk_ips[i], bulk_depths[i],
+			bulk_nhs[i]);
+		if (ret == -ENOSPC) {
+			nospc++;
+			continue;
+		}
+		RTE_TEST_ASSERT(ret == 0, "Failed to add a route\n");
+		ret = rte_fib6_add(trie, &bulk_ips[i], bulk_depths[i],
+			bulk_nhs[i]);
+		RTE_TEST_ASSERT(ret == 0, "Failed to add a route\n");
+	}
+	RTE_TEST_ASSERT(nospc != 0, "POPTRIE did not run out of nodes\n");
+	RTE_TEST_ASSERT(compare_fibs(trie, poptrie) == TEST_SUCCESS,
+		"POPTRIE and TRIE differ after running out of nodes\n");
+
+	rte_fib6_free(poptrie);
+	rte_fib6_free(trie);
+
+	return TEST_SUCCESS;
+}
+
+int32_t
+test_poptrie(void)
+{
+	int ret;
+
+	ret = check_poptrie(RTE_FIB6_TRIE_2B);
+	RTE_TEST_ASSERT(ret == TEST_SUCCESS,
+		"Check fails for POPTRIE_2B type\n");
+
+	ret = check_poptrie(RTE_FIB6_TRIE_4B);
+	RTE_TEST_ASSERT(ret == TEST_SUCCESS,
+		"Check fails for POPTRIE_4B type\n");
+
+	ret = check_poptrie(RTE_FIB6_TRIE_8B);
+	RTE_TEST_ASSERT(ret == TEST_SUCCESS,
+		"Check fails for POPTRIE_8B type\n");
+
+	return TEST_SUCCESS;
+}
+
+/*
+ * rte_fib6_rcu_qsbr_add positive and negative tests.
+ *  - Add RCU QSBR variable to FIB
+ *  - Add another RCU QSBR variable to FIB
+ *  - Check returns
+ */
+int32_t
+test_invalid_rcu(void)
+{
+	struct rte_fib6 *fib = NULL;
+	struct rte_fib6_conf config = { 0 };
+	size_t sz;
+	struct rte_rcu_qsbr *qsv;
+	struct rte_rcu_qsbr *qsv2;
+	int32_t status;
+	struct rte_fib6_rcu_config rcu_cfg = {0};
+
+	config.max_routes = MAX_ROUTES;
+	config.rib_ext_sz = 0;
+	config.default_nh = 100;
+	config.type = RTE_FIB6_TRIE;
+	config.trie.nh_sz = RTE_FIB6_TRIE_4B;
+	config.trie.num_tbl8 = MAX_TBL8;
+
+	fib = rte_fib6_create(__func__, SOCKET_ID_ANY, &config);
+	RTE_TEST_ASSERT(fib != NULL, "Failed to create FIB\n");
+
+	/* Create RCU QSBR variable */
+	sz = rte_rcu_qsbr_get_memsize(RTE_MAX_LCORE);
+	qsv = (struct rte_rcu_qsbr *)rte_zmalloc_socket(NULL, sz, RTE_CACHE_LINE_SIZE,
+		SOCKET_ID_ANY);
+	RTE_TEST_ASSERT(qsv != NULL, "Can not allocate memory for RCU\n");
+
+	status = rte_rcu_qsbr_init(qsv, RTE_MAX_LCORE);
+	RTE_TEST_ASSERT(status == 0, "Can not initialize RCU\n");
+
+	rcu_cfg.v = qsv;
+
+	/* adding rcu to RTE_FIB6_TRIE FIB type */
+	rcu_cfg.mode = RTE_FIB6_QSBR_MODE_SYNC;
+	status = rte_fib6_rcu_qsbr_add(fib, &rcu_cfg);
+	RTE_TEST_ASSERT(status == -ENOTSUP,
+		"rte_fib6_rcu_qsbr_add returned wrong error status when called with TRIE type FIB\n");
+	rte_fib6_free(fib);
+
+	config.type = RTE_FIB6_POPTRIE;
+	config.poptrie.nh_sz = RTE_FIB6_TRIE_4B;
+	config.poptrie.num_nodes = MAX_TBL8;
+	fib = rte_fib6_create(__func__, SOCKET_ID_ANY, &config);
+	RTE_TEST_ASSERT(fib != NULL, "Failed to create FIB\n");
+
+	/* Call rte_fib6_rcu_qsbr_add without fib or config */
+	status = rte_fib6_rcu_qsbr_add(NULL, &rcu_cfg);
+	RTE_TEST_ASSERT(status == -EINVAL, "RCU added without fib\n");
+	status = rte_fib6_rcu_qsbr_add(fib, NULL);
+	RTE_TEST_ASSERT(status == -EINVAL, "RCU added without config\n");
+
+	/* Invalid QSBR mode */
+	rcu_cfg.mode = 2;
+	status = rte_fib6_rcu_qsbr_add(fib, &rcu_cfg);
+	RTE_TEST_ASSERT(status == -EINVAL, "RCU added with incorrect mode\n");
+
+	rcu_cfg.mode = RTE_FIB6_QSBR_MODE_DQ;
+
+	/* Attach RCU QSBR to FIB to check for double attach */
+	status = rte_fib6_rcu_qsbr_add(fib, &rcu_cfg);
+	RTE_TEST_ASSERT(status == 0, "Can not attach RCU to FIB\n");
+
+	/* Create and attach another RCU QSBR to FIB table */
+	qsv2 = (struct rte_rcu_qsbr *)rte_zmalloc_socket(NULL, sz, RTE_CACHE_LINE_SIZE,
+		SOCKET_ID_ANY);
+	RTE_TEST_ASSERT(qsv2 != NULL, "Can not allocate memory for RCU\n");
+
+	rcu_cfg.v = qsv2;
+	rcu_cfg.mode = RTE_FIB6_QSBR_MODE_SYNC;
+	status = rte_fib6_rcu_qsbr_add(fib, &rcu_cfg);
+	RTE_TEST_ASSERT(status == -EEXIST, "Secondary RCU was mistakenly attached\n");
+
+	rte_fib6_free(fib);
+	rte_free(qsv);
+	rte_free(qsv2);
+
+	return TEST_SUCCESS;
+}
+
+/* Nodes on the way to a /64 route: the root and one per 6 bits past 16 */
+#define POPTRIE_RCU_PATH	8
+
+/*
+ * POPTRIE nodes replaced by an update are not reused while a reader
+ * has not reported a quiescent state.
+ *  - Create a POPTRIE FIB with room for two copies of a /64 route path
+ *  - Attach a RCU QSBR variable in defer queue mode
+ *  - Register a reader which does not report quiescent states
+ *  - Changing the route twice must fail the second time, the nodes
+ *    of the first copy being still in use
+ *  - Once the reader reported a quiescent state it must succeed
+ */
+int32_t
+test_poptrie_rcu_dq(void)
+{
+	struct rte_fib6 *fib = NULL;
+	struct rte_fib6_conf config = { 0 };
+	struct rte_fib6_rcu_config rcu_cfg = {0};
+	struct rte_ipv6_addr ip = RTE_IPV6(0x2001, 0xdb8, 1, 2, 0, 0, 0, 0);
+	struct rte_rcu_qsbr *qsv;
+	uint64_t nh;
+	size_t sz;
+	int32_t status;
+
+	config.max_routes = MAX_ROUTES;
+	config.rib_ext_sz = 0;
+	config.default_nh = 100;
+	config.type = RTE_FIB6_POPTRIE;
+	config.poptrie.nh_sz = RTE_FIB6_TRIE_4B;
+	config.poptrie.num_nodes = 2 * POPTRIE_RCU_PATH;
+
+	fib = rte_fib6_create(__func__, SOCKET_ID_ANY, &config);
+	RTE_TEST_ASSERT(fib != NULL, "Failed to create FIB\n");
+
+	sz = rte_rcu_qsbr_get_memsize(1);
+	qsv = (struct rte_rcu_qsbr *)rte_zmalloc_socket(NULL, sz, RTE_CACHE_LINE_SIZE,
+		SOCKET_ID_ANY);
+	RTE_TEST_ASSERT(qsv != NULL, "Can not allocate memory for RCU\n");
+	status = rte_rcu_qsbr_init(qsv, 1);
+	RTE_TEST_ASSERT(status == 0, "Can not initialize RCU\n");
+
+	rcu_cfg.v = qsv;
+	rcu_cfg.mode = RTE_FIB6_QSBR_MODE_DQ;
+	status = rte_fib6_rcu_qsbr_add(fib, &rcu_cfg);
+	RTE_TEST_ASSERT(status == 0, "Can not attach RCU to FIB\n");
+
+	/* The reader is online but does not report a quiescent state */
+	rte_rcu_qsbr_thread_register(qsv, 0);
+	rte_rcu_qsbr_thread_online(qsv, 0);
+
+	status = rte_fib6_add(fib, &ip, 64, 1);
+	RTE_TEST_ASSERT(status == 0, "Failed to add route\n");
+	status = rte_fib6_add(fib, &ip, 64, 2);
+	RTE_TEST_ASSERT(status == 0, "Failed to change route\n");
+	status = rte_fib6_add(fib, &ip, 64, 3);
+	RTE_TEST_ASSERT(status == -ENOSPC,
+		"Nodes reused while a reader may still use them\n");
+	status = rte_fib6_lookup_bulk(fib, &ip, &nh, 1);
+	RTE_TEST_ASSERT((status == 0) && (nh == 2),
+		"Failed update changed the route\n");
+
+	rte_rcu_qsbr_quiescent(qsv, 0);
+	status = rte_fib6_add(fib, &ip, 64, 3);
+	RTE_TEST_ASSERT(status == 0,
+		"Nodes not reclaimed after a quiescent state\n");
+	status = rte_fib6_lookup_bulk(fib, &ip, &nh, 1);
+	RTE_TEST_ASSERT((status == 0) && (nh == 3),
+		"Lookup does not return the new next hop\n");
+
+	rte_rcu_qsbr_thread_offline(qsv, 0);
+	rte_rcu_qsbr_thread_unregister(qsv, 0);
+	rte_fib6_free(fib);
+	rte_free(qsv);
+
+	return TEST_SUCCESS;
+}
+
+/* Resolve ip with every hash selecting a different bucket */
+static int
+lookup_nh_group(struct rte_fib6 *fib, const struct rte_ipv6_addr *ip,
+	uint64_t *nhs)
+{
+	struct rte_ipv6_addr ips[NH_GROUP_BUCKETS];
+	uint32_t hashes[NH_GROUP_BUCKETS];
+	unsigned int i;
+
+	for (i = 0; i < NH_GROUP_BUCKETS; i++) {
+		ips[i] = *ip;
+		/* upper bits must not matter */
+		hashes[i] = i | (rte_rand() << 16);
+	}
+
+	return rte_fib6_lookup_bulk_hash(fib, ips, hashes, nhs,
+		NH_GROUP_BUCKETS);
+}
+
+static unsigned int
+count_nh(const uint64_t *nhs, uint64_t nh)
+{
+	unsigned int i, cnt = 0;
+
+	for (i = 0; i < NH_GROUP_BUCKETS; i++)
+		cnt += (nhs[i] == nh);
+	return cnt;
+}
+
+static int
+check_nh_group(struct rte_fib6_conf *config)
+{
+	struct rte_fib6 *fib = NULL;
+	struct rte_fib6_nh_group_conf grp_conf = { 0 };
+	struct rte_ipv6_addr ip = RTE_IPV6(0x2001, 0xdb8, 0, 0, 0, 0, 0, 0);
+	uint64_t members[] = { 1, 2, 3, 4 };
+	uint64_t dup_members[] = { 1, 2, 1 };
+	uint32_t weights[] = { 3, 1 };
+	uint64_t old_nhs[NH_GROUP_BUCKETS];
+	uint64_t nhs[NH_GROUP_BUCKETS];
+	uint64_t ref, nh;
+	unsigned int i;
+	int ret;
+
+	fib = rte_fib6_create(__func__, SOCKET_ID_ANY, config);
+	RTE_TEST_ASSERT(fib != NULL, "Failed to create FIB\n");
+
+	ret = rte_fib6_nh_group_init(fib, NULL);
+	RTE_TEST_ASSERT(ret == -EINVAL,
+		"Call succeeded with invalid parameters\n");
+	grp_conf.num_groups = NH_GROUPS;
+	grp_conf.num_buckets = NH_GROUP_BUCKETS + 1;
+	ret = rte_fib6_nh_group_init(fib, &grp_conf);
+	RTE_TEST_ASSERT(ret == -EINVAL,
+		"Call succeeded with invalid parameters\n");
+	grp_conf.num_buckets = NH_GROUP_BUCKETS;
+	ret = rte_fib6_nh_group_init(fib, &grp_conf);
+	RTE_TEST_ASSERT(ret == 0, "Failed to enable next hop groups\n");
+	ret = rte_fib6_nh_group_init(fib, &grp_conf);
+	RTE_TEST_ASSERT(ret == -EEXIST, "Next hop groups enabled twice\n");
+
+	ret = rte_fib6_nh_group_get_nh(fib, NH_GROUPS, &ref);
+	RTE_TEST_ASSERT(ret == -EINVAL,
+		"Call succeeded with invalid parameters\n");
+	ret = rte_fib6_nh_group_get_nh(fib, NH_GROUPS - 1, &ref);
+	RTE_TEST_ASSERT(ret == 0, "Failed to get group next hop\n");
+	ret = rte_fib6_add(fib, &ip, 32, ref + 1);
+	RTE_TEST_ASSERT(ret == -EINVAL,
+		"Added route to a missing group\n");
+
+	ret = rte_fib6_nh_group_get_nh(fib, 0, &ref);
+	RTE_TEST_ASSERT(ret == 0, "Failed to get group next hop\n");
+	ret = rte_fib6_nh_group_set(fib, 0, dup_members, NULL,
+		RTE_DIM(dup_members));
+	RTE_TEST_ASSERT(ret == -EINVAL,
+		"Call succeeded with duplicate members\n");
+	ret = rte_fib6_nh_group_set(fib, 0, &ref, NULL, 1);
+	RTE_TEST_ASSERT(ret == -EINVAL,
+		"Call succeeded with a group as member\n");
+
+	ret = rte_fib6_add(fib, &ip, 32, ref);
+	RTE_TEST_ASSERT(ret == 0, "Failed to add route to a group\n");
+	ret = lookup_nh_group(fib, &ip, nhs);
+	RTE_TEST_ASSERT((ret == 0) &&
+		(count_nh(nhs, config->default_nh) == NH_GROUP_BUCKETS),
+		"Empty group does not resolve to the default next hop\n");
+
+	ret = rte_fib6_nh_group_set(fib, 0, members, NULL, RTE_DIM(members));
+	RTE_TEST_ASSERT(ret == 0, "Failed to set group members\n");
+
+	ret = rte_fib6_lookup_bulk(fib, &ip, &nh, 1);
+	RTE_TEST_ASSERT((ret == 0) && (nh == ref),
+		"Lookup does not return the group\n");
+	ret = lookup_nh_group(fib, &ip, nhs);
+	RTE_TEST_ASSERT(ret == 0, "Failed to lookup\n");
+	for (i = 0; i < RTE_DIM(members); i++)
+		RTE_TEST_ASSERT(count_nh(nhs, members[i]) ==
+			NH_GROUP_BUCKETS / RTE_DIM(members),
+			"Members do not share the buckets equally\n");
+	memcpy(old_nhs, nhs, sizeof(nhs));
+
+	/* removing a member only moves its own buckets */
+	members[2] = members[3];
+	ret = rte_fib6_nh_group_set(fib, 0, members, NULL, 3);
+	RTE_TEST_ASSERT(ret == 0, "Failed to set group members\n");
+	ret = lookup_nh_group(fib, &ip, nhs);
+	RTE_TEST_ASSERT(ret == 0, "Failed to lookup\n");
+	for (i = 0; i < NH_GROUP_BUCKETS; i++)
+		RTE_TEST_ASSERT((old_nhs[i] == 3) || (nhs[i] == old_nhs[i]),
+			"Bucket of a kept member moved\n");
+
+	ret = rte_fib6_nh_group_set(fib, 0, members, weights, 2);
+	RTE_TEST_ASSERT(ret == 0, "Failed to set group members\n");
+	ret = lookup_nh_group(fib, &ip, nhs);
+	RTE_TEST_ASSERT((ret == 0) &&
+		(count_nh(nhs, members[0]) == NH_GROUP_BUCKETS * 3 / 4) &&
+		(count_nh(nhs, members[1]) == NH_GROUP_BUCKETS / 4),
+		"Members do not share the buckets by weight\n");
+
+	rte_fib6_free(fib);
+
+	return TEST_SUCCESS;
+}
+
+/*
+ * Check next hop groups: invalid parameters, resolution of the group
+ * members by hash, weights and resilient changes of the members
+ */
+int32_t
+test_nh_group(void)
+{
+	struct rte_fib6_conf config = { 0 };
+	int ret;
+
+	config.max_routes = MAX_ROUTES;
+	config.rib_ext_sz = 0;
+	config.default_nh = 10;
+
+	config.type = RTE_FIB6_DUMMY;
+	ret = check_nh_group(&config);
+	RTE_TEST_ASSERT(ret == TEST_SUCCESS,
+		"Next hop groups fail for DUMMY FIB\n");
+
+	config.type = RTE_FIB6_TRIE;
+	config.trie.nh_sz = RTE_FIB6_TRIE_2B;
+	config.trie.num_tbl8 = MAX_TBL8 - 1;
+	ret = check_nh_group(&config);
+	RTE_TEST_ASSERT(ret == TEST_SUCCESS,
+		"Next hop groups fail for TRIE FIB\n");
+
+	config.type = RTE_FIB6_POPTRIE;
+	config.poptrie.nh_sz = RTE_FIB6_TRIE_2B;
+	config.poptrie.num_nodes = MAX_ROUTES;
+	ret = check_nh_group(&config);
+	RTE_TEST_ASSERT(ret == TEST_SUCCESS,
+		"Next hop groups fail for POPTRIE FIB\n");
+
 	return TEST_SUCCESS;
 }
 
@@ -397,6 +1211,12 @@ static struct unit_test_suite fib6_fast_tests = {
 	TEST_CASE(test_add_del_invalid),
 	TEST_CASE(test_get_invalid),
 	TEST_CASE(test_lookup),
+	TEST_CASE(test_add_bulk),
+	TEST_CASE(test_vector_lookup),
+	TEST_CASE(test_poptrie),
+	TEST_CASE(test_invalid_rcu),
+	TEST_CASE(test_poptrie_rcu_dq),
+	TEST_CASE(test_nh_group),
 	TEST_CASES_END()
 	}
 };
@@ -64,10 +64,9 @@ get_max_nh(uint8_t nh_sz)
 }
 
 static int
-test_fib6_perf(void)
+fib6_perf(struct rte_fib6_conf *conf)
 {
 	struct rte_fib6 *fib = NULL;
-	struct rte_fib6_conf conf;
 	uint64_t begin, total_time;
 	unsigned int i, j;
 	uint64_t next_hop_add;
@@ -75,25 +74,11 @@ test_fib6_perf(void)
 	int64_t count = 0;
 	struct rte_ipv6_addr ip_batch[NUM_IPS_ENTRIES];
 	uint64_t next_hops[NUM_IPS_ENTRIES];
+	struct rte_ipv6_addr ips[NUM_ROUTE_ENTRIES];
+	uint8_t depths[NUM_ROUTE_ENTRIES];
+	uint64_t nhs[NUM_ROUTE_ENTRIES];
 
-	conf.type = RTE_FIB6_TRIE;
-	conf.default_nh = 0;
-	conf.max_routes = 1000000;
-	conf.rib_ext_sz = 0;
-	conf.trie.nh_sz = RTE_FIB6_TRIE_4B;
-	conf.trie.num_tbl8 = RTE_MIN(get_max_nh(conf.trie.nh_sz), 1000000U);
-
-	printf("No. routes = %u\n", (unsigned int) NUM_ROUTE_ENTRIES);
-
-	print_route_distribution(large_route_table,
-		(uint32_t)NUM_ROUTE_ENTRIES);
-
-	/* Only generate IPv6 address of each item in large IPS table,
-	 * here next_hop is not needed.
-	 */
-	generate_large_ips_table(0);
-
-	fib = rte_fib6_create(__func__, SOCKET_ID_ANY, &conf);
+	fib = rte_fib6_create(__func__, SOCKET_ID_ANY, conf);
 	TEST_FIB_ASSERT(fib != NULL);
 
 	/* Measure add. */
@@ -149,9 +134,59 @@ test_fib6_perf(void)
 	printf("Average FIB Delete: %g cycles\n",
 			(double)total_time / NUM_ROUTE_ENTRIES);
 
+	/* Measure bulk add of the same routes into the empty FIB. */
+	for (i = 0; i < NUM_ROUTE_ENTRIES; i++) {
+		ips[i] = large_route_table[i].ip;
+		depths[i] = large_route_table[i].depth;
+		nhs[i] = (i & ((1 << 14) - 1)) + 1;
+	}
+
+	begin = rte_rdtsc();
+	status = rte_fib6_add_bulk(fib, ips, depths, nhs, NUM_ROUTE_ENTRIES);
+	total_time = rte_rdtsc() - begin;
+	TEST_FIB_ASSERT(status == (int)NUM_ROUTE_ENTRIES);
+
+	printf("Average FIB Bulk Add: %g cycles\n",
+			(double)total_time / NUM_ROUTE_ENTRIES);
+
 	rte_fib6_free(fib);
 
 	return 0;
 }
 
+static int
+test_fib6_perf(void)
+{
+	struct rte_fib6_conf conf;
+
+	conf.type = RTE_FIB6_TRIE;
+	conf.default_nh = 0;
+	conf.max_routes = 1000000;
+	conf.rib_ext_sz = 0;
+	conf.trie.nh_sz = RTE_FIB6_TRIE_4B;
+	conf.trie.num_tbl8 = RTE_MIN(get_max_nh(conf.trie.nh_sz), 1000000U);
+
+	printf("No. routes = %u\n", (unsigned int) NUM_ROUTE_ENTRIES);
+
+	print_route_distribution(large_route_table,
+		(uint32_t)NUM_ROUTE_ENTRIES);
+
+	/* Only generate IPv6 address of each item in large IPS table,
+	 * here next_hop is not needed.
+	 */
+	generate_large_ips_table(0);
+
+	printf("TRIE based FIB\n");
+	TEST_FIB_ASSERT(fib6_perf(&conf) == 0);
+
+	conf.type = RTE_FIB6_POPTRIE;
+	conf.poptrie.nh_sz = RTE_FIB6_TRIE_4B;
+	conf.poptrie.num_nodes = 1000000;
+
+	printf("POPTRIE based FIB\n");
+	TEST_FIB_ASSERT(fib6_perf(&conf) == 0);
+
+	return 0;
+}
+
 REGISTER_PERF_TEST(fib6_perf_autotest, test_fib6_perf);
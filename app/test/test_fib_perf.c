@@ -13,6 +13,7 @@
 #include <rte_branch_prediction.h>
 #include <rte_ip.h>
 #include <rte_fib.h>
+#include <rte_malloc.h>
 
 #include "test.h"
 #include "test_xmmt_ops.h"
@@ -333,6 +334,9 @@ test_fib_perf(void)
 	uint32_t next_hop_add = 0xAA;
 	int status = 0;
 	int64_t count = 0;
+	uint32_t *ips;
+	uint8_t *depths;
+	uint64_t *nhs;
 
 	generate_large_route_rule_table();
 
@@ -402,6 +406,31 @@ test_fib_perf(void)
 	printf("Average FIB Delete: %g cycles\n",
 			(double)total_time / NUM_ROUTE_ENTRIES);
 
+	/* Measure bulk add of the same routes into the empty FIB. */
+	ips = rte_malloc(NULL, sizeof(*ips) * NUM_ROUTE_ENTRIES, 0);
+	depths = rte_malloc(NULL, sizeof(*depths) * NUM_ROUTE_ENTRIES, 0);
+	nhs = rte_malloc(NULL, sizeof(*nhs) * NUM_ROUTE_ENTRIES, 0);
+	TEST_FIB_ASSERT((ips != NULL) && (depths != NULL) && (nhs != NULL));
+	for (i = 0; i < NUM_ROUTE_ENTRIES; i++) {
+		ips[i] = large_route_table[i].ip;
+		depths[i] = large_route_table[i].depth;
+		nhs[i] = next_hop_add;
+	}
+
+	begin = rte_rdtsc();
+	status = rte_fib_add_bulk(fib, ips, depths, nhs, NUM_ROUTE_ENTRIES);
+	total_time = rte_rdtsc() - begin;
+	TEST_FIB_ASSERT(status > 0);
+
+	/* Bulk add stops at the first route that does not fit. */
+	printf("Bulk added entries = %d\n", status);
+
+	printf("Average FIB Bulk Add: %g cycles\n",
+			(double)total_time / status);
+
+	rte_free(ips);
+	rte_free(depths);
+	rte_free(nhs);
 	rte_fib_free(fib);
 
 	return 0;
@@ -2319,6 +2319,739 @@ test_hash_rcu_qsbr_dq_reclaim(void)
 	return 0;
 }
 
+#define RESIZE_ENTRIES (1 << 14)
+#define RESIZE_KEYS (RESIZE_ENTRIES * 9 / 10)
+#define RESIZE_SKEWED_KEYS (RESIZE_ENTRIES / 16)
+/* Old buckets an insertion moves at most: the two of its key and its
+ * budget, spent along a cuckoo path or in order
+ */
+#define RESIZE_MAX_MOVED 4
+
+static uint32_t g_resize_keys[RESIZE_KEYS];
+static volatile uint32_t g_resize_misses;
+
+/*
+ * Check that all the keys added to a resizable table are found at the
+ * position they were added to, alone, in bulk and by iterating.
+ */
+static int
+test_hash_resizable_check(struct rte_hash *handle, const int32_t *expected_pos,
+			  uint32_t num_keys)
+{
+	const void *keys[RTE_HASH_LOOKUP_BULK_MAX];
+	int32_t positions[RTE_HASH_LOOKUP_BULK_MAX];
+	uint8_t seen[RESIZE_KEYS] = {0};
+	const void *next_key;
+	void *next_data;
+	uint32_t iter = 0;
+	uint32_t i, j, n;
+	int32_t pos;
+
+	for (i = 0; i < num_keys; i++) {
+		pos = rte_hash_lookup(handle, &g_resize_keys[i]);
+		if (pos != expected_pos[i]) {
+			printf("key %u found at %d instead of %d\n", i, pos,
+			       expected_pos[i]);
+			return -1;
+		}
+	}
+
+	for (i = 0; i < num_keys; i += n) {
+		n = RTE_MIN(num_keys - i, (uint32_t)RTE_HASH_LOOKUP_BULK_MAX);
+		for (j = 0; j < n; j++)
+			keys[j] = &g_resize_keys[i + j];
+		if (rte_hash_lookup_bulk(handle, keys, n, positions) != 0)
+			return -1;
+		for (j = 0; j < n; j++) {
+			if (positions[j] != expected_pos[i + j]) {
+				printf("bulk lookup of key %u returned %d\n",
+				       i + j, positions[j]);
+				return -1;
+			}
+		}
+	}
+
+	n = 0;
+	while ((pos = rte_hash_iterate(handle, &next_key, &next_data,
+				       &iter)) >= 0) {
+		i = *(const uint32_t *)next_key - 1;
+		if (i >= num_keys || seen[i] || pos != expected_pos[i] ||
+				(uintptr_t)next_data != i) {
+			printf("unexpected key %u iterated at %d\n", i, pos);
+			return -1;
+		}
+		seen[i] = 1;
+		n++;
+	}
+	if (n != num_keys || rte_hash_count(handle) != (int32_t)num_keys) {
+		printf("iterated %u keys, count %d, expected %u\n", n,
+		       rte_hash_count(handle), num_keys);
+		return -1;
+	}
+
+	return 0;
+}
+
+/*
+ * Resizable hash table functional test.
+ *  - Check the flags it cannot be combined with
+ *  - Add keys until the table starts growing, check them while it grows,
+ *    with keys deleted and added back
+ *  - Fill the table up to its maximum size and check all keys
+ */
+static int
+test_hash_resizable(uint8_t rw_flag)
+{
+	struct rte_hash *handle = NULL;
+	struct rte_hash_parameters params = {
+		.name = "test_hash_resizable",
+		.entries = RESIZE_ENTRIES,
+		.key_len = sizeof(uint32_t),
+		.socket_id = 0,
+	};
+	static int32_t expected_pos[RESIZE_KEYS];
+	uint32_t i;
+	int32_t ret;
+
+	if (rw_flag)
+		printf("\n# Running resizable hash table functional test with"
+		       " rw concurrency%s\n",
+		       rw_flag == RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY_LF ?
+		       " lock free" : "");
+	else
+		printf("\n# Running resizable hash table functional test\n");
+
+	params.extra_flag = RTE_HASH_EXTRA_FLAGS_RESIZABLE |
+				RTE_HASH_EXTRA_FLAGS_EXT_TABLE;
+	handle = rte_hash_create(&params);
+	RETURN_IF_ERROR(handle != NULL,
+			"resizable table with ext table should fail");
+	params.extra_flag = RTE_HASH_EXTRA_FLAGS_RESIZABLE |
+				RTE_HASH_EXTRA_FLAGS_MULTI_WRITER_ADD;
+	handle = rte_hash_create(&params);
+	RETURN_IF_ERROR(handle != NULL,
+			"resizable table with multi writer should fail");
+
+	params.extra_flag = rw_flag;
+	handle = rte_hash_create(&params);
+	RETURN_IF_ERROR(handle == NULL, "hash creation failed");
+	RETURN_IF_ERROR(rte_hash_resize_step(handle, 1) != -EINVAL,
+			"fixed size table should not be resized");
+	rte_hash_free(handle);
+
+	params.extra_flag = RTE_HASH_EXTRA_FLAGS_RESIZABLE | rw_flag;
+	handle = rte_hash_create(&params);
+	RETURN_IF_ERROR(handle == NULL, "hash creation failed");
+	RETURN_IF_ERROR(rte_hash_max_key_id(handle) != RESIZE_ENTRIES,
+			"max key id should be the maximum size");
+	RETURN_IF_ERROR(rte_hash_resize_step(handle, 1) != 0,
+			"table should not be growing");
+
+	for (i = 0; i < RESIZE_KEYS; i++)
+		g_resize_keys[i] = i + 1;
+
+	/* Add keys until the table grows */
+	for (i = 0; i < RESIZE_KEYS; i++) {
+		expected_pos[i] = rte_hash_add_key_data(handle,
+				&g_resize_keys[i], (void *)(uintptr_t)i);
+		RETURN_IF_ERROR(expected_pos[i] != 0,
+				"failed to add key %u (%d)", i, expected_pos[i]);
+		expected_pos[i] = rte_hash_lookup(handle, &g_resize_keys[i]);
+		RETURN_IF_ERROR(expected_pos[i] < 0, "failed to find key %u", i);
+		if (rte_hash_resize_step(handle, 0) > 0)
+			break;
+	}
+	RETURN_IF_ERROR(i == RESIZE_KEYS, "table did not grow");
+	i++;
+
+	RETURN_IF_ERROR(test_hash_resizable_check(handle, expected_pos, i) < 0,
+			"check while growing failed");
+
+	/* Deleting does not move buckets, keys can be added back */
+	ret = rte_hash_del_key(handle, &g_resize_keys[0]);
+	RETURN_IF_ERROR(ret != expected_pos[0], "failed to delete key 0");
+	RETURN_IF_ERROR(rte_hash_lookup(handle, &g_resize_keys[0]) != -ENOENT,
+			"deleted key found");
+	if (rw_flag == RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY_LF)
+		rte_hash_free_key_with_position(handle, ret);
+	RETURN_IF_ERROR(rte_hash_resize_step(handle, 0) <= 0,
+			"table should still be growing");
+	expected_pos[0] = rte_hash_add_key_data(handle, &g_resize_keys[0],
+						(void *)(uintptr_t)0);
+	RETURN_IF_ERROR(expected_pos[0] != 0, "failed to add key 0 back");
+	expected_pos[0] = rte_hash_lookup(handle, &g_resize_keys[0]);
+
+	RETURN_IF_ERROR(rte_hash_resize_step(handle, UINT32_MAX) != 0,
+			"growth should be done");
+	RETURN_IF_ERROR(test_hash_resizable_check(handle, expected_pos, i) < 0,
+			"check after growing failed");
+
+	/* Grow up to the maximum size */
+	for (; i < RESIZE_KEYS; i++) {
+		expected_pos[i] = rte_hash_add_key(handle, &g_resize_keys[i]);
+		RETURN_IF_ERROR(expected_pos[i] < 0,
+				"failed to add key %u (%d)", i, expected_pos[i]);
+		rte_hash_add_key_data(handle, &g_resize_keys[i],
+				      (void *)(uintptr_t)i);
+		if (i % 1000 == 0)
+			rte_hash_resize_step(handle, 16);
+	}
+	rte_hash_resize_step(handle, UINT32_MAX);
+	RETURN_IF_ERROR(test_hash_resizable_check(handle, expected_pos,
+						  RESIZE_KEYS) < 0,
+			"check at maximum size failed");
+
+	rte_hash_reset(handle);
+	RETURN_IF_ERROR(rte_hash_count(handle) != 0, "reset table not empty");
+
+	rte_hash_free(handle);
+	return 0;
+}
+
+/* Hash sending all the keys to an eighth of the buckets, both primary and
+ * secondary ones.
+ */
+static uint32_t
+test_hash_resizable_skewed_hash(const void *key, uint32_t key_len,
+				uint32_t init_val)
+{
+	return rte_jhash(key, key_len, init_val) & ~UINT32_C(0x70007);
+}
+
+/*
+ * Resizable hash table test with skewed primary buckets.
+ *  - Add keys while the table grows several times, their buckets fill up
+ *    so that entries are pushed around while old buckets are left
+ *  - Check that no insertion moves more than a few old buckets, counted
+ *    by the old buckets left to move before and after it
+ *  - Check all keys
+ */
+static int
+test_hash_resizable_skewed(void)
+{
+	struct rte_hash *handle = NULL;
+	struct rte_hash_parameters params = {
+		.name = "test_hash_resizable_skewed",
+		.entries = RESIZE_ENTRIES,
+		.key_len = sizeof(uint32_t),
+		.hash_func = test_hash_resizable_skewed_hash,
+		.socket_id = 0,
+		.extra_flag = RTE_HASH_EXTRA_FLAGS_RESIZABLE,
+	};
+	static int32_t expected_pos[RESIZE_SKEWED_KEYS];
+	int32_t remaining, ret;
+	uint32_t i;
+
+	printf("\n# Running resizable hash table test with skewed hash\n");
+
+	handle = rte_hash_create(&params);
+	RETURN_IF_ERROR(handle == NULL, "hash creation failed");
+
+	for (i = 0; i < RESIZE_SKEWED_KEYS; i++)
+		g_resize_keys[i] = i + 1;
+
+	for (i = 0; i < RESIZE_SKEWED_KEYS; i++) {
+		remaining = rte_hash_resize_step(handle, 0);
+		expected_pos[i] = rte_hash_add_key(handle, &g_resize_keys[i]);
+		RETURN_IF_ERROR(expected_pos[i] < 0,
+				"failed to add key %u (%d)", i, expected_pos[i]);
+		ret = rte_hash_resize_step(handle, 0);
+		RETURN_IF_ERROR(remaining - ret > RESIZE_MAX_MOVED,
+				"adding key %u moved %d old buckets", i,
+				remaining - ret);
+		remaining = ret;
+		rte_hash_add_key_data(handle, &g_resize_keys[i],
+				      (void *)(uintptr_t)i);
+		ret = rte_hash_resize_step(handle, 0);
+		RETURN_IF_ERROR(remaining - ret > RESIZE_MAX_MOVED,
+				"updating key %u moved %d old buckets", i,
+				remaining - ret);
+	}
+
+	RETURN_IF_ERROR(test_hash_resizable_check(handle, expected_pos,
+						  RESIZE_SKEWED_KEYS) < 0,
+			"check with skewed hash failed");
+
+	rte_hash_free(handle);
+	return 0;
+}
+
+/*
+ * Resizable hash table test with RCU in defer queue mode.
+ *  - The writer is a registered reader too, growing must not wait for it
+ *  - Memory replaced by growing stays in the defer queue until the reader
+ *    reports a quiescent state, then it is reclaimed
+ */
+static int
+test_hash_resizable_rcu_dq(void)
+{
+	struct rte_hash_rcu_config rcu_cfg = {0};
+	struct rte_hash_parameters params = {
+		.name = "test_hash_resizable_rcu_dq",
+		.entries = RESIZE_ENTRIES,
+		.key_len = sizeof(uint32_t),
+		.socket_id = 0,
+		.extra_flag = RTE_HASH_EXTRA_FLAGS_RESIZABLE |
+				RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY_LF,
+	};
+	unsigned int freed, pending, available;
+	int32_t status;
+	uint32_t i;
+
+	printf("\n# Running resizable hash table test with RCU DQ mode\n");
+
+	g_qsv = NULL;
+	g_handle = rte_hash_create(&params);
+	RETURN_IF_ERROR_RCU_QSBR(g_handle == NULL, "hash creation failed");
+
+	g_qsv = rte_zmalloc(NULL, rte_rcu_qsbr_get_memsize(RTE_MAX_LCORE),
+			    RTE_CACHE_LINE_SIZE);
+	RETURN_IF_ERROR_RCU_QSBR(g_qsv == NULL,
+				 "RCU QSBR variable creation failed");
+	status = rte_rcu_qsbr_init(g_qsv, RTE_MAX_LCORE);
+	RETURN_IF_ERROR_RCU_QSBR(status != 0,
+				 "RCU QSBR variable initialization failed");
+
+	rcu_cfg.v = g_qsv;
+	rcu_cfg.mode = RTE_HASH_QSBR_MODE_DQ;
+	status = rte_hash_rcu_qsbr_add(g_handle, &rcu_cfg);
+	RETURN_IF_ERROR_RCU_QSBR(status != 0,
+				 "Attach RCU QSBR to hash table failed");
+
+	status = rte_rcu_qsbr_thread_register(g_qsv, 0);
+	RETURN_IF_ERROR_RCU_QSBR(status != 0,
+				 "RCU QSBR thread registration failed");
+	rte_rcu_qsbr_thread_online(g_qsv, 0);
+
+	for (i = 0; i < RESIZE_KEYS / 2; i++)
+		g_resize_keys[i] = i + 1;
+	for (i = 0; i < RESIZE_KEYS / 2; i++) {
+		status = rte_hash_add_key(g_handle, &g_resize_keys[i]);
+		RETURN_IF_ERROR_RCU_QSBR(status < 0, "failed to add key %u (%d)",
+					 i, status);
+	}
+	status = rte_hash_resize_step(g_handle, UINT32_MAX);
+	RETURN_IF_ERROR_RCU_QSBR(status != 0, "growth should be done");
+
+	status = rte_hash_rcu_qsbr_dq_reclaim(g_handle, &freed, &pending,
+					      &available);
+	RETURN_IF_ERROR_RCU_QSBR(pending == 0,
+				 "memory freed while the reader is online");
+
+	rte_rcu_qsbr_quiescent(g_qsv, 0);
+	status = rte_hash_rcu_qsbr_dq_reclaim(g_handle, &freed, &pending,
+					      &available);
+	RETURN_IF_ERROR_RCU_QSBR(status != 0 || freed == 0 || pending != 0,
+				 "memory not reclaimed after quiescent state");
+
+	for (i = 0; i < RESIZE_KEYS / 2; i++) {
+		status = rte_hash_lookup(g_handle, &g_resize_keys[i]);
+		RETURN_IF_ERROR_RCU_QSBR(status < 0, "failed to find key %u",
+					 i);
+	}
+
+	rte_rcu_qsbr_thread_offline(g_qsv, 0);
+	rte_rcu_qsbr_thread_unregister(g_qsv, 0);
+	rte_hash_free(g_handle);
+	rte_free(g_qsv);
+	g_handle = NULL;
+	g_qsv = NULL;
+	return 0;
+}
+
+static int
+test_hash_resizable_reader(void *arg)
+{
+	uint32_t i, misses = 0;
+
+	RTE_SET_USED(arg);
+	do {
+		for (i = 0; i < RESIZE_KEYS / 4; i++) {
+			if (rte_hash_lookup(g_handle, &g_resize_keys[i]) < 0)
+				misses++;
+		}
+	} while (!writer_done);
+
+	g_resize_misses = misses;
+	return 0;
+}
+
+/*
+ * Resizable hash table lock free reader test.
+ * 1 Reader and 1 writer. They cannot be in the same thread in this test.
+ *  - Add a quarter of the keys, reader keeps looking them up
+ *  - Writer adds the other keys, the table grows several times
+ *  - Reader must never miss a key
+ */
+static int
+test_hash_resizable_lf(void)
+{
+	struct rte_hash *handle = NULL;
+	struct rte_hash_parameters params = {
+		.name = "test_hash_resizable_lf",
+		.entries = RESIZE_ENTRIES,
+		.key_len = sizeof(uint32_t),
+		.socket_id = 0,
+		.extra_flag = RTE_HASH_EXTRA_FLAGS_RESIZABLE |
+				RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY_LF,
+	};
+	uint32_t i;
+	int32_t ret;
+
+	if (rte_lcore_count() < 2) {
+		printf("Not enough cores for resizable lock free test, skipping\n");
+		return 0;
+	}
+
+	printf("\n# Running resizable hash table lock free reader test\n");
+
+	handle = rte_hash_create(&params);
+	RETURN_IF_ERROR(handle == NULL, "hash creation failed");
+	g_handle = handle;
+
+	for (i = 0; i < RESIZE_KEYS; i++)
+		g_resize_keys[i] = i + 1;
+	for (i = 0; i < RESIZE_KEYS / 4; i++) {
+		ret = rte_hash_add_key(handle, &g_resize_keys[i]);
+		RETURN_IF_ERROR(ret < 0, "failed to add key %u (%d)", i, ret);
+	}
+
+	writer_done = 0;
+	g_resize_misses = 0;
+	rte_eal_remote_launch(test_hash_resizable_reader, NULL,
+				rte_get_next_lcore(-1, 1, 0));
+
+	for (; i < RESIZE_KEYS; i++) {
+		ret = rte_hash_add_key(handle, &g_resize_keys[i]);
+		if (ret < 0)
+			break;
+		if (i % 64 == 0)
+			rte_hash_resize_step(handle, 4);
+	}
+
+	writer_done = 1;
+	rte_eal_mp_wait_lcore();
+
+	RETURN_IF_ERROR(ret < 0, "failed to add key %u (%d)", i, ret);
+	RETURN_IF_ERROR(g_resize_misses != 0, "reader missed %u keys",
+			g_resize_misses);
+
+	rte_hash_free(handle);
+	g_handle = NULL;
+	return 0;
+}
+
+#define BULK_ENTRIES 4096
+#define BULK_KEYS (BULK_ENTRIES * 2)
+
+/*
+ * Bulk add and delete test.
+ *  - Add a batch holding the same key twice, the last data wins
+ *  - Add twice as many keys as the table holds, check every key added is
+ *    found at its position and the others failed for lack of space
+ *  - Add them again, which only updates them
+ *  - Delete them all, then again to check they are gone
+ */
+static int
+test_hash_bulk_add_del(uint32_t extra_flag)
+{
+	struct rte_hash *handle = NULL;
+	struct rte_hash_parameters params = {
+		.name = "test_hash_bulk_add_del",
+		.entries = BULK_ENTRIES,
+		.key_len = sizeof(uint32_t),
+		.socket_id = 0,
+		.extra_flag = extra_flag,
+	};
+	static uint32_t bulk_keys[BULK_KEYS];
+	static int32_t expected_pos[BULK_KEYS];
+	const void *keys[RTE_HASH_LOOKUP_BULK_MAX];
+	void *data[RTE_HASH_LOOKUP_BULK_MAX];
+	int32_t positions[RTE_HASH_LOOKUP_BULK_MAX];
+	uint32_t i, j, n, added = 0;
+	void *found;
+	int ret;
+
+	printf("\n# Running bulk add and delete test with flags 0x%x\n",
+	       extra_flag);
+
+	handle = rte_hash_create(&params);
+	RETURN_IF_ERROR(handle == NULL, "hash creation failed");
+
+	for (i = 0; i < BULK_KEYS; i++)
+		bulk_keys[i] = i + 1;
+	for (j = 0; j < RTE_HASH_LOOKUP_BULK_MAX; j++) {
+		keys[j] = &bulk_keys[j];
+		data[j] = (void *)(uintptr_t)j;
+	}
+
+	/* Last key of the batch is the first one again */
+	keys[RTE_HASH_LOOKUP_BULK_MAX - 1] = &bulk_keys[0];
+	ret = rte_hash_add_key_bulk_data(handle, keys, data,
+			RTE_HASH_LOOKUP_BULK_MAX, positions);
+	RETURN_IF_ERROR(ret != RTE_HASH_LOOKUP_BULK_MAX,
+			"failed to add batch (%d)", ret);
+	RETURN_IF_ERROR(positions[RTE_HASH_LOOKUP_BULK_MAX - 1] != positions[0],
+			"duplicated key added twice");
+	RETURN_IF_ERROR(rte_hash_lookup_data(handle, &bulk_keys[0], &found) !=
+			positions[0] ||
+			(uintptr_t)found != RTE_HASH_LOOKUP_BULK_MAX - 1,
+			"duplicated key should have the last data");
+	RETURN_IF_ERROR(rte_hash_count(handle) != RTE_HASH_LOOKUP_BULK_MAX - 1,
+			"wrong number of keys after first batch");
+	rte_hash_reset(handle);
+
+	for (i = 0; i < BULK_KEYS; i += n) {
+		n = RTE_MIN(BULK_KEYS - i, (uint32_t)RTE_HASH_LOOKUP_BULK_MAX);
+		for (j = 0; j < n; j++) {
+			keys[j] = &bulk_keys[i + j];
+			data[j] = (void *)(uintptr_t)(i + j);
+		}
+		ret = rte_hash_add_key_bulk_data(handle, keys, data, n,
+						 &expected_pos[i]);
+		RETURN_IF_ERROR(ret < 0, "failed to add batch at %u", i);
+		added += ret;
+	}
+	RETURN_IF_ERROR(added < BULK_ENTRIES * 9 / 10,
+			"only %u keys added", added);
+	RETURN_IF_ERROR(rte_hash_count(handle) != (int32_t)added,
+			"count %d, %u keys added", rte_hash_count(handle), added);
+
+	for (i = 0; i < BULK_KEYS; i++) {
+		if (expected_pos[i] < 0) {
+			RETURN_IF_ERROR(expected_pos[i] != -ENOSPC,
+					"unexpected error %d", expected_pos[i]);
+			RETURN_IF_ERROR(rte_hash_lookup(handle, &bulk_keys[i])
+					!= -ENOENT, "failed key %u found", i);
+			continue;
+		}
+		ret = rte_hash_lookup_data(handle, &bulk_keys[i], &found);
+		RETURN_IF_ERROR(ret != expected_pos[i] ||
+				(uintptr_t)found != i,
+				"key %u found at %d instead of %d", i, ret,
+				expected_pos[i]);
+	}
+
+	for (i = 0; i < BULK_KEYS; i += n) {
+		n = RTE_MIN(BULK_KEYS - i, (uint32_t)RTE_HASH_LOOKUP_BULK_MAX);
+		for (j = 0; j < n; j++)
+			keys[j] = &bulk_keys[i + j];
+		rte_hash_add_key_bulk_data(handle, keys, NULL, n, positions);
+		for (j = 0; j < n; j++) {
+			if (expected_pos[i + j] >= 0)
+				RETURN_IF_ERROR(positions[j] !=
+						expected_pos[i + j],
+						"key %u moved on update", i + j);
+		}
+	}
+	RETURN_IF_ERROR(rte_hash_count(handle) != (int32_t)added,
+			"keys added on update");
+
+	for (i = 0; i < BULK_KEYS; i += n) {
+		n = RTE_MIN(BULK_KEYS - i, (uint32_t)RTE_HASH_LOOKUP_BULK_MAX);
+		for (j = 0; j < n; j++)
+			keys[j] = &bulk_keys[i + j];
+		ret = rte_hash_del_key_bulk(handle, keys, n, positions);
+		RETURN_IF_ERROR(ret < 0, "failed to delete batch at %u", i);
+		for (j = 0; j < n; j++) {
+			RETURN_IF_ERROR(positions[j] != (expected_pos[i + j] < 0 ?
+					-ENOENT : expected_pos[i + j]),
+					"key %u deleted from %d", i + j,
+					positions[j]);
+			if (positions[j] >= 0 &&
+					(extra_flag &
+					 RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY_LF))
+				rte_hash_free_key_with_position(handle,
+								positions[j]);
+		}
+		ret = rte_hash_del_key_bulk(handle, keys, n, positions);
+		RETURN_IF_ERROR(ret != 0, "keys deleted twice at %u", i);
+	}
+	RETURN_IF_ERROR(rte_hash_count(handle) != 0,
+			"keys left after delete");
+
+	rte_hash_free(handle);
+
+	return 0;
+}
+
+#define AGE_ENTRIES 1024
+#define AGE_KEYS (AGE_ENTRIES / 2)
+#define AGE_TIMEOUT 100
+#define AGE_BURST 32
+/* BUCKET_SIZE should be same as RTE_HASH_BUCKET_ENTRIES in rte_hash library */
+#define AGE_BUCKET_SIZE 8
+
+static uint32_t g_age_calls;
+static uint32_t g_age_freed;
+static int32_t g_age_expired[AGE_KEYS];
+static uint32_t g_age_expired_num;
+
+static int
+test_hash_age_cb(void *p, const void *key, void *data, int32_t position,
+		 uint64_t age)
+{
+	RTE_SET_USED(p);
+	RTE_SET_USED(data);
+
+	g_age_calls++;
+	if (age < AGE_TIMEOUT || *(const uint32_t *)key > AGE_KEYS)
+		return 0;
+
+	g_age_expired[g_age_expired_num++] = position;
+	return 1;
+}
+
+static void
+test_hash_age_free(void *p, void *key_data)
+{
+	RTE_SET_USED(p);
+	RTE_SET_USED(key_data);
+
+	g_age_freed++;
+}
+
+/*
+ * Entry aging functional test.
+ *  - Entries never touched are stamped by the first scan visiting them
+ *  - Touched entries survive, the others expire after the timeout
+ *  - A scan visits no more buckets than its budget
+ *  - Expired positions are freed by the application without RCU, or by
+ *    the scans through the defer queue with RCU
+ */
+static int
+test_hash_aging(uint32_t extra_flag, bool with_rcu)
+{
+	struct rte_hash *handle = NULL;
+	struct rte_hash_parameters params = {
+		.name = "test_hash_aging",
+		.entries = AGE_ENTRIES,
+		.key_len = sizeof(uint32_t),
+		.socket_id = 0,
+		.extra_flag = extra_flag | RTE_HASH_EXTRA_FLAGS_AGING,
+	};
+	struct rte_hash_rcu_config rcu_cfg = {0};
+	struct rte_rcu_qsbr *qsv = NULL;
+	static uint32_t age_keys[AGE_KEYS];
+	static int32_t pos[AGE_KEYS];
+	const void *keys[AGE_BURST];
+	void *data[AGE_BURST];
+	uint64_t hit_mask;
+	uint32_t i, j;
+	int32_t ret;
+
+	printf("\n# Running entry aging test with flags 0x%x%s\n", extra_flag,
+	       with_rcu ? " and RCU" : "");
+
+	params.extra_flag = extra_flag;
+	handle = rte_hash_create(&params);
+	RETURN_IF_ERROR(handle == NULL, "hash creation failed");
+	RETURN_IF_ERROR(rte_hash_age_touch(handle, 0, 1) != -EINVAL,
+			"table without aging should not be touched");
+	RETURN_IF_ERROR(rte_hash_age_scan(handle, 1, 1, test_hash_age_cb,
+			NULL) != -EINVAL,
+			"table without aging should not be scanned");
+	rte_hash_free(handle);
+
+	params.extra_flag = extra_flag | RTE_HASH_EXTRA_FLAGS_AGING;
+	handle = rte_hash_create(&params);
+	RETURN_IF_ERROR(handle == NULL, "hash creation failed");
+
+	if (with_rcu) {
+		qsv = rte_zmalloc(NULL, rte_rcu_qsbr_get_memsize(RTE_MAX_LCORE),
+				  RTE_CACHE_LINE_SIZE);
+		RETURN_IF_ERROR(qsv == NULL, "RCU QSBR allocation failed");
+		rte_rcu_qsbr_init(qsv, RTE_MAX_LCORE);
+		rcu_cfg.v = qsv;
+		rcu_cfg.mode = RTE_HASH_QSBR_MODE_DQ;
+		rcu_cfg.free_key_data_func = test_hash_age_free;
+		RETURN_IF_ERROR(rte_hash_rcu_qsbr_add(handle, &rcu_cfg) != 0,
+				"attach RCU QSBR failed");
+		/* Pseudo reader */
+		rte_rcu_qsbr_thread_register(qsv, 0);
+		rte_rcu_qsbr_thread_online(qsv, 0);
+	}
+
+	g_age_calls = 0;
+	g_age_freed = 0;
+	g_age_expired_num = 0;
+	for (i = 0; i < AGE_KEYS; i++) {
+		age_keys[i] = i + 1;
+		pos[i] = rte_hash_add_key_data(handle, &age_keys[i],
+				(void *)(uintptr_t)i);
+		RETURN_IF_ERROR(pos[i] != 0, "failed to add key %u", i);
+		pos[i] = rte_hash_lookup(handle, &age_keys[i]);
+	}
+
+	/* First sweep only stamps the entries, the budget covers the table */
+	ret = rte_hash_age_scan(handle, 10, AGE_ENTRIES, test_hash_age_cb,
+				NULL);
+	RETURN_IF_ERROR(ret != 0 || g_age_calls != 0,
+			"entries never touched should not age (%d, %u calls)",
+			ret, g_age_calls);
+
+	/* Touch even keys, half of them by lookup, half explicitly */
+	for (i = 0; i < AGE_KEYS; i += 2 * AGE_BURST) {
+		for (j = 0; j < AGE_BURST; j++)
+			keys[j] = &age_keys[i + 2 * j];
+		ret = rte_hash_lookup_bulk_touch(handle, keys, AGE_BURST, 100,
+						 &hit_mask, data);
+		RETURN_IF_ERROR(ret != AGE_BURST, "touched %d keys", ret);
+		for (j = 0; j < AGE_BURST; j++)
+			RETURN_IF_ERROR((uintptr_t)data[j] != i + 2 * j,
+					"wrong data for key %u", i + 2 * j);
+	}
+	for (i = 0; i < AGE_KEYS; i += 4)
+		RETURN_IF_ERROR(rte_hash_age_touch(handle, pos[i], 100) != 0,
+				"failed to touch key %u", i);
+
+	/* A budget of one bucket visits at most one bucket of entries */
+	g_age_calls = 0;
+	ret = rte_hash_age_scan(handle, 50, 1, test_hash_age_cb, NULL);
+	RETURN_IF_ERROR(ret != 0 || g_age_calls > AGE_BUCKET_SIZE,
+			"scan over budget (%d, %u calls)", ret, g_age_calls);
+
+	/* Odd keys are AGE_TIMEOUT old, even ones are fresh */
+	ret = rte_hash_age_scan(handle, 10 + AGE_TIMEOUT, AGE_ENTRIES,
+				test_hash_age_cb, NULL);
+	RETURN_IF_ERROR(ret != AGE_KEYS / 2 || g_age_expired_num != AGE_KEYS / 2,
+			"%d keys expired instead of %u", ret, AGE_KEYS / 2);
+	for (i = 0; i < AGE_KEYS; i++) {
+		ret = rte_hash_lookup(handle, &age_keys[i]);
+		RETURN_IF_ERROR((i & 1) ? ret != -ENOENT : ret != pos[i],
+				"key %u looked up at %d after expiry", i, ret);
+	}
+
+	if (with_rcu) {
+		/* Removed entries are freed once the reader is quiescent */
+		RETURN_IF_ERROR(g_age_freed != 0, "freed before grace period");
+		rte_rcu_qsbr_quiescent(qsv, 0);
+		for (i = 0; i < AGE_KEYS && g_age_freed < AGE_KEYS / 2; i++)
+			rte_hash_age_scan(handle, 10 + AGE_TIMEOUT, 1,
+					  test_hash_age_cb, NULL);
+		RETURN_IF_ERROR(g_age_freed != AGE_KEYS / 2,
+				"%u entries freed by the scan", g_age_freed);
+	} else if (extra_flag & RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY_LF) {
+		for (i = 0; i < g_age_expired_num; i++)
+			rte_hash_free_key_with_position(handle,
+							g_age_expired[i]);
+	}
+	RETURN_IF_ERROR(rte_hash_count(handle) != AGE_KEYS / 2,
+			"wrong number of keys left");
+
+	/* All the slots are back, the table can be filled again */
+	for (i = 1; i < AGE_KEYS; i += 2)
+		RETURN_IF_ERROR(rte_hash_add_key(handle, &age_keys[i]) < 0,
+				"failed to add back key %u", i);
+	RETURN_IF_ERROR(rte_hash_count(handle) != AGE_KEYS,
+			"wrong number of keys added back");
+
+	rte_hash_free(handle);
+	rte_free(qsv);
+
+	return 0;
+}
+
 /*
  * Do all unit and performance tests.
  */
@@ -2400,6 +3133,54 @@ test_hash(void)
 	if (test_hash_rcu_qsbr_dq_reclaim() < 0)
 		return -1;
 
+	if (test_hash_resizable(0) < 0)
+		return -1;
+
+	if (test_hash_resizable(RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY) < 0)
+		return -1;
+
+	if (test_hash_resizable(RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY_LF) < 0)
+		return -1;
+
+	if (test_hash_resizable_skewed() < 0)
+		return -1;
+	if (test_hash_resizable_rcu_dq() < 0)
+		return -1;
+	if (test_hash_resizable_lf() < 0)
+		return -1;
+
+	if (test_hash_bulk_add_del(0) < 0)
+		return -1;
+
+	if (test_hash_bulk_add_del(RTE_HASH_EXTRA_FLAGS_EXT_TABLE) < 0)
+		return -1;
+
+	if (test_hash_bulk_add_del(RTE_HASH_EXTRA_FLAGS_MULTI_WRITER_ADD |
+				   RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY) < 0)
+		return -1;
+
+	if (test_hash_bulk_add_del(RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY_LF) < 0)
+		return -1;
+
+	if (test_hash_bulk_add_del(RTE_HASH_EXTRA_FLAGS_RESIZABLE) < 0)
+		return -1;
+
+	if (test_hash_aging(0, false) < 0)
+		return -1;
+
+	if (test_hash_aging(RTE_HASH_EXTRA_FLAGS_EXT_TABLE, false) < 0)
+		return -1;
+
+	if (test_hash_aging(RTE_HASH_EXTRA_FLAGS_MULTI_WRITER_ADD |
+			    RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY, false) < 0)
+		return -1;
+
+	if (test_hash_aging(RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY_LF, false) < 0)
+		return -1;
+
+	if (test_hash_aging(RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY_LF, true) < 0)
+		return -1;
+
 	return 0;
 }
 
@@ -22,7 +22,11 @@
 #define ADD_PERCENT 0.75 /* 75% table utilization */
 #define NUM_LOOKUPS (KEYS_TO_ADD * 5) /* Loop among keys added, several times */
 /* BUCKET_SIZE should be same as RTE_HASH_BUCKET_ENTRIES in rte_hash library */
+#ifdef RTE_HASH_BUCKET_ENTRIES
+#define BUCKET_SIZE RTE_HASH_BUCKET_ENTRIES
+#else
 #define BUCKET_SIZE 8
+#endif
 #define NUM_BUCKETS (MAX_ENTRIES / BUCKET_SIZE)
 #define MAX_KEYSIZE 64
 #define NUM_KEYSIZES 10
@@ -34,6 +38,8 @@ enum operations {
 	OP_LOOKUP,
 	OP_LOOKUP_MULTI,
 	OP_DELETE,
+	OP_ADD_MULTI,
+	OP_DELETE_MULTI,
 	NUM_OPERATIONS
 };
 
@@ -559,6 +565,94 @@ timed_deletes(unsigned int with_hash, unsigned int with_data,
 	return 0;
 }
 
+/* There are no bulk add and delete functions with pre-computed hash */
+static int
+timed_adds_multi(unsigned int with_data, unsigned int table_index,
+		unsigned int ext)
+{
+	unsigned int i, k, n;
+	int32_t positions_burst[BURST_SIZE];
+	const void *keys_burst[BURST_SIZE];
+	void *data_burst[BURST_SIZE];
+	int ret;
+	unsigned int keys_to_add;
+	const uint64_t start_tsc = rte_rdtsc();
+
+	if (!ext)
+		keys_to_add = KEYS_TO_ADD * ADD_PERCENT;
+	else
+		keys_to_add = KEYS_TO_ADD;
+
+	for (i = 0; i < keys_to_add; i += n) {
+		n = RTE_MIN(keys_to_add - i, (unsigned int)BURST_SIZE);
+		for (k = 0; k < n; k++) {
+			keys_burst[k] = keys[i + k];
+			data_burst[k] = (void *)((uintptr_t)signatures[i + k]);
+		}
+		ret = rte_hash_add_key_bulk_data(h[table_index], keys_burst,
+				with_data ? data_burst : NULL, n,
+				positions_burst);
+		if (ret != (int)n) {
+			printf("Expect to add %u keys, but added %d\n", n, ret);
+			return -1;
+		}
+		for (k = 0; k < n; k++)
+			positions[i + k] = positions_burst[k];
+	}
+
+	const uint64_t end_tsc = rte_rdtsc();
+	const uint64_t time_taken = end_tsc - start_tsc;
+
+	cycles[table_index][OP_ADD_MULTI][0][with_data] = time_taken/keys_to_add;
+
+	return 0;
+}
+
+static int
+timed_deletes_multi(unsigned int with_data, unsigned int table_index,
+		unsigned int ext)
+{
+	unsigned int i, k, n;
+	int32_t positions_burst[BURST_SIZE];
+	const void *keys_burst[BURST_SIZE];
+	int ret;
+	unsigned int keys_to_add;
+	const uint64_t start_tsc = rte_rdtsc();
+
+	if (!ext)
+		keys_to_add = KEYS_TO_ADD * ADD_PERCENT;
+	else
+		keys_to_add = KEYS_TO_ADD;
+
+	for (i = 0; i < keys_to_add; i += n) {
+		n = RTE_MIN(keys_to_add - i, (unsigned int)BURST_SIZE);
+		for (k = 0; k < n; k++)
+			keys_burst[k] = keys[i + k];
+		ret = rte_hash_del_key_bulk(h[table_index], keys_burst, n,
+				positions_burst);
+		if (ret != (int)n) {
+			printf("Expect to delete %u keys, but deleted %d\n",
+				n, ret);
+			return -1;
+		}
+		for (k = 0; k < n; k++) {
+			if (positions_burst[k] != positions[i + k]) {
+				printf("Key deleted from %d, should be in %d\n",
+					positions_burst[k], positions[i + k]);
+				return -1;
+			}
+		}
+	}
+
+	const uint64_t end_tsc = rte_rdtsc();
+	const uint64_t time_taken = end_tsc - start_tsc;
+
+	cycles[table_index][OP_DELETE_MULTI][0][with_data] =
+		time_taken/keys_to_add;
+
+	return 0;
+}
+
 static void
 free_table(unsigned table_index)
 {
@@ -604,6 +698,17 @@ run_all_tbl_perf_tests(unsigned int with_pushes, unsigned int with_locks,
 				if (timed_deletes(with_hash, with_data, i, ext) < 0)
 					return -1;
 
+				if (!with_hash) {
+					shuffle_input_keys(i, ext);
+					if (timed_adds_multi(with_data, i,
+							ext) < 0)
+						return -1;
+					shuffle_input_keys(i, ext);
+					if (timed_deletes_multi(with_data, i,
+							ext) < 0)
+						return -1;
+				}
+
 				/* Print a dot to show progress on operations */
 				printf(".");
 				fflush(stdout);
@@ -627,12 +732,19 @@ run_all_tbl_perf_tests(unsigned int with_pushes, unsigned int with_locks,
 			else
 				printf("\nWithout pre-computed hash values\n");
 
-			printf("\n%-18s%-18s%-18s%-18s%-18s\n",
-			"Keysize", "Add", "Lookup", "Lookup_bulk", "Delete");
+			printf("\n%-18s%-18s%-18s%-18s%-18s%-18s%-18s\n",
+			"Keysize", "Add", "Lookup", "Lookup_bulk", "Delete",
+			"Add_bulk", "Delete_bulk");
 			for (i = 0; i < NUM_KEYSIZES; i++) {
 				printf("%-18d", hashtest_key_lens[i]);
-				for (j = 0; j < NUM_OPERATIONS; j++)
-					printf("%-18"PRIu64, cycles[i][j][with_hash][with_data]);
+				for (j = 0; j < NUM_OPERATIONS; j++) {
+					if (with_hash && (j == OP_ADD_MULTI ||
+							j == OP_DELETE_MULTI))
+						printf("%-18s", "-");
+					else
+						printf("%-18"PRIu64,
+						cycles[i][j][with_hash][with_data]);
+				}
 				printf("\n");
 			}
 		}
@@ -640,6 +752,102 @@ run_all_tbl_perf_tests(unsigned int with_pushes, unsigned int with_locks,
 	return 0;
 }
 
+/* Key size used to measure the load factor a table can reach. */
+#define MAX_LOAD_KEYSIZE 16
+
+/*
+ * Fill a table without extendable buckets with random keys until the first
+ * insertion fails, then measure lookups in the full table. Wider buckets
+ * reach a higher load factor before a key cannot be placed.
+ */
+static int
+max_load_perf_test(void)
+{
+	struct rte_hash_parameters params = {
+		.name = "test_hash_max_load",
+		.entries = MAX_ENTRIES,
+		.key_len = MAX_LOAD_KEYSIZE,
+		.hash_func = rte_jhash,
+		.hash_func_init_val = 0,
+		.socket_id = rte_socket_id(),
+	};
+	const void *keys_burst[BURST_SIZE];
+	int32_t positions_burst[BURST_SIZE];
+	uint64_t add_cycles, lookup_cycles, lookup_multi_cycles;
+	uint64_t start_tsc;
+	struct rte_hash *handle;
+	unsigned int added, i, j, k, n;
+	int32_t ret;
+
+	handle = rte_hash_create(&params);
+	if (handle == NULL) {
+		printf("Error creating table\n");
+		return -1;
+	}
+
+	for (i = 0; i < KEYS_TO_ADD; i++)
+		for (j = 0; j < MAX_LOAD_KEYSIZE; j++)
+			keys[i][j] = (uint8_t)rte_rand();
+
+	start_tsc = rte_rdtsc();
+	for (added = 0; added < KEYS_TO_ADD; added++) {
+		ret = rte_hash_add_key(handle, keys[added]);
+		if (ret < 0)
+			break;
+	}
+	add_cycles = rte_rdtsc() - start_tsc;
+
+	if (added < BURST_SIZE) {
+		printf("Only %u keys could be added\n", added);
+		rte_hash_free(handle);
+		return -1;
+	}
+
+	start_tsc = rte_rdtsc();
+	for (i = 0; i < NUM_LOOKUPS; i++) {
+		ret = rte_hash_lookup(handle, keys[i % added]);
+		if (ret < 0) {
+			printf("Failed to find key number %u\n", i % added);
+			rte_hash_free(handle);
+			return -1;
+		}
+	}
+	lookup_cycles = rte_rdtsc() - start_tsc;
+
+	n = added / BURST_SIZE;
+	start_tsc = rte_rdtsc();
+	for (i = 0; i < NUM_LOOKUPS / BURST_SIZE; i++) {
+		for (k = 0; k < BURST_SIZE; k++)
+			keys_burst[k] = keys[(i % n) * BURST_SIZE + k];
+		rte_hash_lookup_bulk(handle, keys_burst, BURST_SIZE,
+				positions_burst);
+		for (k = 0; k < BURST_SIZE; k++) {
+			if (positions_burst[k] < 0) {
+				printf("Failed to find key number %u\n",
+					(i % n) * BURST_SIZE + k);
+				rte_hash_free(handle);
+				return -1;
+			}
+		}
+	}
+	lookup_multi_cycles = rte_rdtsc() - start_tsc;
+
+	printf("\n\n *** Maximum load performance test results ***\n");
+	printf("Bucket entries = %u, key size = %u\n", BUCKET_SIZE,
+		MAX_LOAD_KEYSIZE);
+	printf("Load factor at first failed insertion = %.2f%% (%u/%u)\n",
+		100.0 * added / MAX_ENTRIES, added, MAX_ENTRIES);
+	printf("Number of ticks per add = %"PRIu64"\n", add_cycles / added);
+	printf("Number of ticks per lookup = %"PRIu64"\n",
+		lookup_cycles / NUM_LOOKUPS);
+	printf("Number of ticks per bulk lookup = %"PRIu64"\n",
+		lookup_multi_cycles / ((NUM_LOOKUPS / BURST_SIZE) * BURST_SIZE));
+
+	rte_hash_free(handle);
+
+	return 0;
+}
+
 /* Control operation of performance testing of fbk hash. */
 #define LOAD_FACTOR 0.667	/* How full to make the hash table. */
 #define TEST_SIZE 1000000	/* How many operations to time. */
@@ -751,6 +959,9 @@ test_hash_perf(void)
 	if (run_all_tbl_perf_tests(1, 0, 1) < 0)
 		return -1;
 
+	if (max_load_perf_test() < 0)
+		return -1;
+
 	if (fbk_hash_perf_test() < 0)
 		return -1;
 
@@ -6,9 +6,11 @@
 #include <stdint.h>
 #include <stdlib.h>
 
+#include <rte_errno.h>
 #include <rte_ip.h>
 #include <rte_lpm.h>
 #include <rte_malloc.h>
+#include <rte_random.h>
 
 #include "test.h"
 #include "test_xmmt_ops.h"
@@ -44,6 +46,7 @@ static int32_t test18(void);
 static int32_t test19(void);
 static int32_t test20(void);
 static int32_t test21(void);
+static int32_t test22(void);
 
 rte_lpm_test tests[] = {
 /* Test Cases */
@@ -68,7 +71,8 @@ rte_lpm_test tests[] = {
 	test18,
 	test19,
 	test20,
-	test21
+	test21,
+	test22
 };
 
 #define MAX_DEPTH 32
@@ -1563,6 +1567,125 @@ test21(void)
 	return (status == 0) ? PASS : -1;
 }
 
+/*
+ * Versioned mode functional test.
+ *  - Apply the same random adds and deletes to an LPM in versioned mode and
+ *    to one in the default mode, and check that all lookups agree.
+ *  - Check that no tbl8 group was leaked once all the rules are deleted.
+ *  - Check that changes still apply when no tbl8 group is free for a copy.
+ *  - Check that unknown flags are rejected, and that the versioned mode
+ *    refuses changes until RCU QSBR is attached.
+ */
+int32_t
+test22(void)
+{
+#define VERSIONED_NUM_ROUTES	64
+#define VERSIONED_NUM_OPS	1024
+	struct rte_lpm *lpm = NULL, *lpm_ref = NULL;
+	struct rte_lpm_config config;
+	struct rte_lpm_rcu_config rcu_cfg = {0};
+	struct rte_rcu_qsbr *qsv;
+	size_t sz;
+	uint32_t ips[VERSIONED_NUM_ROUTES];
+	uint8_t depths[VERSIONED_NUM_ROUTES];
+	uint32_t ip_base = RTE_IPV4(198, 18, 0, 0);
+	uint32_t i, j, ip, next_hop, nh_ret, nh_ref;
+	int32_t status, status_ref;
+
+	config.max_rules = 2 * MAX_RULES;
+	config.number_tbl8s = NUMBER_TBL8S;
+	config.flags = RTE_LPM_F_VERSIONED << 1;
+
+	lpm = rte_lpm_create(__func__, SOCKET_ID_ANY, &config);
+	TEST_LPM_ASSERT(lpm == NULL && rte_errno == EINVAL);
+
+	config.flags = RTE_LPM_F_VERSIONED;
+	lpm = rte_lpm_create(__func__, SOCKET_ID_ANY, &config);
+	TEST_LPM_ASSERT(lpm != NULL);
+
+	status = rte_lpm_add(lpm, ip_base, 24, 1);
+	TEST_LPM_ASSERT(status == -EINVAL);
+	status = rte_lpm_delete(lpm, ip_base, 24);
+	TEST_LPM_ASSERT(status == -EINVAL);
+
+	/* No reader is registered, so the replaced groups are freed at once */
+	sz = rte_rcu_qsbr_get_memsize(1);
+	qsv = (struct rte_rcu_qsbr *)rte_zmalloc_socket(NULL, sz,
+				RTE_CACHE_LINE_SIZE, SOCKET_ID_ANY);
+	TEST_LPM_ASSERT(qsv != NULL);
+	status = rte_rcu_qsbr_init(qsv, 1);
+	TEST_LPM_ASSERT(status == 0);
+	rcu_cfg.v = qsv;
+	rcu_cfg.mode = RTE_LPM_QSBR_MODE_SYNC;
+	status = rte_lpm_rcu_qsbr_add(lpm, &rcu_cfg);
+	TEST_LPM_ASSERT(status == 0);
+
+	config.flags = 0;
+	lpm_ref = rte_lpm_create("test22_ref", SOCKET_ID_ANY, &config);
+	TEST_LPM_ASSERT(lpm_ref != NULL);
+
+	/* Routes within a /20, from /18 down to /32 */
+	for (i = 0; i < VERSIONED_NUM_ROUTES; i++) {
+		ips[i] = ip_base | (rte_rand() & 0xFFF);
+		depths[i] = 18 + rte_rand_max(RTE_LPM_MAX_DEPTH - 18 + 1);
+	}
+
+	for (i = 0; i < VERSIONED_NUM_OPS; i++) {
+		j = rte_rand_max(VERSIONED_NUM_ROUTES);
+		if (rte_lpm_is_rule_present(lpm_ref, ips[j], depths[j],
+				&next_hop) == 1) {
+			status = rte_lpm_delete(lpm, ips[j], depths[j]);
+			status_ref = rte_lpm_delete(lpm_ref, ips[j], depths[j]);
+		} else {
+			next_hop = rte_rand_max(1 << 24);
+			status = rte_lpm_add(lpm, ips[j], depths[j], next_hop);
+			status_ref = rte_lpm_add(lpm_ref, ips[j], depths[j],
+					next_hop);
+		}
+		TEST_LPM_ASSERT(status == 0 && status_ref == 0);
+
+		for (ip = ip_base; ip < ip_base + (1 << 12); ip++) {
+			status = rte_lpm_lookup(lpm, ip, &nh_ret);
+			status_ref = rte_lpm_lookup(lpm_ref, ip, &nh_ref);
+			TEST_LPM_ASSERT(status == status_ref);
+			TEST_LPM_ASSERT(status != 0 || nh_ret == nh_ref);
+		}
+	}
+
+	for (i = 0; i < VERSIONED_NUM_ROUTES; i++)
+		rte_lpm_delete(lpm, ips[i], depths[i]);
+
+	/* Every tbl8 group must be free again */
+	for (i = 0; i < NUMBER_TBL8S; i++) {
+		status = rte_lpm_add(lpm, ip_base + (i << 8), 32, i);
+		TEST_LPM_ASSERT(status == 0);
+	}
+	status = rte_lpm_add(lpm, ip_base + (i << 8), 32, i);
+	TEST_LPM_ASSERT(status == -ENOSPC);
+
+	/* All groups in use, the changes are made to the groups in use */
+	status = rte_lpm_add(lpm, ip_base + 1, 32, 1);
+	TEST_LPM_ASSERT(status == 0);
+	status = rte_lpm_add(lpm, ip_base, 16, 2);
+	TEST_LPM_ASSERT(status == 0);
+	status = rte_lpm_lookup(lpm, ip_base + 1, &nh_ret);
+	TEST_LPM_ASSERT(status == 0 && nh_ret == 1);
+	status = rte_lpm_lookup(lpm, ip_base + 2, &nh_ret);
+	TEST_LPM_ASSERT(status == 0 && nh_ret == 2);
+	status = rte_lpm_delete(lpm, ip_base + 1, 32);
+	TEST_LPM_ASSERT(status == 0);
+	status = rte_lpm_lookup(lpm, ip_base + 1, &nh_ret);
+	TEST_LPM_ASSERT(status == 0 && nh_ret == 2);
+	status = rte_lpm_lookup(lpm, ip_base, &nh_ret);
+	TEST_LPM_ASSERT(status == 0 && nh_ret == 0);
+
+	rte_lpm_free(lpm);
+	rte_lpm_free(lpm_ref);
+	rte_free(qsv);
+
+	return PASS;
+}
+
 /*
  * Do all unit tests.
  */
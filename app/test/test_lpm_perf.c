@@ -59,6 +59,30 @@ struct route_rule large_ldepth_route_table[MAX_RULE_NUM];
 
 static uint32_t num_route_entries;
 static uint32_t num_ldepth_route_entries;
+
+/*
+ * Versioned mode stress test routes, one per /24 of a /8 whose route is
+ * never changed. Every 64th route is a /18 covering the next ones, the
+ * others are longer than /24. Lookups within the /8 must always succeed
+ * with one of the next hops of these routes.
+ */
+#define STRESS_NUM_ROUTES (1 << 13)
+#define STRESS_PREFIX RTE_IPV4(10, 0, 0, 0)
+#define STRESS_NH_BASE 0x100
+#define STRESS_NH_SMALL (STRESS_NH_BASE + 1)
+#define STRESS_NH_BIG (STRESS_NH_BASE + 2)
+
+static struct route_rule stress_route_table[STRESS_NUM_ROUTES];
+
+/*
+ * Versioned mode split test: a /25 splitting the /24 of SPLIT_NET gets a
+ * new next hop on every iteration. Readers look up its first and then its
+ * last address and must never see the last one older than the first one.
+ */
+#define SPLIT_NET RTE_IPV4(10, 1, 0, 0)
+#define SPLIT_LAST (SPLIT_NET + 127)
+#define SPLIT_ITERATIONS (1 << 14)
+static RTE_ATOMIC(uint64_t) glookup_errors;
 #define NUM_ROUTE_ENTRIES num_route_entries
 #define NUM_LDEPTH_ROUTE_ENTRIES num_ldepth_route_entries
 
@@ -590,6 +614,391 @@ test_lpm_rcu_perf_multi_writer(uint8_t use_rcu)
 	return -1;
 }
 
+static void
+generate_stress_route_table(void)
+{
+	unsigned int i;
+
+	for (i = 0; i < STRESS_NUM_ROUTES; i++) {
+		if (i % 64 == 0) {
+			stress_route_table[i].ip = STRESS_PREFIX | (i << 8);
+			stress_route_table[i].depth = 18;
+		} else {
+			stress_route_table[i].ip = STRESS_PREFIX | (i << 8) |
+				(rte_rand() & 0xFF);
+			stress_route_table[i].depth = 25 + rte_rand_max(8);
+		}
+	}
+}
+
+/*
+ * Reader thread checking that every lookup succeeds with a next hop of the
+ * stress test routes.
+ */
+static int
+test_lpm_stress_reader(void *arg)
+{
+	unsigned int i, k;
+	uint32_t thread_id = alloc_thread_id();
+	uint32_t ip_batch[QSBR_REPORTING_INTERVAL];
+	uint32_t next_hops[BULK_SIZE];
+	uint64_t errors = 0;
+
+	RTE_SET_USED(arg);
+	/* Register this thread to report quiescent state */
+	rte_rcu_qsbr_thread_register(rv, thread_id);
+	rte_rcu_qsbr_thread_online(rv, thread_id);
+
+	do {
+		for (i = 0; i < QSBR_REPORTING_INTERVAL; i++)
+			ip_batch[i] = STRESS_PREFIX |
+				(rte_rand() & ((STRESS_NUM_ROUTES << 8) - 1));
+
+		for (i = 0; i < QSBR_REPORTING_INTERVAL; i += BULK_SIZE) {
+			rte_lpm_lookup_bulk(lpm, &ip_batch[i], next_hops,
+				BULK_SIZE);
+			for (k = 0; k < BULK_SIZE; k++) {
+				if (!(next_hops[k] & RTE_LPM_LOOKUP_SUCCESS) ||
+						(next_hops[k] & 0x00FFFFFF) -
+						STRESS_NH_BASE > 2)
+					errors++;
+			}
+		}
+
+		/* Update quiescent state */
+		rte_rcu_qsbr_quiescent(rv, thread_id);
+	} while (!writer_done);
+
+	rte_rcu_qsbr_thread_offline(rv, thread_id);
+	rte_rcu_qsbr_thread_unregister(rv, thread_id);
+
+	rte_atomic_fetch_add_explicit(&glookup_errors, errors,
+		rte_memory_order_relaxed);
+
+	return 0;
+}
+
+/*
+ * Writer thread adding and deleting its share of the stress test routes.
+ */
+static int
+test_lpm_stress_writer(void *arg)
+{
+	unsigned int i, j, si, ei;
+	uint32_t next_hop;
+	uint8_t pos_core = (uint8_t)((uintptr_t)arg);
+
+	si = (pos_core * STRESS_NUM_ROUTES) / num_writers;
+	ei = ((pos_core + 1) * STRESS_NUM_ROUTES) / num_writers;
+
+	for (i = 0; i < RCU_ITERATIONS; i++) {
+		/* Add all the entries */
+		for (j = si; j < ei; j++) {
+			next_hop = (stress_route_table[j].depth <= 24) ?
+				STRESS_NH_SMALL : STRESS_NH_BIG;
+			rte_spinlock_lock(&lpm_lock);
+			if (rte_lpm_add(lpm, stress_route_table[j].ip,
+					stress_route_table[j].depth,
+					next_hop) != 0) {
+				printf("Failed to add iteration %d, route# %d\n",
+					i, j);
+				goto error;
+			}
+			rte_spinlock_unlock(&lpm_lock);
+		}
+
+		/* Delete all the entries */
+		for (j = si; j < ei; j++) {
+			rte_spinlock_lock(&lpm_lock);
+			if (rte_lpm_delete(lpm, stress_route_table[j].ip,
+					stress_route_table[j].depth) != 0) {
+				printf("Failed to delete iteration %d, route# %d\n",
+					i, j);
+				goto error;
+			}
+			rte_spinlock_unlock(&lpm_lock);
+		}
+	}
+
+	return 0;
+
+error:
+	rte_spinlock_unlock(&lpm_lock);
+	return -1;
+}
+
+/*
+ * Reader thread checking that the next hops of the split route are never
+ * seen from two different versions of its tbl8 group in the wrong order.
+ */
+static int
+test_lpm_split_reader(void *arg)
+{
+	unsigned int i;
+	uint32_t thread_id = alloc_thread_id();
+	uint32_t nh_first, nh_last;
+	uint64_t errors = 0;
+
+	RTE_SET_USED(arg);
+	/* Register this thread to report quiescent state */
+	rte_rcu_qsbr_thread_register(rv, thread_id);
+	rte_rcu_qsbr_thread_online(rv, thread_id);
+
+	do {
+		for (i = 0; i < QSBR_REPORTING_INTERVAL; i++) {
+			if (rte_lpm_lookup(lpm, SPLIT_NET, &nh_first) != 0) {
+				errors++;
+				continue;
+			}
+			/* Look up the last address only after the first one */
+			rte_atomic_thread_fence(rte_memory_order_acquire);
+			if (rte_lpm_lookup(lpm, SPLIT_LAST, &nh_last) != 0 ||
+					nh_last < nh_first)
+				errors++;
+		}
+
+		/* Update quiescent state */
+		rte_rcu_qsbr_quiescent(rv, thread_id);
+	} while (!writer_done);
+
+	rte_rcu_qsbr_thread_offline(rv, thread_id);
+	rte_rcu_qsbr_thread_unregister(rv, thread_id);
+
+	rte_atomic_fetch_add_explicit(&glookup_errors, errors,
+		rte_memory_order_relaxed);
+
+	return 0;
+}
+
+/*
+ * Writer thread giving the split route a greater next hop on every
+ * iteration.
+ */
+static int
+test_lpm_split_writer(void *arg)
+{
+	uint32_t i;
+
+	RTE_SET_USED(arg);
+
+	for (i = 1; i <= SPLIT_ITERATIONS; i++) {
+		if (rte_lpm_add(lpm, SPLIT_NET, 25, i) != 0) {
+			printf("Failed to update the split route, iteration %u\n",
+				i);
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+/*
+ * Versioned mode split test: 1 writer, rest are readers checking that a
+ * tbl8 group update is seen as a whole. The RCU variable is used in sync
+ * mode so that the writer never runs out of tbl8 groups to copy into.
+ */
+static int
+test_lpm_versioned_split(void)
+{
+	struct rte_lpm_config config;
+	struct rte_lpm_rcu_config rcu_cfg = {0};
+	uint64_t errors;
+	unsigned int i;
+	size_t sz;
+
+	printf("\nSplit test: 1 writer, %d reader(s), versioned mode\n",
+	       num_cores - 1);
+
+	config.max_rules = 16;
+	config.number_tbl8s = 16;
+	config.flags = RTE_LPM_F_VERSIONED;
+	lpm = rte_lpm_create(__func__, SOCKET_ID_ANY, &config);
+	TEST_LPM_ASSERT(lpm != NULL);
+
+	/* Init RCU variable */
+	sz = rte_rcu_qsbr_get_memsize(num_cores);
+	rv = (struct rte_rcu_qsbr *)rte_zmalloc("rcu0", sz,
+					RTE_CACHE_LINE_SIZE);
+	rte_rcu_qsbr_init(rv, num_cores);
+
+	rcu_cfg.v = rv;
+	rcu_cfg.mode = RTE_LPM_QSBR_MODE_SYNC;
+	/* Assign the RCU variable to LPM */
+	if (rte_lpm_rcu_qsbr_add(lpm, &rcu_cfg) != 0) {
+		printf("RCU variable assignment failed\n");
+		goto error;
+	}
+
+	if (rte_lpm_add(lpm, SPLIT_NET, 24, 0) != 0 ||
+			rte_lpm_add(lpm, SPLIT_NET, 25, 0) != 0) {
+		printf("Failed to add the split routes\n");
+		goto error;
+	}
+
+	writer_done = 0;
+	rte_atomic_store_explicit(&glookup_errors, 0, rte_memory_order_relaxed);
+
+	rte_atomic_store_explicit(&thr_id, 0, rte_memory_order_seq_cst);
+
+	/* Launch reader threads */
+	for (i = 1; i < num_cores; i++)
+		rte_eal_remote_launch(test_lpm_split_reader, NULL,
+					enabled_core_ids[i]);
+
+	/* Launch writer thread */
+	rte_eal_remote_launch(test_lpm_split_writer, NULL,
+				enabled_core_ids[0]);
+
+	/* Wait for writer thread */
+	if (rte_eal_wait_lcore(enabled_core_ids[0]) < 0)
+		goto error;
+
+	writer_done = 1;
+	/* Wait until all readers have exited */
+	for (i = 1; i < num_cores; i++)
+		rte_eal_wait_lcore(enabled_core_ids[i]);
+
+	errors = rte_atomic_load_explicit(&glookup_errors,
+		rte_memory_order_relaxed);
+	printf("Total split route updates: %d\n", SPLIT_ITERATIONS);
+	printf("Inconsistent lookups: %"PRIu64"\n", errors);
+
+	rte_lpm_free(lpm);
+	rte_free(rv);
+	lpm = NULL;
+	rv = NULL;
+
+	TEST_LPM_ASSERT(errors == 0);
+
+	return 0;
+
+error:
+	writer_done = 1;
+	/* Wait until all readers have exited */
+	rte_eal_mp_wait_lcore();
+
+	rte_lpm_free(lpm);
+	rte_free(rv);
+
+	return -1;
+}
+
+/*
+ * Stress test of the versioned mode:
+ * 1/2 writers, rest are readers checking every lookup
+ */
+static int
+test_lpm_versioned_stress(void)
+{
+	struct rte_lpm_config config;
+	struct rte_lpm_rcu_config rcu_cfg = {0};
+	uint64_t begin, total_cycles, errors;
+	unsigned int i, j;
+	uint16_t core_id;
+	size_t sz;
+
+	if (rte_lcore_count() < 3) {
+		printf("Not enough cores for versioned mode stress test, expecting at least 3\n");
+		return TEST_SKIPPED;
+	}
+
+	num_cores = 0;
+	RTE_LCORE_FOREACH_WORKER(core_id) {
+		enabled_core_ids[num_cores] = core_id;
+		num_cores++;
+	}
+
+	generate_stress_route_table();
+
+	for (j = 1; j < 3; j++) {
+		printf("\nStress test: %d writer(s), %d reader(s),"
+		       " versioned mode\n", j, num_cores - j);
+
+		num_writers = j;
+
+		/* Create LPM table, with room for the copies of tbl8 groups */
+		config.max_rules = STRESS_NUM_ROUTES + 1;
+		config.number_tbl8s = 2 * STRESS_NUM_ROUTES;
+		config.flags = RTE_LPM_F_VERSIONED;
+		lpm = rte_lpm_create(__func__, SOCKET_ID_ANY, &config);
+		TEST_LPM_ASSERT(lpm != NULL);
+
+		/* Init RCU variable */
+		sz = rte_rcu_qsbr_get_memsize(num_cores);
+		rv = (struct rte_rcu_qsbr *)rte_zmalloc("rcu0", sz,
+						RTE_CACHE_LINE_SIZE);
+		rte_rcu_qsbr_init(rv, num_cores);
+
+		rcu_cfg.v = rv;
+		/* Assign the RCU variable to LPM */
+		if (rte_lpm_rcu_qsbr_add(lpm, &rcu_cfg) != 0) {
+			printf("RCU variable assignment failed\n");
+			goto error;
+		}
+
+		if (rte_lpm_add(lpm, STRESS_PREFIX, 8, STRESS_NH_BASE) != 0) {
+			printf("Failed to add the covering route\n");
+			goto error;
+		}
+
+		writer_done = 0;
+		rte_atomic_store_explicit(&glookup_errors, 0, rte_memory_order_relaxed);
+
+		rte_atomic_store_explicit(&thr_id, 0, rte_memory_order_seq_cst);
+
+		/* Launch reader threads */
+		for (i = j; i < num_cores; i++)
+			rte_eal_remote_launch(test_lpm_stress_reader, NULL,
+						enabled_core_ids[i]);
+
+		/* Launch writer threads */
+		begin = rte_rdtsc_precise();
+		for (i = 0; i < j; i++)
+			rte_eal_remote_launch(test_lpm_stress_writer,
+						(void *)(uintptr_t)i,
+						enabled_core_ids[i]);
+
+		/* Wait for writer threads */
+		for (i = 0; i < j; i++)
+			if (rte_eal_wait_lcore(enabled_core_ids[i]) < 0)
+				goto error;
+		total_cycles = rte_rdtsc_precise() - begin;
+
+		writer_done = 1;
+		/* Wait until all readers have exited */
+		for (i = j; i < num_cores; i++)
+			rte_eal_wait_lcore(enabled_core_ids[i]);
+
+		errors = rte_atomic_load_explicit(&glookup_errors,
+			rte_memory_order_relaxed);
+		printf("Total LPM Adds/Deletes: %d\n",
+			2 * RCU_ITERATIONS * STRESS_NUM_ROUTES);
+		printf("LPM Add/Del rate: %.0f per second\n",
+			2.0 * RCU_ITERATIONS * STRESS_NUM_ROUTES *
+			rte_get_tsc_hz() / total_cycles);
+		printf("Failed lookups: %"PRIu64"\n", errors);
+
+		rte_lpm_free(lpm);
+		rte_free(rv);
+		lpm = NULL;
+		rv = NULL;
+
+		TEST_LPM_ASSERT(errors == 0);
+	}
+
+	return test_lpm_versioned_split();
+
+error:
+	writer_done = 1;
+	/* Wait until all readers have exited */
+	rte_eal_mp_wait_lcore();
+
+	rte_lpm_free(lpm);
+	rte_free(rv);
+
+	return -1;
+}
+
 static int
 test_lpm_perf(void)
 {
@@ -755,6 +1164,9 @@ test_lpm_perf(void)
 	if (test_lpm_rcu_perf_multi_writer(1) < 0)
 		return -1;
 
+	if (test_lpm_versioned_stress() < 0)
+		return -1;
+
 	return 0;
 }
 
@@ -9,6 +9,7 @@
 #include <stdint.h>
 #include <stdlib.h>
 
+#include <rte_errno.h>
 #include <rte_ip.h>
 #include <rte_rib.h>
 
@@ -21,9 +22,12 @@ static int32_t test_insert_invalid(void);
 static int32_t test_get_fn(void);
 static int32_t test_basic(void);
 static int32_t test_tree_traversal(void);
+static int32_t test_bulk_traversal(void);
+static int32_t test_compact(void);
 
 #define MAX_DEPTH 32
 #define MAX_RULES (1 << 22)
+#define NUM_ROUTES 1000
 
 /*
  * Check that rte_rib_create fails gracefully for incorrect user input
@@ -323,6 +327,166 @@ test_tree_traversal(void)
 	return TEST_SUCCESS;
 }
 
+/*
+ * Check that the bulk walk returns the same nodes in the same order
+ * as rte_rib_get_nxt
+ */
+int32_t
+test_bulk_traversal(void)
+{
+	struct rte_rib *rib = NULL;
+	struct rte_rib_node *node;
+	struct rte_rib_node *nodes[7];
+	struct rte_rib_conf config;
+	uint32_t ip = RTE_IPV4(10, 0, 0, 0);
+	uint32_t prefix = ip;
+	uint8_t depth = 8;
+	int i, ret, num = 0;
+
+	config.max_nodes = MAX_RULES;
+	config.ext_sz = 0;
+
+	rib = rte_rib_create(__func__, SOCKET_ID_ANY, &config);
+	RTE_TEST_ASSERT(rib != NULL, "Failed to create RIB\n");
+
+	ret = rte_rib_get_nxt_bulk(NULL, ip, depth, NULL,
+		RTE_RIB_GET_NXT_ALL, nodes, RTE_DIM(nodes));
+	RTE_TEST_ASSERT(ret == -EINVAL, "Call succeeded with invalid params\n");
+	ret = rte_rib_get_nxt_bulk(rib, ip, MAX_DEPTH + 1, NULL,
+		RTE_RIB_GET_NXT_ALL, nodes, RTE_DIM(nodes));
+	RTE_TEST_ASSERT(ret == -EINVAL, "Call succeeded with invalid params\n");
+	ret = rte_rib_get_nxt_bulk(rib, ip, depth, NULL,
+		RTE_RIB_GET_NXT_ALL, NULL, RTE_DIM(nodes));
+	RTE_TEST_ASSERT(ret == -EINVAL, "Call succeeded with invalid params\n");
+
+	ret = rte_rib_get_nxt_bulk(rib, ip, depth, NULL,
+		RTE_RIB_GET_NXT_ALL, nodes, RTE_DIM(nodes));
+	RTE_TEST_ASSERT(ret == 0, "Walk on empty RIB returned nodes\n");
+
+	for (i = 0; i < NUM_ROUTES; i++) {
+		/* a quarter of the routes are outside of the walked prefix */
+		ip = (uint32_t)i * 2654435761U;
+		if (i % 4 != 0)
+			ip = RTE_IPV4(10, 0, 0, 0) | (ip >> 8);
+		node = rte_rib_insert(rib, ip, 9 + i % 24);
+		RTE_TEST_ASSERT((node != NULL) || (rte_errno == EEXIST),
+			"Failed to insert rule\n");
+	}
+
+	node = NULL;
+	do {
+		ret = rte_rib_get_nxt_bulk(rib, prefix, depth, node,
+			RTE_RIB_GET_NXT_ALL, nodes, RTE_DIM(nodes));
+		RTE_TEST_ASSERT((ret >= 0) && (ret <= (int)RTE_DIM(nodes)),
+			"Failed to walk the RIB\n");
+		for (i = 0; i < ret; i++, num++) {
+			node = rte_rib_get_nxt(rib, prefix, depth, node,
+				RTE_RIB_GET_NXT_ALL);
+			RTE_TEST_ASSERT(node == nodes[i],
+				"Bulk walk returned wrong node\n");
+		}
+	} while (ret == (int)RTE_DIM(nodes));
+
+	node = rte_rib_get_nxt(rib, prefix, depth, node, RTE_RIB_GET_NXT_ALL);
+	RTE_TEST_ASSERT((node == NULL) && (num != 0),
+		"Bulk walk stopped early\n");
+
+	rte_rib_free(rib);
+
+	return TEST_SUCCESS;
+}
+
+/*
+ * Check that routes, next hops and extensions survive the compaction
+ * of a RIB with removed routes
+ */
+int32_t
+test_compact(void)
+{
+	struct rte_rib *rib = NULL;
+	struct rte_rib_node *node;
+	struct rte_rib_conf config;
+	uint32_t ip, ip_ret;
+	uint64_t next_hop_return;
+	uint32_t *ext;
+	uint8_t depth;
+	int i, ret, num = 0;
+
+	config.max_nodes = MAX_RULES;
+	config.ext_sz = sizeof(uint32_t);
+
+	ret = rte_rib_compact(NULL);
+	RTE_TEST_ASSERT(ret == -EINVAL, "Call succeeded with invalid params\n");
+
+	rib = rte_rib_create(__func__, SOCKET_ID_ANY, &config);
+	RTE_TEST_ASSERT(rib != NULL, "Failed to create RIB\n");
+
+	ret = rte_rib_compact(rib);
+	RTE_TEST_ASSERT(ret == 0, "Failed to compact empty RIB\n");
+
+	for (i = 0; i < NUM_ROUTES; i++) {
+		ip = RTE_IPV4(10, i >> 4, (i & 0xf) << 4, 0);
+		node = rte_rib_insert(rib, ip, 20 + i % 8);
+		RTE_TEST_ASSERT(node != NULL, "Failed to insert rule\n");
+		rte_rib_set_nh(node, i);
+		ext = rte_rib_get_ext(node);
+		*ext = ip;
+	}
+	for (i = 0; i < NUM_ROUTES; i += 2)
+		rte_rib_remove(rib, RTE_IPV4(10, i >> 4, (i & 0xf) << 4, 0),
+			20 + i % 8);
+
+	ret = rte_rib_compact(rib);
+	RTE_TEST_ASSERT(ret == 0, "Failed to compact RIB\n");
+
+	for (i = 0; i < NUM_ROUTES; i++) {
+		ip = RTE_IPV4(10, i >> 4, (i & 0xf) << 4, 0);
+		node = rte_rib_lookup_exact(rib, ip, 20 + i % 8);
+		if (i % 2 == 0) {
+			RTE_TEST_ASSERT(node == NULL,
+				"Lookup returns non existent rule\n");
+			continue;
+		}
+		RTE_TEST_ASSERT(node != NULL, "Failed to lookup\n");
+		ret = rte_rib_get_nh(node, &next_hop_return);
+		RTE_TEST_ASSERT((ret == 0) && (next_hop_return == (uint64_t)i),
+			"Failed to get proper nexthop\n");
+		ext = rte_rib_get_ext(node);
+		RTE_TEST_ASSERT(*ext == ip, "Extension not preserved\n");
+	}
+
+	node = NULL;
+	while ((node = rte_rib_get_nxt(rib, 0, 0, node,
+			RTE_RIB_GET_NXT_ALL)) != NULL) {
+		rte_rib_get_ip(node, &ip_ret);
+		rte_rib_get_depth(node, &depth);
+		RTE_TEST_ASSERT(rte_rib_lookup_exact(rib, ip_ret, depth) == node,
+			"Walk returned unknown node\n");
+		num++;
+	}
+	RTE_TEST_ASSERT(num == NUM_ROUTES / 2,
+		"Walk returned wrong number of routes\n");
+
+	/* the RIB keeps working after a compaction */
+	for (i = 0; i < NUM_ROUTES; i += 2) {
+		node = rte_rib_insert(rib, RTE_IPV4(10, i >> 4, (i & 0xf) << 4, 0),
+			20 + i % 8);
+		RTE_TEST_ASSERT(node != NULL, "Failed to insert rule\n");
+	}
+	for (i = 0; i < NUM_ROUTES; i++)
+		rte_rib_remove(rib, RTE_IPV4(10, i >> 4, (i & 0xf) << 4, 0),
+			20 + i % 8);
+
+	node = rte_rib_get_nxt(rib, 0, 0, NULL, RTE_RIB_GET_NXT_ALL);
+	RTE_TEST_ASSERT(node == NULL, "RIB not empty\n");
+	ret = rte_rib_compact(rib);
+	RTE_TEST_ASSERT(ret == 0, "Failed to compact empty RIB\n");
+
+	rte_rib_free(rib);
+
+	return TEST_SUCCESS;
+}
+
 static struct unit_test_suite rib_tests = {
 	.suite_name = "rib autotest",
 	.setup = NULL,
@@ -334,6 +498,8 @@ static struct unit_test_suite rib_tests = {
 		TEST_CASE(test_get_fn),
 		TEST_CASE(test_basic),
 		TEST_CASE(test_tree_traversal),
+		TEST_CASE(test_bulk_traversal),
+		TEST_CASE(test_compact),
 		TEST_CASES_END()
 	}
 };
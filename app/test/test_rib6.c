@@ -6,6 +6,8 @@
 #include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
+#include <rte_errno.h>
 #include <rte_ip6.h>
 #include <rte_rib6.h>
 
@@ -20,9 +22,12 @@ static int32_t test_insert_invalid(void);
 static int32_t test_get_fn(void);
 static int32_t test_basic(void);
 static int32_t test_tree_traversal(void);
+static int32_t test_bulk_traversal(void);
+static int32_t test_compact(void);
 
 #define MAX_DEPTH 128
 #define MAX_RULES (1 << 22)
+#define NUM_ROUTES 1000
 
 /*
  * Check that rte_rib6_create fails gracefully for incorrect user input
@@ -322,6 +327,179 @@ test_tree_traversal(void)
 	return TEST_SUCCESS;
 }
 
+/*
+ * Check that the bulk walk returns the same nodes in the same order
+ * as rte_rib6_get_nxt
+ */
+int32_t
+test_bulk_traversal(void)
+{
+	struct rte_rib6 *rib = NULL;
+	struct rte_rib6_node *node;
+	struct rte_rib6_node *nodes[7];
+	struct rte_rib6_conf config;
+	struct rte_ipv6_addr prefix = RTE_IPV6(0x2001, 0, 0, 0, 0, 0, 0, 0);
+	struct rte_ipv6_addr ip = RTE_IPV6(0x2001, 0, 0, 0, 0, 0, 0, 0);
+	uint8_t depth = 16;
+	uint32_t hash;
+	int i, ret, num = 0;
+
+	config.max_nodes = MAX_RULES;
+	config.ext_sz = 0;
+
+	rib = rte_rib6_create(__func__, SOCKET_ID_ANY, &config);
+	RTE_TEST_ASSERT(rib != NULL, "Failed to create RIB\n");
+
+	ret = rte_rib6_get_nxt_bulk(NULL, &prefix, depth, NULL,
+		RTE_RIB6_GET_NXT_ALL, nodes, RTE_DIM(nodes));
+	RTE_TEST_ASSERT(ret == -EINVAL, "Call succeeded with invalid params\n");
+	ret = rte_rib6_get_nxt_bulk(rib, NULL, depth, NULL,
+		RTE_RIB6_GET_NXT_ALL, nodes, RTE_DIM(nodes));
+	RTE_TEST_ASSERT(ret == -EINVAL, "Call succeeded with invalid params\n");
+	ret = rte_rib6_get_nxt_bulk(rib, &prefix, MAX_DEPTH + 1, NULL,
+		RTE_RIB6_GET_NXT_ALL, nodes, RTE_DIM(nodes));
+	RTE_TEST_ASSERT(ret == -EINVAL, "Call succeeded with invalid params\n");
+	ret = rte_rib6_get_nxt_bulk(rib, &prefix, depth, NULL,
+		RTE_RIB6_GET_NXT_ALL, NULL, RTE_DIM(nodes));
+	RTE_TEST_ASSERT(ret == -EINVAL, "Call succeeded with invalid params\n");
+
+	ret = rte_rib6_get_nxt_bulk(rib, &prefix, depth, NULL,
+		RTE_RIB6_GET_NXT_ALL, nodes, RTE_DIM(nodes));
+	RTE_TEST_ASSERT(ret == 0, "Walk on empty RIB returned nodes\n");
+
+	for (i = 0; i < NUM_ROUTES; i++) {
+		hash = (uint32_t)i * 2654435761U;
+		memcpy(&ip.a[2], &hash, sizeof(hash));
+		/* a quarter of the routes are outside of the walked prefix */
+		ip.a[0] = (i % 4 != 0) ? 0x20 : hash >> 24;
+		node = rte_rib6_insert(rib, &ip, 17 + i % 32);
+		RTE_TEST_ASSERT((node != NULL) || (rte_errno == EEXIST),
+			"Failed to insert rule\n");
+	}
+
+	node = NULL;
+	do {
+		ret = rte_rib6_get_nxt_bulk(rib, &prefix, depth, node,
+			RTE_RIB6_GET_NXT_ALL, nodes, RTE_DIM(nodes));
+		RTE_TEST_ASSERT((ret >= 0) && (ret <= (int)RTE_DIM(nodes)),
+			"Failed to walk the RIB\n");
+		for (i = 0; i < ret; i++, num++) {
+			node = rte_rib6_get_nxt(rib, &prefix, depth, node,
+				RTE_RIB6_GET_NXT_ALL);
+			RTE_TEST_ASSERT(node == nodes[i],
+				"Bulk walk returned wrong node\n");
+		}
+	} while (ret == (int)RTE_DIM(nodes));
+
+	node = rte_rib6_get_nxt(rib, &prefix, depth, node,
+		RTE_RIB6_GET_NXT_ALL);
+	RTE_TEST_ASSERT((node == NULL) && (num != 0),
+		"Bulk walk stopped early\n");
+
+	rte_rib6_free(rib);
+
+	return TEST_SUCCESS;
+}
+
+/*
+ * Check that routes, next hops and extensions survive the compaction
+ * of a RIB with removed routes
+ */
+int32_t
+test_compact(void)
+{
+	struct rte_rib6 *rib = NULL;
+	struct rte_rib6_node *node;
+	struct rte_rib6_conf config;
+	struct rte_ipv6_addr ip, ip_ret;
+	struct rte_ipv6_addr *ext;
+	uint64_t next_hop_return;
+	uint8_t depth;
+	int i, ret, num = 0;
+
+	config.max_nodes = MAX_RULES;
+	config.ext_sz = sizeof(struct rte_ipv6_addr);
+
+	ret = rte_rib6_compact(NULL);
+	RTE_TEST_ASSERT(ret == -EINVAL, "Call succeeded with invalid params\n");
+
+	rib = rte_rib6_create(__func__, SOCKET_ID_ANY, &config);
+	RTE_TEST_ASSERT(rib != NULL, "Failed to create RIB\n");
+
+	ret = rte_rib6_compact(rib);
+	RTE_TEST_ASSERT(ret == 0, "Failed to compact empty RIB\n");
+
+	for (i = 0; i < NUM_ROUTES; i++) {
+		ip = (struct rte_ipv6_addr)RTE_IPV6(0x2001, 0xdb8, i,
+			0, 0, 0, 0, 0);
+		node = rte_rib6_insert(rib, &ip, 48 + i % 8);
+		RTE_TEST_ASSERT(node != NULL, "Failed to insert rule\n");
+		rte_rib6_set_nh(node, i);
+		ext = rte_rib6_get_ext(node);
+		*ext = ip;
+	}
+	for (i = 0; i < NUM_ROUTES; i += 2) {
+		ip = (struct rte_ipv6_addr)RTE_IPV6(0x2001, 0xdb8, i,
+			0, 0, 0, 0, 0);
+		rte_rib6_remove(rib, &ip, 48 + i % 8);
+	}
+
+	ret = rte_rib6_compact(rib);
+	RTE_TEST_ASSERT(ret == 0, "Failed to compact RIB\n");
+
+	for (i = 0; i < NUM_ROUTES; i++) {
+		ip = (struct rte_ipv6_addr)RTE_IPV6(0x2001, 0xdb8, i,
+			0, 0, 0, 0, 0);
+		node = rte_rib6_lookup_exact(rib, &ip, 48 + i % 8);
+		if (i % 2 == 0) {
+			RTE_TEST_ASSERT(node == NULL,
+				"Lookup returns non existent rule\n");
+			continue;
+		}
+		RTE_TEST_ASSERT(node != NULL, "Failed to lookup\n");
+		ret = rte_rib6_get_nh(node, &next_hop_return);
+		RTE_TEST_ASSERT((ret == 0) && (next_hop_return == (uint64_t)i),
+			"Failed to get proper nexthop\n");
+		ext = rte_rib6_get_ext(node);
+		RTE_TEST_ASSERT(rte_ipv6_addr_eq(ext, &ip),
+			"Extension not preserved\n");
+	}
+
+	node = NULL;
+	while ((node = rte_rib6_get_nxt(rib, &ip, 0, node,
+			RTE_RIB6_GET_NXT_ALL)) != NULL) {
+		rte_rib6_get_ip(node, &ip_ret);
+		rte_rib6_get_depth(node, &depth);
+		RTE_TEST_ASSERT(rte_rib6_lookup_exact(rib, &ip_ret, depth) == node,
+			"Walk returned unknown node\n");
+		num++;
+	}
+	RTE_TEST_ASSERT(num == NUM_ROUTES / 2,
+		"Walk returned wrong number of routes\n");
+
+	/* the RIB keeps working after a compaction */
+	for (i = 0; i < NUM_ROUTES; i += 2) {
+		ip = (struct rte_ipv6_addr)RTE_IPV6(0x2001, 0xdb8, i,
+			0, 0, 0, 0, 0);
+		node = rte_rib6_insert(rib, &ip, 48 + i % 8);
+		RTE_TEST_ASSERT(node != NULL, "Failed to insert rule\n");
+	}
+	for (i = 0; i < NUM_ROUTES; i++) {
+		ip = (struct rte_ipv6_addr)RTE_IPV6(0x2001, 0xdb8, i,
+			0, 0, 0, 0, 0);
+		rte_rib6_remove(rib, &ip, 48 + i % 8);
+	}
+
+	node = rte_rib6_get_nxt(rib, &ip, 0, NULL, RTE_RIB6_GET_NXT_ALL);
+	RTE_TEST_ASSERT(node == NULL, "RIB not empty\n");
+	ret = rte_rib6_compact(rib);
+	RTE_TEST_ASSERT(ret == 0, "Failed to compact empty RIB\n");
+
+	rte_rib6_free(rib);
+
+	return TEST_SUCCESS;
+}
+
 static struct unit_test_suite rib6_tests = {
 	.suite_name = "rib6 autotest",
 	.setup = NULL,
@@ -333,6 +511,8 @@ static struct unit_test_suite rib6_tests = {
 		TEST_CASE(test_get_fn),
 		TEST_CASE(test_basic),
 		TEST_CASE(test_tree_traversal),
+		TEST_CASE(test_bulk_traversal),
+		TEST_CASE(test_compact),
 		TEST_CASES_END()
 	}
 };
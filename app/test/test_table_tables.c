@@ -6,6 +6,7 @@
 
 #include <string.h>
 #include <rte_byteorder.h>
+#include <rte_lpm.h>
 #include <rte_table_lpm_ipv6.h>
 #include <rte_lru.h>
 #include <rte_cycles.h>
@@ -447,6 +448,12 @@ test_table_lpm(void)
 
 	status = rte_table_lpm_ops.f_free(table);
 
+	/* Versioned LPM needs RCU, which the table cannot attach */
+	lpm_params.flags = RTE_LPM_F_VERSIONED;
+	table = rte_table_lpm_ops.f_create(&lpm_params, 0, entry_size);
+	if (table != NULL)
+		return -24;
+
 	return 0;
 }
 
@@ -5,6 +5,7 @@
 
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 #include <rte_debug.h>
 #include <rte_malloc.h>
@@ -22,6 +23,12 @@
 
 #endif /* CC_DIR24_8_AVX512_SUPPORT */
 
+#ifdef CC_DIR24_8_AVX2_SUPPORT
+
+#include "dir24_8_avx2.h"
+
+#endif /* CC_DIR24_8_AVX2_SUPPORT */
+
 #define DIR24_8_NAMESIZE	64
 
 #define ROUNDUP(x, y)	 RTE_ALIGN_CEIL(x, (1 << (32 - y)))
@@ -95,6 +102,37 @@ get_vector_fn(enum rte_fib_dir24_8_nh_sz nh_sz, bool be_addr)
 	return NULL;
 }
 
+static inline rte_fib_lookup_fn_t
+get_avx2_fn(enum rte_fib_dir24_8_nh_sz nh_sz, bool be_addr)
+{
+#ifdef CC_DIR24_8_AVX2_SUPPORT
+	if (rte_cpu_get_flag_enabled(RTE_CPUFLAG_AVX2) <= 0 ||
+			rte_vect_get_max_simd_bitwidth() < RTE_VECT_SIMD_256)
+		return NULL;
+
+	switch (nh_sz) {
+	case RTE_FIB_DIR24_8_1B:
+		return be_addr ? rte_dir24_8_avx2_lookup_bulk_1b_be :
+			rte_dir24_8_avx2_lookup_bulk_1b;
+	case RTE_FIB_DIR24_8_2B:
+		return be_addr ? rte_dir24_8_avx2_lookup_bulk_2b_be :
+			rte_dir24_8_avx2_lookup_bulk_2b;
+	case RTE_FIB_DIR24_8_4B:
+		return be_addr ? rte_dir24_8_avx2_lookup_bulk_4b_be :
+			rte_dir24_8_avx2_lookup_bulk_4b;
+	case RTE_FIB_DIR24_8_8B:
+		return be_addr ? rte_dir24_8_avx2_lookup_bulk_8b_be :
+			rte_dir24_8_avx2_lookup_bulk_8b;
+	default:
+		return NULL;
+	}
+#else
+	RTE_SET_USED(nh_sz);
+	RTE_SET_USED(be_addr);
+#endif
+	return NULL;
+}
+
 rte_fib_lookup_fn_t
 dir24_8_get_lookup_fn(void *p, enum rte_fib_lookup_type type, bool be_addr)
 {
@@ -116,8 +154,13 @@ dir24_8_get_lookup_fn(void *p, enum rte_fib_lookup_type type, bool be_addr)
 		return be_addr ? dir24_8_lookup_bulk_uni_be : dir24_8_lookup_bulk_uni;
 	case RTE_FIB_LOOKUP_DIR24_8_VECTOR_AVX512:
 		return get_vector_fn(nh_sz, be_addr);
+	case RTE_FIB_LOOKUP_DIR24_8_VECTOR_AVX2:
+		return get_avx2_fn(nh_sz, be_addr);
 	case RTE_FIB_LOOKUP_DEFAULT:
 		ret_fn = get_vector_fn(nh_sz, be_addr);
+		/* AVX2 gathers are only faster than scalar for 1 byte entries */
+		if (ret_fn == NULL && nh_sz == RTE_FIB_DIR24_8_1B)
+			ret_fn = get_avx2_fn(nh_sz, be_addr);
 		return ret_fn != NULL ? ret_fn : get_scalar_fn(nh_sz, be_addr);
 	default:
 		return NULL;
@@ -533,6 +576,181 @@ dir24_8_modify(struct rte_fib *fib, uint32_t ip, uint8_t depth,
 	return -EINVAL;
 }
 
+/* Route changed by a bulk add, the next hop is taken from the RIB node. */
+struct dir24_8_bulk_route {
+	uint32_t		ip;
+	uint8_t			depth;
+	struct rte_rib_node	*node;
+};
+
+static int
+bulk_route_cmp(const void *a, const void *b)
+{
+	const struct dir24_8_bulk_route *ra = a;
+	const struct dir24_8_bulk_route *rb = b;
+
+	if (ra->ip != rb->ip)
+		return (ra->ip < rb->ip) ? -1 : 1;
+	return (int)ra->depth - (int)rb->depth;
+}
+
+/*
+ * Build the dataplane of an empty FIB from sorted routes in one pass.
+ * Prefixes either nest or do not overlap, so a stack of the open ones
+ * gives the next hop of every range between two route edges, and each
+ * address is written exactly once.
+ */
+static int
+install_sorted(struct dir24_8_tbl *dp,
+	const struct dir24_8_bulk_route *routes, unsigned int num)
+{
+	struct {
+		uint64_t	end;
+		uint64_t	nh;
+	} stack[RTE_FIB_MAXDEPTH + 1];
+	uint64_t start, pos = 0;
+	unsigned int i, top = 0;
+	int ret;
+
+	for (i = 0; i < num; i++) {
+		if ((i != 0) && (routes[i].ip == routes[i - 1].ip) &&
+				(routes[i].depth == routes[i - 1].depth))
+			continue;
+		start = routes[i].ip;
+		/* close the prefixes ending before this one */
+		while ((top != 0) && (stack[top - 1].end <= start)) {
+			top--;
+			if (pos != stack[top].end) {
+				ret = install_to_fib(dp, pos,
+					stack[top].end, stack[top].nh);
+				if (ret != 0)
+					return ret;
+			}
+			pos = stack[top].end;
+		}
+		if ((top != 0) && (pos != start)) {
+			ret = install_to_fib(dp, pos, start,
+				stack[top - 1].nh);
+			if (ret != 0)
+				return ret;
+		}
+		stack[top].end = start + (1ULL << (32 - routes[i].depth));
+		rte_rib_get_nh(routes[i].node, &stack[top].nh);
+		top++;
+		pos = start;
+	}
+	while (top != 0) {
+		top--;
+		if (pos != stack[top].end) {
+			ret = install_to_fib(dp, pos, stack[top].end,
+				stack[top].nh);
+			if (ret != 0)
+				return ret;
+		}
+		pos = stack[top].end;
+	}
+
+	return 0;
+}
+
+int
+dir24_8_add_bulk(struct rte_fib *fib, const uint32_t *ips,
+	const uint8_t *depths, const uint64_t *next_hops, unsigned int n)
+{
+	struct dir24_8_bulk_route *routes;
+	struct dir24_8_tbl *dp;
+	struct rte_rib *rib;
+	struct rte_rib_node *tmp;
+	struct rte_rib_node *node;
+	uint64_t node_nh;
+	unsigned int i, added, num = 0;
+	uint32_t ip;
+	uint8_t depth;
+	bool empty, sorted = true;
+	int ret = 0;
+
+	if (n == 0)
+		return 0;
+
+	dp = rte_fib_get_dp(fib);
+	rib = rte_fib_get_rib(fib);
+	RTE_ASSERT((dp != NULL) && (rib != NULL));
+
+	routes = rte_malloc(NULL, n * sizeof(*routes), 0);
+	if (routes == NULL)
+		return -ENOMEM;
+
+	/* Nothing but the new routes to write, no RIB walk is needed */
+	empty = (rte_rib_lookup_exact(rib, 0, 0) == NULL) &&
+		(rte_rib_get_nxt(rib, 0, 0, NULL,
+		RTE_RIB_GET_NXT_ALL) == NULL);
+
+	/*
+	 * Put all the routes into the RIB first, so that each prefix
+	 * written below already sees all its more specifics and only
+	 * fills the gaps between them.
+	 */
+	for (added = 0; added < n; added++) {
+		depth = depths[added];
+		if ((depth > RTE_FIB_MAXDEPTH) ||
+				(next_hops[added] > get_max_nh(dp->nh_sz)))
+			break;
+
+		ip = ips[added] & rte_rib_depth_to_mask(depth);
+		node = rte_rib_lookup_exact(rib, ip, depth);
+		if (node != NULL) {
+			rte_rib_get_nh(node, &node_nh);
+			if (node_nh == next_hops[added])
+				continue;
+		} else {
+			tmp = NULL;
+			if (depth > 24) {
+				tmp = rte_rib_get_nxt(rib, ip, 24, NULL,
+					RTE_RIB_GET_NXT_COVER);
+				if ((tmp == NULL) &&
+						(dp->rsvd_tbl8s >= dp->number_tbl8s))
+					break;
+			}
+			node = rte_rib_insert(rib, ip, depth);
+			if (node == NULL)
+				break;
+			if ((depth > 24) && (tmp == NULL))
+				dp->rsvd_tbl8s++;
+		}
+		rte_rib_set_nh(node, next_hops[added]);
+		routes[num].ip = ip;
+		routes[num].depth = depth;
+		routes[num].node = node;
+		/* tables are usually dumped in order already */
+		if ((num != 0) && sorted)
+			sorted = bulk_route_cmp(&routes[num - 1],
+				&routes[num]) <= 0;
+		num++;
+	}
+
+	/* Write every changed prefix once, in address order. */
+	if (!sorted)
+		qsort(routes, num, sizeof(*routes), bulk_route_cmp);
+	if (empty) {
+		ret = install_sorted(dp, routes, num);
+		num = 0;
+	}
+	for (i = 0; i < num; i++) {
+		if ((i != 0) && (routes[i].ip == routes[i - 1].ip) &&
+				(routes[i].depth == routes[i - 1].depth))
+			continue;
+		rte_rib_get_nh(routes[i].node, &node_nh);
+		ret = modify_fib(dp, rib, routes[i].ip, routes[i].depth,
+			node_nh);
+		if (ret != 0)
+			break;
+	}
+
+	rte_free(routes);
+
+	return (ret != 0) ? ret : (int)added;
+}
+
 void *
 dir24_8_create(const char *name, int socket_id, struct rte_fib_conf *fib_conf)
 {
@@ -0,0 +1,199 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2020 Intel Corporation
+ */
+
+#include <rte_vect.h>
+#include <rte_fib.h>
+
+#include "dir24_8.h"
+#include "dir24_8_avx2.h"
+
+static __rte_always_inline __m256i
+dir24_8_avx2_load_ips(const uint32_t *ips, bool be_addr)
+{
+	const __m256i bswap32 = _mm256_set_epi8(
+		12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3,
+		12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3
+	);
+	__m256i ip_vec;
+
+	ip_vec = _mm256_loadu_si256((const void *)ips);
+	if (be_addr)
+		ip_vec = _mm256_shuffle_epi8(ip_vec, bswap32);
+
+	return ip_vec;
+}
+
+/*
+ * Gather one entry per 32-bit lane. Narrow entries are read as 32 bits
+ * and masked, the tables are padded to make it safe for the last ones.
+ */
+static __rte_always_inline __m256i
+dir24_8_avx2_gather(const void *tbl, __m256i src, __m256i idxes,
+	__m256i msk, int size)
+{
+	__m256i res;
+
+	/* Put it inside branch to make compiler happy with -O0 */
+	if (size == sizeof(uint8_t)) {
+		res = _mm256_mask_i32gather_epi32(src, tbl, idxes, msk, 1);
+		res = _mm256_and_si256(res, _mm256_set1_epi32(UINT8_MAX));
+	} else if (size == sizeof(uint16_t)) {
+		res = _mm256_mask_i32gather_epi32(src, tbl, idxes, msk, 2);
+		res = _mm256_and_si256(res, _mm256_set1_epi32(UINT16_MAX));
+	} else
+		res = _mm256_mask_i32gather_epi32(src, tbl, idxes, msk, 4);
+
+	return res;
+}
+
+static __rte_always_inline void
+dir24_8_avx2_store(uint64_t *next_hops, __m256i res)
+{
+	res = _mm256_srli_epi32(res, 1);
+	_mm256_storeu_si256((void *)next_hops,
+		_mm256_cvtepu32_epi64(_mm256_castsi256_si128(res)));
+	_mm256_storeu_si256((void *)(next_hops + 4),
+		_mm256_cvtepu32_epi64(_mm256_extracti128_si256(res, 1)));
+}
+
+/*
+ * Two independent sets of 8 lookups are interleaved, so that the latency
+ * of one gather is hidden behind the other.
+ */
+static __rte_always_inline void
+dir24_8_avx2_lookup_x8x2(void *p, const uint32_t *ips,
+	uint64_t *next_hops, int size, bool be_addr)
+{
+	struct dir24_8_tbl *dp = (struct dir24_8_tbl *)p;
+	const __m256i all = _mm256_set1_epi32(-1);
+	const __m256i lsb = _mm256_set1_epi32(1);
+	const __m256i lsbyte_msk = _mm256_set1_epi32(0xff);
+	__m256i ip_1, ip_2, idxes_1, idxes_2, res_1, res_2;
+	__m256i msk_ext_1, msk_ext_2;
+
+	ip_1 = dir24_8_avx2_load_ips(ips, be_addr);
+	ip_2 = dir24_8_avx2_load_ips(ips + 8, be_addr);
+
+	/* mask 24 most significant bits */
+	idxes_1 = _mm256_srli_epi32(ip_1, 8);
+	idxes_2 = _mm256_srli_epi32(ip_2, 8);
+
+	/* lookup in tbl24 */
+	res_1 = dir24_8_avx2_gather(dp->tbl24, _mm256_setzero_si256(),
+		idxes_1, all, size);
+	res_2 = dir24_8_avx2_gather(dp->tbl24, _mm256_setzero_si256(),
+		idxes_2, all, size);
+
+	/* get extended entries */
+	msk_ext_1 = _mm256_cmpeq_epi32(_mm256_and_si256(res_1, lsb), lsb);
+	msk_ext_2 = _mm256_cmpeq_epi32(_mm256_and_si256(res_2, lsb), lsb);
+
+	if (!_mm256_testz_si256(_mm256_or_si256(msk_ext_1, msk_ext_2),
+			all)) {
+		idxes_1 = _mm256_slli_epi32(_mm256_srli_epi32(res_1, 1), 8);
+		idxes_2 = _mm256_slli_epi32(_mm256_srli_epi32(res_2, 1), 8);
+		idxes_1 = _mm256_add_epi32(idxes_1,
+			_mm256_and_si256(ip_1, lsbyte_msk));
+		idxes_2 = _mm256_add_epi32(idxes_2,
+			_mm256_and_si256(ip_2, lsbyte_msk));
+		/* lanes out of the mask keep their tbl24 entry */
+		res_1 = dir24_8_avx2_gather(dp->tbl8, res_1, idxes_1,
+			msk_ext_1, size);
+		res_2 = dir24_8_avx2_gather(dp->tbl8, res_2, idxes_2,
+			msk_ext_2, size);
+	}
+
+	dir24_8_avx2_store(next_hops, res_1);
+	dir24_8_avx2_store(next_hops + 8, res_2);
+}
+
+static __rte_always_inline void
+dir24_8_avx2_lookup_x4x2_8b(void *p, const uint32_t *ips,
+	uint64_t *next_hops, bool be_addr)
+{
+	struct dir24_8_tbl *dp = (struct dir24_8_tbl *)p;
+	const __m256i all = _mm256_set1_epi64x(-1);
+	const __m256i lsb = _mm256_set1_epi64x(1);
+	const __m256i lsbyte_msk = _mm256_set1_epi64x(0xff);
+	__m256i ip_vec, bytes_1, bytes_2, idxes_1, idxes_2, res_1, res_2;
+	__m256i msk_ext_1, msk_ext_2;
+	__m128i ip_1, ip_2;
+
+	ip_vec = dir24_8_avx2_load_ips(ips, be_addr);
+	ip_1 = _mm256_castsi256_si128(ip_vec);
+	ip_2 = _mm256_extracti128_si256(ip_vec, 1);
+
+	/* lookup in tbl24 */
+	res_1 = _mm256_i32gather_epi64((const void *)dp->tbl24,
+		_mm_srli_epi32(ip_1, 8), 8);
+	res_2 = _mm256_i32gather_epi64((const void *)dp->tbl24,
+		_mm_srli_epi32(ip_2, 8), 8);
+
+	/* get extended entries */
+	msk_ext_1 = _mm256_cmpeq_epi64(_mm256_and_si256(res_1, lsb), lsb);
+	msk_ext_2 = _mm256_cmpeq_epi64(_mm256_and_si256(res_2, lsb), lsb);
+
+	if (!_mm256_testz_si256(_mm256_or_si256(msk_ext_1, msk_ext_2),
+			all)) {
+		bytes_1 = _mm256_and_si256(_mm256_cvtepu32_epi64(ip_1),
+			lsbyte_msk);
+		bytes_2 = _mm256_and_si256(_mm256_cvtepu32_epi64(ip_2),
+			lsbyte_msk);
+		idxes_1 = _mm256_slli_epi64(_mm256_srli_epi64(res_1, 1), 8);
+		idxes_2 = _mm256_slli_epi64(_mm256_srli_epi64(res_2, 1), 8);
+		idxes_1 = _mm256_add_epi64(idxes_1, bytes_1);
+		idxes_2 = _mm256_add_epi64(idxes_2, bytes_2);
+		/* lanes out of the mask keep their tbl24 entry */
+		res_1 = _mm256_mask_i64gather_epi64(res_1,
+			(const void *)dp->tbl8, idxes_1, msk_ext_1, 8);
+		res_2 = _mm256_mask_i64gather_epi64(res_2,
+			(const void *)dp->tbl8, idxes_2, msk_ext_2, 8);
+	}
+
+	_mm256_storeu_si256((void *)next_hops, _mm256_srli_epi64(res_1, 1));
+	_mm256_storeu_si256((void *)(next_hops + 4),
+		_mm256_srli_epi64(res_2, 1));
+}
+
+#define DECLARE_AVX2_FN(suffix, nh_type, be_addr) \
+void \
+rte_dir24_8_avx2_lookup_bulk_##suffix(void *p, const uint32_t *ips, uint64_t *next_hops, \
+	const unsigned int n) \
+{ \
+	uint32_t i; \
+	for (i = 0; i < (n / 16); i++) \
+		dir24_8_avx2_lookup_x8x2(p, ips + i * 16, next_hops + i * 16, \
+			sizeof(nh_type), be_addr); \
+	dir24_8_lookup_bulk_##suffix(p, ips + i * 16, next_hops + i * 16, n - i * 16); \
+}
+
+DECLARE_AVX2_FN(1b, uint8_t, false)
+DECLARE_AVX2_FN(1b_be, uint8_t, true)
+DECLARE_AVX2_FN(2b, uint16_t, false)
+DECLARE_AVX2_FN(2b_be, uint16_t, true)
+DECLARE_AVX2_FN(4b, uint32_t, false)
+DECLARE_AVX2_FN(4b_be, uint32_t, true)
+
+void
+rte_dir24_8_avx2_lookup_bulk_8b(void *p, const uint32_t *ips,
+	uint64_t *next_hops, const unsigned int n)
+{
+	uint32_t i;
+	for (i = 0; i < (n / 8); i++)
+		dir24_8_avx2_lookup_x4x2_8b(p, ips + i * 8, next_hops + i * 8,
+			false);
+	dir24_8_lookup_bulk_8b(p, ips + i * 8, next_hops + i * 8, n - i * 8);
+}
+
+void
+rte_dir24_8_avx2_lookup_bulk_8b_be(void *p, const uint32_t *ips,
+	uint64_t *next_hops, const unsigned int n)
+{
+	uint32_t i;
+	for (i = 0; i < (n / 8); i++)
+		dir24_8_avx2_lookup_x4x2_8b(p, ips + i * 8, next_hops + i * 8,
+			true);
+	dir24_8_lookup_bulk_8b_be(p, ips + i * 8, next_hops + i * 8,
+		n - i * 8);
+}
@@ -0,0 +1,177 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2026 agent <agent@local>
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <rte_bitops.h>
+#include <rte_errno.h>
+#include <rte_malloc.h>
+#include <rte_stdatomic.h>
+
+#include "nh_group.h"
+#include "fib_log.h"
+
+#define NH_GROUP_NAMESIZE	64
+
+/* Member of the group being set, sorted by next hop to find it by bucket */
+struct nh_group_member {
+	uint64_t	nh;
+	uint32_t	quota;	/**< Number of buckets it should get */
+	uint32_t	cnt;	/**< Number of buckets it got */
+};
+
+static int
+member_cmp(const void *a, const void *b)
+{
+	const struct nh_group_member *ma = a;
+	const struct nh_group_member *mb = b;
+
+	if (ma->nh != mb->nh)
+		return (ma->nh < mb->nh) ? -1 : 1;
+	return 0;
+}
+
+static struct nh_group_member *
+find_member(struct nh_group_member *members, unsigned int n, uint64_t nh)
+{
+	struct nh_group_member key = { .nh = nh };
+
+	return bsearch(&key, members, n, sizeof(*members), member_cmp);
+}
+
+/* Lookups may read the bucket meanwhile, so it is written in one store */
+static inline void
+bucket_set(uint64_t *bucket, uint64_t nh)
+{
+	rte_atomic_store_explicit((uint64_t __rte_atomic *)bucket, nh,
+		rte_memory_order_release);
+}
+
+int
+nh_group_set(struct nh_group_tbl *tbl, uint32_t grp,
+	const uint64_t *next_hops, const uint32_t *weights, unsigned int n)
+{
+	struct nh_group_member *members, *m;
+	uint64_t *buckets;
+	uint64_t total = 0, cur = 0, w;
+	uint32_t *moved;
+	uint32_t i, k, num_moved = 0, prev = 0, next;
+	uint32_t num_buckets = tbl->bucket_msk + 1;
+
+	if ((grp >= tbl->num_groups) || (n > num_buckets) ||
+			((n != 0) && (next_hops == NULL)))
+		return -EINVAL;
+
+	buckets = &tbl->buckets[(uint64_t)grp << tbl->bucket_shift];
+	if (n == 0) {
+		for (i = 0; i < num_buckets; i++)
+			bucket_set(&buckets[i], tbl->def_nh);
+		return 0;
+	}
+
+	for (i = 0; i < n; i++) {
+		w = (weights == NULL) ? 1 : weights[i];
+		if ((next_hops[i] > tbl->max_nh) || (w == 0))
+			return -EINVAL;
+		total += w;
+	}
+	/* the running sum is scaled by the number of buckets below */
+	if (total > UINT64_MAX / num_buckets)
+		return -EINVAL;
+
+	members = rte_malloc(NULL, n * sizeof(*members) +
+		num_buckets * sizeof(*moved), 0);
+	if (members == NULL)
+		return -ENOMEM;
+	moved = (uint32_t *)&members[n];
+
+	/*
+	 * Shares are rounded on the running sum of the weights, so that they
+	 * add up to the number of buckets and are each off by less than one.
+	 */
+	for (i = 0; i < n; i++) {
+		cur += (weights == NULL) ? 1 : weights[i];
+		next = cur * num_buckets / total;
+		members[i].nh = next_hops[i];
+		members[i].quota = next - prev;
+		members[i].cnt = 0;
+		prev = next;
+	}
+
+	qsort(members, n, sizeof(*members), member_cmp);
+	for (i = 1; i < n; i++) {
+		if (members[i].nh == members[i - 1].nh) {
+			rte_free(members);
+			return -EINVAL;
+		}
+	}
+
+	/* buckets keep their member as long as it is within its share */
+	for (i = 0; i < num_buckets; i++) {
+		m = find_member(members, n, buckets[i]);
+		if ((m != NULL) && (m->cnt < m->quota))
+			m->cnt++;
+		else
+			moved[num_moved++] = i;
+	}
+
+	for (i = 0, k = 0; i < num_moved; i++) {
+		while (members[k].cnt == members[k].quota)
+			k++;
+		bucket_set(&buckets[moved[i]], members[k].nh);
+		members[k].cnt++;
+	}
+
+	rte_free(members);
+
+	return 0;
+}
+
+struct nh_group_tbl *
+nh_group_create(const char *name, int socket_id, uint32_t num_groups,
+	uint32_t num_buckets, uint64_t max_nh, uint64_t def_nh)
+{
+	char mem_name[NH_GROUP_NAMESIZE];
+	struct nh_group_tbl *tbl;
+	uint64_t grp_flag = (max_nh >> 1) + 1;
+	uint64_t i, num;
+
+	/* groups take the top bit of the next hop, members the others */
+	if ((num_groups == 0) || (num_groups > grp_flag) ||
+			!rte_is_power_of_2(num_buckets) ||
+			(num_buckets > NH_GROUP_MAX_BUCKETS) ||
+			(def_nh & grp_flag)) {
+		rte_errno = EINVAL;
+		return NULL;
+	}
+
+	num = (uint64_t)num_groups * num_buckets;
+	snprintf(mem_name, sizeof(mem_name), "NHGRP_%s", name);
+	tbl = rte_malloc_socket(mem_name, sizeof(struct nh_group_tbl) +
+		num * sizeof(uint64_t), RTE_CACHE_LINE_SIZE, socket_id);
+	if (tbl == NULL) {
+		FIB_LOG(ERR, "Can not allocate next hop groups for %s", name);
+		rte_errno = ENOMEM;
+		return NULL;
+	}
+
+	tbl->grp_flag = grp_flag;
+	tbl->max_nh = grp_flag - 1;
+	tbl->def_nh = def_nh;
+	tbl->num_groups = num_groups;
+	tbl->bucket_shift = rte_log2_u32(num_buckets);
+	tbl->bucket_msk = num_buckets - 1;
+	for (i = 0; i < num; i++)
+		tbl->buckets[i] = def_nh;
+
+	return tbl;
+}
+
+void
+nh_group_free(struct nh_group_tbl *tbl)
+{
+	rte_free(tbl);
+}
@@ -0,0 +1,83 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2026 agent <agent@local>
+ */
+
+#ifndef _NH_GROUP_H_
+#define _NH_GROUP_H_
+
+#include <stdalign.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <rte_common.h>
+
+/**
+ * @file
+ * Next hop groups shared by the IPv4 and IPv6 FIB
+ *
+ * A group spreads the traffic of its routes over weighted members. Every
+ * group has the same power of two number of buckets, each holding one
+ * member, and a packet hash selects the bucket. A member gets a share of
+ * the buckets proportional to its weight, and changing the members only
+ * moves the buckets which have to change hands, so that the flows of the
+ * other members keep their next hop.
+ */
+
+/* @internal Maximum number of buckets per group. */
+#define NH_GROUP_MAX_BUCKETS	(1 << 16)
+
+struct nh_group_tbl {
+	uint64_t	grp_flag;	/**< Next hop bit marking a group */
+	uint64_t	max_nh;		/**< Maximum member next hop */
+	uint64_t	def_nh;		/**< Next hop of empty groups */
+	uint32_t	num_groups;	/**< Number of groups */
+	uint32_t	bucket_shift;	/**< Log2 of buckets per group */
+	uint32_t	bucket_msk;	/**< Buckets per group - 1 */
+	/* Member of every bucket, group after group. */
+	alignas(RTE_CACHE_LINE_SIZE) uint64_t	buckets[];
+};
+
+/* Check that nh is either a plain next hop or references an existing group */
+static inline bool
+nh_group_check_nh(const struct nh_group_tbl *tbl, uint64_t nh)
+{
+	return !(nh & tbl->grp_flag) ||
+		((nh & ~tbl->grp_flag) < tbl->num_groups);
+}
+
+/*
+ * Replace the group references among next_hops by the member of the bucket
+ * given by the hash of the same index. The table fields are read once, as
+ * the stores to next_hops could otherwise alias them.
+ */
+static inline void
+nh_group_resolve_bulk(const struct nh_group_tbl *tbl, const uint32_t *hashes,
+	uint64_t *next_hops, unsigned int n)
+{
+	const uint64_t *buckets = tbl->buckets;
+	const uint64_t grp_flag = tbl->grp_flag;
+	const uint32_t shift = tbl->bucket_shift;
+	const uint32_t msk = tbl->bucket_msk;
+	uint64_t nh;
+	unsigned int i;
+
+	for (i = 0; i < n; i++) {
+		nh = next_hops[i];
+		if (nh & grp_flag)
+			next_hops[i] = buckets[((nh & ~grp_flag) << shift) +
+				(hashes[i] & msk)];
+	}
+}
+
+struct nh_group_tbl *
+nh_group_create(const char *name, int socket_id, uint32_t num_groups,
+	uint32_t num_buckets, uint64_t max_nh, uint64_t def_nh);
+
+void
+nh_group_free(struct nh_group_tbl *tbl);
+
+int
+nh_group_set(struct nh_group_tbl *tbl, uint32_t grp,
+	const uint64_t *next_hops, const uint32_t *weights, unsigned int n);
+
+#endif /* _NH_GROUP_H_ */
@@ -0,0 +1,914 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2026 agent <agent@local>
+ */
+
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <rte_debug.h>
+#include <rte_malloc.h>
+#include <rte_errno.h>
+#include <rte_stdatomic.h>
+#include <rte_rcu_qsbr.h>
+
+#include <rte_rib6.h>
+#include <rte_fib6.h>
+#include "poptrie.h"
+#include "fib_log.h"
+
+#define POPTRIE_NAMESIZE	64
+#define POPTRIE_POOL_END	UINT32_MAX
+#define POPTRIE_ROUTES_MIN	64U
+/* Number of RIB nodes fetched at once when collecting routes */
+#define POPTRIE_WALK_BULK	32
+/* Maximum number of nodes on the way to a next hop */
+#define POPTRIE_MAX_LEVELS	((RTE_IPV6_MAX_DEPTH - POPTRIE_DIRECT_BITS + \
+	POPTRIE_STRIDE - 1) / POPTRIE_STRIDE)
+
+static inline rte_fib6_lookup_fn_t
+get_scalar_fn(enum rte_fib_trie_nh_sz nh_sz)
+{
+	switch (nh_sz) {
+	case RTE_FIB6_TRIE_2B:
+		return rte_poptrie_lookup_bulk_2b;
+	case RTE_FIB6_TRIE_4B:
+		return rte_poptrie_lookup_bulk_4b;
+	case RTE_FIB6_TRIE_8B:
+		return rte_poptrie_lookup_bulk_8b;
+	default:
+		return NULL;
+	}
+}
+
+rte_fib6_lookup_fn_t
+poptrie_get_lookup_fn(void *p, enum rte_fib6_lookup_type type)
+{
+	struct rte_poptrie_tbl *dp = p;
+
+	if (dp == NULL)
+		return NULL;
+
+	switch (type) {
+	case RTE_FIB6_LOOKUP_POPTRIE_SCALAR:
+	case RTE_FIB6_LOOKUP_DEFAULT:
+		return get_scalar_fn(dp->nh_sz);
+	default:
+		return NULL;
+	}
+	return NULL;
+}
+
+static void
+write_leaf(struct rte_poptrie_tbl *dp, uint32_t idx, uint64_t val)
+{
+	switch (dp->nh_sz) {
+	case RTE_FIB6_TRIE_2B:
+		((uint16_t *)dp->leaves)[idx] = (uint16_t)val;
+		break;
+	case RTE_FIB6_TRIE_4B:
+		((uint32_t *)dp->leaves)[idx] = (uint32_t)val;
+		break;
+	case RTE_FIB6_TRIE_8B:
+		((uint64_t *)dp->leaves)[idx] = val;
+		break;
+	}
+}
+
+static int
+pool_init(struct poptrie_pool *pool, const char *name, uint32_t first,
+	uint32_t num, int socket_id)
+{
+	uint32_t i;
+
+	pool->next = rte_malloc_socket(name, sizeof(uint32_t) * num,
+		RTE_CACHE_LINE_SIZE, socket_id);
+	if (pool->next == NULL)
+		return -ENOMEM;
+
+	pool->first = first;
+	pool->num = num;
+	pool->pos = 0;
+	for (i = 0; i < RTE_DIM(pool->free); i++)
+		pool->free[i] = POPTRIE_POOL_END;
+
+	return 0;
+}
+
+/*
+ * Put a block of n entries back to the pool
+ */
+static void
+pool_put(struct poptrie_pool *pool, uint32_t idx, uint32_t n)
+{
+	pool->next[idx - pool->first] = pool->free[n];
+	pool->free[n] = idx;
+}
+
+/*
+ * Get a block of n contiguous entries, from the free blocks of that size
+ * first, then from the never used entries, then by splitting a larger block
+ */
+static int64_t
+pool_get(struct poptrie_pool *pool, uint32_t n)
+{
+	uint32_t idx, sz;
+
+	idx = pool->free[n];
+	if (idx != POPTRIE_POOL_END) {
+		pool->free[n] = pool->next[idx - pool->first];
+		return idx;
+	}
+
+	if (pool->num - pool->pos >= n) {
+		idx = pool->first + pool->pos;
+		pool->pos += n;
+		return idx;
+	}
+
+	for (sz = n + 1; sz < RTE_DIM(pool->free); sz++) {
+		idx = pool->free[sz];
+		if (idx == POPTRIE_POOL_END)
+			continue;
+		pool->free[sz] = pool->next[idx - pool->first];
+		pool_put(pool, idx + n, sz - n);
+		return idx;
+	}
+
+	return -ENOSPC;
+}
+
+/* Block of nodes or leaves waiting in the RCU defer queue */
+struct poptrie_block {
+	uint32_t	idx;
+	uint16_t	num;
+	uint16_t	leaf;
+};
+
+static void
+__rcu_qsbr_free_resource(void *p, void *data, unsigned int n __rte_unused)
+{
+	struct rte_poptrie_tbl *dp = p;
+	struct poptrie_block *blk = data;
+
+	pool_put(blk->leaf ? &dp->leaf_pool : &dp->node_pool, blk->idx,
+		blk->num);
+}
+
+/*
+ * Get a block of n entries, if there is none try to reclaim the blocks
+ * left by previous updates first
+ */
+static int64_t
+block_get(struct rte_poptrie_tbl *dp, struct poptrie_pool *pool, uint32_t n)
+{
+	int64_t idx;
+
+	idx = pool_get(pool, n);
+	if (unlikely(idx == -ENOSPC && dp->dq != NULL &&
+			!rte_rcu_qsbr_dq_reclaim(dp->dq, UINT32_MAX, NULL,
+			NULL, NULL)))
+		idx = pool_get(pool, n);
+
+	return idx;
+}
+
+/*
+ * Free a block which lookups may still be reading. In the defer queue mode
+ * it is put back to the pool once the readers went through a quiescent
+ * state, otherwise at once: the blocking mode already waited for them.
+ */
+static void
+block_retire(struct rte_poptrie_tbl *dp, struct poptrie_pool *pool,
+	uint32_t idx, uint32_t n)
+{
+	struct poptrie_block blk = {
+		.idx = idx,
+		.num = n,
+		.leaf = (pool == &dp->leaf_pool),
+	};
+
+	if (dp->dq != NULL) {
+		if (rte_rcu_qsbr_dq_enqueue(dp->dq, &blk) == 0)
+			return;
+		/* the queue is full, wait for the readers instead */
+		FIB_LOG(DEBUG, "QSBR FIFO full, waiting for readers");
+		rte_rcu_qsbr_synchronize(dp->v, RTE_QSBR_THRID_INVALID);
+	}
+	pool_put(pool, idx, n);
+}
+
+/*
+ * Wait for the readers which may still walk the subtree replaced by an
+ * update, when the blocks are not freed through the defer queue
+ */
+static void
+wait_readers(struct rte_poptrie_tbl *dp)
+{
+	if (dp->v != NULL && dp->rcu_mode == RTE_FIB6_QSBR_MODE_SYNC)
+		rte_rcu_qsbr_synchronize(dp->v, RTE_QSBR_THRID_INVALID);
+}
+
+/*
+ * recursively free the children and the leaves of a node, through the
+ * RCU if the node was visible to lookups
+ */
+static void
+free_node(struct rte_poptrie_tbl *dp, uint32_t idx, bool retire)
+{
+	const struct poptrie_node *node = &dp->nodes[idx];
+	uint32_t nb_child = rte_popcount64(node->vector);
+	uint32_t nb_leaf = rte_popcount64(node->leafvec);
+	uint32_t i;
+
+	for (i = 0; i < nb_child; i++)
+		free_node(dp, node->base1 + i, retire);
+	if (nb_child != 0) {
+		if (retire)
+			block_retire(dp, &dp->node_pool, node->base1, nb_child);
+		else
+			pool_put(&dp->node_pool, node->base1, nb_child);
+	}
+	if (nb_leaf != 0) {
+		if (retire)
+			block_retire(dp, &dp->leaf_pool, node->base0, nb_leaf);
+		else
+			pool_put(&dp->leaf_pool, node->base0, nb_leaf);
+	}
+}
+
+static inline uint32_t
+route_chunk(const struct poptrie_route *route, uint32_t off)
+{
+	return poptrie_get_chunk(route->hi, route->lo, off);
+}
+
+/*
+ * Build the node at idx from the sorted routes more specific than bit off
+ * under its prefix, the entries not covered by any of them get nh.
+ * The children and the leaves are put into new blocks, so that a node
+ * only becomes visible once its whole subtree is complete.
+ */
+static int
+build_node(struct rte_poptrie_tbl *dp, uint32_t idx,
+	const struct poptrie_route *routes, uint32_t num, uint32_t off,
+	uint64_t nh)
+{
+	uint64_t nhs[POPTRIE_NODE_NUM_ENT];
+	uint64_t vector = 0, leafvec = 0;
+	uint64_t prev = nh;
+	uint32_t end = off + POPTRIE_STRIDE;
+	uint32_t i, j, v, nb_child, nb_leaf, built = 0;
+	int64_t base0 = 0, base1 = 0;
+	int ret;
+
+	for (v = 0; v < POPTRIE_NODE_NUM_ENT; v++)
+		nhs[v] = nh;
+
+	/*
+	 * A covering prefix is sorted before the ones it covers,
+	 * so the most specific one ending in this node is written last.
+	 */
+	for (i = 0; i < num; i++) {
+		v = route_chunk(&routes[i], off);
+		if (routes[i].depth > end) {
+			vector |= 1ULL << v;
+			continue;
+		}
+		for (j = 0; j < (1U << (end - routes[i].depth)); j++)
+			nhs[v + j] = routes[i].nh;
+	}
+
+	for (v = 0; v < POPTRIE_NODE_NUM_ENT; v++) {
+		if (vector & (1ULL << v))
+			continue;
+		if ((leafvec == 0) || (nhs[v] != prev)) {
+			leafvec |= 1ULL << v;
+			prev = nhs[v];
+		}
+	}
+
+	nb_child = rte_popcount64(vector);
+	nb_leaf = rte_popcount64(leafvec);
+	if (nb_leaf != 0) {
+		base0 = block_get(dp, &dp->leaf_pool, nb_leaf);
+		if (base0 < 0)
+			return base0;
+	}
+	if (nb_child != 0) {
+		base1 = block_get(dp, &dp->node_pool, nb_child);
+		if (base1 < 0) {
+			ret = base1;
+			goto free_leaves;
+		}
+	}
+
+	for (v = 0, j = 0; v < POPTRIE_NODE_NUM_ENT; v++) {
+		if (leafvec & (1ULL << v))
+			write_leaf(dp, base0 + j++, nhs[v]);
+	}
+
+	/* the routes of a child are next to each other */
+	for (i = 0; i < num; i = j) {
+		j = i + 1;
+		if (routes[i].depth <= end)
+			continue;
+		v = route_chunk(&routes[i], off);
+		while ((j < num) && (route_chunk(&routes[j], off) == v))
+			j++;
+		ret = build_node(dp, base1 + built, &routes[i], j - i, end,
+			nhs[v]);
+		if (ret != 0)
+			goto free_children;
+		built++;
+	}
+
+	dp->nodes[idx].vector = vector;
+	dp->nodes[idx].leafvec = leafvec;
+	dp->nodes[idx].base0 = base0;
+	dp->nodes[idx].base1 = base1;
+	return 0;
+
+free_children:
+	for (i = 0; i < built; i++)
+		free_node(dp, base1 + i, false);
+	if (nb_child != 0)
+		pool_put(&dp->node_pool, base1, nb_child);
+free_leaves:
+	if (nb_leaf != 0)
+		pool_put(&dp->leaf_pool, base0, nb_leaf);
+	return ret;
+}
+
+static int
+route_cmp(const void *a, const void *b)
+{
+	const struct poptrie_route *ra = a;
+	const struct poptrie_route *rb = b;
+
+	if (ra->hi != rb->hi)
+		return (ra->hi < rb->hi) ? -1 : 1;
+	if (ra->lo != rb->lo)
+		return (ra->lo < rb->lo) ? -1 : 1;
+	return (int)ra->depth - (int)rb->depth;
+}
+
+/*
+ * Get the routes more specific than the prefix ip/depth into the scratch
+ * space, sorted by address
+ */
+static int
+collect_routes(struct rte_poptrie_tbl *dp, struct rte_rib6 *rib,
+	const struct rte_ipv6_addr *ip, uint8_t depth)
+{
+	struct rte_rib6_node *nodes[POPTRIE_WALK_BULK];
+	struct rte_rib6_node *last = NULL;
+	struct poptrie_route *routes;
+	struct rte_ipv6_addr addr;
+	uint32_t num = 0, sz;
+	int i, ret;
+
+	do {
+		ret = rte_rib6_get_nxt_bulk(rib, ip, depth, last,
+			RTE_RIB6_GET_NXT_ALL, nodes, RTE_DIM(nodes));
+		if (ret < 0)
+			return ret;
+		if (num + ret > dp->routes_sz) {
+			sz = RTE_MAX(dp->routes_sz * 2, POPTRIE_ROUTES_MIN);
+			routes = rte_realloc_socket(dp->routes,
+				sz * sizeof(*routes), 0, dp->socket_id);
+			if (routes == NULL)
+				return -ENOMEM;
+			dp->routes = routes;
+			dp->routes_sz = sz;
+		}
+		for (i = 0; i < ret; i++, num++) {
+			rte_rib6_get_ip(nodes[i], &addr);
+			rte_rib6_get_depth(nodes[i], &dp->routes[num].depth);
+			rte_rib6_get_nh(nodes[i], &dp->routes[num].nh);
+			dp->routes[num].hi = poptrie_addr_hi(&addr);
+			dp->routes[num].lo = poptrie_addr_lo(&addr);
+		}
+		if (ret != 0)
+			last = nodes[ret - 1];
+	} while (ret == (int)RTE_DIM(nodes));
+
+	if (num != 0)
+		qsort(dp->routes, num, sizeof(*dp->routes), route_cmp);
+
+	return num;
+}
+
+/*
+ * Get the next hop of the most specific route covering the whole prefix
+ * ip/depth
+ */
+static uint64_t
+get_cover_nh(struct rte_poptrie_tbl *dp, struct rte_rib6 *rib,
+	const struct rte_ipv6_addr *ip, uint8_t depth)
+{
+	struct rte_rib6_node *tmp;
+	uint64_t nh = dp->def_nh;
+	uint8_t tmp_depth;
+
+	tmp = rte_rib6_lookup(rib, ip);
+	while (tmp != NULL) {
+		rte_rib6_get_depth(tmp, &tmp_depth);
+		if (tmp_depth <= depth) {
+			rte_rib6_get_nh(tmp, &nh);
+			break;
+		}
+		tmp = rte_rib6_lookup_parent(tmp);
+	}
+
+	return nh;
+}
+
+/*
+ * Rebuild the direct table entry idx from the RIB. A new subtree replaces
+ * the old one, which is freed once the entry points to the new one and
+ * the lookups are done with it.
+ */
+static int
+rebuild_direct(struct rte_poptrie_tbl *dp, struct rte_rib6 *rib, uint32_t idx)
+{
+	struct rte_ipv6_addr ip = RTE_IPV6_ADDR_UNSPEC;
+	uint64_t hi, nh;
+	int64_t node_idx;
+	uint32_t old;
+	int num, ret;
+
+	hi = rte_cpu_to_be_64((uint64_t)idx << (64 - POPTRIE_DIRECT_BITS));
+	memcpy(&ip.a[0], &hi, sizeof(hi));
+
+	nh = get_cover_nh(dp, rib, &ip, POPTRIE_DIRECT_BITS);
+	num = collect_routes(dp, rib, &ip, POPTRIE_DIRECT_BITS);
+	if (num < 0)
+		return num;
+
+	old = dp->direct[idx];
+	if (num == 0) {
+		write_leaf(dp, idx, nh);
+		rte_atomic_thread_fence(rte_memory_order_release);
+		dp->direct[idx] = 0;
+	} else {
+		node_idx = block_get(dp, &dp->node_pool, 1);
+		if (node_idx < 0)
+			return node_idx;
+		ret = build_node(dp, node_idx, dp->routes, num,
+			POPTRIE_DIRECT_BITS, nh);
+		if (ret != 0) {
+			pool_put(&dp->node_pool, node_idx, 1);
+			return ret;
+		}
+		rte_atomic_thread_fence(rte_memory_order_release);
+		dp->direct[idx] = (node_idx << 1) | POPTRIE_EXT_ENT;
+	}
+
+	if (old & POPTRIE_EXT_ENT) {
+		wait_readers(dp);
+		free_node(dp, old >> 1, true);
+		block_retire(dp, &dp->node_pool, old >> 1, 1);
+	}
+
+	return 0;
+}
+
+static inline uint32_t
+get_direct_idx(const struct rte_ipv6_addr *ip)
+{
+	return poptrie_addr_hi(ip) >> (64 - POPTRIE_DIRECT_BITS);
+}
+
+static inline uint32_t
+get_direct_num(uint8_t depth)
+{
+	return (depth < POPTRIE_DIRECT_BITS) ?
+		1 << (POPTRIE_DIRECT_BITS - depth) : 1;
+}
+
+/*
+ * Rebuild the deepest node holding the entries of the route ip/depth, or
+ * which has to get a child for it. Its ancestors are copied into new
+ * blocks up to the direct table entry, so the update becomes visible at
+ * once when the entry is switched, and only the rebuilt subtree and the
+ * old copies are freed, once the lookups are done with them.
+ */
+static int
+rebuild_route(struct rte_poptrie_tbl *dp, struct rte_rib6 *rib,
+	const struct rte_ipv6_addr *ip, uint8_t depth)
+{
+	uint32_t path[POPTRIE_MAX_LEVELS];
+	uint32_t blocks[POPTRIE_MAX_LEVELS];
+	const struct poptrie_node *par;
+	struct rte_ipv6_addr prefix;
+	uint32_t idx, lvl, top, off, v, nb_child, pos;
+	uint64_t hi, lo, nh;
+	int64_t new_idx;
+	int num, ret;
+
+	idx = get_direct_idx(ip);
+	if (!(dp->direct[idx] & POPTRIE_EXT_ENT))
+		return rebuild_direct(dp, rib, idx);
+
+	hi = poptrie_addr_hi(ip);
+	lo = poptrie_addr_lo(ip);
+	poptrie_shift_addr(&hi, &lo, POPTRIE_DIRECT_BITS);
+	path[0] = dp->direct[idx] >> 1;
+	off = POPTRIE_DIRECT_BITS;
+	lvl = 0;
+	while (depth > off + POPTRIE_STRIDE) {
+		par = &dp->nodes[path[lvl]];
+		v = hi >> (64 - POPTRIE_STRIDE);
+		if (!(par->vector & (1ULL << v)))
+			break;
+		path[++lvl] = par->base1 + poptrie_popcnt(par->vector, v) - 1;
+		off += POPTRIE_STRIDE;
+		poptrie_shift_addr(&hi, &lo, POPTRIE_STRIDE);
+	}
+
+	/* a node left without routes is folded into the leaves of its parent */
+	for (;;) {
+		if (lvl == 0)
+			return rebuild_direct(dp, rib, idx);
+		prefix = *ip;
+		rte_ipv6_addr_mask(&prefix, off);
+		num = collect_routes(dp, rib, &prefix, off);
+		if (num < 0)
+			return num;
+		if (num != 0)
+			break;
+		lvl--;
+		off -= POPTRIE_STRIDE;
+	}
+	nh = get_cover_nh(dp, rib, &prefix, off);
+
+	for (top = lvl + 1; top > 1; top--) {
+		par = &dp->nodes[path[top - 2]];
+		nb_child = rte_popcount64(par->vector);
+		new_idx = block_get(dp, &dp->node_pool, nb_child);
+		if (new_idx < 0) {
+			ret = new_idx;
+			goto free_blocks;
+		}
+		memcpy(&dp->nodes[new_idx], &dp->nodes[par->base1],
+			sizeof(struct poptrie_node) * nb_child);
+		pos = path[top - 1] - par->base1;
+		if (top - 1 == lvl) {
+			ret = build_node(dp, new_idx + pos, dp->routes, num,
+				off, nh);
+			if (ret != 0) {
+				pool_put(&dp->node_pool, new_idx, nb_child);
+				goto free_blocks;
+			}
+		} else
+			dp->nodes[new_idx + pos].base1 = blocks[top];
+		blocks[top - 1] = new_idx;
+	}
+
+	new_idx = block_get(dp, &dp->node_pool, 1);
+	if (new_idx < 0) {
+		ret = new_idx;
+		goto free_blocks;
+	}
+	dp->nodes[new_idx] = dp->nodes[path[0]];
+	dp->nodes[new_idx].base1 = blocks[1];
+
+	rte_atomic_thread_fence(rte_memory_order_release);
+	dp->direct[idx] = (new_idx << 1) | POPTRIE_EXT_ENT;
+
+	wait_readers(dp);
+	free_node(dp, path[lvl], true);
+	for (top = 1; top <= lvl; top++) {
+		par = &dp->nodes[path[top - 1]];
+		block_retire(dp, &dp->node_pool, par->base1,
+			rte_popcount64(par->vector));
+	}
+	block_retire(dp, &dp->node_pool, path[0], 1);
+
+	return 0;
+
+free_blocks:
+	for (; top <= lvl; top++) {
+		par = &dp->nodes[path[top - 1]];
+		nb_child = rte_popcount64(par->vector);
+		if (top == lvl)
+			free_node(dp, blocks[top] + path[top] - par->base1,
+				false);
+		pool_put(&dp->node_pool, blocks[top], nb_child);
+	}
+	return ret;
+}
+
+/*
+ * Rebuild the direct table entries under a masked prefix
+ */
+static int
+modify_dp(struct rte_poptrie_tbl *dp, struct rte_rib6 *rib,
+	const struct rte_ipv6_addr *ip, uint8_t depth)
+{
+	uint32_t i, idx, num;
+	int ret;
+
+	if (depth > POPTRIE_DIRECT_BITS)
+		return rebuild_route(dp, rib, ip, depth);
+
+	idx = get_direct_idx(ip);
+	num = get_direct_num(depth);
+	for (i = 0; i < num; i++) {
+		ret = rebuild_direct(dp, rib, idx + i);
+		if (ret != 0)
+			return ret;
+	}
+
+	return 0;
+}
+
+int
+poptrie_modify(struct rte_fib6 *fib, const struct rte_ipv6_addr *ip,
+	uint8_t depth, uint64_t next_hop, int op)
+{
+	struct rte_poptrie_tbl *dp;
+	struct rte_rib6 *rib;
+	struct rte_rib6_node *node;
+	struct rte_rib6_node *parent;
+	struct rte_ipv6_addr ip_masked;
+	uint64_t par_nh, node_nh;
+	int ret;
+
+	if ((fib == NULL) || (ip == NULL) || (depth > RTE_IPV6_MAX_DEPTH))
+		return -EINVAL;
+
+	dp = rte_fib6_get_dp(fib);
+	RTE_ASSERT(dp);
+	rib = rte_fib6_get_rib(fib);
+	RTE_ASSERT(rib);
+
+	ip_masked = *ip;
+	rte_ipv6_addr_mask(&ip_masked, depth);
+	node = rte_rib6_lookup_exact(rib, &ip_masked, depth);
+
+	switch (op) {
+	case RTE_FIB6_ADD:
+		if (next_hop > poptrie_max_nh(dp->nh_sz))
+			return -EINVAL;
+
+		if (node != NULL) {
+			rte_rib6_get_nh(node, &node_nh);
+			if (node_nh == next_hop)
+				return 0;
+			rte_rib6_set_nh(node, next_hop);
+			ret = modify_dp(dp, rib, &ip_masked, depth);
+			if (ret != 0) {
+				rte_rib6_set_nh(node, node_nh);
+				modify_dp(dp, rib, &ip_masked, depth);
+			}
+			return ret;
+		}
+
+		node = rte_rib6_insert(rib, &ip_masked, depth);
+		if (node == NULL)
+			return -rte_errno;
+		rte_rib6_set_nh(node, next_hop);
+		par_nh = dp->def_nh;
+		parent = rte_rib6_lookup_parent(node);
+		if (parent != NULL)
+			rte_rib6_get_nh(parent, &par_nh);
+		if (par_nh == next_hop)
+			return 0;
+
+		ret = modify_dp(dp, rib, &ip_masked, depth);
+		if (ret != 0) {
+			rte_rib6_remove(rib, &ip_masked, depth);
+			modify_dp(dp, rib, &ip_masked, depth);
+		}
+		return ret;
+	case RTE_FIB6_DEL:
+		if (node == NULL)
+			return -ENOENT;
+
+		rte_rib6_get_nh(node, &node_nh);
+		par_nh = dp->def_nh;
+		parent = rte_rib6_lookup_parent(node);
+		if (parent != NULL)
+			rte_rib6_get_nh(parent, &par_nh);
+		rte_rib6_remove(rib, &ip_masked, depth);
+		if (par_nh == node_nh)
+			return 0;
+
+		ret = modify_dp(dp, rib, &ip_masked, depth);
+		if (ret != 0) {
+			node = rte_rib6_insert(rib, &ip_masked, depth);
+			if (node != NULL) {
+				rte_rib6_set_nh(node, node_nh);
+				modify_dp(dp, rib, &ip_masked, depth);
+			}
+		}
+		return ret;
+	default:
+		break;
+	}
+	return -EINVAL;
+}
+
+int
+poptrie_add_bulk(struct rte_fib6 *fib, const struct rte_ipv6_addr *ips,
+	const uint8_t *depths, const uint64_t *next_hops, unsigned int n)
+{
+	struct rte_poptrie_tbl *dp;
+	struct rte_rib6 *rib;
+	struct rte_rib6_node *node;
+	struct rte_ipv6_addr ip_masked;
+	uint64_t *dirty;
+	uint64_t node_nh;
+	unsigned int added;
+	uint32_t i, idx, num;
+	uint8_t depth;
+	int ret = 0;
+
+	if (n == 0)
+		return 0;
+
+	dp = rte_fib6_get_dp(fib);
+	RTE_ASSERT(dp);
+	rib = rte_fib6_get_rib(fib);
+	RTE_ASSERT(rib);
+
+	/* direct table entries to rebuild */
+	dirty = rte_zmalloc(NULL, POPTRIE_DIRECT_NUM_ENT / CHAR_BIT, 0);
+	if (dirty == NULL)
+		return -ENOMEM;
+
+	/*
+	 * Put all the routes into the RIB first, so that every direct
+	 * table entry is rebuilt once, whatever the number of routes in it.
+	 */
+	for (added = 0; added < n; added++) {
+		depth = depths[added];
+		if ((depth > RTE_IPV6_MAX_DEPTH) ||
+				(next_hops[added] > poptrie_max_nh(dp->nh_sz)))
+			break;
+
+		ip_masked = ips[added];
+		rte_ipv6_addr_mask(&ip_masked, depth);
+		node = rte_rib6_lookup_exact(rib, &ip_masked, depth);
+		if (node != NULL) {
+			rte_rib6_get_nh(node, &node_nh);
+			if (node_nh == next_hops[added])
+				continue;
+		} else {
+			node = rte_rib6_insert(rib, &ip_masked, depth);
+			if (node == NULL)
+				break;
+		}
+		rte_rib6_set_nh(node, next_hops[added]);
+
+		idx = get_direct_idx(&ip_masked);
+		num = get_direct_num(depth);
+		for (i = idx; i < idx + num; i++)
+			dirty[i / 64] |= 1ULL << (i % 64);
+	}
+
+	for (i = 0; i < POPTRIE_DIRECT_NUM_ENT; i++) {
+		if (!(dirty[i / 64] & (1ULL << (i % 64))))
+			continue;
+		ret = rebuild_direct(dp, rib, i);
+		if (ret != 0)
+			break;
+	}
+
+	rte_free(dirty);
+
+	return (ret != 0) ? ret : (int)added;
+}
+
+void *
+poptrie_create(const char *name, int socket_id, struct rte_fib6_conf *conf)
+{
+	char mem_name[POPTRIE_NAMESIZE];
+	struct rte_poptrie_tbl *dp = NULL;
+	enum rte_fib_trie_nh_sz nh_sz;
+	uint32_t num_nodes, num_leaves;
+	uint32_t i;
+
+	if ((name == NULL) || (conf == NULL) ||
+			(conf->poptrie.nh_sz < RTE_FIB6_TRIE_2B) ||
+			(conf->poptrie.nh_sz > RTE_FIB6_TRIE_8B) ||
+			(conf->poptrie.num_nodes == 0) ||
+			(conf->poptrie.num_nodes > POPTRIE_MAX_NODES) ||
+			(conf->default_nh >
+			poptrie_max_nh(conf->poptrie.nh_sz))) {
+		rte_errno = EINVAL;
+		return NULL;
+	}
+
+	nh_sz = conf->poptrie.nh_sz;
+	num_nodes = conf->poptrie.num_nodes;
+	num_leaves = num_nodes * POPTRIE_LEAVES_PER_NODE;
+
+	snprintf(mem_name, sizeof(mem_name), "DP_%s", name);
+	dp = rte_zmalloc_socket(mem_name, sizeof(struct rte_poptrie_tbl) +
+		POPTRIE_DIRECT_NUM_ENT * sizeof(uint32_t),
+		RTE_CACHE_LINE_SIZE, socket_id);
+	if (dp == NULL) {
+		rte_errno = ENOMEM;
+		return NULL;
+	}
+	dp->def_nh = conf->default_nh;
+	dp->nh_sz = nh_sz;
+	dp->socket_id = socket_id;
+
+	snprintf(mem_name, sizeof(mem_name), "NODES_%p", dp);
+	dp->nodes = rte_zmalloc_socket(mem_name,
+		sizeof(struct poptrie_node) * num_nodes,
+		RTE_CACHE_LINE_SIZE, socket_id);
+	if (dp->nodes == NULL)
+		goto free_dp;
+
+	snprintf(mem_name, sizeof(mem_name), "LEAVES_%p", dp);
+	dp->leaves = rte_zmalloc_socket(mem_name,
+		((size_t)POPTRIE_DIRECT_NUM_ENT + num_leaves) << nh_sz,
+		RTE_CACHE_LINE_SIZE, socket_id);
+	if (dp->leaves == NULL)
+		goto free_dp;
+	for (i = 0; i < POPTRIE_DIRECT_NUM_ENT; i++)
+		write_leaf(dp, i, dp->def_nh);
+
+	snprintf(mem_name, sizeof(mem_name), "NODES_idxes_%p", dp);
+	if (pool_init(&dp->node_pool, mem_name, 0, num_nodes, socket_id) != 0)
+		goto free_dp;
+
+	snprintf(mem_name, sizeof(mem_name), "LEAVES_idxes_%p", dp);
+	if (pool_init(&dp->leaf_pool, mem_name, POPTRIE_DIRECT_NUM_ENT,
+			num_leaves, socket_id) != 0)
+		goto free_dp;
+
+	return dp;
+
+free_dp:
+	poptrie_free(dp);
+	rte_errno = ENOMEM;
+	return NULL;
+}
+
+void
+poptrie_free(void *p)
+{
+	struct rte_poptrie_tbl *dp = (struct rte_poptrie_tbl *)p;
+
+	rte_rcu_qsbr_dq_delete(dp->dq);
+	rte_free(dp->routes);
+	rte_free(dp->leaf_pool.next);
+	rte_free(dp->node_pool.next);
+	rte_free(dp->leaves);
+	rte_free(dp->nodes);
+	rte_free(dp);
+}
+
+int
+poptrie_rcu_qsbr_add(struct rte_poptrie_tbl *dp,
+	struct rte_fib6_rcu_config *cfg, const char *name)
+{
+	struct rte_rcu_qsbr_dq_parameters params = {0};
+	char rcu_dq_name[RTE_RCU_QSBR_DQ_NAMESIZE];
+
+	if (dp == NULL || cfg == NULL)
+		return -EINVAL;
+
+	if (dp->v != NULL)
+		return -EEXIST;
+
+	if (cfg->mode == RTE_FIB6_QSBR_MODE_SYNC) {
+		/* No other things to do. */
+	} else if (cfg->mode == RTE_FIB6_QSBR_MODE_DQ) {
+		/* Init QSBR defer queue. */
+		snprintf(rcu_dq_name, sizeof(rcu_dq_name),
+				"FIB6_RCU_%s", name);
+		params.name = rcu_dq_name;
+		params.size = cfg->dq_size;
+		if (params.size == 0)
+			params.size = RTE_FIB6_RCU_DQ_RECLAIM_SZ;
+		params.trigger_reclaim_limit = cfg->reclaim_thd;
+		params.max_reclaim_size = cfg->reclaim_max;
+		if (params.max_reclaim_size == 0)
+			params.max_reclaim_size = RTE_FIB6_RCU_DQ_RECLAIM_MAX;
+		params.esize = sizeof(struct poptrie_block);
+		params.free_fn = __rcu_qsbr_free_resource;
+		params.p = dp;
+		params.v = cfg->v;
+		dp->dq = rte_rcu_qsbr_dq_create(&params);
+		if (dp->dq == NULL) {
+			FIB_LOG(ERR, "FIB6 defer queue creation failed");
+			return -rte_errno;
+		}
+	} else {
+		return -EINVAL;
+	}
+
+	dp->rcu_mode = cfg->mode;
+	dp->v = cfg->v;
+
+	return 0;
+}
@@ -0,0 +1,197 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2026 agent <agent@local>
+ */
+
+#ifndef _POPTRIE_H_
+#define _POPTRIE_H_
+
+#include <stdalign.h>
+#include <string.h>
+
+#include <rte_common.h>
+#include <rte_bitops.h>
+#include <rte_byteorder.h>
+#include <rte_fib6.h>
+
+/**
+ * @file
+ * RTE IPv6 Longest Prefix Match (LPM) with a poptrie
+ *
+ * The first bits of the address index a direct table, the rest is resolved
+ * by nodes of 64 entries. A node only stores a bitmap of its entries which
+ * are nodes, and a bitmap of the entries starting a run of equal leaves, so
+ * its children and leaves are packed and found with a popcount.
+ */
+
+/* @internal Number of address bits resolved by the direct table. */
+#define POPTRIE_DIRECT_BITS	16
+/* @internal Total number of direct table entries. */
+#define POPTRIE_DIRECT_NUM_ENT	(1 << POPTRIE_DIRECT_BITS)
+/* @internal Number of address bits resolved by a node. */
+#define POPTRIE_STRIDE		6
+/* @internal Number of entries in a node. */
+#define POPTRIE_NODE_NUM_ENT	(1 << POPTRIE_STRIDE)
+/* @internal Number of leaves reserved per node. */
+#define POPTRIE_LEAVES_PER_NODE	8
+/* @internal Direct table entry pointing to a node */
+#define POPTRIE_EXT_ENT		1
+/* @internal Maximum number of nodes, indexes must fit in the direct table. */
+#define POPTRIE_MAX_NODES	(1U << 28)
+
+struct poptrie_node {
+	uint64_t	vector;		/**< Entries which are child nodes */
+	uint64_t	leafvec;	/**< Entries starting a run of leaves */
+	uint32_t	base0;		/**< Index of the first leaf */
+	uint32_t	base1;		/**< Index of the first child node */
+};
+
+/* Allocator of node and leaf blocks, one free list per block size */
+struct poptrie_pool {
+	uint32_t	first;		/**< First index managed by the pool */
+	uint32_t	num;		/**< Total number of entries */
+	uint32_t	pos;		/**< First never allocated entry */
+	uint32_t	*next;		/**< Next free block of the same size */
+	uint32_t	free[POPTRIE_NODE_NUM_ENT + 1];
+};
+
+/* Route under a direct table entry, collected from the RIB */
+struct poptrie_route {
+	uint64_t	hi;	/**< First half of the address, host order */
+	uint64_t	lo;	/**< Second half of the address, host order */
+	uint64_t	nh;
+	uint8_t		depth;
+};
+
+struct rte_poptrie_tbl {
+	struct poptrie_node	*nodes;	/**< Node table */
+	/** Leaf table, the first entries are the direct table leaves */
+	void			*leaves;
+	enum rte_fib_trie_nh_sz	nh_sz;	/**< Size of nexthop entry */
+	uint64_t		def_nh;	/**< Default next hop */
+	struct poptrie_pool	node_pool;
+	struct poptrie_pool	leaf_pool;
+	struct poptrie_route	*routes; /**< Scratch space for rebuilds */
+	uint32_t		routes_sz;
+	int			socket_id;
+	/* RCU config. */
+	enum rte_fib6_qsbr_mode rcu_mode;/* Blocking, defer queue. */
+	struct rte_rcu_qsbr	*v;	/* RCU QSBR variable. */
+	struct rte_rcu_qsbr_dq	*dq;	/* RCU QSBR defer queue. */
+	/* Direct table, node index or leaf at the same index. */
+	alignas(RTE_CACHE_LINE_SIZE) uint32_t	direct[];
+};
+
+static inline uint64_t
+poptrie_max_nh(uint8_t nh_sz)
+{
+	return (nh_sz == RTE_FIB6_TRIE_8B) ? UINT64_MAX :
+		(1ULL << (8 << nh_sz)) - 1;
+}
+
+static inline uint64_t
+poptrie_addr_hi(const struct rte_ipv6_addr *ip)
+{
+	uint64_t val;
+
+	memcpy(&val, &ip->a[0], sizeof(val));
+	return rte_be_to_cpu_64(val);
+}
+
+static inline uint64_t
+poptrie_addr_lo(const struct rte_ipv6_addr *ip)
+{
+	uint64_t val;
+
+	memcpy(&val, &ip->a[8], sizeof(val));
+	return rte_be_to_cpu_64(val);
+}
+
+/*
+ * Get the node entry index at bit offset off of the address, bits past the
+ * end of the address read as zero
+ */
+static inline uint32_t
+poptrie_get_chunk(uint64_t hi, uint64_t lo, uint32_t off)
+{
+	if (off >= 64) {
+		hi = lo;
+		lo = 0;
+		off -= 64;
+	}
+	if (off != 0)
+		hi = (hi << off) | (lo >> (64 - off));
+	return hi >> (64 - POPTRIE_STRIDE);
+}
+
+/* Number of bits set in vec up to and including bit v */
+static inline uint32_t
+poptrie_popcnt(uint64_t vec, uint32_t v)
+{
+	return rte_popcount64(vec & ((2ULL << v) - 1));
+}
+
+/* Shift the next stride of the address into the top bits of hi */
+static inline void
+poptrie_shift_addr(uint64_t *hi, uint64_t *lo, uint32_t bits)
+{
+	*hi = (*hi << bits) | (*lo >> (64 - bits));
+	*lo <<= bits;
+}
+
+#define POPTRIE_LOOKUP_FUNC(suffix, type)				\
+static inline void rte_poptrie_lookup_bulk_##suffix(void *p,		\
+	const struct rte_ipv6_addr *ips,				\
+	uint64_t *next_hops, const unsigned int n)			\
+{									\
+	struct rte_poptrie_tbl *dp = (struct rte_poptrie_tbl *)p;	\
+	const struct poptrie_node *node;				\
+	uint64_t hi, lo;						\
+	uint32_t i, idx, v;						\
+									\
+	for (i = 0; i < n; i++) {					\
+		hi = poptrie_addr_hi(&ips[i]);				\
+		idx = hi >> (64 - POPTRIE_DIRECT_BITS);			\
+		if (!(dp->direct[idx] & POPTRIE_EXT_ENT)) {		\
+			next_hops[i] = ((type *)dp->leaves)[idx];	\
+			continue;					\
+		}							\
+		lo = poptrie_addr_lo(&ips[i]);				\
+		poptrie_shift_addr(&hi, &lo, POPTRIE_DIRECT_BITS);	\
+		node = &dp->nodes[dp->direct[idx] >> 1];		\
+		v = hi >> (64 - POPTRIE_STRIDE);			\
+		while (node->vector & (1ULL << v)) {			\
+			node = &dp->nodes[node->base1 +			\
+				poptrie_popcnt(node->vector, v) - 1];	\
+			poptrie_shift_addr(&hi, &lo, POPTRIE_STRIDE);	\
+			v = hi >> (64 - POPTRIE_STRIDE);		\
+		}							\
+		next_hops[i] = ((type *)dp->leaves)[node->base0 +	\
+			poptrie_popcnt(node->leafvec, v) - 1];		\
+	}								\
+}
+POPTRIE_LOOKUP_FUNC(2b, uint16_t)
+POPTRIE_LOOKUP_FUNC(4b, uint32_t)
+POPTRIE_LOOKUP_FUNC(8b, uint64_t)
+
+void *
+poptrie_create(const char *name, int socket_id, struct rte_fib6_conf *conf);
+
+void
+poptrie_free(void *p);
+
+rte_fib6_lookup_fn_t
+poptrie_get_lookup_fn(void *p, enum rte_fib6_lookup_type type);
+
+int
+poptrie_modify(struct rte_fib6 *fib, const struct rte_ipv6_addr *ip,
+	uint8_t depth, uint64_t next_hop, int op);
+
+int
+poptrie_add_bulk(struct rte_fib6 *fib, const struct rte_ipv6_addr *ips,
+	const uint8_t *depths, const uint64_t *next_hops, unsigned int n);
+
+int
+poptrie_rcu_qsbr_add(struct rte_poptrie_tbl *dp,
+	struct rte_fib6_rcu_config *cfg, const char *name);
+
+#endif /* _POPTRIE_H_ */
@@ -17,6 +17,7 @@
 #include <rte_fib.h>
 
 #include "dir24_8.h"
+#include "nh_group.h"
 #include "fib_log.h"
 
 RTE_LOG_REGISTER_DEFAULT(fib_logtype, INFO);
@@ -48,6 +49,8 @@ struct rte_fib {
 	rte_fib_lookup_fn_t	lookup;	/**< FIB lookup function */
 	rte_fib_modify_fn_t	modify; /**< modify FIB datastructure */
 	uint64_t		def_nh;
+	struct nh_group_tbl	*nh_grp; /**< Next hop groups */
+	int			socket_id;
 };
 
 static void
@@ -126,9 +129,44 @@ rte_fib_add(struct rte_fib *fib, uint32_t ip, uint8_t depth, uint64_t next_hop)
 	if ((fib == NULL) || (fib->modify == NULL) ||
 			(depth > RTE_FIB_MAXDEPTH))
 		return -EINVAL;
+	if ((fib->nh_grp != NULL) && !nh_group_check_nh(fib->nh_grp, next_hop))
+		return -EINVAL;
 	return fib->modify(fib, ip, depth, next_hop, RTE_FIB_ADD);
 }
 
+int
+rte_fib_add_bulk(struct rte_fib *fib, const uint32_t *ips,
+	const uint8_t *depths, const uint64_t *next_hops, unsigned int n)
+{
+	unsigned int i;
+
+	if ((fib == NULL) || (fib->modify == NULL) || ((n != 0) &&
+			((ips == NULL) || (depths == NULL) ||
+			(next_hops == NULL))))
+		return -EINVAL;
+
+	/* stop at the first reference to a missing group */
+	if (fib->nh_grp != NULL) {
+		for (i = 0; i < n; i++) {
+			if (!nh_group_check_nh(fib->nh_grp, next_hops[i]))
+				break;
+		}
+		n = i;
+	}
+
+	switch (fib->type) {
+	case RTE_FIB_DIR24_8:
+		return dir24_8_add_bulk(fib, ips, depths, next_hops, n);
+	default:
+		for (i = 0; i < n; i++) {
+			if (rte_fib_add(fib, ips[i], depths[i],
+					next_hops[i]) != 0)
+				break;
+		}
+		return i;
+	}
+}
+
 int
 rte_fib_delete(struct rte_fib *fib, uint32_t ip, uint8_t depth)
 {
@@ -149,6 +187,20 @@ rte_fib_lookup_bulk(struct rte_fib *fib, uint32_t *ips,
 	return 0;
 }
 
+int
+rte_fib_lookup_bulk_hash(struct rte_fib *fib, uint32_t *ips,
+	const uint32_t *hashes, uint64_t *next_hops, int n)
+{
+	FIB_RETURN_IF_TRUE(((fib == NULL) || (ips == NULL) ||
+		(hashes == NULL) || (next_hops == NULL) ||
+		(fib->lookup == NULL)), -EINVAL);
+
+	fib->lookup(fib->dp, ips, next_hops, n);
+	if (fib->nh_grp != NULL)
+		nh_group_resolve_bulk(fib->nh_grp, hashes, next_hops, n);
+	return 0;
+}
+
 struct rte_fib *
 rte_fib_create(const char *name, int socket_id, struct rte_fib_conf *conf)
 {
@@ -218,6 +270,7 @@ rte_fib_create(const char *name, int socket_id, struct rte_fib_conf *conf)
 	fib->type = conf->type;
 	fib->flags = conf->flags;
 	fib->def_nh = conf->default_nh;
+	fib->socket_id = socket_id;
 	ret = init_dataplane(fib, socket_id, conf);
 	if (ret < 0) {
 		FIB_LOG(ERR,
@@ -307,6 +360,7 @@ rte_fib_free(struct rte_fib *fib)
 	rte_mcfg_tailq_write_unlock();
 
 	free_dataplane(fib);
+	nh_group_free(fib->nh_grp);
 	rte_rib_free(fib->rib);
 	rte_free(fib);
 	rte_free(te);
@@ -356,3 +410,83 @@ rte_fib_rcu_qsbr_add(struct rte_fib *fib, struct rte_fib_rcu_config *cfg)
 		return -ENOTSUP;
 	}
 }
+
+/* Largest next hop the dataplane can store */
+static uint64_t
+get_dp_max_nh(struct rte_fib *fib)
+{
+	switch (fib->type) {
+	case RTE_FIB_DIR24_8:
+		return get_max_nh(((struct dir24_8_tbl *)fib->dp)->nh_sz);
+	default:
+		return UINT64_MAX;
+	}
+}
+
+int
+rte_fib_nh_group_init(struct rte_fib *fib,
+	const struct rte_fib_nh_group_conf *conf)
+{
+	struct rte_rib_node *node = NULL;
+	struct nh_group_tbl *tbl;
+	uint64_t nh;
+
+	if ((fib == NULL) || (conf == NULL))
+		return -EINVAL;
+
+	if (fib->nh_grp != NULL)
+		return -EEXIST;
+
+	tbl = nh_group_create(fib->name, fib->socket_id,
+		conf->num_groups, conf->num_buckets, get_dp_max_nh(fib),
+		fib->def_nh);
+	if (tbl == NULL)
+		return -rte_errno;
+
+	/*
+	 * the next hops of the existing routes must not turn into groups,
+	 * the default route is checked apart as get_nxt skips it
+	 */
+	node = rte_rib_lookup_exact(fib->rib, 0, 0);
+	if (node != NULL) {
+		rte_rib_get_nh(node, &nh);
+		if (nh > tbl->max_nh) {
+			nh_group_free(tbl);
+			return -EINVAL;
+		}
+	}
+	node = NULL;
+	while ((node = rte_rib_get_nxt(fib->rib, 0, 0, node,
+			RTE_RIB_GET_NXT_ALL)) != NULL) {
+		rte_rib_get_nh(node, &nh);
+		if (nh > tbl->max_nh) {
+			nh_group_free(tbl);
+			return -EINVAL;
+		}
+	}
+
+	fib->nh_grp = tbl;
+	return 0;
+}
+
+int
+rte_fib_nh_group_set(struct rte_fib *fib, uint32_t group,
+	const uint64_t *next_hops, const uint32_t *weights, unsigned int n)
+{
+	if ((fib == NULL) || (fib->nh_grp == NULL))
+		return -EINVAL;
+
+	return nh_group_set(fib->nh_grp, group, next_hops, weights, n);
+}
+
+int
+rte_fib_nh_group_get_nh(struct rte_fib *fib, uint32_t group,
+	uint64_t *next_hop)
+{
+	if ((fib == NULL) || (fib->nh_grp == NULL) || (next_hop == NULL) ||
+			(group >= fib->nh_grp->num_groups))
+		return -EINVAL;
+
+	*next_hop = fib->nh_grp->grp_flag | group;
+	return 0;
+}
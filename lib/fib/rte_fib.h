@@ -83,8 +83,10 @@ enum rte_fib_lookup_type {
 	/**<
 	 * Unified lookup function for all next hop sizes
 	 */
-	RTE_FIB_LOOKUP_DIR24_8_VECTOR_AVX512
+	RTE_FIB_LOOKUP_DIR24_8_VECTOR_AVX512,
 	/**< Vector implementation using AVX512 */
+	RTE_FIB_LOOKUP_DIR24_8_VECTOR_AVX2
+	/**< Vector implementation using AVX2 */
 };
 
 /** If set, fib lookup is expecting IPv4 address in network byte order */
@@ -128,6 +130,21 @@ struct rte_fib_rcu_config {
 	uint32_t reclaim_max;
 };
 
+/** FIB next hop groups configuration structure. */
+struct rte_fib_nh_group_conf {
+	/**
+	 * Number of groups, at most half of the next hop values
+	 * the FIB can store.
+	 */
+	uint32_t num_groups;
+	/**
+	 * Number of buckets per group, a power of two up to 65536.
+	 * Bounds the number of members of a group and sets the precision
+	 * of the weights.
+	 */
+	uint32_t num_buckets;
+};
+
 /**
  * Create FIB
  *
@@ -184,6 +201,44 @@ rte_fib_free(struct rte_fib *fib);
 int
 rte_fib_add(struct rte_fib *fib, uint32_t ip, uint8_t depth, uint64_t next_hop);
 
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice.
+ *
+ * Add a batch of routes to the FIB.
+ *
+ * All the routes are put into the RIB first, then the dataplane is
+ * updated in a single pass over the changed prefixes sorted by address,
+ * so that every entry is written once instead of once per covering
+ * route. Loading into an empty FIB does not walk the RIB at all, and
+ * routes given in address order, as tables are usually dumped, are
+ * not sorted again.
+ *
+ * @param fib
+ *   FIB object handle
+ * @param ips
+ *   Array of IPv4 prefix addresses to be added to the FIB
+ * @param depths
+ *   Array of prefix lengths
+ * @param next_hops
+ *   Array of next hops to be added to the FIB
+ * @param n
+ *   Number of elements in ips, depths and next_hops arrays
+ * @return
+ *   Number of routes added from the start of the arrays, if less than n
+ *   the route at that index is invalid or could not be added and the
+ *   following ones were not tried.
+ *   Negative value if the dataplane could not be updated:
+ *   - -EINVAL - invalid parameters
+ *   - -ENOMEM - memory allocation failure
+ *   - -ENOSPC - no more tbl8 groups, the RIB holds the routes
+ *     but the dataplane is only partially updated
+ */
+__rte_experimental
+int
+rte_fib_add_bulk(struct rte_fib *fib, const uint32_t *ips,
+	const uint8_t *depths, const uint64_t *next_hops, unsigned int n);
+
 /**
  * Delete a rule from the FIB.
  *
@@ -219,6 +274,39 @@ rte_fib_delete(struct rte_fib *fib, uint32_t ip, uint8_t depth);
 int
 rte_fib_lookup_bulk(struct rte_fib *fib, uint32_t *ips,
 		uint64_t *next_hops, int n);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice.
+ *
+ * Lookup multiple IP addresses in the FIB, resolving next hop groups.
+ *
+ * Same as rte_fib_lookup_bulk(), except that when the route of an IP
+ * references a next hop group, the member selected by the hash of the
+ * same index is returned instead of the group reference.
+ *
+ * @param fib
+ *   FIB object handle
+ * @param ips
+ *   Array of IPs to be looked up in the FIB
+ * @param hashes
+ *   Array of flow hashes of the packets, e.g. RSS hashes.
+ *   The low bits select the bucket of the group.
+ * @param next_hops
+ *   Next hop of the most specific rule found for IP,
+ *   or member of its group.
+ *   This is an array of eight byte values.
+ *   If the lookup for the given IP failed, then corresponding element would
+ *   contain default nexthop value configured for a FIB.
+ * @param n
+ *   Number of elements in ips, hashes and next_hops arrays to lookup.
+ * @return
+ *   -EINVAL for incorrect arguments, otherwise 0
+ */
+__rte_experimental
+int
+rte_fib_lookup_bulk_hash(struct rte_fib *fib, uint32_t *ips,
+	const uint32_t *hashes, uint64_t *next_hops, int n);
 /**
  * Get pointer to the dataplane specific struct
  *
@@ -278,6 +366,91 @@ __rte_experimental
 int
 rte_fib_rcu_qsbr_add(struct rte_fib *fib, struct rte_fib_rcu_config *cfg);
 
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice.
+ *
+ * Enable next hop groups (ECMP) in the FIB.
+ *
+ * A group spreads the traffic of its routes over weighted member next hops.
+ * Groups are referenced by next hops with the most significant bit of
+ * the next hop size set, see rte_fib_nh_group_get_nh(), so the member and
+ * plain next hops are limited to the lower half of the values.
+ * All the groups are empty at first, and resolve to the default next hop.
+ *
+ * @param fib
+ *   FIB object handle
+ * @param conf
+ *   Next hop groups configuration
+ * @return
+ *   0 on success
+ *   Negative otherwise
+ *   Possible error codes are:
+ *   - -EINVAL - invalid parameters, or the default next hop or the next hop
+ *     of an existing route is in the upper half of the values
+ *   - -EEXIST - next hop groups already enabled
+ *   - -ENOMEM - memory allocation failure
+ */
+__rte_experimental
+int
+rte_fib_nh_group_init(struct rte_fib *fib,
+	const struct rte_fib_nh_group_conf *conf);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice.
+ *
+ * Set the members of a next hop group.
+ *
+ * Members get a share of the buckets of the group proportional to their
+ * weight. The hashing is resilient: the buckets of a member which is kept
+ * and within its new share keep it, so only the flows of the buckets
+ * which have to change member are moved.
+ * Each bucket is updated atomically, so the lookups may go on meanwhile.
+ *
+ * @param fib
+ *   FIB object handle
+ * @param group
+ *   Group index, lower than the configured number of groups
+ * @param next_hops
+ *   Array of member next hops, without duplicates
+ * @param weights
+ *   Array of the weights of the members, or NULL for equal weights.
+ *   Their sum times the number of buckets must fit in 64 bits.
+ * @param n
+ *   Number of members, at most the number of buckets per group.
+ *   0 empties the group, which then resolves to the default next hop.
+ * @return
+ *   0 on success
+ *   -EINVAL for invalid parameters
+ *   -ENOMEM for memory allocation failure
+ */
+__rte_experimental
+int
+rte_fib_nh_group_set(struct rte_fib *fib, uint32_t group,
+	const uint64_t *next_hops, const uint32_t *weights, unsigned int n);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice.
+ *
+ * Get the next hop referencing a group, to add routes using the group.
+ *
+ * @param fib
+ *   FIB object handle
+ * @param group
+ *   Group index
+ * @param next_hop
+ *   Next hop to give to rte_fib_add() for the routes of the group
+ * @return
+ *   0 on success
+ *   -EINVAL for invalid parameters
+ */
+__rte_experimental
+int
+rte_fib_nh_group_get_nh(struct rte_fib *fib, uint32_t group,
+	uint64_t *next_hop);
+
 #ifdef __cplusplus
 }
 #endif
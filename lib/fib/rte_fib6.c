@@ -19,6 +19,8 @@
 #include <rte_fib6.h>
 
 #include "trie.h"
+#include "poptrie.h"
+#include "nh_group.h"
 #include "fib_log.h"
 
 TAILQ_HEAD(rte_fib6_list, rte_tailq_entry);
@@ -47,6 +49,8 @@ struct rte_fib6 {
 	rte_fib6_lookup_fn_t	lookup;	/**< FIB lookup function */
 	rte_fib6_modify_fn_t	modify; /**< modify FIB datastructure */
 	uint64_t		def_nh;
+	struct nh_group_tbl	*nh_grp; /**< Next hop groups */
+	int			socket_id;
 };
 
 static void
@@ -112,6 +116,14 @@ init_dataplane(struct rte_fib6 *fib, __rte_unused int socket_id,
 		fib->lookup = trie_get_lookup_fn(fib->dp, RTE_FIB6_LOOKUP_DEFAULT);
 		fib->modify = trie_modify;
 		return 0;
+	case RTE_FIB6_POPTRIE:
+		fib->dp = poptrie_create(dp_name, socket_id, conf);
+		if (fib->dp == NULL)
+			return -rte_errno;
+		fib->lookup = poptrie_get_lookup_fn(fib->dp,
+			RTE_FIB6_LOOKUP_DEFAULT);
+		fib->modify = poptrie_modify;
+		return 0;
 	default:
 		return -EINVAL;
 	}
@@ -125,9 +137,46 @@ rte_fib6_add(struct rte_fib6 *fib, const struct rte_ipv6_addr *ip,
 	if ((fib == NULL) || (ip == NULL) || (fib->modify == NULL) ||
 			(depth > RTE_IPV6_MAX_DEPTH))
 		return -EINVAL;
+	if ((fib->nh_grp != NULL) && !nh_group_check_nh(fib->nh_grp, next_hop))
+		return -EINVAL;
 	return fib->modify(fib, ip, depth, next_hop, RTE_FIB6_ADD);
 }
 
+int
+rte_fib6_add_bulk(struct rte_fib6 *fib, const struct rte_ipv6_addr *ips,
+	const uint8_t *depths, const uint64_t *next_hops, unsigned int n)
+{
+	unsigned int i;
+
+	if ((fib == NULL) || (fib->modify == NULL) || ((n != 0) &&
+			((ips == NULL) || (depths == NULL) ||
+			(next_hops == NULL))))
+		return -EINVAL;
+
+	/* stop at the first reference to a missing group */
+	if (fib->nh_grp != NULL) {
+		for (i = 0; i < n; i++) {
+			if (!nh_group_check_nh(fib->nh_grp, next_hops[i]))
+				break;
+		}
+		n = i;
+	}
+
+	switch (fib->type) {
+	case RTE_FIB6_TRIE:
+		return trie_add_bulk(fib, ips, depths, next_hops, n);
+	case RTE_FIB6_POPTRIE:
+		return poptrie_add_bulk(fib, ips, depths, next_hops, n);
+	default:
+		for (i = 0; i < n; i++) {
+			if (rte_fib6_add(fib, &ips[i], depths[i],
+					next_hops[i]) != 0)
+				break;
+		}
+		return i;
+	}
+}
+
 int
 rte_fib6_delete(struct rte_fib6 *fib, const struct rte_ipv6_addr *ip,
 	uint8_t depth)
@@ -149,6 +198,20 @@ rte_fib6_lookup_bulk(struct rte_fib6 *fib,
 	return 0;
 }
 
+int
+rte_fib6_lookup_bulk_hash(struct rte_fib6 *fib,
+	const struct rte_ipv6_addr *ips, const uint32_t *hashes,
+	uint64_t *next_hops, int n)
+{
+	FIB6_RETURN_IF_TRUE((fib == NULL) || (ips == NULL) ||
+		(hashes == NULL) || (next_hops == NULL) ||
+		(fib->lookup == NULL), -EINVAL);
+	fib->lookup(fib->dp, ips, next_hops, n);
+	if (fib->nh_grp != NULL)
+		nh_group_resolve_bulk(fib->nh_grp, hashes, next_hops, n);
+	return 0;
+}
+
 struct rte_fib6 *
 rte_fib6_create(const char *name, int socket_id, struct rte_fib6_conf *conf)
 {
@@ -162,7 +225,7 @@ rte_fib6_create(const char *name, int socket_id, struct rte_fib6_conf *conf)
 
 	/* Check user arguments. */
 	if ((name == NULL) || (conf == NULL) || (conf->max_routes < 0) ||
-			(conf->type > RTE_FIB6_TRIE)) {
+			(conf->type > RTE_FIB6_POPTRIE)) {
 		rte_errno = EINVAL;
 		return NULL;
 	}
@@ -216,6 +279,7 @@ rte_fib6_create(const char *name, int socket_id, struct rte_fib6_conf *conf)
 	fib->rib = rib;
 	fib->type = conf->type;
 	fib->def_nh = conf->default_nh;
+	fib->socket_id = socket_id;
 	ret = init_dataplane(fib, socket_id, conf);
 	if (ret < 0) {
 		FIB_LOG(ERR,
@@ -276,6 +340,10 @@ free_dataplane(struct rte_fib6 *fib)
 		return;
 	case RTE_FIB6_TRIE:
 		trie_free(fib->dp);
+		return;
+	case RTE_FIB6_POPTRIE:
+		poptrie_free(fib->dp);
+		return;
 	default:
 		return;
 	}
@@ -305,6 +373,7 @@ rte_fib6_free(struct rte_fib6 *fib)
 	rte_mcfg_tailq_write_unlock();
 
 	free_dataplane(fib);
+	nh_group_free(fib->nh_grp);
 	rte_rib6_free(fib->rib);
 	rte_free(fib);
 	rte_free(te);
@@ -335,7 +404,109 @@ rte_fib6_select_lookup(struct rte_fib6 *fib,
 			return -EINVAL;
 		fib->lookup = fn;
 		return 0;
+	case RTE_FIB6_POPTRIE:
+		fn = poptrie_get_lookup_fn(fib->dp, type);
+		if (fn == NULL)
+			return -EINVAL;
+		fib->lookup = fn;
+		return 0;
 	default:
 		return -EINVAL;
 	}
 }
+
+int
+rte_fib6_rcu_qsbr_add(struct rte_fib6 *fib, struct rte_fib6_rcu_config *cfg)
+{
+	if (fib == NULL)
+		return -EINVAL;
+
+	switch (fib->type) {
+	case RTE_FIB6_POPTRIE:
+		return poptrie_rcu_qsbr_add(fib->dp, cfg, fib->name);
+	default:
+		return -ENOTSUP;
+	}
+}
+
+/* Largest next hop the dataplane can store */
+static uint64_t
+get_dp_max_nh(struct rte_fib6 *fib)
+{
+	switch (fib->type) {
+	case RTE_FIB6_TRIE:
+		return get_max_nh(((struct rte_trie_tbl *)fib->dp)->nh_sz);
+	case RTE_FIB6_POPTRIE:
+		return poptrie_max_nh(((struct rte_poptrie_tbl *)fib->dp)->nh_sz);
+	default:
+		return UINT64_MAX;
+	}
+}
+
+int
+rte_fib6_nh_group_init(struct rte_fib6 *fib,
+	const struct rte_fib6_nh_group_conf *conf)
+{
+	struct rte_rib6_node *node = NULL;
+	struct rte_ipv6_addr zero_ip = { 0 };
+	struct nh_group_tbl *tbl;
+	uint64_t nh;
+
+	if ((fib == NULL) || (conf == NULL))
+		return -EINVAL;
+
+	if (fib->nh_grp != NULL)
+		return -EEXIST;
+
+	tbl = nh_group_create(fib->name, fib->socket_id, conf->num_groups,
+		conf->num_buckets, get_dp_max_nh(fib), fib->def_nh);
+	if (tbl == NULL)
+		return -rte_errno;
+
+	/*
+	 * the next hops of the existing routes must not turn into groups,
+	 * the default route is checked apart as get_nxt skips it
+	 */
+	node = rte_rib6_lookup_exact(fib->rib, &zero_ip, 0);
+	if (node != NULL) {
+		rte_rib6_get_nh(node, &nh);
+		if (nh > tbl->max_nh) {
+			nh_group_free(tbl);
+			return -EINVAL;
+		}
+	}
+	node = NULL;
+	while ((node = rte_rib6_get_nxt(fib->rib, &zero_ip, 0, node,
+			RTE_RIB6_GET_NXT_ALL)) != NULL) {
+		rte_rib6_get_nh(node, &nh);
+		if (nh > tbl->max_nh) {
+			nh_group_free(tbl);
+			return -EINVAL;
+		}
+	}
+
+	fib->nh_grp = tbl;
+	return 0;
+}
+
+int
+rte_fib6_nh_group_set(struct rte_fib6 *fib, uint32_t group,
+	const uint64_t *next_hops, const uint32_t *weights, unsigned int n)
+{
+	if ((fib == NULL) || (fib->nh_grp == NULL))
+		return -EINVAL;
+
+	return nh_group_set(fib->nh_grp, group, next_hops, weights, n);
+}
+
+int
+rte_fib6_nh_group_get_nh(struct rte_fib6 *fib, uint32_t group,
+	uint64_t *next_hop)
+{
+	if ((fib == NULL) || (fib->nh_grp == NULL) || (next_hop == NULL) ||
+			(group >= fib->nh_grp->num_groups))
+		return -EINVAL;
+
+	*next_hop = fib->nh_grp->grp_flag | group;
+	return 0;
+}
@@ -18,7 +18,9 @@
 #include <stdint.h>
 
 #include <rte_common.h>
+#include <rte_compat.h>
 #include <rte_ip6.h>
+#include <rte_rcu_qsbr.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -28,13 +30,27 @@ extern "C" {
 /** Maximum depth value possible for IPv6 FIB. */
 #define RTE_FIB6_MAXDEPTH (RTE_DEPRECATED(RTE_FIB6_MAXDEPTH) RTE_IPV6_MAX_DEPTH)
 
+/** @internal Default RCU defer queue entries to reclaim in one go. */
+#define RTE_FIB6_RCU_DQ_RECLAIM_MAX	16
+/** @internal Default RCU defer queue size. */
+#define RTE_FIB6_RCU_DQ_RECLAIM_SZ	128
+
 struct rte_fib6;
 struct rte_rib6;
 
+/** RCU reclamation modes */
+enum rte_fib6_qsbr_mode {
+	/** Create defer queue for reclaim. */
+	RTE_FIB6_QSBR_MODE_DQ = 0,
+	/** Use blocking mode reclaim. No defer queue created. */
+	RTE_FIB6_QSBR_MODE_SYNC
+};
+
 /** Type of FIB struct */
 enum rte_fib6_type {
 	RTE_FIB6_DUMMY,		/**< RIB6 tree based FIB */
-	RTE_FIB6_TRIE		/**< TRIE based fib  */
+	RTE_FIB6_TRIE,		/**< TRIE based fib  */
+	RTE_FIB6_POPTRIE	/**< Compressed multibit trie based fib */
 };
 
 /** Modify FIB function */
@@ -51,7 +67,7 @@ enum rte_fib6_op {
 	RTE_FIB6_DEL,
 };
 
-/** Size of nexthop (1 << nh_sz) bits for TRIE based FIB */
+/** Size of nexthop (1 << nh_sz) bits for TRIE and POPTRIE based FIB */
 enum rte_fib_trie_nh_sz {
 	RTE_FIB6_TRIE_2B = 1,
 	RTE_FIB6_TRIE_4B,
@@ -63,7 +79,10 @@ enum rte_fib6_lookup_type {
 	RTE_FIB6_LOOKUP_DEFAULT,
 	/**< Selects the best implementation based on the max simd bitwidth */
 	RTE_FIB6_LOOKUP_TRIE_SCALAR, /**< Scalar lookup function implementation*/
-	RTE_FIB6_LOOKUP_TRIE_VECTOR_AVX512 /**< Vector implementation using AVX512 */
+	RTE_FIB6_LOOKUP_TRIE_VECTOR_AVX512, /**< Vector implementation using AVX512 */
+	RTE_FIB6_LOOKUP_TRIE_VECTOR_AVX2, /**< Vector implementation using AVX2 */
+	/** Scalar lookup function implementation for POPTRIE based FIB */
+	RTE_FIB6_LOOKUP_POPTRIE_SCALAR
 };
 
 /** FIB configuration structure */
@@ -79,9 +98,52 @@ struct rte_fib6_conf {
 			enum rte_fib_trie_nh_sz nh_sz;
 			uint32_t	num_tbl8;
 		} trie;
+		/**
+		 * The next hop of a POPTRIE based FIB may use all the bits
+		 * of the entry. Leaves are reserved for 8 per node.
+		 */
+		struct {
+			enum rte_fib_trie_nh_sz nh_sz;
+			uint32_t	num_nodes;
+		} poptrie;
 	};
 };
 
+/** FIB RCU QSBR configuration structure. */
+struct rte_fib6_rcu_config {
+	/** RCU QSBR variable. */
+	struct rte_rcu_qsbr *v;
+	/** Mode of RCU QSBR. See RTE_FIB6_QSBR_MODE_xxx.
+	 * Default: RTE_FIB6_QSBR_MODE_DQ, create defer queue for reclaim.
+	 */
+	enum rte_fib6_qsbr_mode mode;
+	/** RCU defer queue size.
+	 * Default: RTE_FIB6_RCU_DQ_RECLAIM_SZ.
+	 */
+	uint32_t dq_size;
+	/** Threshold to trigger auto reclaim. */
+	uint32_t reclaim_thd;
+	/** Max entries to reclaim in one go.
+	 * Default: RTE_FIB6_RCU_DQ_RECLAIM_MAX.
+	 */
+	uint32_t reclaim_max;
+};
+
+/** FIB next hop groups configuration structure. */
+struct rte_fib6_nh_group_conf {
+	/**
+	 * Number of groups, at most half of the next hop values
+	 * the FIB can store.
+	 */
+	uint32_t num_groups;
+	/**
+	 * Number of buckets per group, a power of two up to 65536.
+	 * Bounds the number of members of a group and sets the precision
+	 * of the weights.
+	 */
+	uint32_t num_buckets;
+};
+
 /**
  * Create FIB
  *
@@ -139,6 +201,44 @@ int
 rte_fib6_add(struct rte_fib6 *fib, const struct rte_ipv6_addr *ip,
 	uint8_t depth, uint64_t next_hop);
 
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice.
+ *
+ * Add a batch of routes to the FIB.
+ *
+ * All the routes are put into the RIB first, then the dataplane is
+ * updated in a single pass over the changed prefixes sorted by address,
+ * so that every entry is written once instead of once per covering
+ * route. Loading into an empty FIB does not walk the RIB at all, and
+ * routes given in address order, as tables are usually dumped, are
+ * not sorted again.
+ *
+ * @param fib
+ *   FIB object handle
+ * @param ips
+ *   Array of IPv6 prefix addresses to be added to the FIB
+ * @param depths
+ *   Array of prefix lengths
+ * @param next_hops
+ *   Array of next hops to be added to the FIB
+ * @param n
+ *   Number of elements in ips, depths and next_hops arrays
+ * @return
+ *   Number of routes added from the start of the arrays, if less than n
+ *   the route at that index is invalid or could not be added and the
+ *   following ones were not tried.
+ *   Negative value if the dataplane could not be updated:
+ *   - -EINVAL - invalid parameters
+ *   - -ENOMEM - memory allocation failure
+ *   - -ENOSPC - no more tbl8 groups or nodes, the RIB holds the routes
+ *     but the dataplane is only partially updated
+ */
+__rte_experimental
+int
+rte_fib6_add_bulk(struct rte_fib6 *fib, const struct rte_ipv6_addr *ips,
+	const uint8_t *depths, const uint64_t *next_hops, unsigned int n);
+
 /**
  * Delete a rule from the FIB.
  *
@@ -177,6 +277,40 @@ rte_fib6_lookup_bulk(struct rte_fib6 *fib,
 	const struct rte_ipv6_addr *ips,
 	uint64_t *next_hops, int n);
 
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice.
+ *
+ * Lookup multiple IP addresses in the FIB, resolving next hop groups.
+ *
+ * Same as rte_fib6_lookup_bulk(), except that when the route of an IP
+ * references a next hop group, the member selected by the hash of the
+ * same index is returned instead of the group reference.
+ *
+ * @param fib
+ *   FIB object handle
+ * @param ips
+ *   Array of IPv6s to be looked up in the FIB
+ * @param hashes
+ *   Array of flow hashes of the packets, e.g. RSS hashes.
+ *   The low bits select the bucket of the group.
+ * @param next_hops
+ *   Next hop of the most specific rule found for IP,
+ *   or member of its group.
+ *   This is an array of eight byte values.
+ *   If the lookup for the given IP failed, then corresponding element would
+ *   contain default nexthop value configured for a FIB.
+ * @param n
+ *   Number of elements in ips, hashes and next_hops arrays to lookup.
+ * @return
+ *   -EINVAL for incorrect arguments, otherwise 0
+ */
+__rte_experimental
+int
+rte_fib6_lookup_bulk_hash(struct rte_fib6 *fib,
+	const struct rte_ipv6_addr *ips, const uint32_t *hashes,
+	uint64_t *next_hops, int n);
+
 /**
  * Get pointer to the dataplane specific struct
  *
@@ -216,6 +350,117 @@ rte_fib6_get_rib(struct rte_fib6 *fib);
 int
 rte_fib6_select_lookup(struct rte_fib6 *fib, enum rte_fib6_lookup_type type);
 
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Associate RCU QSBR variable with a FIB object.
+ *
+ * Without it, a POPTRIE based FIB reuses the nodes and leaves replaced by
+ * an update at once, so lookups must not run while the FIB is modified.
+ *
+ * @param fib
+ *   FIB object handle
+ * @param cfg
+ *   RCU QSBR configuration
+ * @return
+ *   0 on success
+ *   Negative otherwise
+ *   Possible error codes are:
+ *   - -EINVAL - invalid parameters
+ *   - -EEXIST - already added QSBR
+ *   - -ENOMEM - memory allocation failure
+ *   - -ENOTSUP - not supported by configured dataplane algorithm
+ */
+__rte_experimental
+int
+rte_fib6_rcu_qsbr_add(struct rte_fib6 *fib, struct rte_fib6_rcu_config *cfg);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice.
+ *
+ * Enable next hop groups (ECMP) in the FIB.
+ *
+ * A group spreads the traffic of its routes over weighted member next hops.
+ * Groups are referenced by next hops with the most significant bit of
+ * the next hop size set, see rte_fib6_nh_group_get_nh(), so the member and
+ * plain next hops are limited to the lower half of the values.
+ * All the groups are empty at first, and resolve to the default next hop.
+ *
+ * @param fib
+ *   FIB object handle
+ * @param conf
+ *   Next hop groups configuration
+ * @return
+ *   0 on success
+ *   Negative otherwise
+ *   Possible error codes are:
+ *   - -EINVAL - invalid parameters, or the default next hop or the next hop
+ *     of an existing route is in the upper half of the values
+ *   - -EEXIST - next hop groups already enabled
+ *   - -ENOMEM - memory allocation failure
+ */
+__rte_experimental
+int
+rte_fib6_nh_group_init(struct rte_fib6 *fib,
+	const struct rte_fib6_nh_group_conf *conf);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice.
+ *
+ * Set the members of a next hop group.
+ *
+ * Members get a share of the buckets of the group proportional to their
+ * weight. The hashing is resilient: the buckets of a member which is kept
+ * and within its new share keep it, so only the flows of the buckets
+ * which have to change member are moved.
+ * Each bucket is updated atomically, so the lookups may go on meanwhile.
+ *
+ * @param fib
+ *   FIB object handle
+ * @param group
+ *   Group index, lower than the configured number of groups
+ * @param next_hops
+ *   Array of member next hops, without duplicates
+ * @param weights
+ *   Array of the weights of the members, or NULL for equal weights.
+ *   Their sum times the number of buckets must fit in 64 bits.
+ * @param n
+ *   Number of members, at most the number of buckets per group.
+ *   0 empties the group, which then resolves to the default next hop.
+ * @return
+ *   0 on success
+ *   -EINVAL for invalid parameters
+ *   -ENOMEM for memory allocation failure
+ */
+__rte_experimental
+int
+rte_fib6_nh_group_set(struct rte_fib6 *fib, uint32_t group,
+	const uint64_t *next_hops, const uint32_t *weights, unsigned int n);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice.
+ *
+ * Get the next hop referencing a group, to add routes using the group.
+ *
+ * @param fib
+ *   FIB object handle
+ * @param group
+ *   Group index
+ * @param next_hop
+ *   Next hop to give to rte_fib6_add() for the routes of the group
+ * @return
+ *   0 on success
+ *   -EINVAL for invalid parameters
+ */
+__rte_experimental
+int
+rte_fib6_nh_group_get_nh(struct rte_fib6 *fib, uint32_t group,
+	uint64_t *next_hop);
+
 #ifdef __cplusplus
 }
 #endif
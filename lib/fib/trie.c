@@ -5,6 +5,8 @@
 
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include <rte_debug.h>
 #include <rte_malloc.h>
@@ -20,6 +22,12 @@
 
 #endif /* CC_TRIE_AVX512_SUPPORT */
 
+#ifdef CC_TRIE_AVX2_SUPPORT
+
+#include "trie_avx2.h"
+
+#endif /* CC_TRIE_AVX2_SUPPORT */
+
 #define TRIE_NAMESIZE		64
 
 enum edge {
@@ -67,6 +75,29 @@ get_vector_fn(enum rte_fib_trie_nh_sz nh_sz)
 	return NULL;
 }
 
+static inline rte_fib6_lookup_fn_t
+get_avx2_fn(enum rte_fib_trie_nh_sz nh_sz)
+{
+#ifdef CC_TRIE_AVX2_SUPPORT
+	if (rte_cpu_get_flag_enabled(RTE_CPUFLAG_AVX2) <= 0 ||
+			rte_vect_get_max_simd_bitwidth() < RTE_VECT_SIMD_256)
+		return NULL;
+	switch (nh_sz) {
+	case RTE_FIB6_TRIE_2B:
+		return rte_trie_avx2_lookup_bulk_2b;
+	case RTE_FIB6_TRIE_4B:
+		return rte_trie_avx2_lookup_bulk_4b;
+	case RTE_FIB6_TRIE_8B:
+		return rte_trie_avx2_lookup_bulk_8b;
+	default:
+		return NULL;
+	}
+#else
+	RTE_SET_USED(nh_sz);
+#endif
+	return NULL;
+}
+
 rte_fib6_lookup_fn_t
 trie_get_lookup_fn(void *p, enum rte_fib6_lookup_type type)
 {
@@ -84,8 +115,12 @@ trie_get_lookup_fn(void *p, enum rte_fib6_lookup_type type)
 		return get_scalar_fn(nh_sz);
 	case RTE_FIB6_LOOKUP_TRIE_VECTOR_AVX512:
 		return get_vector_fn(nh_sz);
+	case RTE_FIB6_LOOKUP_TRIE_VECTOR_AVX2:
+		return get_avx2_fn(nh_sz);
 	case RTE_FIB6_LOOKUP_DEFAULT:
 		ret_fn = get_vector_fn(nh_sz);
+		if (ret_fn == NULL)
+			ret_fn = get_avx2_fn(nh_sz);
 		return (ret_fn != NULL) ? ret_fn : get_scalar_fn(nh_sz);
 	default:
 		return NULL;
@@ -607,6 +642,206 @@ trie_modify(struct rte_fib6 *fib, const struct rte_ipv6_addr *ip,
 	return -EINVAL;
 }
 
+/* Route changed by a bulk add, the next hop is taken from the RIB node. */
+struct trie_bulk_route {
+	struct rte_ipv6_addr	ip;
+	uint8_t			depth;
+	struct rte_rib6_node	*node;
+};
+
+static int
+bulk_route_cmp(const void *a, const void *b)
+{
+	const struct trie_bulk_route *ra = a;
+	const struct trie_bulk_route *rb = b;
+	int ret;
+
+	ret = memcmp(&ra->ip, &rb->ip, sizeof(ra->ip));
+	if (ret != 0)
+		return ret;
+	return (int)ra->depth - (int)rb->depth;
+}
+
+/*
+ * Build the dataplane of an empty FIB from sorted routes in one pass.
+ * Prefixes either nest or do not overlap, so a stack of the open ones
+ * gives the next hop of every range between two route edges, and each
+ * address is written exactly once. The end of the address space wraps
+ * around to the unspecified address.
+ */
+static int
+install_sorted(struct rte_trie_tbl *dp,
+	const struct trie_bulk_route *routes, unsigned int num)
+{
+	struct {
+		struct rte_ipv6_addr	end;
+		uint64_t		nh;
+	} stack[RTE_IPV6_MAX_DEPTH + 1];
+	struct rte_ipv6_addr pos = RTE_IPV6_ADDR_UNSPEC;
+	unsigned int i, top = 0;
+	bool wrapped = false;
+	int ret;
+
+	for (i = 0; i < num; i++) {
+		if ((i != 0) && (routes[i].depth == routes[i - 1].depth) &&
+				rte_ipv6_addr_eq(&routes[i].ip,
+				&routes[i - 1].ip))
+			continue;
+		/* close the prefixes ending before this one */
+		while ((top != 0) &&
+				!rte_ipv6_addr_is_unspec(&stack[top - 1].end) &&
+				(memcmp(&stack[top - 1].end, &routes[i].ip,
+				RTE_IPV6_ADDR_SIZE) <= 0)) {
+			top--;
+			if (!rte_ipv6_addr_eq(&pos, &stack[top].end)) {
+				ret = install_to_dp(dp, &pos,
+					&stack[top].end, stack[top].nh);
+				if (ret != 0)
+					return ret;
+			}
+			pos = stack[top].end;
+		}
+		if ((top != 0) && !rte_ipv6_addr_eq(&pos, &routes[i].ip)) {
+			ret = install_to_dp(dp, &pos, &routes[i].ip,
+				stack[top - 1].nh);
+			if (ret != 0)
+				return ret;
+		}
+		stack[top].end = routes[i].ip;
+		get_nxt_net(&stack[top].end, routes[i].depth);
+		rte_rib6_get_nh(routes[i].node, &stack[top].nh);
+		top++;
+		pos = routes[i].ip;
+	}
+	while (top != 0) {
+		top--;
+		if (!wrapped && (!rte_ipv6_addr_eq(&pos, &stack[top].end) ||
+				rte_ipv6_addr_is_unspec(&stack[top].end))) {
+			ret = install_to_dp(dp, &pos, &stack[top].end,
+				stack[top].nh);
+			if (ret != 0)
+				return ret;
+		}
+		pos = stack[top].end;
+		wrapped = rte_ipv6_addr_is_unspec(&pos);
+	}
+
+	return 0;
+}
+
+int
+trie_add_bulk(struct rte_fib6 *fib, const struct rte_ipv6_addr *ips,
+	const uint8_t *depths, const uint64_t *next_hops, unsigned int n)
+{
+	struct trie_bulk_route *routes;
+	struct rte_trie_tbl *dp;
+	struct rte_rib6 *rib;
+	struct rte_rib6_node *tmp;
+	struct rte_rib6_node *node;
+	struct rte_ipv6_addr ip_masked;
+	uint64_t node_nh;
+	unsigned int i, added, num = 0;
+	const struct rte_ipv6_addr zero_ip = RTE_IPV6_ADDR_UNSPEC;
+	uint8_t depth, tmp_depth, depth_diff, parent_depth;
+	bool empty, sorted = true;
+	int ret = 0;
+
+	if (n == 0)
+		return 0;
+
+	dp = rte_fib6_get_dp(fib);
+	RTE_ASSERT(dp);
+	rib = rte_fib6_get_rib(fib);
+	RTE_ASSERT(rib);
+
+	routes = rte_malloc(NULL, n * sizeof(*routes), 0);
+	if (routes == NULL)
+		return -ENOMEM;
+
+	/* Nothing but the new routes to write, no RIB walk is needed */
+	empty = (rte_rib6_lookup_exact(rib, &zero_ip, 0) == NULL) &&
+		(rte_rib6_get_nxt(rib, &zero_ip, 0, NULL,
+		RTE_RIB6_GET_NXT_ALL) == NULL);
+
+	/*
+	 * Put all the routes into the RIB first, so that each prefix
+	 * written below already sees all its more specifics and only
+	 * fills the gaps between them.
+	 */
+	for (added = 0; added < n; added++) {
+		depth = depths[added];
+		if ((depth > RTE_IPV6_MAX_DEPTH) ||
+				(next_hops[added] > get_max_nh(dp->nh_sz)))
+			break;
+
+		ip_masked = ips[added];
+		rte_ipv6_addr_mask(&ip_masked, depth);
+		node = rte_rib6_lookup_exact(rib, &ip_masked, depth);
+		if (node != NULL) {
+			rte_rib6_get_nh(node, &node_nh);
+			if (node_nh == next_hops[added])
+				continue;
+		} else {
+			depth_diff = 0;
+			parent_depth = 24;
+			if (depth > 24) {
+				tmp = rte_rib6_get_nxt(rib, &ip_masked,
+					RTE_ALIGN_FLOOR(depth, 8), NULL,
+					RTE_RIB6_GET_NXT_COVER);
+				if (tmp == NULL) {
+					tmp = rte_rib6_lookup(rib, &ips[added]);
+					if (tmp != NULL) {
+						rte_rib6_get_depth(tmp, &tmp_depth);
+						parent_depth = RTE_MAX(tmp_depth, 24);
+					}
+					depth_diff = RTE_ALIGN_CEIL(depth, 8) -
+						RTE_ALIGN_CEIL(parent_depth, 8);
+					depth_diff = depth_diff >> 3;
+				}
+				if (dp->rsvd_tbl8s >=
+						dp->number_tbl8s - depth_diff)
+					break;
+			}
+			node = rte_rib6_insert(rib, &ip_masked, depth);
+			if (node == NULL)
+				break;
+			dp->rsvd_tbl8s += depth_diff;
+		}
+		rte_rib6_set_nh(node, next_hops[added]);
+		routes[num].ip = ip_masked;
+		routes[num].depth = depth;
+		routes[num].node = node;
+		/* tables are usually dumped in order already */
+		if ((num != 0) && sorted)
+			sorted = bulk_route_cmp(&routes[num - 1],
+				&routes[num]) <= 0;
+		num++;
+	}
+
+	/* Write every changed prefix once, in address order. */
+	if (!sorted)
+		qsort(routes, num, sizeof(*routes), bulk_route_cmp);
+	if (empty) {
+		ret = install_sorted(dp, routes, num);
+		num = 0;
+	}
+	for (i = 0; i < num; i++) {
+		if ((i != 0) && (routes[i].depth == routes[i - 1].depth) &&
+				rte_ipv6_addr_eq(&routes[i].ip,
+				&routes[i - 1].ip))
+			continue;
+		rte_rib6_get_nh(routes[i].node, &node_nh);
+		ret = modify_dp(dp, rib, &routes[i].ip, routes[i].depth,
+			node_nh);
+		if (ret != 0)
+			break;
+	}
+
+	rte_free(routes);
+
+	return (ret != 0) ? ret : (int)added;
+}
+
 void *
 trie_create(const char *name, int socket_id,
 	struct rte_fib6_conf *conf)
@@ -0,0 +1,202 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2020 Intel Corporation
+ */
+
+#include <rte_vect.h>
+#include <rte_fib6.h>
+
+#include "trie.h"
+#include "trie_avx2.h"
+
+/*
+ * Transpose 4 byte chunks of 8 ips, so that chunk n of every ip is in
+ * vector n. The ips end up in order 0, 2, 4, 6, 1, 3, 5, 7 of the lanes,
+ * restored once on the result.
+ */
+static __rte_always_inline void
+transpose_x8(const struct rte_ipv6_addr *ips, __m256i chunks[4])
+{
+	__m256i tmp1, tmp2, tmp3, tmp4;
+	__m256i tmp5, tmp6, tmp7, tmp8;
+
+	/* two ips per register, one per 128 bit lane */
+	tmp1 = _mm256_loadu_si256((const void *)&ips[0]);
+	tmp2 = _mm256_loadu_si256((const void *)&ips[2]);
+	tmp3 = _mm256_loadu_si256((const void *)&ips[4]);
+	tmp4 = _mm256_loadu_si256((const void *)&ips[6]);
+
+	tmp5 = _mm256_unpacklo_epi32(tmp1, tmp2);
+	tmp6 = _mm256_unpackhi_epi32(tmp1, tmp2);
+	tmp7 = _mm256_unpacklo_epi32(tmp3, tmp4);
+	tmp8 = _mm256_unpackhi_epi32(tmp3, tmp4);
+
+	chunks[0] = _mm256_unpacklo_epi64(tmp5, tmp7);
+	chunks[1] = _mm256_unpackhi_epi64(tmp5, tmp7);
+	chunks[2] = _mm256_unpacklo_epi64(tmp6, tmp8);
+	chunks[3] = _mm256_unpackhi_epi64(tmp6, tmp8);
+}
+
+/* Transpose 8 byte chunks of 4 ips, keeping the order of the ips */
+static __rte_always_inline void
+transpose_x4(const struct rte_ipv6_addr *ips, __m256i chunks[2])
+{
+	__m256i tmp1, tmp2;
+
+	tmp1 = _mm256_loadu_si256((const void *)&ips[0]);
+	tmp2 = _mm256_loadu_si256((const void *)&ips[2]);
+
+	chunks[0] = _mm256_permute4x64_epi64(
+		_mm256_unpacklo_epi64(tmp1, tmp2), 0xd8);
+	chunks[1] = _mm256_permute4x64_epi64(
+		_mm256_unpackhi_epi64(tmp1, tmp2), 0xd8);
+}
+
+static __rte_always_inline __m256i
+trie_avx2_gather(const void *tbl, __m256i src, __m256i idxes,
+	__m256i msk, int size)
+{
+	__m256i res;
+
+	/* Put it inside branch to make compiler happy with -O0 */
+	if (size == sizeof(uint16_t)) {
+		res = _mm256_mask_i32gather_epi32(src, tbl, idxes, msk, 2);
+		res = _mm256_and_si256(res, _mm256_set1_epi32(UINT16_MAX));
+	} else
+		res = _mm256_mask_i32gather_epi32(src, tbl, idxes, msk, 4);
+
+	return res;
+}
+
+static __rte_always_inline void
+trie_avx2_lookup_x8(void *p, const struct rte_ipv6_addr *ips,
+	uint64_t *next_hops, int size)
+{
+	struct rte_trie_tbl *dp = (struct rte_trie_tbl *)p;
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i all = _mm256_set1_epi32(-1);
+	const __m256i lsb = _mm256_set1_epi32(1);
+	const __m256i lsbyte_msk = _mm256_set1_epi32(0xff);
+	const __m256i unpermute = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+	/* get_tbl24_idx() from the first 4 byte chunk */
+	const __m256i bswap = _mm256_setr_epi8(
+		2, 1, 0, -1, 6, 5, 4, -1, 10, 9, 8, -1, 14, 13, 12, -1,
+		2, 1, 0, -1, 6, 5, 4, -1, 10, 9, 8, -1, 14, 13, 12, -1);
+	__m256i chunks[4];
+	__m256i idxes, res, tmp, bytes, msk_ext, new_msk;
+	int i = 3;
+
+	transpose_x8(ips, chunks);
+
+	/* lookup in tbl24 */
+	res = trie_avx2_gather(dp->tbl24, zero,
+		_mm256_shuffle_epi8(chunks[0], bswap), all, size);
+	msk_ext = _mm256_cmpeq_epi32(_mm256_and_si256(res, lsb), lsb);
+	tmp = res;
+
+	/* traverse down the trie, one byte of the address per level */
+	while (!_mm256_testz_si256(msk_ext, all)) {
+		bytes = _mm256_srl_epi32(chunks[i / 4],
+			_mm_cvtsi32_si128((i % 4) * 8));
+		bytes = _mm256_and_si256(bytes, lsbyte_msk);
+		idxes = _mm256_slli_epi32(_mm256_srli_epi32(tmp, 1), 8);
+		idxes = _mm256_add_epi32(idxes, bytes);
+		tmp = trie_avx2_gather(dp->tbl8, zero, idxes, msk_ext, size);
+		new_msk = _mm256_cmpeq_epi32(_mm256_and_si256(tmp, lsb), lsb);
+		/* lanes which reached a next hop at this level */
+		res = _mm256_blendv_epi8(res, tmp,
+			_mm256_andnot_si256(new_msk, msk_ext));
+		msk_ext = new_msk;
+		i++;
+	}
+
+	res = _mm256_permutevar8x32_epi32(_mm256_srli_epi32(res, 1),
+		unpermute);
+	_mm256_storeu_si256((void *)next_hops,
+		_mm256_cvtepu32_epi64(_mm256_castsi256_si128(res)));
+	_mm256_storeu_si256((void *)(next_hops + 4),
+		_mm256_cvtepu32_epi64(_mm256_extracti128_si256(res, 1)));
+}
+
+static __rte_always_inline void
+trie_avx2_lookup_x4_8b(void *p, const struct rte_ipv6_addr *ips,
+	uint64_t *next_hops)
+{
+	struct rte_trie_tbl *dp = (struct rte_trie_tbl *)p;
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i all = _mm256_set1_epi64x(-1);
+	const __m256i lsb = _mm256_set1_epi64x(1);
+	const __m256i lsbyte_msk = _mm256_set1_epi64x(0xff);
+	/* get_tbl24_idx() from the first 8 byte chunk */
+	const __m256i bswap = _mm256_setr_epi8(
+		2, 1, 0, -1, -1, -1, -1, -1, 10, 9, 8, -1, -1, -1, -1, -1,
+		2, 1, 0, -1, -1, -1, -1, -1, 10, 9, 8, -1, -1, -1, -1, -1);
+	__m256i chunks[2];
+	__m256i idxes, res, tmp, bytes, msk_ext, new_msk;
+	int i = 3;
+
+	transpose_x4(ips, chunks);
+
+	/* lookup in tbl24 */
+	res = _mm256_i64gather_epi64((const void *)dp->tbl24,
+		_mm256_shuffle_epi8(chunks[0], bswap), 8);
+	msk_ext = _mm256_cmpeq_epi64(_mm256_and_si256(res, lsb), lsb);
+	tmp = res;
+
+	/* traverse down the trie, one byte of the address per level */
+	while (!_mm256_testz_si256(msk_ext, all)) {
+		bytes = _mm256_srl_epi64(chunks[i / 8],
+			_mm_cvtsi32_si128((i % 8) * 8));
+		bytes = _mm256_and_si256(bytes, lsbyte_msk);
+		idxes = _mm256_slli_epi64(_mm256_srli_epi64(tmp, 1), 8);
+		idxes = _mm256_add_epi64(idxes, bytes);
+		tmp = _mm256_mask_i64gather_epi64(zero, (const void *)dp->tbl8,
+			idxes, msk_ext, 8);
+		new_msk = _mm256_cmpeq_epi64(_mm256_and_si256(tmp, lsb), lsb);
+		/* lanes which reached a next hop at this level */
+		res = _mm256_blendv_epi8(res, tmp,
+			_mm256_andnot_si256(new_msk, msk_ext));
+		msk_ext = new_msk;
+		i++;
+	}
+
+	_mm256_storeu_si256((void *)next_hops, _mm256_srli_epi64(res, 1));
+}
+
+void
+rte_trie_avx2_lookup_bulk_2b(void *p, const struct rte_ipv6_addr *ips,
+	uint64_t *next_hops, const unsigned int n)
+{
+	uint32_t i;
+	for (i = 0; i < (n / 8); i++) {
+		trie_avx2_lookup_x8(p, &ips[i * 8],
+				next_hops + i * 8, sizeof(uint16_t));
+	}
+	rte_trie_lookup_bulk_2b(p, &ips[i * 8],
+			next_hops + i * 8, n - i * 8);
+}
+
+void
+rte_trie_avx2_lookup_bulk_4b(void *p, const struct rte_ipv6_addr *ips,
+	uint64_t *next_hops, const unsigned int n)
+{
+	uint32_t i;
+	for (i = 0; i < (n / 8); i++) {
+		trie_avx2_lookup_x8(p, &ips[i * 8],
+				next_hops + i * 8, sizeof(uint32_t));
+	}
+	rte_trie_lookup_bulk_4b(p, &ips[i * 8],
+			next_hops + i * 8, n - i * 8);
+}
+
+void
+rte_trie_avx2_lookup_bulk_8b(void *p, const struct rte_ipv6_addr *ips,
+	uint64_t *next_hops, const unsigned int n)
+{
+	uint32_t i;
+	for (i = 0; i < (n / 4); i++) {
+		trie_avx2_lookup_x4_8b(p, &ips[i * 4],
+				next_hops + i * 4);
+	}
+	rte_trie_lookup_bulk_8b(p, &ips[i * 4],
+			next_hops + i * 4, n - i * 4);
+}
@@ -17,7 +17,7 @@
 #define DENSE_HASH_BULK_LOOKUP 1
 
 static inline void
-compare_signatures_dense(uint16_t *hitmask_buffer,
+compare_signatures_dense(uint32_t *hitmask_buffer,
 			const uint16_t *prim_bucket_sigs,
 			const uint16_t *sec_bucket_sigs,
 			uint16_t sig,
@@ -48,7 +48,7 @@ compare_signatures_dense(uint16_t *hitmask_buffer,
 		break;
 	}
 #endif
-#if defined(RTE_HAS_SVE_ACLE)
+#if defined(RTE_HAS_SVE_ACLE) && RTE_HASH_BUCKET_ENTRIES <= 8
 	case RTE_HASH_COMPARE_SVE: {
 		svuint16_t vsign, shift, sv_matches;
 		svbool_t pred, match, bucket_wide_pred;
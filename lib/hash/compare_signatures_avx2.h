@@ -0,0 +1,16 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2010-2016 Intel Corporation
+ * Copyright(c) 2018-2024 Arm Limited
+ */
+
+#ifndef _COMPARE_SIGNATURES_AVX2_H_
+#define _COMPARE_SIGNATURES_AVX2_H_
+
+void
+compare_signatures_sparse_avx2(uint32_t *prim_hash_matches,
+	uint32_t *sec_hash_matches,
+	const struct rte_hash_bucket **prim_bkt,
+	const struct rte_hash_bucket **sec_bkt,
+	const uint16_t *sig, int32_t num_keys);
+
+#endif /* _COMPARE_SIGNATURES_AVX2_H_ */
@@ -0,0 +1,47 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2010-2016 Intel Corporation
+ * Copyright(c) 2018-2024 Arm Limited
+ */
+
+#include <rte_common.h>
+#include <rte_rwlock.h>
+#include <rte_vect.h>
+
+#include "rte_hash.h"
+#include "rte_cuckoo_hash.h"
+#include "compare_signatures_avx512.h"
+
+void
+compare_signatures_sparse_avx512(uint32_t *prim_hash_matches,
+	uint32_t *sec_hash_matches,
+	const struct rte_hash_bucket **prim_bkt,
+	const struct rte_hash_bucket **sec_bkt,
+	const uint16_t *sig, int32_t num_keys)
+{
+	uint32_t matches;
+	int32_t i;
+
+	/* Compare both buckets of a key at once, primary in the low half.
+	 * The mask has one bit per signature, spread it back to
+	 * the sparse layout.
+	 */
+	for (i = 0; i < num_keys; i++) {
+#if RTE_HASH_BUCKET_ENTRIES <= 8
+		matches = _mm256_cmpeq_epi16_mask(
+			_mm256_inserti128_si256(_mm256_castsi128_si256(
+				_mm_load_si128((__m128i const *)prim_bkt[i]->sig_current)),
+				_mm_load_si128((__m128i const *)sec_bkt[i]->sig_current), 1),
+			_mm256_set1_epi16(sig[i]));
+		prim_hash_matches[i] = _pdep_u32(matches & 0xff, 0x5555);
+		sec_hash_matches[i] = _pdep_u32(matches >> 8, 0x5555);
+#else
+		matches = _mm512_cmpeq_epi16_mask(
+			_mm512_inserti64x4(_mm512_castsi256_si512(
+				_mm256_load_si256((__m256i const *)prim_bkt[i]->sig_current)),
+				_mm256_load_si256((__m256i const *)sec_bkt[i]->sig_current), 1),
+			_mm512_set1_epi16(sig[i]));
+		prim_hash_matches[i] = _pdep_u32(matches & 0xffff, 0x55555555);
+		sec_hash_matches[i] = _pdep_u32(matches >> 16, 0x55555555);
+#endif
+	}
+}
@@ -20,7 +20,7 @@
 #define DENSE_HASH_BULK_LOOKUP 1
 
 static inline void
-compare_signatures_dense(uint16_t *hitmask_buffer,
+compare_signatures_dense(uint32_t *hitmask_buffer,
 			const uint16_t *prim_bucket_sigs,
 			const uint16_t *sec_bucket_sigs,
 			uint16_t sig,
@@ -12,6 +12,12 @@
 #include <rte_vect.h>
 
 #include "rte_cuckoo_hash.h"
+#ifdef CC_HASH_AVX2_SUPPORT
+#include "compare_signatures_avx2.h"
+#endif
+#ifdef CC_HASH_AVX512_SUPPORT
+#include "compare_signatures_avx512.h"
+#endif
 
 /* x86's version uses a sparsely packed hitmask buffer: every other bit is padding. */
 #define DENSE_HASH_BULK_LOOKUP 0
@@ -40,6 +46,24 @@ compare_signatures_sparse(uint32_t *prim_hash_matches, uint32_t *sec_hash_matche
 		/* Extract the even-index bits only */
 		*sec_hash_matches &= 0x5555;
 		break;
+#endif
+#if defined(__SSE2__) && RTE_HASH_BUCKET_ENTRIES == 16
+	case RTE_HASH_COMPARE_SSE: {
+		const __m128i vsig = _mm_set1_epi16(sig);
+
+		/* Compare both halves of the bucket */
+		*prim_hash_matches = _mm_movemask_epi8(_mm_cmpeq_epi16(_mm_load_si128(
+			(__m128i const *)prim_bkt->sig_current), vsig)) |
+			(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_load_si128(
+			(__m128i const *)&prim_bkt->sig_current[8]), vsig)) << 16;
+		*prim_hash_matches &= 0x55555555;
+		*sec_hash_matches = _mm_movemask_epi8(_mm_cmpeq_epi16(_mm_load_si128(
+			(__m128i const *)sec_bkt->sig_current), vsig)) |
+			(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_load_si128(
+			(__m128i const *)&sec_bkt->sig_current[8]), vsig)) << 16;
+		*sec_hash_matches &= 0x55555555;
+		break;
+	}
 #endif
 	default:
 		for (i = 0; i < RTE_HASH_BUCKET_ENTRIES; i++) {
@@ -48,4 +72,37 @@ compare_signatures_sparse(uint32_t *prim_hash_matches, uint32_t *sec_hash_matche
 		}
 	}
 }
+
+/* Compare the signatures of a whole burst of keys, the AVX2 and AVX512
+ * versions are built apart and only called when the CPU supports them.
+ */
+static inline void
+compare_signatures_sparse_bulk(uint32_t *prim_hash_matches, uint32_t *sec_hash_matches,
+			const struct rte_hash_bucket **prim_bkt,
+			const struct rte_hash_bucket **sec_bkt,
+			const uint16_t *sig, int32_t num_keys,
+			enum rte_hash_sig_compare_function sig_cmp_fn)
+{
+	int32_t i;
+
+	switch (sig_cmp_fn) {
+#ifdef CC_HASH_AVX2_SUPPORT
+	case RTE_HASH_COMPARE_AVX2:
+		compare_signatures_sparse_avx2(prim_hash_matches, sec_hash_matches,
+			prim_bkt, sec_bkt, sig, num_keys);
+		break;
+#endif
+#ifdef CC_HASH_AVX512_SUPPORT
+	case RTE_HASH_COMPARE_AVX512:
+		compare_signatures_sparse_avx512(prim_hash_matches, sec_hash_matches,
+			prim_bkt, sec_bkt, sig, num_keys);
+		break;
+#endif
+	default:
+		for (i = 0; i < num_keys; i++)
+			compare_signatures_sparse(&prim_hash_matches[i],
+				&sec_hash_matches[i], prim_bkt[i], sec_bkt[i],
+				sig[i], sig_cmp_fn);
+	}
+}
 #endif /* COMPARE_SIGNATURES_X86_H */
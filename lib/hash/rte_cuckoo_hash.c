@@ -33,6 +33,30 @@ RTE_LOG_REGISTER_DEFAULT(hash_logtype, INFO);
 
 #include "rte_cuckoo_hash.h"
 
+/*
+ * Table storing all different key compare functions
+ * (multi-process supported)
+ */
+#if defined(RTE_ARCH_X86) || defined(RTE_ARCH_ARM64)
+static const rte_hash_cmp_eq_t cmp_jump_table[NUM_KEY_CMP_CASES] = {
+	NULL,
+	rte_hash_k16_cmp_eq,
+	rte_hash_k32_cmp_eq,
+	rte_hash_k48_cmp_eq,
+	rte_hash_k64_cmp_eq,
+	rte_hash_k80_cmp_eq,
+	rte_hash_k96_cmp_eq,
+	rte_hash_k112_cmp_eq,
+	rte_hash_k128_cmp_eq,
+	memcmp
+};
+#else
+static const rte_hash_cmp_eq_t cmp_jump_table[NUM_KEY_CMP_CASES] = {
+	NULL,
+	memcmp
+};
+#endif
+
 /* Enum used to select the implementation of the signature comparison function to use
  * eg: a system supporting SVE might want to use a NEON or scalar implementation.
  */
@@ -41,6 +65,8 @@ enum rte_hash_sig_compare_function {
 	RTE_HASH_COMPARE_SSE,
 	RTE_HASH_COMPARE_NEON,
 	RTE_HASH_COMPARE_SVE,
+	RTE_HASH_COMPARE_AVX2,
+	RTE_HASH_COMPARE_AVX512,
 };
 
 #if defined(__ARM_NEON)
@@ -57,13 +83,17 @@ enum rte_hash_sig_compare_function {
 				   RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY | \
 				   RTE_HASH_EXTRA_FLAGS_EXT_TABLE |	\
 				   RTE_HASH_EXTRA_FLAGS_NO_FREE_ON_DEL | \
-				   RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY_LF)
+				   RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY_LF | \
+				   RTE_HASH_EXTRA_FLAGS_RESIZABLE | \
+				   RTE_HASH_EXTRA_FLAGS_AGING)
 
 #define FOR_EACH_BUCKET(CURRENT_BKT, START_BUCKET)                            \
 	for (CURRENT_BKT = START_BUCKET;                                      \
 		CURRENT_BKT != NULL;                                          \
 		CURRENT_BKT = CURRENT_BKT->next)
 
+#define PREFETCH_OFFSET 4
+
 TAILQ_HEAD(rte_hash_list, rte_tailq_entry);
 
 static struct rte_tailq_elem rte_hash_tailq = {
@@ -74,6 +104,7 @@ EAL_REGISTER_TAILQ(rte_hash_tailq)
 struct __rte_hash_rcu_dq_entry {
 	uint32_t key_idx;
 	uint32_t ext_bkt_idx;
+	void *mem; /* Memory of a resizable table to free instead of a key */
 };
 
 struct rte_hash *
@@ -153,6 +184,46 @@ get_alt_bucket_index(const struct rte_hash *h,
 	return (cur_bkt_idx ^ sig) & h->bucket_bitmask;
 }
 
+/* Number of key store chunks holding key slots 0 to n - 1 */
+#define KEY_CHUNKS(n) \
+	(((n) + RTE_HASH_KEY_CHUNK_SLOTS - 1) >> RTE_HASH_KEY_CHUNK_SHIFT)
+
+/* Allocate the missing key store chunks of a resizable table holding key
+ * slots 0 to @num_key_slots - 1. On failure, the chunks already allocated
+ * are kept, they are freed with the table.
+ */
+static int
+__rte_hash_key_chunks_alloc(void **key_chunks, uint32_t num_key_slots,
+			    uint32_t key_entry_size, int socket_id)
+{
+	uint32_t i;
+
+	for (i = 0; i < KEY_CHUNKS(num_key_slots); i++) {
+		if (key_chunks[i] != NULL)
+			continue;
+		key_chunks[i] = rte_zmalloc_socket(NULL,
+				(size_t)key_entry_size * RTE_HASH_KEY_CHUNK_SLOTS,
+				RTE_CACHE_LINE_SIZE, socket_id);
+		if (key_chunks[i] == NULL)
+			return -ENOMEM;
+	}
+
+	return 0;
+}
+
+static void
+__rte_hash_key_chunks_free(void **key_chunks, uint32_t num_key_slots)
+{
+	uint32_t i;
+
+	if (key_chunks == NULL)
+		return;
+
+	for (i = 0; i < KEY_CHUNKS(num_key_slots); i++)
+		rte_free(key_chunks[i]);
+	rte_free(key_chunks);
+}
+
 struct rte_hash *
 rte_hash_create(const struct rte_hash_parameters *params)
 {
@@ -163,6 +234,7 @@ rte_hash_create(const struct rte_hash_parameters *params)
 	struct rte_ring *r_ext = NULL;
 	char hash_name[RTE_HASH_NAMESIZE];
 	void *k = NULL;
+	void **key_chunks = NULL;
 	void *buckets = NULL;
 	void *buckets_ext = NULL;
 	char ring_name[RTE_RING_NAMESIZE];
@@ -177,6 +249,12 @@ rte_hash_create(const struct rte_hash_parameters *params)
 	RTE_ATOMIC(uint32_t) *tbl_chng_cnt = NULL;
 	struct lcore_cache *local_free_slots = NULL;
 	unsigned int readwrite_concur_lf_support = 0;
+	unsigned int resizable = 0;
+	unsigned int aging = 0;
+	uint32_t age_offset = 0;
+	struct rte_hash_table *tbl = NULL;
+	unsigned int max_key_slots;
+	uint32_t entries;
 	uint32_t i;
 
 	rte_hash_function default_hash_func = (rte_hash_function)rte_jhash;
@@ -227,6 +305,15 @@ rte_hash_create(const struct rte_hash_parameters *params)
 		return NULL;
 	}
 
+	if ((params->extra_flag & RTE_HASH_EXTRA_FLAGS_RESIZABLE) &&
+	    (params->extra_flag & (RTE_HASH_EXTRA_FLAGS_EXT_TABLE |
+				   RTE_HASH_EXTRA_FLAGS_MULTI_WRITER_ADD))) {
+		rte_errno = EINVAL;
+		HASH_LOG(ERR, "%s: resizable table cannot have ext table or multi writer",
+			__func__);
+		return NULL;
+	}
+
 	/* Check extra flags field to check extra options. */
 	if (params->extra_flag & RTE_HASH_EXTRA_FLAGS_TRANS_MEM_SUPPORT)
 		hw_trans_mem_support = 1;
@@ -256,6 +343,18 @@ rte_hash_create(const struct rte_hash_parameters *params)
 		no_free_on_del = 1;
 	}
 
+	if (params->extra_flag & RTE_HASH_EXTRA_FLAGS_AGING)
+		aging = 1;
+
+	/* A resizable table starts small, its free slots ring is sized for
+	 * the entries it may grow to.
+	 */
+	entries = params->entries;
+	if (params->extra_flag & RTE_HASH_EXTRA_FLAGS_RESIZABLE) {
+		resizable = 1;
+		entries = RTE_MIN(entries, RTE_HASH_RESIZE_INIT_ENTRIES);
+	}
+
 	/* Store all keys and leave the first entry as a dummy entry for lookup_bulk */
 	if (use_local_cache)
 		/*
@@ -263,21 +362,22 @@ rte_hash_create(const struct rte_hash_parameters *params)
 		 * that can be stored in the lcore caches
 		 * except for the first cache
 		 */
-		num_key_slots = params->entries + (RTE_MAX_LCORE - 1) *
+		num_key_slots = entries + (RTE_MAX_LCORE - 1) *
 					(LCORE_CACHE_SIZE - 1) + 1;
 	else
-		num_key_slots = params->entries + 1;
+		num_key_slots = entries + 1;
+	max_key_slots = num_key_slots + params->entries - entries;
 
 	snprintf(ring_name, sizeof(ring_name), "HT_%s", params->name);
 	/* Create ring (Dummy slot index is not enqueued) */
 	r = rte_ring_create_elem(ring_name, sizeof(uint32_t),
-			rte_align32pow2(num_key_slots), params->socket_id, 0);
+			rte_align32pow2(max_key_slots), params->socket_id, 0);
 	if (r == NULL) {
 		HASH_LOG(ERR, "memory allocation failed");
 		goto err;
 	}
 
-	const uint32_t num_buckets = rte_align32pow2(params->entries) /
+	const uint32_t num_buckets = rte_align32pow2(entries) /
 						RTE_HASH_BUCKET_ENTRIES;
 
 	/* Create ring for extendable buckets. */
@@ -365,17 +465,36 @@ rte_hash_create(const struct rte_hash_parameters *params)
 		}
 	}
 
-	const uint32_t key_entry_size =
+	/* Timestamp of an entry is kept right after its key */
+	if (aging)
+		age_offset = RTE_ALIGN(sizeof(struct rte_hash_key) +
+				params->key_len, sizeof(uint64_t));
+	const uint32_t key_entry_size = aging ?
+		RTE_ALIGN(age_offset + sizeof(uint64_t), KEY_ALIGNMENT) :
 		RTE_ALIGN(sizeof(struct rte_hash_key) + params->key_len,
 			  KEY_ALIGNMENT);
 	const uint64_t key_tbl_size = (uint64_t) key_entry_size * num_key_slots;
 
-	k = rte_zmalloc_socket(NULL, key_tbl_size,
-			RTE_CACHE_LINE_SIZE, params->socket_id);
+	/* Keys of a resizable table are stored in chunks, added as it grows */
+	if (resizable) {
+		key_chunks = rte_zmalloc_socket(NULL,
+				sizeof(void *) * KEY_CHUNKS(max_key_slots),
+				RTE_CACHE_LINE_SIZE, params->socket_id);
+		if (key_chunks == NULL ||
+				__rte_hash_key_chunks_alloc(key_chunks,
+					num_key_slots, key_entry_size,
+					params->socket_id) != 0) {
+			HASH_LOG(ERR, "memory allocation failed");
+			goto err_unlock;
+		}
+	} else {
+		k = rte_zmalloc_socket(NULL, key_tbl_size,
+				RTE_CACHE_LINE_SIZE, params->socket_id);
 
-	if (k == NULL) {
-		HASH_LOG(ERR, "memory allocation failed");
-		goto err_unlock;
+		if (k == NULL) {
+			HASH_LOG(ERR, "memory allocation failed");
+			goto err_unlock;
+		}
 	}
 
 	tbl_chng_cnt = rte_zmalloc_socket(NULL, sizeof(uint32_t),
@@ -386,6 +505,17 @@ rte_hash_create(const struct rte_hash_parameters *params)
 		goto err_unlock;
 	}
 
+	if (resizable) {
+		tbl = rte_zmalloc_socket(NULL, sizeof(struct rte_hash_table),
+				RTE_CACHE_LINE_SIZE, params->socket_id);
+		if (tbl == NULL) {
+			HASH_LOG(ERR, "memory allocation failed");
+			goto err_unlock;
+		}
+		tbl->buckets = buckets;
+		tbl->bucket_bitmask = num_buckets - 1;
+	}
+
 /*
  * If x86 architecture is used, select appropriate compare function,
  * which may use x86 intrinsics, otherwise use memcmp
@@ -444,7 +574,9 @@ rte_hash_create(const struct rte_hash_parameters *params)
 #endif
 	/* Setup hash context */
 	strlcpy(h->name, params->name, sizeof(h->name));
-	h->entries = params->entries;
+	h->entries = entries;
+	h->max_entries = params->entries;
+	h->socket_id = params->socket_id;
 	h->key_len = params->key_len;
 	h->key_entry_size = key_entry_size;
 	h->hash_func_init_val = params->hash_func_init_val;
@@ -457,6 +589,7 @@ rte_hash_create(const struct rte_hash_parameters *params)
 	h->hash_func = (params->hash_func == NULL) ?
 		default_hash_func : params->hash_func;
 	h->key_store = k;
+	h->key_chunks = key_chunks;
 	h->free_slots = r;
 	h->ext_bkt_to_free = ext_bkt_to_free;
 	h->tbl_chng_cnt = tbl_chng_cnt;
@@ -469,10 +602,27 @@ rte_hash_create(const struct rte_hash_parameters *params)
 	h->writer_takes_lock = writer_takes_lock;
 	h->no_free_on_del = no_free_on_del;
 	h->readwrite_concur_lf_support = readwrite_concur_lf_support;
+	h->resizable = resizable;
+	h->tbl = tbl;
+	h->aging = aging;
+	h->age_offset = age_offset;
 
 #if defined(RTE_ARCH_X86)
-	if (rte_cpu_get_flag_enabled(RTE_CPUFLAG_SSE2))
+	if (rte_cpu_get_flag_enabled(RTE_CPUFLAG_SSE2)) {
 		h->sig_cmp_fn = RTE_HASH_COMPARE_SSE;
+#ifdef CC_HASH_AVX2_SUPPORT
+		if (rte_cpu_get_flag_enabled(RTE_CPUFLAG_AVX2) &&
+				rte_vect_get_max_simd_bitwidth() >= RTE_VECT_SIMD_256)
+			h->sig_cmp_fn = RTE_HASH_COMPARE_AVX2;
+#endif
+#ifdef CC_HASH_AVX512_SUPPORT
+		if (rte_cpu_get_flag_enabled(RTE_CPUFLAG_AVX512BW) &&
+				rte_cpu_get_flag_enabled(RTE_CPUFLAG_AVX512VL) &&
+				rte_cpu_get_flag_enabled(RTE_CPUFLAG_BMI2) &&
+				rte_vect_get_max_simd_bitwidth() >= RTE_VECT_SIMD_512)
+			h->sig_cmp_fn = RTE_HASH_COMPARE_AVX512;
+#endif
+	}
 	else
 #elif defined(RTE_ARCH_ARM64)
 	if (rte_cpu_get_flag_enabled(RTE_CPUFLAG_NEON)) {
@@ -519,11 +669,16 @@ rte_hash_create(const struct rte_hash_parameters *params)
 	rte_free(buckets);
 	rte_free(buckets_ext);
 	rte_free(k);
+	__rte_hash_key_chunks_free(key_chunks, max_key_slots);
 	rte_free((void *)(uintptr_t)tbl_chng_cnt);
 	rte_free(ext_bkt_to_free);
+	rte_free(tbl);
 	return NULL;
 }
 
+static void
+__rte_hash_tbl_flush(struct rte_hash *h);
+
 void
 rte_hash_free(struct rte_hash *h)
 {
@@ -555,6 +710,12 @@ rte_hash_free(struct rte_hash *h)
 	if (h->dq)
 		rte_rcu_qsbr_dq_delete(h->dq);
 
+	if (h->resizable) {
+		__rte_hash_tbl_flush(h);
+		rte_free(h->tbl);
+		__rte_hash_key_chunks_free(h->key_chunks, h->max_entries + 1);
+	}
+
 	if (h->use_local_cache)
 		rte_free(h->local_free_slots);
 	if (h->writer_takes_lock)
@@ -587,10 +748,10 @@ rte_hash_max_key_id(const struct rte_hash *h)
 		 * Increase number of slots by total number of indices
 		 * that can be stored in the lcore caches
 		 */
-		return (h->entries + ((RTE_MAX_LCORE - 1) *
+		return (h->max_entries + ((RTE_MAX_LCORE - 1) *
 					(LCORE_CACHE_SIZE - 1)));
 	else
-		return h->entries;
+		return h->max_entries;
 }
 
 int32_t
@@ -662,6 +823,422 @@ __hash_rw_reader_unlock(const struct rte_hash *h)
 		rte_rwlock_read_unlock(h->readwrite_lock);
 }
 
+static inline struct rte_hash_table *
+__hash_tbl(const struct rte_hash *h)
+{
+	return rte_atomic_load_explicit(&h->tbl, rte_memory_order_acquire);
+}
+
+/* Key store entry of a key index. The chunk of a key index of a resizable
+ * table is set before the index is handed out, so that readers which got
+ * the index from a bucket also see its chunk.
+ */
+static inline struct rte_hash_key *
+__hash_key(const struct rte_hash *h, uint32_t key_idx)
+{
+	if (h->resizable)
+		return RTE_PTR_ADD(
+			h->key_chunks[key_idx >> RTE_HASH_KEY_CHUNK_SHIFT],
+			(size_t)(key_idx & (RTE_HASH_KEY_CHUNK_SLOTS - 1)) *
+			h->key_entry_size);
+
+	return RTE_PTR_ADD(h->key_store, (size_t)key_idx * h->key_entry_size);
+}
+
+/* Timestamp of a key entry of a table with aging, 0 until first touched */
+static inline RTE_ATOMIC(uint64_t) *
+__hash_age_ts(const struct rte_hash *h, struct rte_hash_key *k)
+{
+	return (RTE_ATOMIC(uint64_t) *)RTE_PTR_ADD(k, h->age_offset);
+}
+
+/* Readers of the same entry race to refresh it, any of their times will do.
+ * The entry is not written again within the same time unit, so that lookups
+ * of a busy flow from several cores do not bounce its cache line.
+ */
+static inline void
+__hash_age_touch(const struct rte_hash *h, struct rte_hash_key *k,
+		uint64_t now)
+{
+	RTE_ATOMIC(uint64_t) *ts = __hash_age_ts(h, k);
+
+	if (rte_atomic_load_explicit(ts, rte_memory_order_relaxed) < now)
+		rte_atomic_store_explicit(ts, now, rte_memory_order_relaxed);
+}
+
+/* Push the memory replaced by previous geometries of a resizable table to
+ * the RCU defer queue. What does not fit is kept for the next attempt.
+ * Writer is expected to hold the lock while calling this function.
+ */
+static void
+__rte_hash_tbl_defer(struct rte_hash *h, struct rte_hash_table *tbl)
+{
+	struct __rte_hash_rcu_dq_entry rcu_dq_entry = {
+		.key_idx = EMPTY_SLOT,
+		.ext_bkt_idx = EMPTY_SLOT,
+	};
+	struct rte_hash_table *prev, *next;
+
+	if (tbl->retired != NULL) {
+		rcu_dq_entry.mem = tbl->retired;
+		if (rte_rcu_qsbr_dq_enqueue(h->dq, &rcu_dq_entry) != 0)
+			return;
+		tbl->retired = NULL;
+	}
+
+	while (tbl->prev != NULL) {
+		prev = tbl->prev;
+		if (prev->retired != NULL) {
+			rcu_dq_entry.mem = prev->retired;
+			if (rte_rcu_qsbr_dq_enqueue(h->dq, &rcu_dq_entry) != 0)
+				return;
+			prev->retired = NULL;
+		}
+		/* The enqueue may free it right away */
+		next = prev->prev;
+		rcu_dq_entry.mem = prev;
+		if (rte_rcu_qsbr_dq_enqueue(h->dq, &rcu_dq_entry) != 0)
+			return;
+		tbl->prev = next;
+	}
+}
+
+/* Free the memory replaced by previous geometries of a resizable table.
+ * With lock free readers, this is done only once they no longer reference
+ * it: the memory goes to the defer queue in RCU defer queue mode, the
+ * writer waits for a quiescent state in RCU sync mode, and without RCU it
+ * is kept until the caller guarantees there are no readers.
+ * Writer is expected to hold the lock while calling this function.
+ */
+static void
+__rte_hash_tbl_reclaim(struct rte_hash *h, bool no_readers)
+{
+	struct rte_hash_table *tbl = __hash_tbl(h);
+	struct rte_hash_table *prev;
+
+	if (h->readwrite_concur_lf_support && !no_readers) {
+		if (h->hash_rcu_cfg == NULL)
+			return;
+		if (h->dq != NULL) {
+			__rte_hash_tbl_defer(h, tbl);
+			return;
+		}
+		rte_rcu_qsbr_synchronize(h->hash_rcu_cfg->v,
+					 RTE_QSBR_THRID_INVALID);
+	}
+
+	rte_free(tbl->retired);
+	tbl->retired = NULL;
+	while (tbl->prev != NULL) {
+		prev = tbl->prev;
+		tbl->prev = prev->prev;
+		rte_free(prev->retired);
+		rte_free(prev);
+	}
+}
+
+/* Make a new geometry visible to the readers.
+ * Writer is expected to hold the lock while calling this function.
+ */
+static void
+__rte_hash_tbl_publish(struct rte_hash *h, struct rte_hash_table *tbl)
+{
+	tbl->prev = __hash_tbl(h);
+	rte_atomic_store_explicit(&h->tbl, tbl, rte_memory_order_release);
+
+	if (h->readwrite_concur_lf_support) {
+		/* Inform the readers that the table has changed
+		 * Since there is one writer, load acquire on
+		 * tbl_chng_cnt is not required.
+		 */
+		rte_atomic_store_explicit(h->tbl_chng_cnt,
+				 *h->tbl_chng_cnt + 1,
+				 rte_memory_order_release);
+		/* The stores to the buckets should not move above
+		 * the store to tbl_chng_cnt.
+		 */
+		rte_atomic_thread_fence(rte_memory_order_release);
+	}
+
+	__rte_hash_tbl_reclaim(h, false);
+}
+
+/* Drop the old buckets of a growing table along with their entries, and
+ * all the memory of previous geometries. There must be no readers.
+ */
+static void
+__rte_hash_tbl_flush(struct rte_hash *h)
+{
+	struct rte_hash_table *tbl = __hash_tbl(h);
+
+	if (tbl->old_buckets != NULL) {
+		rte_free(tbl->old_buckets);
+		tbl->old_buckets = NULL;
+		rte_free(tbl->next);
+		tbl->next = NULL;
+		rte_free(h->migrated);
+		h->migrated = NULL;
+		h->migrate_left = 0;
+	}
+	__rte_hash_tbl_reclaim(h, true);
+}
+
+static inline bool
+__rte_hash_bkt_moved(const struct rte_hash *h, uint32_t old_bkt_idx)
+{
+	return (h->migrated[old_bkt_idx / 64] >> (old_bkt_idx % 64)) & 1;
+}
+
+/* Move the entries of an old bucket to the larger table. Old bucket i
+ * splits into buckets i and i + number of old buckets of the larger table,
+ * picked by the hash of the stored key since buckets only keep its upper
+ * bits. Nothing is inserted into these two buckets before old bucket i is
+ * moved, so they always have room for its entries.
+ * Return 1 if the bucket is moved now, 0 if it already was.
+ * Writer is expected to hold the lock while calling this function.
+ */
+static uint32_t
+__rte_hash_migrate_bucket(struct rte_hash *h, struct rte_hash_table *tbl,
+			uint32_t old_bkt_idx)
+{
+	struct rte_hash_bucket *old_bkt = &tbl->old_buckets[old_bkt_idx];
+	struct rte_hash_bucket *bkt;
+	struct rte_hash_key *k;
+	uint32_t bkt_idx, key_idx;
+	unsigned int i, j, moved = 0;
+	hash_sig_t sig;
+
+	if (__rte_hash_bkt_moved(h, old_bkt_idx))
+		return 0;
+	h->migrated[old_bkt_idx / 64] |= UINT64_C(1) << (old_bkt_idx % 64);
+	h->migrate_left--;
+
+	for (i = 0; i < RTE_HASH_BUCKET_ENTRIES; i++) {
+		key_idx = old_bkt->key_idx[i];
+		if (key_idx == EMPTY_SLOT)
+			continue;
+
+		k = __hash_key(h, key_idx);
+		sig = rte_hash_hash(h, k->key);
+		bkt_idx = get_prim_bucket_index(h, sig);
+		/* Entry is in its secondary bucket */
+		if ((sig & tbl->old_bucket_bitmask) != old_bkt_idx)
+			bkt_idx = get_alt_bucket_index(h, bkt_idx,
+						old_bkt->sig_current[i]);
+
+		bkt = &h->buckets[bkt_idx];
+		for (j = 0; j < RTE_HASH_BUCKET_ENTRIES; j++) {
+			if (bkt->key_idx[j] == EMPTY_SLOT)
+				break;
+		}
+		RTE_ASSERT(j < RTE_HASH_BUCKET_ENTRIES);
+
+		bkt->sig_current[j] = old_bkt->sig_current[i];
+		/* Store to signature should not leak after
+		 * the store to key_idx.
+		 */
+		rte_atomic_store_explicit(&bkt->key_idx[j], key_idx,
+				 rte_memory_order_release);
+		moved++;
+	}
+
+	if (moved == 0)
+		return 1;
+
+	if (h->readwrite_concur_lf_support) {
+		/* Inform the readers that the table has changed
+		 * Since there is one writer, load acquire on
+		 * tbl_chng_cnt is not required.
+		 */
+		rte_atomic_store_explicit(h->tbl_chng_cnt,
+				 *h->tbl_chng_cnt + 1,
+				 rte_memory_order_release);
+		/* The store to sig_current should
+		 * not move above the store to tbl_chng_cnt.
+		 */
+		rte_atomic_thread_fence(rte_memory_order_release);
+	}
+
+	/* Readers look into the old buckets first, so the entries are only
+	 * removed from there once they are in the new ones.
+	 */
+	for (i = 0; i < RTE_HASH_BUCKET_ENTRIES; i++) {
+		old_bkt->sig_current[i] = NULL_SIGNATURE;
+		rte_atomic_store_explicit(&old_bkt->key_idx[i], EMPTY_SLOT,
+				 rte_memory_order_release);
+	}
+
+	return 1;
+}
+
+/* Move up to @budget old buckets, in order, skipping the ones already
+ * moved, and end the growth once all of them are moved.
+ * Writer is expected to hold the lock while calling this function.
+ */
+static void
+__rte_hash_migrate(struct rte_hash *h, uint32_t budget)
+{
+	struct rte_hash_table *tbl = __hash_tbl(h);
+	struct rte_hash_table *grown;
+
+	if (tbl->old_buckets == NULL)
+		return;
+
+	/* Buckets before migrate_next are all moved */
+	while (budget > 0 && h->migrate_left > 0)
+		budget -= __rte_hash_migrate_bucket(h, tbl, h->migrate_next++);
+
+	if (h->migrate_left > 0)
+		return;
+
+	rte_free(h->migrated);
+	h->migrated = NULL;
+	grown = tbl->next;
+	grown->buckets = tbl->buckets;
+	grown->bucket_bitmask = tbl->bucket_bitmask;
+	grown->retired = tbl->old_buckets;
+	__rte_hash_tbl_publish(h, grown);
+}
+
+/* Move the old buckets a key may still be in before it is inserted, and
+ * give the insertion its budget of old buckets to move.
+ */
+static inline void
+__rte_hash_resize_prepare(struct rte_hash *h, hash_sig_t sig)
+{
+	struct rte_hash_table *tbl = __hash_tbl(h);
+	uint32_t old_bkt_idx;
+
+	if (likely(tbl->old_buckets == NULL))
+		return;
+
+	__hash_rw_writer_lock(h);
+	old_bkt_idx = sig & tbl->old_bucket_bitmask;
+	__rte_hash_migrate_bucket(h, tbl, old_bkt_idx);
+	old_bkt_idx = (old_bkt_idx ^ get_short_sig(sig)) &
+					tbl->old_bucket_bitmask;
+	__rte_hash_migrate_bucket(h, tbl, old_bkt_idx);
+	h->migrate_budget = RTE_HASH_RESIZE_STEP;
+	__hash_rw_writer_unlock(h);
+}
+
+/* Move the old bucket the entries of a bucket of the larger table come from,
+ * so that other entries can be pushed into it while the table grows.
+ * Return false if it is not moved and the insertion has no budget left.
+ */
+static inline bool
+__rte_hash_resize_prepare_bkt(struct rte_hash *h, uint32_t bkt_idx)
+{
+	struct rte_hash_table *tbl = __hash_tbl(h);
+	uint32_t old_bkt_idx;
+
+	if (likely(tbl->old_buckets == NULL))
+		return true;
+
+	old_bkt_idx = bkt_idx & tbl->old_bucket_bitmask;
+	if (__rte_hash_bkt_moved(h, old_bkt_idx))
+		return true;
+	if (h->migrate_budget == 0)
+		return false;
+
+	__hash_rw_writer_lock(h);
+	h->migrate_budget -= __rte_hash_migrate_bucket(h, tbl, old_bkt_idx);
+	__hash_rw_writer_unlock(h);
+	return true;
+}
+
+/* Spend the budget the insertion has left on old buckets in order, so that
+ * the growth makes progress.
+ */
+static inline void
+__rte_hash_resize_finish(struct rte_hash *h)
+{
+	if (likely(__hash_tbl(h)->old_buckets == NULL))
+		return;
+
+	__hash_rw_writer_lock(h);
+	__rte_hash_migrate(h, h->migrate_budget);
+	h->migrate_budget = 0;
+	__hash_rw_writer_unlock(h);
+}
+
+/* Double the capacity of a resizable table. Key slots are added in new
+ * chunks of the key store, the buckets are moved to the larger table by the
+ * following insertions. A table still growing cannot grow again, moving all
+ * its old buckets at once would stall this insertion.
+ * Return 0 if the insertion can be retried, -ENOSPC otherwise.
+ */
+static int
+__rte_hash_grow(struct rte_hash *h)
+{
+	struct rte_hash_table *tbl = NULL, *grown = NULL;
+	struct rte_hash_bucket *buckets = NULL;
+	uint64_t *migrated = NULL;
+	uint32_t entries, num_buckets, num_key_slots, i;
+	int ret = 0;
+
+	__hash_rw_writer_lock(h);
+
+	if (__hash_tbl(h)->old_buckets != NULL ||
+			h->entries >= h->max_entries) {
+		ret = -ENOSPC;
+		goto out;
+	}
+
+	entries = RTE_MIN(h->entries * 2, h->max_entries);
+	num_buckets = rte_align32pow2(entries) / RTE_HASH_BUCKET_ENTRIES;
+	/* No lcore cache, resizable tables have a single writer */
+	num_key_slots = entries + 1;
+
+	tbl = rte_zmalloc_socket(NULL, sizeof(struct rte_hash_table),
+			RTE_CACHE_LINE_SIZE, h->socket_id);
+	grown = rte_zmalloc_socket(NULL, sizeof(struct rte_hash_table),
+			RTE_CACHE_LINE_SIZE, h->socket_id);
+	buckets = rte_zmalloc_socket(NULL,
+			num_buckets * sizeof(struct rte_hash_bucket),
+			RTE_CACHE_LINE_SIZE, h->socket_id);
+	migrated = rte_zmalloc_socket(NULL,
+			RTE_ALIGN_CEIL(h->num_buckets, 64) / 8,
+			RTE_CACHE_LINE_SIZE, h->socket_id);
+	if (tbl == NULL || grown == NULL || buckets == NULL ||
+			migrated == NULL ||
+			__rte_hash_key_chunks_alloc(h->key_chunks, num_key_slots,
+				h->key_entry_size, h->socket_id) != 0) {
+		HASH_LOG(ERR, "%s: memory allocation failed", __func__);
+		rte_free(tbl);
+		rte_free(grown);
+		rte_free(buckets);
+		rte_free(migrated);
+		ret = -ENOSPC;
+		goto out;
+	}
+
+	tbl->buckets = buckets;
+	tbl->bucket_bitmask = num_buckets - 1;
+	tbl->old_buckets = h->buckets;
+	tbl->old_bucket_bitmask = h->bucket_bitmask;
+	tbl->next = grown;
+
+	h->migrate_next = 0;
+	h->migrate_left = h->num_buckets;
+	h->migrate_budget = 0;
+	h->migrated = migrated;
+	h->buckets = buckets;
+	h->num_buckets = num_buckets;
+	h->bucket_bitmask = num_buckets - 1;
+	__rte_hash_tbl_publish(h, tbl);
+
+	/* New key slots are handed out once their chunks are set */
+	i = h->entries + 1;
+	h->entries = entries;
+	for (; i < num_key_slots; i++)
+		rte_ring_sp_enqueue_elem(h->free_slots, &i, sizeof(uint32_t));
+
+out:
+	__hash_rw_writer_unlock(h);
+	return ret;
+}
+
 void
 rte_hash_reset(struct rte_hash *h)
 {
@@ -680,8 +1257,16 @@ rte_hash_reset(struct rte_hash *h)
 			HASH_LOG(ERR, "RCU reclaim all resources failed");
 	}
 
+	if (h->resizable)
+		__rte_hash_tbl_flush(h);
+
 	memset(h->buckets, 0, h->num_buckets * sizeof(struct rte_hash_bucket));
-	memset(h->key_store, 0, h->key_entry_size * (h->entries + 1));
+	if (h->resizable) {
+		for (i = 0; i < KEY_CHUNKS(h->entries + 1); i++)
+			memset(h->key_chunks[i], 0, (size_t)h->key_entry_size *
+					RTE_HASH_KEY_CHUNK_SLOTS);
+	} else
+		memset(h->key_store, 0, h->key_entry_size * (h->entries + 1));
 	*h->tbl_chng_cnt = 0;
 
 	/* reset the free ring */
@@ -745,12 +1330,11 @@ search_and_update(const struct rte_hash *h, void *data, const void *key,
 	struct rte_hash_bucket *bkt, uint16_t sig)
 {
 	int i;
-	struct rte_hash_key *k, *keys = h->key_store;
+	struct rte_hash_key *k;
 
 	for (i = 0; i < RTE_HASH_BUCKET_ENTRIES; i++) {
 		if (bkt->sig_current[i] == sig) {
-			k = (struct rte_hash_key *) ((char *)keys +
-					bkt->key_idx[i] * h->key_entry_size);
+			k = __hash_key(h, bkt->key_idx[i]);
 			if (rte_hash_cmp_eq(key, k->key, h) == 0) {
 				/* The store to application data at *data
 				 * should not leak after the store to pdata
@@ -1007,6 +1591,14 @@ rte_hash_cuckoo_make_space_mw(const struct rte_hash *h,
 			/* Enqueue new node and keep prev node info */
 			alt_idx = get_alt_bucket_index(h, cur_idx,
 						curr_bkt->sig_current[i]);
+			/* Entries of a growing table are only pushed to the
+			 * buckets whose old bucket is moved, within the
+			 * budget of the insertion.
+			 */
+			if (h->resizable && !__rte_hash_resize_prepare_bkt(
+					(struct rte_hash *)(uintptr_t)h,
+					alt_idx))
+				continue;
 			alt_bkt = &(h->buckets[alt_idx]);
 			head->bkt = alt_bkt;
 			head->cur_bkt_idx = alt_idx;
@@ -1053,13 +1645,13 @@ alloc_slot(const struct rte_hash *h, struct lcore_cache *cached_free_slots)
 }
 
 static inline int32_t
-__rte_hash_add_key_with_hash(const struct rte_hash *h, const void *key,
+__rte_hash_add_key_cuckoo(const struct rte_hash *h, const void *key,
 						hash_sig_t sig, void *data)
 {
 	uint16_t short_sig;
 	uint32_t prim_bucket_idx, sec_bucket_idx;
 	struct rte_hash_bucket *prim_bkt, *sec_bkt, *cur_bkt;
-	struct rte_hash_key *new_k, *keys = h->key_store;
+	struct rte_hash_key *new_k;
 	uint32_t ext_bkt_id = 0;
 	uint32_t slot_id;
 	int ret;
@@ -1070,6 +1662,9 @@ __rte_hash_add_key_with_hash(const struct rte_hash *h, const void *key,
 	struct rte_hash_bucket *last;
 
 	short_sig = get_short_sig(sig);
+retry:
+	if (h->resizable)
+		__rte_hash_resize_prepare((struct rte_hash *)(uintptr_t)h, sig);
 	prim_bucket_idx = get_prim_bucket_index(h, sig);
 	sec_bucket_idx = get_alt_bucket_index(h, prim_bucket_idx, short_sig);
 	prim_bkt = &h->buckets[prim_bucket_idx];
@@ -1112,11 +1707,15 @@ __rte_hash_add_key_with_hash(const struct rte_hash *h, const void *key,
 			if (ret == 0)
 				slot_id = alloc_slot(h, cached_free_slots);
 		}
-		if (slot_id == EMPTY_SLOT)
+		if (slot_id == EMPTY_SLOT) {
+			if (h->resizable && __rte_hash_grow(
+					(struct rte_hash *)(uintptr_t)h) == 0)
+				goto retry;
 			return -ENOSPC;
+		}
 	}
 
-	new_k = RTE_PTR_ADD(keys, slot_id * h->key_entry_size);
+	new_k = __hash_key(h, slot_id);
 	/* The store to application data (by the application) at *data should
 	 * not leak after the store of pdata in the key store. i.e. pdata is
 	 * the guard variable. Release the application data to the readers.
@@ -1126,6 +1725,9 @@ __rte_hash_add_key_with_hash(const struct rte_hash *h, const void *key,
 		rte_memory_order_release);
 	/* Copy key */
 	memcpy(new_k->key, key, h->key_len);
+	if (h->aging)
+		rte_atomic_store_explicit(__hash_age_ts(h, new_k), 0,
+				 rte_memory_order_relaxed);
 
 	/* Find an empty slot and insert */
 	ret = rte_hash_cuckoo_insert_mw(h, prim_bkt, sec_bkt, key, data,
@@ -1161,6 +1763,9 @@ __rte_hash_add_key_with_hash(const struct rte_hash *h, const void *key,
 	/* if ext table not enabled, we failed the insertion */
 	if (!h->ext_table_support) {
 		enqueue_slot_back(h, cached_free_slots, slot_id);
+		if (h->resizable && __rte_hash_grow(
+				(struct rte_hash *)(uintptr_t)h) == 0)
+			goto retry;
 		return ret;
 	}
 
@@ -1245,6 +1850,19 @@ __rte_hash_add_key_with_hash(const struct rte_hash *h, const void *key,
 
 }
 
+static inline int32_t
+__rte_hash_add_key_with_hash(const struct rte_hash *h, const void *key,
+						hash_sig_t sig, void *data)
+{
+	int32_t ret;
+
+	ret = __rte_hash_add_key_cuckoo(h, key, sig, data);
+	if (h->resizable)
+		__rte_hash_resize_finish((struct rte_hash *)(uintptr_t)h);
+
+	return ret;
+}
+
 int32_t
 rte_hash_add_key_with_hash(const struct rte_hash *h,
 			const void *key, hash_sig_t sig)
@@ -1288,27 +1906,208 @@ rte_hash_add_key_data(const struct rte_hash *h, const void *key, void *data)
 		return ret;
 }
 
-/* Search one bucket to find the match key - uses rw lock */
-static inline int32_t
-search_one_bucket_l(const struct rte_hash *h, const void *key,
-		uint16_t sig, void **data,
-		const struct rte_hash_bucket *bkt)
+/* Hash a batch of keys to be added or removed, prefetching the keys ahead */
+static inline void
+__bulk_write_hash(const struct rte_hash *h, const void **keys,
+		uint32_t num_keys, hash_sig_t *sig)
 {
-	int i;
-	struct rte_hash_key *k, *keys = h->key_store;
+	uint32_t i;
 
-	for (i = 0; i < RTE_HASH_BUCKET_ENTRIES; i++) {
-		if (bkt->sig_current[i] == sig &&
-				bkt->key_idx[i] != EMPTY_SLOT) {
-			k = (struct rte_hash_key *) ((char *)keys +
-					bkt->key_idx[i] * h->key_entry_size);
+	for (i = 0; i < PREFETCH_OFFSET && i < num_keys; i++)
+		rte_prefetch0(keys[i]);
 
-			if (rte_hash_cmp_eq(key, k->key, h) == 0) {
-				if (data != NULL)
-					*data = k->pdata;
-				/*
-				 * Return index where key is stored,
-				 * subtracting the first dummy index
+	for (i = 0; i < num_keys; i++) {
+		if (i + PREFETCH_OFFSET < num_keys)
+			rte_prefetch0(keys[i + PREFETCH_OFFSET]);
+		sig[i] = rte_hash_hash(h, keys[i]);
+	}
+}
+
+/* Locate and prefetch the primary and secondary buckets of a batch */
+static inline void
+__bulk_write_prefetch_buckets(const struct rte_hash *h, const hash_sig_t *sig,
+		uint32_t num_keys, struct rte_hash_bucket **prim_bkt,
+		struct rte_hash_bucket **sec_bkt)
+{
+	uint32_t i, prim_idx, sec_idx;
+
+	for (i = 0; i < num_keys; i++) {
+		prim_idx = get_prim_bucket_index(h, sig[i]);
+		sec_idx = get_alt_bucket_index(h, prim_idx,
+					get_short_sig(sig[i]));
+		prim_bkt[i] = &h->buckets[prim_idx];
+		sec_bkt[i] = &h->buckets[sec_idx];
+		rte_prefetch0(prim_bkt[i]);
+		rte_prefetch0(sec_bkt[i]);
+	}
+}
+
+/* Insert a key in an empty entry of its primary or secondary bucket, without
+ * pushing other entries around.
+ * Writer is expected to hold the lock while calling this function.
+ * Return the position of the key, or -ENOSPC if it has to go through the
+ * single key path.
+ */
+static inline int32_t
+__rte_hash_add_key_no_move_locked(const struct rte_hash *h, const void *key,
+			uint16_t short_sig, void *data,
+			struct rte_hash_bucket *prim_bkt,
+			struct rte_hash_bucket *sec_bkt,
+			struct lcore_cache *cached_free_slots)
+{
+	struct rte_hash_bucket *bkt, *cur_bkt;
+	struct rte_hash_key *new_k;
+	uint32_t slot_id;
+	unsigned int i;
+	int32_t ret;
+
+	ret = search_and_update(h, data, key, prim_bkt, short_sig);
+	if (ret != -1)
+		return ret;
+
+	FOR_EACH_BUCKET(cur_bkt, sec_bkt) {
+		ret = search_and_update(h, data, key, cur_bkt, short_sig);
+		if (ret != -1)
+			return ret;
+	}
+
+	bkt = prim_bkt;
+	for (i = 0; i < RTE_HASH_BUCKET_ENTRIES; i++) {
+		if (bkt->key_idx[i] == EMPTY_SLOT)
+			break;
+	}
+	if (i == RTE_HASH_BUCKET_ENTRIES) {
+		bkt = sec_bkt;
+		for (i = 0; i < RTE_HASH_BUCKET_ENTRIES; i++) {
+			if (bkt->key_idx[i] == EMPTY_SLOT)
+				break;
+		}
+		if (i == RTE_HASH_BUCKET_ENTRIES)
+			return -ENOSPC;
+	}
+
+	slot_id = alloc_slot(h, cached_free_slots);
+	if (slot_id == EMPTY_SLOT)
+		return -ENOSPC;
+
+	new_k = __hash_key(h, slot_id);
+	/* The store to application data (by the application) at *data should
+	 * not leak after the store of pdata in the key store. i.e. pdata is
+	 * the guard variable. Release the application data to the readers.
+	 */
+	rte_atomic_store_explicit(&new_k->pdata,
+		data,
+		rte_memory_order_release);
+	/* Copy key */
+	memcpy(new_k->key, key, h->key_len);
+	if (h->aging)
+		rte_atomic_store_explicit(__hash_age_ts(h, new_k), 0,
+				 rte_memory_order_relaxed);
+
+	bkt->sig_current[i] = short_sig;
+	/* Store to signature and key should not leak after
+	 * the store to key_idx. i.e. key_idx is the guard variable
+	 * for signature and key.
+	 */
+	rte_atomic_store_explicit(&bkt->key_idx[i],
+			 slot_id,
+			 rte_memory_order_release);
+
+	return slot_id - 1;
+}
+
+/* The keys that fit in their primary or secondary bucket are inserted under
+ * a single writer lock. The others, which need entries to be pushed around,
+ * an extendable bucket, RCU reclaim or the table to grow, go through the
+ * single key path once the lock is released.
+ */
+static inline int
+__rte_hash_add_key_bulk(const struct rte_hash *h, const void **keys,
+			void **data, uint32_t num_keys, int32_t *positions)
+{
+	hash_sig_t sig[RTE_HASH_LOOKUP_BULK_MAX];
+	struct rte_hash_bucket *prim_bkt[RTE_HASH_LOOKUP_BULK_MAX];
+	struct rte_hash_bucket *sec_bkt[RTE_HASH_LOOKUP_BULK_MAX];
+	struct lcore_cache *cached_free_slots = NULL;
+	uint64_t slow_mask = 0;
+	uint32_t i;
+	int added = 0;
+
+	__bulk_write_hash(h, keys, num_keys, sig);
+
+	/* Buckets do not move once the old ones of all the keys are moved,
+	 * the table only grows from the single key path.
+	 */
+	if (h->resizable) {
+		for (i = 0; i < num_keys; i++) {
+			__rte_hash_resize_prepare(
+				(struct rte_hash *)(uintptr_t)h, sig[i]);
+			__rte_hash_resize_finish(
+				(struct rte_hash *)(uintptr_t)h);
+		}
+	}
+
+	__bulk_write_prefetch_buckets(h, sig, num_keys, prim_bkt, sec_bkt);
+
+	if (h->use_local_cache)
+		cached_free_slots = &h->local_free_slots[rte_lcore_id()];
+
+	__hash_rw_writer_lock(h);
+	for (i = 0; i < num_keys; i++) {
+		positions[i] = __rte_hash_add_key_no_move_locked(h, keys[i],
+				get_short_sig(sig[i]),
+				data != NULL ? data[i] : NULL,
+				prim_bkt[i], sec_bkt[i], cached_free_slots);
+		if (positions[i] == -ENOSPC)
+			slow_mask |= 1ULL << i;
+	}
+	__hash_rw_writer_unlock(h);
+
+	while (slow_mask) {
+		i = rte_ctz64(slow_mask);
+		slow_mask &= ~(1ULL << i);
+		positions[i] = __rte_hash_add_key_with_hash(h, keys[i], sig[i],
+				data != NULL ? data[i] : NULL);
+	}
+
+	for (i = 0; i < num_keys; i++)
+		added += (positions[i] >= 0);
+
+	return added;
+}
+
+int
+rte_hash_add_key_bulk_data(const struct rte_hash *h, const void **keys,
+			void **data, uint32_t num_keys, int32_t *positions)
+{
+	RETURN_IF_TRUE(((h == NULL) || (keys == NULL) || (num_keys == 0) ||
+			(num_keys > RTE_HASH_LOOKUP_BULK_MAX) ||
+			(positions == NULL)), -EINVAL);
+
+	return __rte_hash_add_key_bulk(h, keys, data, num_keys, positions);
+}
+
+/* Search one bucket to find the match key - uses rw lock */
+static inline int32_t
+search_one_bucket_l(const struct rte_hash *h, const void *key,
+		uint16_t sig, void **data,
+		const struct rte_hash_bucket *bkt)
+{
+	int i;
+	struct rte_hash_key *k, *keys = h->key_store;
+
+	for (i = 0; i < RTE_HASH_BUCKET_ENTRIES; i++) {
+		if (bkt->sig_current[i] == sig &&
+				bkt->key_idx[i] != EMPTY_SLOT) {
+			k = (struct rte_hash_key *) ((char *)keys +
+					bkt->key_idx[i] * h->key_entry_size);
+
+			if (rte_hash_cmp_eq(key, k->key, h) == 0) {
+				if (data != NULL)
+					*data = k->pdata;
+				/*
+				 * Return index where key is stored,
+				 * subtracting the first dummy index
 				 */
 				return bkt->key_idx[i] - 1;
 			}
@@ -1457,11 +2256,129 @@ __rte_hash_lookup_with_hash_lf(const struct rte_hash *h, const void *key,
 	return -ENOENT;
 }
 
+/* Search one bucket of a resizable table to find the match key. The key
+ * store chunk is loaded after the key index, so that the chunk of a key
+ * added after the table grew is always seen.
+ */
+static inline int32_t
+search_one_bucket_rs(const struct rte_hash *h, const void *key, uint16_t sig,
+			void **data, const struct rte_hash_bucket *bkt)
+{
+	int i;
+	uint32_t key_idx;
+	struct rte_hash_key *k;
+
+	for (i = 0; i < RTE_HASH_BUCKET_ENTRIES; i++) {
+		if (bkt->sig_current[i] == sig) {
+			key_idx = rte_atomic_load_explicit(&bkt->key_idx[i],
+					  rte_memory_order_acquire);
+			if (key_idx != EMPTY_SLOT) {
+				k = __hash_key(h, key_idx);
+
+				if (rte_hash_cmp_eq(key, k->key, h) == 0) {
+					if (data != NULL) {
+						*data = rte_atomic_load_explicit(
+							&k->pdata,
+							rte_memory_order_acquire);
+					}
+					/*
+					 * Return index where key is stored,
+					 * subtracting the first dummy index
+					 */
+					return key_idx - 1;
+				}
+			}
+		}
+	}
+	return -1;
+}
+
+/* Lookup in a resizable table, the caller holds the reader lock if needed.
+ * While the table grows, keys not moved yet are in the old buckets. They
+ * are searched first since entries are removed from them only after being
+ * added to the new ones.
+ */
+static inline int32_t
+__rte_hash_lookup_rs(const struct rte_hash *h, const void *key,
+			hash_sig_t sig, void **data)
+{
+	const struct rte_hash_table *tbl;
+	uint32_t bkt_idx;
+	uint32_t cnt_b, cnt_a;
+	int32_t ret;
+	uint16_t short_sig;
+
+	short_sig = get_short_sig(sig);
+
+	do {
+		/* Load the table change counter before the lookup
+		 * starts. Acquire semantics will make sure that
+		 * loads in search_one_bucket are not hoisted.
+		 */
+		cnt_b = rte_atomic_load_explicit(h->tbl_chng_cnt,
+				rte_memory_order_acquire);
+		tbl = __hash_tbl(h);
+
+		if (tbl->old_buckets != NULL) {
+			bkt_idx = sig & tbl->old_bucket_bitmask;
+			ret = search_one_bucket_rs(h, key, short_sig, data,
+						&tbl->old_buckets[bkt_idx]);
+			if (ret != -1)
+				return ret;
+			bkt_idx = (bkt_idx ^ short_sig) &
+					tbl->old_bucket_bitmask;
+			ret = search_one_bucket_rs(h, key, short_sig, data,
+						&tbl->old_buckets[bkt_idx]);
+			if (ret != -1)
+				return ret;
+		}
+
+		bkt_idx = sig & tbl->bucket_bitmask;
+		ret = search_one_bucket_rs(h, key, short_sig, data,
+					&tbl->buckets[bkt_idx]);
+		if (ret != -1)
+			return ret;
+		bkt_idx = (bkt_idx ^ short_sig) & tbl->bucket_bitmask;
+		ret = search_one_bucket_rs(h, key, short_sig, data,
+					&tbl->buckets[bkt_idx]);
+		if (ret != -1)
+			return ret;
+
+		/* The loads of sig_current in search_one_bucket
+		 * should not move below the load from tbl_chng_cnt.
+		 */
+		rte_atomic_thread_fence(rte_memory_order_acquire);
+		/* Re-read the table change counter to check if the
+		 * table has changed or grown during search. If yes,
+		 * re-do the search.
+		 */
+		cnt_a = rte_atomic_load_explicit(h->tbl_chng_cnt,
+					rte_memory_order_acquire);
+	} while (cnt_b != cnt_a);
+
+	return -ENOENT;
+}
+
+static inline int32_t
+__rte_hash_lookup_with_hash_rs(const struct rte_hash *h, const void *key,
+					hash_sig_t sig, void **data)
+{
+	int32_t ret;
+
+	__hash_rw_reader_lock(h);
+	ret = __rte_hash_lookup_rs(h, key, sig, data);
+	__hash_rw_reader_unlock(h);
+
+	return ret;
+}
+
 static inline int32_t
 __rte_hash_lookup_with_hash(const struct rte_hash *h, const void *key,
 					hash_sig_t sig, void **data)
 {
-	if (h->readwrite_concur_lf_support)
+	if (h->resizable)
+		return __rte_hash_lookup_with_hash_rs(h, key, sig, data);
+	else if (h->readwrite_concur_lf_support)
 		return __rte_hash_lookup_with_hash_lf(h, key, sig, data);
 	else
 		return __rte_hash_lookup_with_hash_l(h, key, sig, data);
@@ -1528,16 +2445,18 @@ __hash_rcu_qsbr_free_resource(void *p, void *e, unsigned int n)
 {
 	void *key_data = NULL;
 	int ret;
-	struct rte_hash_key *keys, *k;
+	struct rte_hash_key *k;
 	struct rte_hash *h = (struct rte_hash *)p;
 	struct __rte_hash_rcu_dq_entry rcu_dq_entry =
 			*((struct __rte_hash_rcu_dq_entry *)e);
 
 	RTE_SET_USED(n);
-	keys = h->key_store;
+	if (rcu_dq_entry.mem != NULL) {
+		rte_free(rcu_dq_entry.mem);
+		return;
+	}
 
-	k = (struct rte_hash_key *) ((char *)keys +
-				rcu_dq_entry.key_idx * h->key_entry_size);
+	k = __hash_key(h, rcu_dq_entry.key_idx);
 	key_data = k->pdata;
 	if (h->hash_rcu_cfg->free_key_data_func)
 		h->hash_rcu_cfg->free_key_data_func(h->hash_rcu_cfg->key_data_ptr,
@@ -1570,8 +2489,8 @@ rte_hash_rcu_qsbr_add(struct rte_hash *h, struct rte_hash_rcu_config *cfg)
 	}
 
 	const uint32_t total_entries = h->use_local_cache ?
-		h->entries + (RTE_MAX_LCORE - 1) * (LCORE_CACHE_SIZE - 1) + 1
-							: h->entries + 1;
+		h->max_entries + (RTE_MAX_LCORE - 1) * (LCORE_CACHE_SIZE - 1) + 1
+							: h->max_entries + 1;
 
 	if (h->hash_rcu_cfg) {
 		rte_errno = EEXIST;
@@ -1711,7 +2630,7 @@ static inline int32_t
 search_and_remove(const struct rte_hash *h, const void *key,
 			struct rte_hash_bucket *bkt, uint16_t sig, int *pos)
 {
-	struct rte_hash_key *k, *keys = h->key_store;
+	struct rte_hash_key *k;
 	unsigned int i;
 	uint32_t key_idx;
 
@@ -1720,8 +2639,7 @@ search_and_remove(const struct rte_hash *h, const void *key,
 		key_idx = rte_atomic_load_explicit(&bkt->key_idx[i],
 					  rte_memory_order_acquire);
 		if (bkt->sig_current[i] == sig && key_idx != EMPTY_SLOT) {
-			k = (struct rte_hash_key *) ((char *)keys +
-					key_idx * h->key_entry_size);
+			k = __hash_key(h, key_idx);
 			if (rte_hash_cmp_eq(key, k->key, h) == 0) {
 				bkt->sig_current[i] = NULL_SIGNATURE;
 				/* Free the key store index if
@@ -1746,8 +2664,37 @@ search_and_remove(const struct rte_hash *h, const void *key,
 	return -1;
 }
 
+/* Search the old buckets of a growing table and remove the matched key.
+ * Writer is expected to hold the lock while calling this function.
+ */
 static inline int32_t
-__rte_hash_del_key_with_hash(const struct rte_hash *h, const void *key,
+search_and_remove_old(const struct rte_hash *h, const void *key,
+			hash_sig_t sig)
+{
+	struct rte_hash_table *tbl = __hash_tbl(h);
+	uint32_t old_bkt_idx;
+	uint16_t short_sig;
+	int32_t ret;
+	int pos;
+
+	if (tbl->old_buckets == NULL)
+		return -1;
+
+	short_sig = get_short_sig(sig);
+	old_bkt_idx = sig & tbl->old_bucket_bitmask;
+	ret = search_and_remove(h, key, &tbl->old_buckets[old_bkt_idx],
+				short_sig, &pos);
+	if (ret != -1)
+		return ret;
+
+	old_bkt_idx = (old_bkt_idx ^ short_sig) & tbl->old_bucket_bitmask;
+	return search_and_remove(h, key, &tbl->old_buckets[old_bkt_idx],
+				short_sig, &pos);
+}
+
+/* Writer is expected to hold the lock while calling this function. */
+static inline int32_t
+__rte_hash_del_key_with_hash_locked(const struct rte_hash *h, const void *key,
 						hash_sig_t sig)
 {
 	uint32_t prim_bucket_idx, sec_bucket_idx;
@@ -1757,14 +2704,24 @@ __rte_hash_del_key_with_hash(const struct rte_hash *h, const void *key,
 	int32_t ret, i;
 	uint16_t short_sig;
 	uint32_t index = EMPTY_SLOT;
-	struct __rte_hash_rcu_dq_entry rcu_dq_entry;
+	struct __rte_hash_rcu_dq_entry rcu_dq_entry = { .mem = NULL };
 
 	short_sig = get_short_sig(sig);
 	prim_bucket_idx = get_prim_bucket_index(h, sig);
 	sec_bucket_idx = get_alt_bucket_index(h, prim_bucket_idx, short_sig);
 	prim_bkt = &h->buckets[prim_bucket_idx];
 
-	__hash_rw_writer_lock(h);
+	/* Key is not moved yet if the table is growing, deleting does not
+	 * move buckets so that it can be done while iterating.
+	 */
+	if (h->resizable) {
+		ret = search_and_remove_old(h, key, sig);
+		if (ret != -1) {
+			last_bkt = NULL;
+			goto return_bkt;
+		}
+	}
+
 	/* look for key in primary bucket */
 	ret = search_and_remove(h, key, prim_bkt, short_sig, &pos);
 	if (ret != -1) {
@@ -1787,7 +2744,6 @@ __rte_hash_del_key_with_hash(const struct rte_hash *h, const void *key,
 		}
 	}
 
-	__hash_rw_writer_unlock(h);
 	return -ENOENT;
 
 /* Search last bucket to see if empty to be recycled */
@@ -1847,6 +2803,17 @@ __rte_hash_del_key_with_hash(const struct rte_hash *h, const void *key,
 			if (rte_rcu_qsbr_dq_enqueue(h->dq, &rcu_dq_entry) != 0)
 				HASH_LOG(ERR, "Failed to push QSBR FIFO");
 	}
+	return ret;
+}
+
+static inline int32_t
+__rte_hash_del_key_with_hash(const struct rte_hash *h, const void *key,
+						hash_sig_t sig)
+{
+	int32_t ret;
+
+	__hash_rw_writer_lock(h);
+	ret = __rte_hash_del_key_with_hash_locked(h, key, sig);
 	__hash_rw_writer_unlock(h);
 	return ret;
 }
@@ -1866,15 +2833,41 @@ rte_hash_del_key(const struct rte_hash *h, const void *key)
 	return __rte_hash_del_key_with_hash(h, key, rte_hash_hash(h, key));
 }
 
+int
+rte_hash_del_key_bulk(const struct rte_hash *h, const void **keys,
+			uint32_t num_keys, int32_t *positions)
+{
+	hash_sig_t sig[RTE_HASH_LOOKUP_BULK_MAX];
+	struct rte_hash_bucket *prim_bkt[RTE_HASH_LOOKUP_BULK_MAX];
+	struct rte_hash_bucket *sec_bkt[RTE_HASH_LOOKUP_BULK_MAX];
+	uint32_t i;
+	int deleted = 0;
+
+	RETURN_IF_TRUE(((h == NULL) || (keys == NULL) || (num_keys == 0) ||
+			(num_keys > RTE_HASH_LOOKUP_BULK_MAX) ||
+			(positions == NULL)), -EINVAL);
+
+	__bulk_write_hash(h, keys, num_keys, sig);
+	__bulk_write_prefetch_buckets(h, sig, num_keys, prim_bkt, sec_bkt);
+
+	__hash_rw_writer_lock(h);
+	for (i = 0; i < num_keys; i++) {
+		positions[i] = __rte_hash_del_key_with_hash_locked(h, keys[i],
+							sig[i]);
+		deleted += (positions[i] >= 0);
+	}
+	__hash_rw_writer_unlock(h);
+
+	return deleted;
+}
+
 int
 rte_hash_get_key_with_position(const struct rte_hash *h, const int32_t position,
 			       void **key)
 {
 	RETURN_IF_TRUE(((h == NULL) || (key == NULL)), -EINVAL);
 
-	struct rte_hash_key *k, *keys = h->key_store;
-	k = (struct rte_hash_key *) ((char *) keys + (position + 1) *
-				     h->key_entry_size);
+	struct rte_hash_key *k = __hash_key(h, position + 1);
 	*key = k->key;
 
 	if (position !=
@@ -1931,7 +2924,7 @@ __bulk_lookup_l(const struct rte_hash *h, const void **keys,
 
 #if DENSE_HASH_BULK_LOOKUP
 	const int hitmask_padding = 0;
-	uint16_t hitmask_buffer[RTE_HASH_LOOKUP_BULK_MAX] = {0};
+	uint32_t hitmask_buffer[RTE_HASH_LOOKUP_BULK_MAX] = {0};
 #else
 	const int hitmask_padding = 1;
 	uint32_t prim_hitmask_buffer[RTE_HASH_LOOKUP_BULK_MAX] = {0};
@@ -1940,20 +2933,24 @@ __bulk_lookup_l(const struct rte_hash *h, const void **keys,
 
 	__hash_rw_reader_lock(h);
 
+#if !DENSE_HASH_BULK_LOOKUP
+	compare_signatures_sparse_bulk(prim_hitmask_buffer, sec_hitmask_buffer,
+		primary_bkt, secondary_bkt, sig, num_keys, h->sig_cmp_fn);
+#endif
+
 	/* Compare signatures and prefetch key slot of first hit */
 	for (i = 0; i < num_keys; i++) {
 #if DENSE_HASH_BULK_LOOKUP
-		uint16_t *hitmask = &hitmask_buffer[i];
+		uint32_t *hitmask = &hitmask_buffer[i];
 		compare_signatures_dense(hitmask,
 			primary_bkt[i]->sig_current,
 			secondary_bkt[i]->sig_current,
 			sig[i], h->sig_cmp_fn);
-		const unsigned int prim_hitmask = *(uint8_t *)(hitmask);
-		const unsigned int sec_hitmask = *((uint8_t *)(hitmask)+1);
+		const unsigned int prim_hitmask = *hitmask &
+				RTE_LEN2MASK(RTE_HASH_BUCKET_ENTRIES, uint32_t);
+		const unsigned int sec_hitmask = *hitmask >>
+				RTE_HASH_BUCKET_ENTRIES;
 #else
-		compare_signatures_sparse(&prim_hitmask_buffer[i], &sec_hitmask_buffer[i],
-			primary_bkt[i], secondary_bkt[i],
-			sig[i], h->sig_cmp_fn);
 		const unsigned int prim_hitmask = prim_hitmask_buffer[i];
 		const unsigned int sec_hitmask = sec_hitmask_buffer[i];
 #endif
@@ -1990,9 +2987,11 @@ __bulk_lookup_l(const struct rte_hash *h, const void **keys,
 	for (i = 0; i < num_keys; i++) {
 		positions[i] = -ENOENT;
 #if DENSE_HASH_BULK_LOOKUP
-		uint16_t *hitmask = &hitmask_buffer[i];
-		unsigned int prim_hitmask = *(uint8_t *)(hitmask);
-		unsigned int sec_hitmask = *((uint8_t *)(hitmask)+1);
+		uint32_t *hitmask = &hitmask_buffer[i];
+		unsigned int prim_hitmask = *hitmask &
+				RTE_LEN2MASK(RTE_HASH_BUCKET_ENTRIES, uint32_t);
+		unsigned int sec_hitmask = *hitmask >>
+				RTE_HASH_BUCKET_ENTRIES;
 #else
 		unsigned int prim_hitmask = prim_hitmask_buffer[i];
 		unsigned int sec_hitmask = sec_hitmask_buffer[i];
@@ -2106,9 +3105,9 @@ __bulk_lookup_lf(const struct rte_hash *h, const void **keys,
 
 #if DENSE_HASH_BULK_LOOKUP
 	const int hitmask_padding = 0;
-	uint16_t hitmask_buffer[RTE_HASH_LOOKUP_BULK_MAX] = {0};
-	static_assert(sizeof(*hitmask_buffer)*8/2 == RTE_HASH_BUCKET_ENTRIES,
-	"The hitmask must be exactly wide enough to accept the whole hitmask chen it is dense");
+	uint32_t hitmask_buffer[RTE_HASH_LOOKUP_BULK_MAX] = {0};
+	static_assert(sizeof(*hitmask_buffer)*8/2 >= RTE_HASH_BUCKET_ENTRIES,
+	"The hitmask must be wide enough to accept the whole hitmask when it is dense");
 #else
 	const int hitmask_padding = 1;
 	uint32_t prim_hitmask_buffer[RTE_HASH_LOOKUP_BULK_MAX] = {0};
@@ -2126,20 +3125,25 @@ __bulk_lookup_lf(const struct rte_hash *h, const void **keys,
 		cnt_b = rte_atomic_load_explicit(h->tbl_chng_cnt,
 					rte_memory_order_acquire);
 
+#if !DENSE_HASH_BULK_LOOKUP
+		compare_signatures_sparse_bulk(prim_hitmask_buffer,
+			sec_hitmask_buffer, primary_bkt, secondary_bkt,
+			sig, num_keys, h->sig_cmp_fn);
+#endif
+
 		/* Compare signatures and prefetch key slot of first hit */
 		for (i = 0; i < num_keys; i++) {
 #if DENSE_HASH_BULK_LOOKUP
-			uint16_t *hitmask = &hitmask_buffer[i];
+			uint32_t *hitmask = &hitmask_buffer[i];
 			compare_signatures_dense(hitmask,
 				primary_bkt[i]->sig_current,
 				secondary_bkt[i]->sig_current,
 				sig[i], h->sig_cmp_fn);
-			const unsigned int prim_hitmask = *(uint8_t *)(hitmask);
-			const unsigned int sec_hitmask = *((uint8_t *)(hitmask)+1);
+			const unsigned int prim_hitmask = *hitmask &
+					RTE_LEN2MASK(RTE_HASH_BUCKET_ENTRIES, uint32_t);
+			const unsigned int sec_hitmask = *hitmask >>
+					RTE_HASH_BUCKET_ENTRIES;
 #else
-			compare_signatures_sparse(&prim_hitmask_buffer[i], &sec_hitmask_buffer[i],
-				primary_bkt[i], secondary_bkt[i],
-				sig[i], h->sig_cmp_fn);
 			const unsigned int prim_hitmask = prim_hitmask_buffer[i];
 			const unsigned int sec_hitmask = sec_hitmask_buffer[i];
 #endif
@@ -2175,9 +3179,11 @@ __bulk_lookup_lf(const struct rte_hash *h, const void **keys,
 		/* Compare keys, first hits in primary first */
 		for (i = 0; i < num_keys; i++) {
 #if DENSE_HASH_BULK_LOOKUP
-			uint16_t *hitmask = &hitmask_buffer[i];
-			unsigned int prim_hitmask = *(uint8_t *)(hitmask);
-			unsigned int sec_hitmask = *((uint8_t *)(hitmask)+1);
+			uint32_t *hitmask = &hitmask_buffer[i];
+			unsigned int prim_hitmask = *hitmask &
+					RTE_LEN2MASK(RTE_HASH_BUCKET_ENTRIES, uint32_t);
+			unsigned int sec_hitmask = *hitmask >>
+					RTE_HASH_BUCKET_ENTRIES;
 #else
 			unsigned int prim_hitmask = prim_hitmask_buffer[i];
 			unsigned int sec_hitmask = sec_hitmask_buffer[i];
@@ -2299,7 +3305,6 @@ __bulk_lookup_lf(const struct rte_hash *h, const void **keys,
 		*hit_mask = hits;
 }
 
-#define PREFETCH_OFFSET 4
 static inline void
 __bulk_lookup_prefetching_loop(const struct rte_hash *h,
 	const void **keys, int32_t num_keys,
@@ -2352,6 +3357,56 @@ __bulk_lookup_prefetching_loop(const struct rte_hash *h,
 	}
 }
 
+/* Bulk lookup in a resizable table. Buckets of all the keys are prefetched
+ * before they are looked up one at a time, as their location depends on
+ * the geometry of the table at the time of each lookup.
+ */
+static inline void
+__rte_hash_lookup_bulk_rs(const struct rte_hash *h, const void **keys,
+			const hash_sig_t *prim_hash, int32_t num_keys,
+			int32_t *positions, uint64_t *hit_mask, void *data[])
+{
+	hash_sig_t hash[RTE_HASH_LOOKUP_BULK_MAX];
+	const struct rte_hash_table *tbl;
+	uint32_t bkt_idx;
+	uint64_t hits = 0;
+	int32_t i;
+
+	if (prim_hash == NULL) {
+		for (i = 0; i < PREFETCH_OFFSET && i < num_keys; i++)
+			rte_prefetch0(keys[i]);
+		for (i = 0; i < num_keys; i++) {
+			if (i + PREFETCH_OFFSET < num_keys)
+				rte_prefetch0(keys[i + PREFETCH_OFFSET]);
+			hash[i] = rte_hash_hash(h, keys[i]);
+		}
+		prim_hash = hash;
+	}
+
+	__hash_rw_reader_lock(h);
+
+	tbl = __hash_tbl(h);
+	for (i = 0; i < num_keys; i++) {
+		rte_prefetch0(keys[i]);
+		bkt_idx = prim_hash[i] & tbl->bucket_bitmask;
+		rte_prefetch0(&tbl->buckets[bkt_idx]);
+		bkt_idx = (bkt_idx ^ get_short_sig(prim_hash[i])) &
+						tbl->bucket_bitmask;
+		rte_prefetch0(&tbl->buckets[bkt_idx]);
+	}
+
+	for (i = 0; i < num_keys; i++) {
+		positions[i] = __rte_hash_lookup_rs(h, keys[i], prim_hash[i],
+					data != NULL ? &data[i] : NULL);
+		if (positions[i] >= 0)
+			hits |= 1ULL << i;
+	}
+
+	__hash_rw_reader_unlock(h);
+
+	if (hit_mask != NULL)
+		*hit_mask = hits;
+}
 
 static inline void
 __rte_hash_lookup_bulk_l(const struct rte_hash *h, const void **keys,
@@ -2390,7 +3445,10 @@ __rte_hash_lookup_bulk(const struct rte_hash *h, const void **keys,
 			int32_t num_keys, int32_t *positions,
 			uint64_t *hit_mask, void *data[])
 {
-	if (h->readwrite_concur_lf_support)
+	if (h->resizable)
+		__rte_hash_lookup_bulk_rs(h, keys, NULL, num_keys, positions,
+					  hit_mask, data);
+	else if (h->readwrite_concur_lf_support)
 		__rte_hash_lookup_bulk_lf(h, keys, num_keys, positions,
 					  hit_mask, data);
 	else
@@ -2502,7 +3560,10 @@ __rte_hash_lookup_with_hash_bulk(const struct rte_hash *h, const void **keys,
 			hash_sig_t *prim_hash, int32_t num_keys,
 			int32_t *positions, uint64_t *hit_mask, void *data[])
 {
-	if (h->readwrite_concur_lf_support)
+	if (h->resizable)
+		__rte_hash_lookup_bulk_rs(h, keys, prim_hash, num_keys,
+					  positions, hit_mask, data);
+	else if (h->readwrite_concur_lf_support)
 		__rte_hash_lookup_with_hash_bulk_lf(h, keys, prim_hash,
 				num_keys, positions, hit_mask, data);
 	else
@@ -2543,6 +3604,57 @@ rte_hash_lookup_with_hash_bulk_data(const struct rte_hash *h,
 	return rte_popcount64(*hit_mask);
 }
 
+/* Iterate a resizable table. While it grows, the old buckets come first.
+ * Deleting keys does not move them, so all keys are seen exactly once if
+ * only deletes happen in between calls.
+ */
+static int32_t
+__rte_hash_iterate_rs(const struct rte_hash *h, const void **key, void **data,
+			uint32_t *next)
+{
+	const struct rte_hash_table *tbl;
+	const struct rte_hash_bucket *bkt;
+	struct rte_hash_key *next_key;
+	uint32_t total_entries_old = 0, total_entries;
+	uint32_t position;
+	int32_t ret = -ENOENT;
+
+	__hash_rw_reader_lock(h);
+
+	tbl = __hash_tbl(h);
+	if (tbl->old_buckets != NULL)
+		total_entries_old = (tbl->old_bucket_bitmask + 1) *
+						RTE_HASH_BUCKET_ENTRIES;
+	total_entries = total_entries_old + (tbl->bucket_bitmask + 1) *
+						RTE_HASH_BUCKET_ENTRIES;
+
+	for (; *next < total_entries; (*next)++) {
+		if (*next < total_entries_old)
+			bkt = &tbl->old_buckets[*next / RTE_HASH_BUCKET_ENTRIES];
+		else
+			bkt = &tbl->buckets[(*next - total_entries_old) /
+						RTE_HASH_BUCKET_ENTRIES];
+		position = rte_atomic_load_explicit(
+				&bkt->key_idx[*next % RTE_HASH_BUCKET_ENTRIES],
+				rte_memory_order_acquire);
+		if (position == EMPTY_SLOT)
+			continue;
+
+		next_key = __hash_key(h, position);
+		/* Return key and data */
+		*key = next_key->key;
+		*data = next_key->pdata;
+		/* Increment iterator */
+		(*next)++;
+		ret = position - 1;
+		break;
+	}
+
+	__hash_rw_reader_unlock(h);
+
+	return ret;
+}
+
 int32_t
 rte_hash_iterate(const struct rte_hash *h, const void **key, void **data, uint32_t *next)
 {
@@ -2551,6 +3663,9 @@ rte_hash_iterate(const struct rte_hash *h, const void **key, void **data, uint32
 
 	RETURN_IF_TRUE(((h == NULL) || (next == NULL)), -EINVAL);
 
+	if (h->resizable)
+		return __rte_hash_iterate_rs(h, key, data, next);
+
 	const uint32_t total_entries_main = h->num_buckets *
 							RTE_HASH_BUCKET_ENTRIES;
 	const uint32_t total_entries = total_entries_main << 1;
@@ -2618,3 +3733,167 @@ rte_hash_iterate(const struct rte_hash *h, const void **key, void **data, uint32
 	(*next)++;
 	return position - 1;
 }
+
+int32_t
+rte_hash_resize_step(const struct rte_hash *h, uint32_t budget)
+{
+	struct rte_hash *w = (struct rte_hash *)(uintptr_t)h;
+	struct rte_hash_table *tbl;
+	int32_t ret = 0;
+
+	RETURN_IF_TRUE((h == NULL), -EINVAL);
+	if (!h->resizable)
+		return -EINVAL;
+
+	__hash_rw_writer_lock(w);
+	__rte_hash_migrate(w, budget);
+	tbl = __hash_tbl(h);
+	if (tbl->old_buckets != NULL)
+		ret = h->migrate_left;
+	__hash_rw_writer_unlock(w);
+
+	return ret;
+}
+
+int
+rte_hash_lookup_bulk_touch(const struct rte_hash *h, const void **keys,
+			   uint32_t num_keys, uint64_t now,
+			   uint64_t *hit_mask, void *data[])
+{
+	int32_t positions[RTE_HASH_LOOKUP_BULK_MAX];
+	struct rte_hash_key *k;
+	uint64_t hits;
+	uint32_t i;
+
+	RETURN_IF_TRUE(((h == NULL) || (keys == NULL) || (num_keys == 0) ||
+			(num_keys > RTE_HASH_LOOKUP_BULK_MAX) ||
+			(hit_mask == NULL)), -EINVAL);
+	if (!h->aging)
+		return -EINVAL;
+
+	__rte_hash_lookup_bulk(h, keys, num_keys, positions, hit_mask, data);
+
+	/* Keys found were just compared, their timestamp is in cache */
+	hits = *hit_mask;
+	while (hits) {
+		i = rte_ctz64(hits);
+		hits &= hits - 1;
+		k = __hash_key(h, positions[i] + 1);
+		__hash_age_touch(h, k, now);
+	}
+
+	/* Return number of hits */
+	return rte_popcount64(*hit_mask);
+}
+
+int
+rte_hash_age_touch(const struct rte_hash *h, int32_t position, uint64_t now)
+{
+	/* Key index where key is stored, adding the first dummy index */
+	uint32_t key_idx = position + 1;
+	struct rte_hash_key *k;
+
+	RETURN_IF_TRUE(((h == NULL) || (key_idx == EMPTY_SLOT)), -EINVAL);
+
+	const uint32_t total_entries = h->use_local_cache ?
+		h->entries + (RTE_MAX_LCORE - 1) * (LCORE_CACHE_SIZE - 1) + 1
+							: h->entries + 1;
+
+	if (!h->aging || key_idx >= total_entries)
+		return -EINVAL;
+
+	k = __hash_key(h, key_idx);
+	__hash_age_touch(h, k, now);
+
+	return 0;
+}
+
+/* Visit the entries of a bucket and of its extendable buckets. The expired
+ * ones are collected before being removed since removal may compact the
+ * linked list into the bucket being visited.
+ * Writer is expected to hold the lock while calling this function.
+ */
+static int32_t
+__rte_hash_age_bucket(const struct rte_hash *h, struct rte_hash_bucket *bkt,
+		uint64_t now, rte_hash_age_cb_t cb, void *p)
+{
+	const void *expired[RTE_HASH_BUCKET_ENTRIES];
+	struct rte_hash_bucket *cur_bkt;
+	struct rte_hash_key *k;
+	RTE_ATOMIC(uint64_t) *ts;
+	unsigned int i, n;
+	uint32_t key_idx;
+	uint64_t stamp;
+	int32_t removed = 0;
+
+	FOR_EACH_BUCKET(cur_bkt, bkt) {
+		n = 0;
+		for (i = 0; i < RTE_HASH_BUCKET_ENTRIES; i++) {
+			key_idx = cur_bkt->key_idx[i];
+			if (key_idx == EMPTY_SLOT)
+				continue;
+
+			k = __hash_key(h, key_idx);
+			ts = __hash_age_ts(h, k);
+			stamp = rte_atomic_load_explicit(ts,
+					rte_memory_order_relaxed);
+			/* Never touched, starts aging now */
+			if (stamp == 0) {
+				rte_atomic_store_explicit(ts, now,
+						rte_memory_order_relaxed);
+				continue;
+			}
+
+			if (cb(p, k->key, k->pdata, key_idx - 1,
+					now > stamp ? now - stamp : 0))
+				expired[n++] = k->key;
+		}
+
+		for (i = 0; i < n; i++) {
+			if (__rte_hash_del_key_with_hash_locked(h, expired[i],
+					rte_hash_hash(h, expired[i])) >= 0)
+				removed++;
+		}
+	}
+
+	return removed;
+}
+
+int32_t
+rte_hash_age_scan(const struct rte_hash *h, uint64_t now, uint32_t budget,
+		  rte_hash_age_cb_t cb, void *p)
+{
+	struct rte_hash *w = (struct rte_hash *)(uintptr_t)h;
+	int32_t removed = 0;
+
+	RETURN_IF_TRUE(((h == NULL) || (cb == NULL)), -EINVAL);
+	if (!h->aging)
+		return -EINVAL;
+
+	__hash_rw_writer_lock(h);
+
+	/* Entries are moving, help the growth end instead */
+	if (h->resizable && __hash_tbl(h)->old_buckets != NULL) {
+		__rte_hash_migrate(w, budget);
+		goto out;
+	}
+
+	budget = RTE_MIN(budget, h->num_buckets);
+	while (budget-- > 0) {
+		w->age_next &= h->bucket_bitmask;
+		removed += __rte_hash_age_bucket(h, &h->buckets[w->age_next],
+						 now, cb, p);
+		w->age_next++;
+	}
+
+out:
+	/* Drain the entries removed by the previous scans */
+	if (h->dq)
+		rte_rcu_qsbr_dq_reclaim(h->dq,
+				h->hash_rcu_cfg->max_reclaim_size,
+				NULL, NULL, NULL);
+
+	__hash_rw_writer_unlock(h);
+
+	return removed;
+}
@@ -52,23 +52,6 @@ enum cmp_jump_table_case {
 	KEY_OTHER_BYTES,
 	NUM_KEY_CMP_CASES,
 };
-
-/*
- * Table storing all different key compare functions
- * (multi-process supported)
- */
-const rte_hash_cmp_eq_t cmp_jump_table[NUM_KEY_CMP_CASES] = {
-	NULL,
-	rte_hash_k16_cmp_eq,
-	rte_hash_k32_cmp_eq,
-	rte_hash_k48_cmp_eq,
-	rte_hash_k64_cmp_eq,
-	rte_hash_k80_cmp_eq,
-	rte_hash_k96_cmp_eq,
-	rte_hash_k112_cmp_eq,
-	rte_hash_k128_cmp_eq,
-	memcmp
-};
 #else
 /*
  * All different options to select a key compare function,
@@ -80,15 +63,6 @@ enum cmp_jump_table_case {
 	NUM_KEY_CMP_CASES,
 };
 
-/*
- * Table storing all different key compare functions
- * (multi-process supported)
- */
-const rte_hash_cmp_eq_t cmp_jump_table[NUM_KEY_CMP_CASES] = {
-	NULL,
-	memcmp
-};
-
 #endif
 
 
@@ -98,13 +72,23 @@ const rte_hash_cmp_eq_t cmp_jump_table[NUM_KEY_CMP_CASES] = {
  * When it is equal to 8, multiple 'struct rte_hash_bucket' can be fit
  * on a single cache line (64 or 128 bytes long) without any gaps
  * in memory between them due to alignment.
+ * Wide buckets of 16 items can be selected at build time, e.g. with
+ * -Dc_args=-DRTE_HASH_BUCKET_ENTRIES=16. Tables then fill up further
+ * before an insertion fails and displace fewer entries, while the 16
+ * signatures of a bucket are still compared by a single AVX2 instruction.
  */
+#ifndef RTE_HASH_BUCKET_ENTRIES
 #define RTE_HASH_BUCKET_ENTRIES		8
+#endif
 
 #if !RTE_IS_POWER_OF_2(RTE_HASH_BUCKET_ENTRIES)
 #error RTE_HASH_BUCKET_ENTRIES must be a power of 2
 #endif
 
+#if RTE_HASH_BUCKET_ENTRIES > 16
+#error RTE_HASH_BUCKET_ENTRIES must not be larger than 16
+#endif
+
 #define NULL_SIGNATURE			0
 
 #define EMPTY_SLOT			0
@@ -115,6 +99,19 @@ const rte_hash_cmp_eq_t cmp_jump_table[NUM_KEY_CMP_CASES] = {
 
 #define RTE_HASH_BFS_QUEUE_MAX_LEN       1000
 
+/** Entries a resizable table is created with, at most. */
+#define RTE_HASH_RESIZE_INIT_ENTRIES	1024U
+
+/**
+ * Old buckets moved to the larger table by each insertion besides the ones
+ * of its key, to make room along a cuckoo path first, then in order.
+ */
+#define RTE_HASH_RESIZE_STEP		2
+
+/** Log2 of the key slots in each chunk of the key store of a resizable table. */
+#define RTE_HASH_KEY_CHUNK_SHIFT	10
+#define RTE_HASH_KEY_CHUNK_SLOTS	(1U << RTE_HASH_KEY_CHUNK_SHIFT)
+
 #define RTE_XABORT_CUCKOO_PATH_INVALIDED 0x4
 
 #define RTE_HASH_TSX_MAX_RETRY  10
@@ -145,6 +142,26 @@ struct __rte_cache_aligned rte_hash_bucket {
 	void *next;
 };
 
+/**
+ * Geometry of a resizable table. Readers never see it modified: a new one
+ * replaces it when the table starts or ends growing, so that lock free
+ * readers always see buckets and bitmasks that belong together.
+ */
+struct rte_hash_table {
+	struct rte_hash_bucket *buckets;
+	/**< Buckets new entries go to. */
+	uint32_t bucket_bitmask;
+	uint32_t old_bucket_bitmask;
+	struct rte_hash_bucket *old_buckets;
+	/**< Buckets being moved to the larger table, NULL if not growing. */
+	void *retired;
+	/**< Memory replaced when this geometry was published. */
+	struct rte_hash_table *prev;
+	/**< Previous geometry, kept until readers cannot reference it. */
+	struct rte_hash_table *next;
+	/**< Geometry published when the growth ends, allocated beforehand. */
+};
+
 /** A hash table structure. */
 struct __rte_cache_aligned rte_hash {
 	char name[RTE_HASH_NAMESIZE];   /**< Name of the hash. */
@@ -185,6 +202,10 @@ struct __rte_cache_aligned rte_hash {
 	/**< If read-write concurrency lock free support is enabled */
 	uint8_t writer_takes_lock;
 	/**< Indicates if the writer threads need to take lock */
+	uint8_t resizable;
+	/**< If the table grows when it is full */
+	uint8_t aging;
+	/**< If entries have a timestamp */
 	rte_hash_function hash_func;    /**< Function used to calculate hash. */
 	uint32_t hash_func_init_val;    /**< Init value used by hash_func. */
 	rte_hash_cmp_eq_t rte_hash_custom_cmp_eq;
@@ -214,6 +235,28 @@ struct __rte_cache_aligned rte_hash {
 	uint32_t *ext_bkt_to_free;
 	RTE_ATOMIC(uint32_t) *tbl_chng_cnt;
 	/**< Indicates if the hash table changed from last read. */
+
+	/* Fields used by resizable tables */
+	uint32_t max_entries;           /**< Entries the table may grow to. */
+	int socket_id;                  /**< NUMA Socket ID for memory. */
+	uint32_t migrate_next;
+	/**< Next old bucket to move in order while the table is growing. */
+	uint32_t migrate_left;
+	/**< Old buckets not moved yet while the table is growing. */
+	uint32_t migrate_budget;
+	/**< Old buckets the current insertion may still move. */
+	uint64_t *migrated;
+	/**< One bit per old bucket, set once it is moved. */
+	RTE_ATOMIC(struct rte_hash_table *) tbl;
+	/**< Current geometry, NULL if the table is not resizable. */
+	void **key_chunks;
+	/**< Key store split in chunks allocated as the table grows, so that
+	 * keys never move. Replaces key_store.
+	 */
+	uint32_t age_offset;
+	/**< Offset of the timestamp in a key entry of a table with aging. */
+	uint32_t age_next;
+	/**< Next bucket to visit by rte_hash_age_scan(). */
 };
 
 struct queue_node {
@@ -55,6 +55,31 @@ extern "C" {
  */
 #define RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY_LF 0x20
 
+/** Flag to let the table grow on demand. The table starts with a small
+ * number of entries and doubles, up to the entries given at creation, each
+ * time an insertion finds it full. Old buckets are moved to the larger table
+ * a few at a time by the following insertions or by rte_hash_resize_step(),
+ * while readers keep finding keys in both tables. Key positions do not change.
+ * Each insertion moves the old buckets of its key and a few more, so that
+ * entries are only pushed into buckets whose old bucket is moved. An
+ * insertion finding no room within this limit while the table is still
+ * growing fails with -ENOSPC, as growing again would first move all the
+ * remaining old buckets.
+ *
+ * Entries are rehashed from the stored key with the hash function of the
+ * table, so hash values passed to the rte_hash_xxx_with_hash APIs must be
+ * the ones returned by rte_hash_hash(). Cannot be combined with
+ * RTE_HASH_EXTRA_FLAGS_EXT_TABLE or RTE_HASH_EXTRA_FLAGS_MULTI_WRITER_ADD.
+ */
+#define RTE_HASH_EXTRA_FLAGS_RESIZABLE 0x40
+
+/** Flag to keep a timestamp with each entry, so that entries no longer
+ * looked up can be expired a few buckets at a time by rte_hash_age_scan()
+ * instead of iterating over the whole table. Timestamps are refreshed by
+ * rte_hash_lookup_bulk_touch() and rte_hash_age_touch().
+ */
+#define RTE_HASH_EXTRA_FLAGS_AGING 0x80
+
 /**
  * The type of hash value of a key.
  * It should be a value of at least 32bit with fully random pattern.
@@ -75,6 +100,25 @@ typedef int (*rte_hash_cmp_eq_t)(const void *key1, const void *key2, size_t key_
  */
 typedef void (*rte_hash_free_key_data)(void *p, void *key_data);
 
+/**
+ * Type of function called by rte_hash_age_scan() for the entries it visits.
+ *
+ * @param p
+ *   Pointer passed to rte_hash_age_scan().
+ * @param key
+ *   Key of the entry.
+ * @param data
+ *   Data of the entry.
+ * @param position
+ *   Position of the entry, as returned when the key was added.
+ * @param age
+ *   Time elapsed since the entry was last touched.
+ * @return
+ *   Non-zero to remove the entry from the table, 0 to keep it.
+ */
+typedef int (*rte_hash_age_cb_t)(void *p, const void *key, void *data,
+				 int32_t position, uint64_t age);
+
 /**
  * Parameters used when creating the hash table.
  */
@@ -698,6 +742,206 @@ __rte_experimental
 int rte_hash_rcu_qsbr_dq_reclaim(struct rte_hash *h, unsigned int *freed,
 		unsigned int *pending, unsigned int *available);
 
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice.
+ *
+ * Move buckets of a growing table to the larger table, so that insertions
+ * do not have to. Typically called by the writer thread when it is idle.
+ * This operation is not multi-thread safe and should only be called from
+ * the writer thread.
+ *
+ * Memory released by a table that is done growing is freed right away,
+ * unless readers may still reference it: with
+ * RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY_LF, it is pushed to the defer queue in
+ * RTE_HASH_QSBR_MODE_DQ, freed once the readers went through a quiescent
+ * state in RTE_HASH_QSBR_MODE_SYNC, or freed by rte_hash_reset() and
+ * rte_hash_free() if RCU QSBR is not attached to the table.
+ *
+ * @param h
+ *   Hash table created with RTE_HASH_EXTRA_FLAGS_RESIZABLE.
+ * @param budget
+ *   Maximum number of old buckets to move.
+ * @return
+ *   - Number of old buckets still to be moved, 0 if the table is not growing.
+ *   - -EINVAL if the parameters are invalid.
+ */
+__rte_experimental
+int32_t
+rte_hash_resize_step(const struct rte_hash *h, uint32_t budget);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice.
+ *
+ * Add multiple key-value pairs to an existing hash table.
+ * Signatures of all the keys are computed and their buckets prefetched
+ * before any of them is inserted, and the keys which fit in their buckets
+ * are inserted under a single acquisition of the writer lock.
+ * This operation is not multi-thread safe
+ * and should only be called from one thread by default.
+ * Thread safety can be enabled by setting flag during
+ * table creation.
+ * If a key exists already in the table, this API updates its value
+ * with the corresponding entry of 'data', as rte_hash_add_key_data() does.
+ * A key present several times in the batch is added once, with the data
+ * of its last occurrence.
+ *
+ * @param h
+ *   Hash table to add the keys to.
+ * @param keys
+ *   A pointer to a list of keys to add.
+ * @param data
+ *   Data to add with each key, NULL to add all the keys without data.
+ * @param num_keys
+ *   How many keys are in the keys list (less than RTE_HASH_LOOKUP_BULK_MAX).
+ * @param positions
+ *   Output containing, for each key, the value rte_hash_add_key() would
+ *   return: its position in the table, or -ENOSPC if there is no space for it.
+ * @return
+ *   - Number of keys added or updated.
+ *   - -EINVAL if the parameters are invalid.
+ */
+__rte_experimental
+int
+rte_hash_add_key_bulk_data(const struct rte_hash *h, const void **keys,
+			   void **data, uint32_t num_keys, int32_t *positions);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice.
+ *
+ * Remove multiple keys from an existing hash table.
+ * Signatures of all the keys are computed and their buckets prefetched
+ * before any of them is removed, and the writer lock is acquired once
+ * for the whole batch.
+ * This operation is not multi-thread safe
+ * and should only be called from one thread by default.
+ * Thread safety can be enabled by setting flag during
+ * table creation.
+ * Key indexes are freed as by rte_hash_del_key().
+ *
+ * @param h
+ *   Hash table to remove the keys from.
+ * @param keys
+ *   A pointer to a list of keys to remove.
+ * @param num_keys
+ *   How many keys are in the keys list (less than RTE_HASH_LOOKUP_BULK_MAX).
+ * @param positions
+ *   Output containing, for each key, the value rte_hash_del_key() would
+ *   return: the position the key was stored at, or -ENOENT if it was not
+ *   found.
+ * @return
+ *   - Number of keys removed.
+ *   - -EINVAL if the parameters are invalid.
+ */
+__rte_experimental
+int
+rte_hash_del_key_bulk(const struct rte_hash *h, const void **keys,
+		      uint32_t num_keys, int32_t *positions);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice.
+ *
+ * Find multiple keys in the hash table and refresh the timestamp of the
+ * keys found, which is stored next to the key already read to compare it.
+ * This operation is multi-thread safe with regarding to other lookup
+ * threads. Read-write concurrency can be enabled by setting flag during
+ * table creation.
+ *
+ * @param h
+ *   Hash table created with RTE_HASH_EXTRA_FLAGS_AGING.
+ * @param keys
+ *   A pointer to a list of keys to look for.
+ * @param num_keys
+ *   How many keys are in the keys list (less than RTE_HASH_LOOKUP_BULK_MAX).
+ * @param now
+ *   Current time, in any unit as long as it is the one given to
+ *   rte_hash_age_scan(). Must not be 0.
+ * @param hit_mask
+ *   Output containing a bitmask with all successful lookups.
+ * @param data
+ *   Output containing array of data returned from all the successful lookups.
+ * @return
+ *   - -EINVAL if there's an error, otherwise number of successful lookups.
+ */
+__rte_experimental
+int
+rte_hash_lookup_bulk_touch(const struct rte_hash *h, const void **keys,
+			   uint32_t num_keys, uint64_t now,
+			   uint64_t *hit_mask, void *data[]);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice.
+ *
+ * Refresh the timestamp of an entry given its position, e.g. right after
+ * the key is added. An entry never touched starts aging from the first
+ * rte_hash_age_scan() that visits it.
+ * This operation is multi-thread safe with regarding to other lookup
+ * threads.
+ *
+ * @param h
+ *   Hash table created with RTE_HASH_EXTRA_FLAGS_AGING.
+ * @param position
+ *   Position returned when the key was added.
+ * @param now
+ *   Current time, must not be 0.
+ * @return
+ *   - 0 if refreshed successfully
+ *   - -EINVAL if the parameters are invalid.
+ */
+__rte_experimental
+int
+rte_hash_age_touch(const struct rte_hash *h, int32_t position, uint64_t now);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice.
+ *
+ * Visit the entries of the next @p budget buckets, resuming where the
+ * previous call stopped, and remove those the callback expires based on
+ * their age. The cost of a call is bounded by the budget whatever the size
+ * of the table, a whole table is swept every number of buckets / budget
+ * calls.
+ * This operation is not multi-thread safe
+ * and should only be called from one thread by default.
+ * Thread safety can be enabled by setting flag during
+ * table creation.
+ *
+ * The callback is called with the writer lock held and must not call the
+ * rte_hash_xxx APIs on this table. Entries are removed as by
+ * rte_hash_del_key(): with internal RCU in defer queue mode, they are
+ * pushed to the defer queue, which this API also reclaims from so that it
+ * is drained by a periodic scan. Without internal RCU and with
+ * RTE_HASH_EXTRA_FLAGS_NO_FREE_ON_DEL or
+ * RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY_LF, the callback is expected to keep
+ * the positions it expires to free them with
+ * rte_hash_free_key_with_position() once readers are done with them.
+ *
+ * While a resizable table grows, the budget is spent on moving its old
+ * buckets instead.
+ *
+ * @param h
+ *   Hash table created with RTE_HASH_EXTRA_FLAGS_AGING.
+ * @param now
+ *   Current time, in the unit of the timestamps. Must not be 0.
+ * @param budget
+ *   Maximum number of buckets to visit.
+ * @param cb
+ *   Function deciding which entries expire.
+ * @param p
+ *   Pointer passed to the callback.
+ * @return
+ *   - Number of entries removed.
+ *   - -EINVAL if the parameters are invalid.
+ */
+__rte_experimental
+int32_t
+rte_hash_age_scan(const struct rte_hash *h, uint64_t now, uint32_t budget,
+		  rte_hash_age_cb_t cb, void *p);
+
 #ifdef __cplusplus
 }
 #endif
@@ -57,6 +57,7 @@ struct __rte_lpm {
 	char name[RTE_LPM_NAMESIZE];        /**< Name of the lpm. */
 	uint32_t max_rules; /**< Max. balanced rules per lpm. */
 	uint32_t number_tbl8s; /**< Number of tbl8s. */
+	int flags; /**< Configuration flags, RTE_LPM_F_*. */
 	/**< Rule info table. */
 	struct rte_lpm_rule_info rule_info[RTE_LPM_MAX_DEPTH];
 	struct rte_lpm_rule *rules_tbl; /**< LPM rules. */
@@ -162,7 +163,8 @@ rte_lpm_create(const char *name, int socket_id,
 
 	/* Check user arguments. */
 	if ((name == NULL) || (socket_id < -1) || (config->max_rules == 0)
-			|| config->number_tbl8s > RTE_LPM_MAX_TBL8_NUM_GROUPS) {
+			|| config->number_tbl8s > RTE_LPM_MAX_TBL8_NUM_GROUPS
+			|| (config->flags & ~RTE_LPM_F_VERSIONED)) {
 		rte_errno = EINVAL;
 		return NULL;
 	}
@@ -235,6 +237,7 @@ rte_lpm_create(const char *name, int socket_id,
 	/* Save user arguments. */
 	i_lpm->max_rules = config->max_rules;
 	i_lpm->number_tbl8s = config->number_tbl8s;
+	i_lpm->flags = config->flags;
 	strlcpy(i_lpm->name, name, sizeof(i_lpm->name));
 
 	te->data = i_lpm;
@@ -573,12 +576,69 @@ tbl8_free(struct __rte_lpm *i_lpm, uint32_t tbl8_group_start)
 	return 0;
 }
 
+/*
+ * In versioned mode, copy a tbl8 group in use to a free one, which is then
+ * modified in place of the group in use and published by tbl8_publish().
+ * Returns the start of the group to modify, which is the group in use
+ * when not in versioned mode or when no tbl8 group is free.
+ */
+static uint32_t
+tbl8_shadow(struct __rte_lpm *i_lpm, uint32_t tbl8_group_start)
+{
+	int32_t tbl8_group_index;
+	uint32_t shadow_start;
+
+	if (!(i_lpm->flags & RTE_LPM_F_VERSIONED))
+		return tbl8_group_start;
+
+	tbl8_group_index = tbl8_alloc(i_lpm);
+	if (tbl8_group_index < 0)
+		return tbl8_group_start;
+
+	shadow_start = tbl8_group_index * RTE_LPM_TBL8_GROUP_NUM_ENTRIES;
+	memcpy(&i_lpm->lpm.tbl8[shadow_start],
+			&i_lpm->lpm.tbl8[tbl8_group_start],
+			RTE_LPM_TBL8_GROUP_NUM_ENTRIES *
+			sizeof(i_lpm->lpm.tbl8[0]));
+
+	return shadow_start;
+}
+
+/*
+ * Point the tbl24 entry to the modified copy of its tbl8 group and free the
+ * group it replaces.
+ */
+static int32_t
+tbl8_publish(struct __rte_lpm *i_lpm, uint32_t tbl24_index,
+		uint32_t shadow_start, uint32_t tbl8_group_start)
+{
+	if (shadow_start == tbl8_group_start)
+		return 0;
+
+	struct rte_lpm_tbl_entry new_tbl24_entry = {
+		.next_hop = shadow_start / RTE_LPM_TBL8_GROUP_NUM_ENTRIES,
+		.valid = VALID,
+		.valid_group = 1,
+		.depth = 0,
+	};
+
+	/* The tbl24 entry must be written only after the
+	 * tbl8 entries are written.
+	 */
+	__atomic_store(&i_lpm->lpm.tbl24[tbl24_index], &new_tbl24_entry,
+			__ATOMIC_RELEASE);
+
+	return tbl8_free(i_lpm, tbl8_group_start);
+}
+
 static __rte_noinline int32_t
 add_depth_small(struct __rte_lpm *i_lpm, uint32_t ip, uint8_t depth,
 		uint32_t next_hop)
 {
 #define group_idx next_hop
 	uint32_t tbl24_index, tbl24_range, tbl8_index, tbl8_group_end, i, j;
+	uint32_t tbl8_group_start;
+	int32_t status;
 
 	/* Calculate the index into Table24. */
 	tbl24_index = ip >> 8;
@@ -612,8 +672,9 @@ add_depth_small(struct __rte_lpm *i_lpm, uint32_t ip, uint8_t depth,
 			/* If tbl24 entry is valid and extended calculate the
 			 *  index into tbl8.
 			 */
-			tbl8_index = i_lpm->lpm.tbl24[i].group_idx *
+			tbl8_group_start = i_lpm->lpm.tbl24[i].group_idx *
 					RTE_LPM_TBL8_GROUP_NUM_ENTRIES;
+			tbl8_index = tbl8_shadow(i_lpm, tbl8_group_start);
 			tbl8_group_end = tbl8_index +
 					RTE_LPM_TBL8_GROUP_NUM_ENTRIES;
 
@@ -639,6 +700,11 @@ add_depth_small(struct __rte_lpm *i_lpm, uint32_t ip, uint8_t depth,
 					continue;
 				}
 			}
+
+			status = tbl8_publish(i_lpm, i, tbl8_index,
+					tbl8_group_start);
+			if (status < 0)
+				return status;
 		}
 	}
 #undef group_idx
@@ -652,7 +718,7 @@ add_depth_big(struct __rte_lpm *i_lpm, uint32_t ip_masked, uint8_t depth,
 #define group_idx next_hop
 	uint32_t tbl24_index;
 	int32_t tbl8_group_index, tbl8_group_start, tbl8_group_end, tbl8_index,
-		tbl8_range, i;
+		tbl8_range, shadow_start, i;
 
 	tbl24_index = (ip_masked >> 8);
 	tbl8_range = depth_to_range(depth);
@@ -767,7 +833,8 @@ add_depth_big(struct __rte_lpm *i_lpm, uint32_t ip_masked, uint8_t depth,
 		tbl8_group_index = i_lpm->lpm.tbl24[tbl24_index].group_idx;
 		tbl8_group_start = tbl8_group_index *
 				RTE_LPM_TBL8_GROUP_NUM_ENTRIES;
-		tbl8_index = tbl8_group_start + (ip_masked & 0xFF);
+		shadow_start = tbl8_shadow(i_lpm, tbl8_group_start);
+		tbl8_index = shadow_start + (ip_masked & 0xFF);
 
 		for (i = tbl8_index; i < (tbl8_index + tbl8_range); i++) {
 
@@ -790,6 +857,9 @@ add_depth_big(struct __rte_lpm *i_lpm, uint32_t ip_masked, uint8_t depth,
 				continue;
 			}
 		}
+
+		return tbl8_publish(i_lpm, tbl24_index, shadow_start,
+				tbl8_group_start);
 	}
 #undef group_idx
 	return 0;
@@ -811,6 +881,10 @@ rte_lpm_add(struct rte_lpm *lpm, uint32_t ip, uint8_t depth,
 		return -EINVAL;
 
 	i_lpm = container_of(lpm, struct __rte_lpm, lpm);
+	/* the groups replaced by versioned updates are released through RCU */
+	if ((i_lpm->flags & RTE_LPM_F_VERSIONED) && (i_lpm->v == NULL))
+		return -EINVAL;
+
 	ip_masked = ip & depth_to_mask(depth);
 
 	/* Add the rule to the rule table. */
@@ -904,7 +978,9 @@ delete_depth_small(struct __rte_lpm *i_lpm, uint32_t ip_masked,
 	uint8_t depth, int32_t sub_rule_index, uint8_t sub_rule_depth)
 {
 #define group_idx next_hop
-	uint32_t tbl24_range, tbl24_index, tbl8_group_index, tbl8_index, i, j;
+	uint32_t tbl24_range, tbl24_index, tbl8_group_index, tbl8_group_start,
+			tbl8_index, i, j;
+	int32_t status;
 
 	/* Calculate the range and index into Table24. */
 	tbl24_range = depth_to_range(depth);
@@ -934,8 +1010,9 @@ delete_depth_small(struct __rte_lpm *i_lpm, uint32_t ip_masked,
 				 */
 
 				tbl8_group_index = i_lpm->lpm.tbl24[i].group_idx;
-				tbl8_index = tbl8_group_index *
+				tbl8_group_start = tbl8_group_index *
 						RTE_LPM_TBL8_GROUP_NUM_ENTRIES;
+				tbl8_index = tbl8_shadow(i_lpm, tbl8_group_start);
 
 				for (j = tbl8_index; j < (tbl8_index +
 					RTE_LPM_TBL8_GROUP_NUM_ENTRIES); j++) {
@@ -943,6 +1020,11 @@ delete_depth_small(struct __rte_lpm *i_lpm, uint32_t ip_masked,
 					if (i_lpm->lpm.tbl8[j].depth <= depth)
 						i_lpm->lpm.tbl8[j].valid = INVALID;
 				}
+
+				status = tbl8_publish(i_lpm, i, tbl8_index,
+						tbl8_group_start);
+				if (status < 0)
+					return status;
 			}
 		}
 	} else {
@@ -980,8 +1062,9 @@ delete_depth_small(struct __rte_lpm *i_lpm, uint32_t ip_masked,
 				 */
 
 				tbl8_group_index = i_lpm->lpm.tbl24[i].group_idx;
-				tbl8_index = tbl8_group_index *
+				tbl8_group_start = tbl8_group_index *
 						RTE_LPM_TBL8_GROUP_NUM_ENTRIES;
+				tbl8_index = tbl8_shadow(i_lpm, tbl8_group_start);
 
 				for (j = tbl8_index; j < (tbl8_index +
 					RTE_LPM_TBL8_GROUP_NUM_ENTRIES); j++) {
@@ -991,6 +1074,11 @@ delete_depth_small(struct __rte_lpm *i_lpm, uint32_t ip_masked,
 							&new_tbl8_entry,
 							__ATOMIC_RELAXED);
 				}
+
+				status = tbl8_publish(i_lpm, i, tbl8_index,
+						tbl8_group_start);
+				if (status < 0)
+					return status;
 			}
 		}
 	}
@@ -1059,8 +1147,10 @@ delete_depth_big(struct __rte_lpm *i_lpm, uint32_t ip_masked,
 {
 #define group_idx next_hop
 	uint32_t tbl24_index, tbl8_group_index, tbl8_group_start, tbl8_index,
-			tbl8_range, i;
+			tbl8_range, shadow_start, i;
 	int32_t tbl8_recycle_index, status = 0;
+	struct rte_lpm_tbl_entry zero_tbl_entry = {0};
+	struct rte_lpm_tbl_entry new_tbl24_entry;
 
 	/*
 	 * Calculate the index into tbl24 and range. Note: All depths larger
@@ -1071,7 +1161,8 @@ delete_depth_big(struct __rte_lpm *i_lpm, uint32_t ip_masked,
 	/* Calculate the index into tbl8 and range. */
 	tbl8_group_index = i_lpm->lpm.tbl24[tbl24_index].group_idx;
 	tbl8_group_start = tbl8_group_index * RTE_LPM_TBL8_GROUP_NUM_ENTRIES;
-	tbl8_index = tbl8_group_start + (ip_masked & 0xFF);
+	shadow_start = tbl8_shadow(i_lpm, tbl8_group_start);
+	tbl8_index = shadow_start + (ip_masked & 0xFF);
 	tbl8_range = depth_to_range(depth);
 
 	if (sub_rule_index < 0) {
@@ -1088,7 +1179,7 @@ delete_depth_big(struct __rte_lpm *i_lpm, uint32_t ip_masked,
 		struct rte_lpm_tbl_entry new_tbl8_entry = {
 			.valid = VALID,
 			.depth = sub_rule_depth,
-			.valid_group = i_lpm->lpm.tbl8[tbl8_group_start].valid_group,
+			.valid_group = i_lpm->lpm.tbl8[shadow_start].valid_group,
 			.next_hop = i_lpm->rules_tbl[sub_rule_index].next_hop,
 		};
 
@@ -1109,32 +1200,35 @@ delete_depth_big(struct __rte_lpm *i_lpm, uint32_t ip_masked,
 	 * associated tbl24 entry.
 	 */
 
-	tbl8_recycle_index = tbl8_recycle_check(i_lpm->lpm.tbl8, tbl8_group_start);
+	tbl8_recycle_index = tbl8_recycle_check(i_lpm->lpm.tbl8, shadow_start);
 
 	if (tbl8_recycle_index == -EINVAL) {
-		/* Set tbl24 before freeing tbl8 to avoid race condition.
-		 * Prevent the free of the tbl8 group from hoisting.
-		 */
-		i_lpm->lpm.tbl24[tbl24_index].valid = 0;
-		rte_atomic_thread_fence(rte_memory_order_release);
-		status = tbl8_free(i_lpm, tbl8_group_start);
+		new_tbl24_entry = zero_tbl_entry;
 	} else if (tbl8_recycle_index > -1) {
 		/* Update tbl24 entry. */
-		struct rte_lpm_tbl_entry new_tbl24_entry = {
+		new_tbl24_entry = (struct rte_lpm_tbl_entry) {
 			.next_hop = i_lpm->lpm.tbl8[tbl8_recycle_index].next_hop,
 			.valid = VALID,
 			.valid_group = 0,
 			.depth = i_lpm->lpm.tbl8[tbl8_recycle_index].depth,
 		};
+	} else {
+		return tbl8_publish(i_lpm, tbl24_index, shadow_start,
+				tbl8_group_start);
+	}
 
-		/* Set tbl24 before freeing tbl8 to avoid race condition.
-		 * Prevent the free of the tbl8 group from hoisting.
-		 */
-		__atomic_store(&i_lpm->lpm.tbl24[tbl24_index], &new_tbl24_entry,
+	/* Set tbl24 before freeing tbl8 to avoid race condition.
+	 * Prevent the free of the tbl8 group from hoisting.
+	 */
+	__atomic_store(&i_lpm->lpm.tbl24[tbl24_index], &new_tbl24_entry,
+			__ATOMIC_RELAXED);
+	rte_atomic_thread_fence(rte_memory_order_release);
+
+	/* The copy was never visible to readers, release it right away. */
+	if (shadow_start != tbl8_group_start)
+		__atomic_store(&i_lpm->lpm.tbl8[shadow_start], &zero_tbl_entry,
 				__ATOMIC_RELAXED);
-		rte_atomic_thread_fence(rte_memory_order_release);
-		status = tbl8_free(i_lpm, tbl8_group_start);
-	}
+	status = tbl8_free(i_lpm, tbl8_group_start);
 #undef group_idx
 	return status;
 }
@@ -1158,6 +1252,10 @@ rte_lpm_delete(struct rte_lpm *lpm, uint32_t ip, uint8_t depth)
 	}
 
 	i_lpm = container_of(lpm, struct __rte_lpm, lpm);
+	/* the groups replaced by versioned updates are released through RCU */
+	if ((i_lpm->flags & RTE_LPM_F_VERSIONED) && (i_lpm->v == NULL))
+		return -EINVAL;
+
 	ip_masked = ip & depth_to_mask(depth);
 
 	/*
@@ -73,6 +73,19 @@ enum rte_lpm_qsbr_mode {
 	RTE_LPM_QSBR_MODE_SYNC
 };
 
+/**
+ * Versioned update mode.
+ *
+ * A tbl8 group in use is never modified: a route change affecting it is
+ * applied to a copy, which replaces the group with a single store of its
+ * tbl24 entry once complete, so that a lookup never sees a change in
+ * progress. Replaced groups are released as configured with
+ * rte_lpm_rcu_qsbr_add(), which must be called before any rule is added or
+ * deleted. A change is applied to the group in use when no tbl8 group is
+ * free for the copy.
+ */
+#define RTE_LPM_F_VERSIONED	0x1
+
 #if RTE_BYTE_ORDER == RTE_LITTLE_ENDIAN
 /** @internal Tbl24 entry structure. */
 __extension__
@@ -113,7 +126,11 @@ struct rte_lpm_tbl_entry {
 struct rte_lpm_config {
 	uint32_t max_rules;      /**< Max number of rules. */
 	uint32_t number_tbl8s;   /**< Number of tbl8s to allocate. */
-	int flags;               /**< This field is currently unused. */
+	/**
+	 * Optional feature flags from RTE_LPM_F_*. rte_lpm_create() fails
+	 * with EINVAL if any other bit is set.
+	 */
+	int flags;
 };
 
 /** @internal LPM structure. */
@@ -215,7 +232,8 @@ int rte_lpm_rcu_qsbr_add(struct rte_lpm *lpm, struct rte_lpm_rcu_config *cfg);
  * @param next_hop
  *   Next hop of the rule to be added to the LPM table
  * @return
- *   0 on success, negative value otherwise
+ *   0 on success, negative value otherwise. -EINVAL if the LPM is in
+ *   versioned mode and no RCU QSBR variable is attached yet.
  */
 int
 rte_lpm_add(struct rte_lpm *lpm, uint32_t ip, uint8_t depth, uint32_t next_hop);
@@ -249,7 +267,8 @@ uint32_t *next_hop);
  * @param depth
  *   Depth of the rule to be deleted from the LPM table
  * @return
- *   0 on success, negative value otherwise
+ *   0 on success, negative value otherwise. -EINVAL if the LPM is in
+ *   versioned mode and no RCU QSBR variable is attached yet.
  */
 int
 rte_lpm_delete(struct rte_lpm *lpm, uint32_t ip, uint8_t depth);
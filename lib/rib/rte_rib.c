@@ -10,7 +10,6 @@
 #include <rte_eal_memconfig.h>
 #include <rte_errno.h>
 #include <rte_malloc.h>
-#include <rte_mempool.h>
 #include <rte_string_fns.h>
 #include <rte_tailq.h>
 
@@ -31,27 +30,104 @@ EAL_REGISTER_TAILQ(rte_rib_tailq)
 #define RIB_MAXDEPTH		32
 /* Maximum length of a RIB name. */
 #define RTE_RIB_NAMESIZE	64
+/* Nodes are aligned on, and linked in units of, this many bytes. */
+#define RIB_NODE_ALIGN		sizeof(uint64_t)
+/* End of the list of free nodes */
+#define RIB_NODE_NONE		UINT32_MAX
 
+/*
+ * Nodes live in a single array, the links between them are 32-bit offsets
+ * from the node in units of RIB_NODE_ALIGN, 0 meaning no node.
+ */
 struct rte_rib_node {
-	struct rte_rib_node	*left;
-	struct rte_rib_node	*right;
-	struct rte_rib_node	*parent;
+	int32_t		left;
+	int32_t		right;
+	int32_t		parent;
 	uint32_t	ip;
+	uint64_t	nh;
 	uint8_t		depth;
 	uint8_t		flag;
-	uint64_t	nh;
 	uint64_t ext[];
 };
 
 struct rte_rib {
 	char		name[RTE_RIB_NAMESIZE];
 	struct rte_rib_node	*tree;
-	struct rte_mempool	*node_pool;
+	uint8_t			*nodes;		/**< Node array */
+	uint32_t		node_sz;	/**< Node size with ext */
+	uint32_t		free_node;	/**< First free node index */
+	uint32_t		used_nodes;	/**< Never allocated past it */
 	uint32_t		cur_nodes;
 	uint32_t		cur_routes;
 	uint32_t		max_nodes;
+	int			socket_id;
 };
 
+static inline struct rte_rib_node *
+get_node(const struct rte_rib *rib, uint32_t idx)
+{
+	return (struct rte_rib_node *)(rib->nodes + (size_t)idx * rib->node_sz);
+}
+
+static inline uint32_t
+get_node_idx(const struct rte_rib *rib, const struct rte_rib_node *node)
+{
+	return ((const uint8_t *)node - rib->nodes) / rib->node_sz;
+}
+
+static inline struct rte_rib_node *
+get_link(const struct rte_rib_node *node, int32_t link)
+{
+	if (link == 0)
+		return NULL;
+	return (struct rte_rib_node *)((uintptr_t)node +
+		(intptr_t)link * (intptr_t)RIB_NODE_ALIGN);
+}
+
+static inline int32_t
+make_link(const struct rte_rib_node *node, const struct rte_rib_node *to)
+{
+	if (to == NULL)
+		return 0;
+	return ((intptr_t)to - (intptr_t)node) / (intptr_t)RIB_NODE_ALIGN;
+}
+
+static inline struct rte_rib_node *
+get_left(const struct rte_rib_node *node)
+{
+	return get_link(node, node->left);
+}
+
+static inline struct rte_rib_node *
+get_right(const struct rte_rib_node *node)
+{
+	return get_link(node, node->right);
+}
+
+static inline struct rte_rib_node *
+get_parent(const struct rte_rib_node *node)
+{
+	return get_link(node, node->parent);
+}
+
+/*
+ * Put child under parent on the side given by ip, or at the root of the
+ * tree if parent is NULL
+ */
+static inline void
+set_child(struct rte_rib *rib, struct rte_rib_node *parent, uint32_t ip,
+	struct rte_rib_node *child)
+{
+	if (parent == NULL)
+		rib->tree = child;
+	else if (ip & (1 << (31 - parent->depth)))
+		parent->right = make_link(parent, child);
+	else
+		parent->left = make_link(parent, child);
+	if (child != NULL)
+		child->parent = make_link(child, parent);
+}
+
 static inline bool
 is_valid_node(const struct rte_rib_node *node)
 {
@@ -61,7 +137,7 @@ is_valid_node(const struct rte_rib_node *node)
 static inline bool
 is_right_node(const struct rte_rib_node *node)
 {
-	return node->parent->right == node;
+	return get_right(get_parent(node)) == node;
 }
 
 /*
@@ -78,19 +154,29 @@ get_nxt_node(struct rte_rib_node *node, uint32_t ip)
 {
 	if (node->depth == RIB_MAXDEPTH)
 		return NULL;
-	return (ip & (1 << (31 - node->depth))) ? node->right : node->left;
+	return (ip & (1 << (31 - node->depth))) ? get_right(node) :
+		get_left(node);
 }
 
+/*
+ * Get a node from the free list first, then from the never used ones
+ */
 static struct rte_rib_node *
 node_alloc(struct rte_rib *rib)
 {
 	struct rte_rib_node *ent;
-	int ret;
 
-	ret = rte_mempool_get(rib->node_pool, (void *)&ent);
-	if (unlikely(ret != 0))
+	if (rib->free_node != RIB_NODE_NONE) {
+		ent = get_node(rib, rib->free_node);
+		rib->free_node = (uint32_t)ent->left;
+	} else if (rib->used_nodes < rib->max_nodes)
+		ent = get_node(rib, rib->used_nodes++);
+	else
 		return NULL;
 	++rib->cur_nodes;
+	ent->left = 0;
+	ent->right = 0;
+	ent->parent = 0;
 	return ent;
 }
 
@@ -98,7 +184,8 @@ static void
 node_free(struct rte_rib *rib, struct rte_rib_node *ent)
 {
 	--rib->cur_nodes;
-	rte_mempool_put(rib->node_pool, ent);
+	ent->left = (int32_t)rib->free_node;
+	rib->free_node = get_node_idx(rib, ent);
 }
 
 struct rte_rib_node *
@@ -127,9 +214,9 @@ rte_rib_lookup_parent(struct rte_rib_node *ent)
 
 	if (ent == NULL)
 		return NULL;
-	tmp = ent->parent;
+	tmp = get_parent(ent);
 	while ((tmp != NULL) &&	!is_valid_node(tmp))
-		tmp = tmp->parent;
+		tmp = get_parent(tmp);
 	return tmp;
 }
 
@@ -168,32 +255,27 @@ rte_rib_lookup_exact(struct rte_rib *rib, uint32_t ip, uint8_t depth)
  *  for a given in args ip/depth prefix
  *  last = NULL means the first invocation
  */
-struct rte_rib_node *
-rte_rib_get_nxt(struct rte_rib *rib, uint32_t ip,
+static struct rte_rib_node *
+__rib_get_nxt(struct rte_rib *rib, uint32_t ip,
 	uint8_t depth, struct rte_rib_node *last, int flag)
 {
 	struct rte_rib_node *tmp, *prev = NULL;
 
-	if (unlikely(rib == NULL || depth > RIB_MAXDEPTH)) {
-		rte_errno = EINVAL;
-		return NULL;
-	}
-
 	if (last == NULL) {
 		tmp = rib->tree;
 		while ((tmp) && (tmp->depth < depth))
 			tmp = get_nxt_node(tmp, ip);
 	} else {
 		tmp = last;
-		while ((tmp->parent != NULL) && (is_right_node(tmp) ||
-				(tmp->parent->right == NULL))) {
-			tmp = tmp->parent;
+		while ((get_parent(tmp) != NULL) && (is_right_node(tmp) ||
+				(get_right(get_parent(tmp)) == NULL))) {
+			tmp = get_parent(tmp);
 			if (is_valid_node(tmp) &&
 					(is_covered(tmp->ip, ip, depth) &&
 					(tmp->depth > depth)))
 				return tmp;
 		}
-		tmp = (tmp->parent) ? tmp->parent->right : NULL;
+		tmp = (get_parent(tmp)) ? get_right(get_parent(tmp)) : NULL;
 	}
 	while (tmp) {
 		if (is_valid_node(tmp) &&
@@ -203,15 +285,47 @@ rte_rib_get_nxt(struct rte_rib *rib, uint32_t ip,
 			if (flag == RTE_RIB_GET_NXT_COVER)
 				return prev;
 		}
-		tmp = (tmp->left) ? tmp->left : tmp->right;
+		tmp = (get_left(tmp)) ? get_left(tmp) : get_right(tmp);
 	}
 	return prev;
 }
 
+struct rte_rib_node *
+rte_rib_get_nxt(struct rte_rib *rib, uint32_t ip,
+	uint8_t depth, struct rte_rib_node *last, int flag)
+{
+	if (unlikely(rib == NULL || depth > RIB_MAXDEPTH)) {
+		rte_errno = EINVAL;
+		return NULL;
+	}
+
+	return __rib_get_nxt(rib, ip, depth, last, flag);
+}
+
+int
+rte_rib_get_nxt_bulk(struct rte_rib *rib, uint32_t ip, uint8_t depth,
+	struct rte_rib_node *last, int flag, struct rte_rib_node **nodes,
+	unsigned int n)
+{
+	unsigned int i;
+
+	if (unlikely(rib == NULL || depth > RIB_MAXDEPTH || nodes == NULL))
+		return -EINVAL;
+
+	for (i = 0; i < n; i++) {
+		last = __rib_get_nxt(rib, ip, depth, last, flag);
+		if (last == NULL)
+			break;
+		nodes[i] = last;
+	}
+
+	return i;
+}
+
 void
 rte_rib_remove(struct rte_rib *rib, uint32_t ip, uint8_t depth)
 {
-	struct rte_rib_node *cur, *prev, *child;
+	struct rte_rib_node *cur, *prev, *child, *parent;
 
 	cur = rte_rib_lookup_exact(rib, ip, depth);
 	if (cur == NULL)
@@ -220,22 +334,18 @@ rte_rib_remove(struct rte_rib *rib, uint32_t ip, uint8_t depth)
 	--rib->cur_routes;
 	cur->flag &= ~RTE_RIB_VALID_NODE;
 	while (!is_valid_node(cur)) {
-		if ((cur->left != NULL) && (cur->right != NULL))
+		if ((get_left(cur) != NULL) && (get_right(cur) != NULL))
 			return;
-		child = (cur->left == NULL) ? cur->right : cur->left;
-		if (child != NULL)
-			child->parent = cur->parent;
-		if (cur->parent == NULL) {
-			rib->tree = child;
+		child = (get_left(cur) == NULL) ? get_right(cur) :
+			get_left(cur);
+		parent = get_parent(cur);
+		set_child(rib, parent, cur->ip, child);
+		if (parent == NULL) {
 			node_free(rib, cur);
 			return;
 		}
-		if (cur->parent->left == cur)
-			cur->parent->left = child;
-		else
-			cur->parent->right = child;
 		prev = cur;
-		cur = cur->parent;
+		cur = parent;
 		node_free(rib, prev);
 	}
 }
@@ -243,7 +353,7 @@ rte_rib_remove(struct rte_rib *rib, uint32_t ip, uint8_t depth)
 struct rte_rib_node *
 rte_rib_insert(struct rte_rib *rib, uint32_t ip, uint8_t depth)
 {
-	struct rte_rib_node **tmp;
+	struct rte_rib_node *tmp;
 	struct rte_rib_node *prev = NULL;
 	struct rte_rib_node *new_node = NULL;
 	struct rte_rib_node *common_node = NULL;
@@ -256,7 +366,7 @@ rte_rib_insert(struct rte_rib *rib, uint32_t ip, uint8_t depth)
 		return NULL;
 	}
 
-	tmp = &rib->tree;
+	tmp = rib->tree;
 	ip &= rte_rib_depth_to_mask(depth);
 	new_node = __rib_lookup_exact(rib, ip, depth);
 	if (new_node != NULL) {
@@ -269,9 +379,6 @@ rte_rib_insert(struct rte_rib *rib, uint32_t ip, uint8_t depth)
 		rte_errno = ENOMEM;
 		return NULL;
 	}
-	new_node->left = NULL;
-	new_node->right = NULL;
-	new_node->parent = NULL;
 	new_node->ip = ip;
 	new_node->depth = depth;
 	new_node->flag = RTE_RIB_VALID_NODE;
@@ -279,11 +386,10 @@ rte_rib_insert(struct rte_rib *rib, uint32_t ip, uint8_t depth)
 	/* traverse down the tree to find matching node or closest matching */
 	while (1) {
 		/* insert as the last node in the branch */
-		if (*tmp == NULL) {
-			*tmp = new_node;
-			new_node->parent = prev;
+		if (tmp == NULL) {
+			set_child(rib, prev, ip, new_node);
 			++rib->cur_routes;
-			return *tmp;
+			return new_node;
 		}
 		/*
 		 * Intermediate node found.
@@ -291,34 +397,29 @@ rte_rib_insert(struct rte_rib *rib, uint32_t ip, uint8_t depth)
 		 * but node with proper search criteria is found.
 		 * Validate intermediate node and return.
 		 */
-		if ((ip == (*tmp)->ip) && (depth == (*tmp)->depth)) {
+		if ((ip == tmp->ip) && (depth == tmp->depth)) {
 			node_free(rib, new_node);
-			(*tmp)->flag |= RTE_RIB_VALID_NODE;
+			tmp->flag |= RTE_RIB_VALID_NODE;
 			++rib->cur_routes;
-			return *tmp;
+			return tmp;
 		}
-		d = (*tmp)->depth;
-		if ((d >= depth) || !is_covered(ip, (*tmp)->ip, d))
+		d = tmp->depth;
+		if ((d >= depth) || !is_covered(ip, tmp->ip, d))
 			break;
-		prev = *tmp;
-		tmp = (ip & (1 << (31 - d))) ? &(*tmp)->right : &(*tmp)->left;
+		prev = tmp;
+		tmp = get_nxt_node(tmp, ip);
 	}
 	/* closest node found, new_node should be inserted in the middle */
-	common_depth = RTE_MIN(depth, (*tmp)->depth);
-	common_prefix = ip ^ (*tmp)->ip;
+	common_depth = RTE_MIN(depth, tmp->depth);
+	common_prefix = ip ^ tmp->ip;
 	d = (common_prefix == 0) ? 32 : rte_clz32(common_prefix);
 
 	common_depth = RTE_MIN(d, common_depth);
 	common_prefix = ip & rte_rib_depth_to_mask(common_depth);
 	if ((common_prefix == ip) && (common_depth == depth)) {
 		/* insert as a parent */
-		if ((*tmp)->ip & (1 << (31 - depth)))
-			new_node->right = *tmp;
-		else
-			new_node->left = *tmp;
-		new_node->parent = (*tmp)->parent;
-		(*tmp)->parent = new_node;
-		*tmp = new_node;
+		set_child(rib, prev, ip, new_node);
+		set_child(rib, new_node, tmp->ip, tmp);
 	} else {
 		/* create intermediate node */
 		common_node = node_alloc(rib);
@@ -330,22 +431,123 @@ rte_rib_insert(struct rte_rib *rib, uint32_t ip, uint8_t depth)
 		common_node->ip = common_prefix;
 		common_node->depth = common_depth;
 		common_node->flag = 0;
-		common_node->parent = (*tmp)->parent;
-		new_node->parent = common_node;
-		(*tmp)->parent = common_node;
-		if ((new_node->ip & (1 << (31 - common_depth))) == 0) {
-			common_node->left = new_node;
-			common_node->right = *tmp;
-		} else {
-			common_node->left = *tmp;
-			common_node->right = new_node;
-		}
-		*tmp = common_node;
+		set_child(rib, prev, ip, common_node);
+		set_child(rib, common_node, new_node->ip, new_node);
+		set_child(rib, common_node, tmp->ip, tmp);
 	}
 	++rib->cur_routes;
 	return new_node;
 }
 
+/*
+ * Get the node following node in depth first order, the order in which
+ * the tree is walked
+ */
+static struct rte_rib_node *
+get_dfs_nxt(struct rte_rib_node *node)
+{
+	if (get_left(node) != NULL)
+		return get_left(node);
+	if (get_right(node) != NULL)
+		return get_right(node);
+	while (get_parent(node) != NULL) {
+		if (!is_right_node(node) && (get_right(get_parent(node)) != NULL))
+			return get_right(get_parent(node));
+		node = get_parent(node);
+	}
+	return NULL;
+}
+
+/* Turn a link into the new index of the node plus one */
+static inline int32_t
+link_to_pos(const struct rte_rib *rib, const uint32_t *pos,
+	const struct rte_rib_node *node, int32_t link)
+{
+	if (link == 0)
+		return 0;
+	return pos[get_node_idx(rib, get_link(node, link))] + 1;
+}
+
+/* Turn the new index of a node plus one back into a link */
+static inline int32_t
+pos_to_link(const struct rte_rib *rib, const struct rte_rib_node *node,
+	int32_t pos)
+{
+	if (pos == 0)
+		return 0;
+	return make_link(node, get_node(rib, pos - 1));
+}
+
+int
+rte_rib_compact(struct rte_rib *rib)
+{
+	struct rte_rib_node *node;
+	uint32_t *pos;
+	void *tmp;
+	uint32_t i, j, num = 0;
+
+	if (unlikely(rib == NULL))
+		return -EINVAL;
+
+	if (rib->tree == NULL) {
+		rib->free_node = RIB_NODE_NONE;
+		rib->used_nodes = 0;
+		return 0;
+	}
+
+	pos = rte_malloc_socket(NULL, sizeof(uint32_t) * rib->used_nodes, 0,
+		rib->socket_id);
+	tmp = rte_malloc_socket(NULL, rib->node_sz, 0, rib->socket_id);
+	if ((pos == NULL) || (tmp == NULL)) {
+		rte_free(pos);
+		rte_free(tmp);
+		return -ENOMEM;
+	}
+
+	for (i = 0; i < rib->used_nodes; i++)
+		pos[i] = RIB_NODE_NONE;
+	for (node = rib->tree; node != NULL; node = get_dfs_nxt(node))
+		pos[get_node_idx(rib, node)] = num++;
+
+	/* links only depend on the node holding them while nodes move */
+	for (i = 0; i < rib->used_nodes; i++) {
+		if (pos[i] == RIB_NODE_NONE)
+			continue;
+		node = get_node(rib, i);
+		node->left = link_to_pos(rib, pos, node, node->left);
+		node->right = link_to_pos(rib, pos, node, node->right);
+		node->parent = link_to_pos(rib, pos, node, node->parent);
+	}
+
+	/* every swap puts one node at its final place */
+	for (i = 0; i < rib->used_nodes; i++) {
+		while ((pos[i] != RIB_NODE_NONE) && (pos[i] != i)) {
+			j = pos[i];
+			memcpy(tmp, get_node(rib, j), rib->node_sz);
+			memcpy(get_node(rib, j), get_node(rib, i), rib->node_sz);
+			memcpy(get_node(rib, i), tmp, rib->node_sz);
+			pos[i] = pos[j];
+			pos[j] = j;
+		}
+	}
+
+	for (i = 0; i < num; i++) {
+		node = get_node(rib, i);
+		node->left = pos_to_link(rib, node, node->left);
+		node->right = pos_to_link(rib, node, node->right);
+		node->parent = pos_to_link(rib, node, node->parent);
+	}
+
+	rib->tree = get_node(rib, 0);
+	rib->free_node = RIB_NODE_NONE;
+	rib->used_nodes = num;
+
+	rte_free(tmp);
+	rte_free(pos);
+
+	return 0;
+}
+
 int
 rte_rib_get_ip(const struct rte_rib_node *node, uint32_t *ip)
 {
@@ -403,22 +605,32 @@ rte_rib_create(const char *name, int socket_id, const struct rte_rib_conf *conf)
 	struct rte_rib *rib = NULL;
 	struct rte_tailq_entry *te;
 	struct rte_rib_list *rib_list;
-	struct rte_mempool *node_pool;
+	uint8_t *nodes;
+	size_t node_sz;
 
 	/* Check user arguments. */
-	if (unlikely(name == NULL || conf == NULL || conf->max_nodes <= 0)) {
+	if (unlikely(name == NULL || conf == NULL || conf->max_nodes <= 0 ||
+			conf->ext_sz > INT32_MAX || socket_id < -1)) {
 		rte_errno = EINVAL;
 		return NULL;
 	}
 
-	snprintf(mem_name, sizeof(mem_name), "MP_%s", name);
-	node_pool = rte_mempool_create(mem_name, conf->max_nodes,
-		sizeof(struct rte_rib_node) + conf->ext_sz, 0, 0,
-		NULL, NULL, NULL, NULL, socket_id, 0);
+	/* the links must reach across the whole node array */
+	node_sz = RTE_ALIGN_CEIL(sizeof(struct rte_rib_node) + conf->ext_sz,
+		RIB_NODE_ALIGN);
+	if ((uint64_t)conf->max_nodes * node_sz >
+			(uint64_t)INT32_MAX * RIB_NODE_ALIGN) {
+		rte_errno = EINVAL;
+		return NULL;
+	}
 
-	if (node_pool == NULL) {
+	snprintf(mem_name, sizeof(mem_name), "MP_%s", name);
+	nodes = rte_malloc_socket(mem_name, conf->max_nodes * node_sz,
+		RTE_CACHE_LINE_SIZE, socket_id);
+	if (nodes == NULL) {
 		RIB_LOG(ERR,
-			"Can not allocate mempool for RIB %s", name);
+			"Can not allocate nodes for RIB %s", name);
+		rte_errno = ENOMEM;
 		return NULL;
 	}
 
@@ -460,7 +672,10 @@ rte_rib_create(const char *name, int socket_id, const struct rte_rib_conf *conf)
 	rte_strlcpy(rib->name, name, sizeof(rib->name));
 	rib->tree = NULL;
 	rib->max_nodes = conf->max_nodes;
-	rib->node_pool = node_pool;
+	rib->nodes = nodes;
+	rib->node_sz = node_sz;
+	rib->free_node = RIB_NODE_NONE;
+	rib->socket_id = socket_id;
 	te->data = (void *)rib;
 	TAILQ_INSERT_TAIL(rib_list, te, next);
 
@@ -472,7 +687,7 @@ rte_rib_create(const char *name, int socket_id, const struct rte_rib_conf *conf)
 	rte_free(te);
 exit:
 	rte_mcfg_tailq_write_unlock();
-	rte_mempool_free(node_pool);
+	rte_free(nodes);
 
 	return NULL;
 }
@@ -507,7 +722,6 @@ rte_rib_free(struct rte_rib *rib)
 {
 	struct rte_tailq_entry *te;
 	struct rte_rib_list *rib_list;
-	struct rte_rib_node *tmp = NULL;
 
 	if (rib == NULL)
 		return;
@@ -526,11 +740,7 @@ rte_rib_free(struct rte_rib *rib)
 
 	rte_mcfg_tailq_write_unlock();
 
-	while ((tmp = rte_rib_get_nxt(rib, 0, 0, tmp,
-			RTE_RIB_GET_NXT_ALL)) != NULL)
-		rte_rib_remove(rib, tmp->ip, tmp->depth);
-
-	rte_mempool_free(rib->node_pool);
+	rte_free(rib->nodes);
 	rte_free(rib);
 	rte_free(te);
 }
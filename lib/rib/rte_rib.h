@@ -17,6 +17,8 @@
 #include <stdlib.h>
 #include <stdint.h>
 
+#include <rte_compat.h>
+
 
 #ifdef __cplusplus
 extern "C" {
@@ -132,6 +134,44 @@ struct rte_rib_node *
 rte_rib_get_nxt(struct rte_rib *rib, uint32_t ip, uint8_t depth,
 	struct rte_rib_node *last, int flag);
 
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice.
+ *
+ * Retrieve up to n next more specific prefixes from the RIB
+ * that are covered by ip/depth supernet, in the order of rte_rib_get_nxt()
+ *
+ * @param rib
+ *  RIB object handle
+ * @param ip
+ *  net address of supernet prefix that covers returned more specific prefixes
+ * @param depth
+ *  supernet prefix length
+ * @param last
+ *   pointer to the last returned prefix to get the following ones
+ *   or
+ *   NULL to get the first more specific prefixes
+ * @param flag
+ *  -RTE_RIB_GET_NXT_ALL
+ *   get all prefixes from subtrie
+ *  -RTE_RIB_GET_NXT_COVER
+ *   get only first more specific prefix even if it have more specifics
+ * @param nodes
+ *  array to store the returned prefixes, the last one is used as last
+ *  to continue the walk
+ * @param n
+ *  maximum number of prefixes to return
+ * @return
+ *  number of prefixes stored in nodes, less than n when there are no
+ *  prefixes left
+ *  -EINVAL for invalid parameters
+ */
+__rte_experimental
+int
+rte_rib_get_nxt_bulk(struct rte_rib *rib, uint32_t ip,
+	uint8_t depth, struct rte_rib_node *last, int flag,
+	struct rte_rib_node **nodes, unsigned int n);
+
 /**
  * Remove prefix from the RIB
  *
@@ -161,6 +201,29 @@ rte_rib_remove(struct rte_rib *rib, uint32_t ip, uint8_t depth);
 struct rte_rib_node *
 rte_rib_insert(struct rte_rib *rib, uint32_t ip, uint8_t depth);
 
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice.
+ *
+ * Compact the RIB nodes.
+ *
+ * Nodes are moved to the start of the node array in the order they are
+ * walked, so that walks and lookups touch consecutive memory again after
+ * many insertions and removals. It is meant to be called from time to
+ * time, e.g. once a routing table has converged.
+ * All the rte_rib_node pointers previously returned are invalidated.
+ *
+ * @param rib
+ *  RIB object handle
+ * @return
+ *  0 on success
+ *  -EINVAL for invalid parameters
+ *  -ENOMEM if there is not enough memory for the temporary state
+ */
+__rte_experimental
+int
+rte_rib_compact(struct rte_rib *rib);
+
 /**
  * Get an ip from rte_rib_node
  *
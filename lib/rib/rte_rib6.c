@@ -11,7 +11,6 @@
 #include <rte_errno.h>
 #include <rte_log.h>
 #include <rte_malloc.h>
-#include <rte_mempool.h>
 #include <rte_string_fns.h>
 #include <rte_tailq.h>
 
@@ -22,6 +21,10 @@
 #define RTE_RIB_VALID_NODE	1
 /* Maximum length of a RIB6 name. */
 #define RTE_RIB6_NAMESIZE	64
+/* Nodes are aligned on, and linked in units of, this many bytes. */
+#define RIB6_NODE_ALIGN		sizeof(uint64_t)
+/* End of the list of free nodes */
+#define RIB6_NODE_NONE		UINT32_MAX
 
 TAILQ_HEAD(rte_rib6_list, rte_tailq_entry);
 static struct rte_tailq_elem rte_rib6_tailq = {
@@ -29,12 +32,16 @@ static struct rte_tailq_elem rte_rib6_tailq = {
 };
 EAL_REGISTER_TAILQ(rte_rib6_tailq)
 
+/*
+ * Nodes live in a single array, the links between them are 32-bit offsets
+ * from the node in units of RIB6_NODE_ALIGN, 0 meaning no node.
+ */
 struct rte_rib6_node {
-	struct rte_rib6_node	*left;
-	struct rte_rib6_node	*right;
-	struct rte_rib6_node	*parent;
 	uint64_t		nh;
 	struct rte_ipv6_addr	ip;
+	int32_t			left;
+	int32_t			right;
+	int32_t			parent;
 	uint8_t			depth;
 	uint8_t			flag;
 	uint64_t ext[];
@@ -43,12 +50,64 @@ struct rte_rib6_node {
 struct rte_rib6 {
 	char		name[RTE_RIB6_NAMESIZE];
 	struct rte_rib6_node	*tree;
-	struct rte_mempool	*node_pool;
+	uint8_t			*nodes;		/**< Node array */
+	uint32_t		node_sz;	/**< Node size with ext */
+	uint32_t		free_node;	/**< First free node index */
+	uint32_t		used_nodes;	/**< Never allocated past it */
 	uint32_t		cur_nodes;
 	uint32_t		cur_routes;
 	int			max_nodes;
+	int			socket_id;
 };
 
+static inline struct rte_rib6_node *
+get_node(const struct rte_rib6 *rib, uint32_t idx)
+{
+	return (struct rte_rib6_node *)(rib->nodes +
+		(size_t)idx * rib->node_sz);
+}
+
+static inline uint32_t
+get_node_idx(const struct rte_rib6 *rib, const struct rte_rib6_node *node)
+{
+	return ((const uint8_t *)node - rib->nodes) / rib->node_sz;
+}
+
+static inline struct rte_rib6_node *
+get_link(const struct rte_rib6_node *node, int32_t link)
+{
+	if (link == 0)
+		return NULL;
+	return (struct rte_rib6_node *)((uintptr_t)node +
+		(intptr_t)link * (intptr_t)RIB6_NODE_ALIGN);
+}
+
+static inline int32_t
+make_link(const struct rte_rib6_node *node, const struct rte_rib6_node *to)
+{
+	if (to == NULL)
+		return 0;
+	return ((intptr_t)to - (intptr_t)node) / (intptr_t)RIB6_NODE_ALIGN;
+}
+
+static inline struct rte_rib6_node *
+get_left(const struct rte_rib6_node *node)
+{
+	return get_link(node, node->left);
+}
+
+static inline struct rte_rib6_node *
+get_right(const struct rte_rib6_node *node)
+{
+	return get_link(node, node->right);
+}
+
+static inline struct rte_rib6_node *
+get_parent(const struct rte_rib6_node *node)
+{
+	return get_link(node, node->parent);
+}
+
 static inline bool
 is_valid_node(const struct rte_rib6_node *node)
 {
@@ -58,7 +117,7 @@ is_valid_node(const struct rte_rib6_node *node)
 static inline bool
 is_right_node(const struct rte_rib6_node *node)
 {
-	return node->parent->right == node;
+	return get_right(get_parent(node)) == node;
 }
 
 static inline int
@@ -91,19 +150,46 @@ get_nxt_node(struct rte_rib6_node *node,
 	if (node->depth == RTE_IPV6_MAX_DEPTH)
 		return NULL;
 
-	return (get_dir(ip, node->depth)) ? node->right : node->left;
+	return (get_dir(ip, node->depth)) ? get_right(node) : get_left(node);
 }
 
+/*
+ * Put child under parent on the side given by ip, or at the root of the
+ * tree if parent is NULL
+ */
+static inline void
+set_child(struct rte_rib6 *rib, struct rte_rib6_node *parent,
+	const struct rte_ipv6_addr *ip, struct rte_rib6_node *child)
+{
+	if (parent == NULL)
+		rib->tree = child;
+	else if (get_dir(ip, parent->depth))
+		parent->right = make_link(parent, child);
+	else
+		parent->left = make_link(parent, child);
+	if (child != NULL)
+		child->parent = make_link(child, parent);
+}
+
+/*
+ * Get a node from the free list first, then from the never used ones
+ */
 static struct rte_rib6_node *
 node_alloc(struct rte_rib6 *rib)
 {
 	struct rte_rib6_node *ent;
-	int ret;
 
-	ret = rte_mempool_get(rib->node_pool, (void *)&ent);
-	if (unlikely(ret != 0))
+	if (rib->free_node != RIB6_NODE_NONE) {
+		ent = get_node(rib, rib->free_node);
+		rib->free_node = (uint32_t)ent->left;
+	} else if (rib->used_nodes < (uint32_t)rib->max_nodes)
+		ent = get_node(rib, rib->used_nodes++);
+	else
 		return NULL;
 	++rib->cur_nodes;
+	ent->left = 0;
+	ent->right = 0;
+	ent->parent = 0;
 	return ent;
 }
 
@@ -111,7 +197,8 @@ static void
 node_free(struct rte_rib6 *rib, struct rte_rib6_node *ent)
 {
 	--rib->cur_nodes;
-	rte_mempool_put(rib->node_pool, ent);
+	ent->left = (int32_t)rib->free_node;
+	rib->free_node = get_node_idx(rib, ent);
 }
 
 struct rte_rib6_node *
@@ -143,9 +230,9 @@ rte_rib6_lookup_parent(struct rte_rib6_node *ent)
 	if (ent == NULL)
 		return NULL;
 
-	tmp = ent->parent;
+	tmp = get_parent(ent);
 	while ((tmp != NULL) && (!is_valid_node(tmp)))
-		tmp = tmp->parent;
+		tmp = get_parent(tmp);
 
 	return tmp;
 }
@@ -184,59 +271,93 @@ rte_rib6_lookup_exact(struct rte_rib6 *rib,
 
 /*
  *  Traverses on subtree and retrieves more specific routes
- *  for a given in args ip/depth prefix
+ *  for a given in args masked ip/depth prefix
  *  last = NULL means the first invocation
  */
-struct rte_rib6_node *
-rte_rib6_get_nxt(struct rte_rib6 *rib,
-	const struct rte_ipv6_addr *ip,
+static struct rte_rib6_node *
+__rib6_get_nxt(struct rte_rib6 *rib, const struct rte_ipv6_addr *ip,
 	uint8_t depth, struct rte_rib6_node *last, int flag)
 {
 	struct rte_rib6_node *tmp, *prev = NULL;
-	struct rte_ipv6_addr tmp_ip;
-
-	if (unlikely(rib == NULL || ip == NULL || depth > RTE_IPV6_MAX_DEPTH)) {
-		rte_errno = EINVAL;
-		return NULL;
-	}
-
-	tmp_ip = *ip;
-	rte_ipv6_addr_mask(&tmp_ip, depth);
 
 	if (last == NULL) {
 		tmp = rib->tree;
 		while ((tmp) && (tmp->depth < depth))
-			tmp = get_nxt_node(tmp, &tmp_ip);
+			tmp = get_nxt_node(tmp, ip);
 	} else {
 		tmp = last;
-		while ((tmp->parent != NULL) && (is_right_node(tmp) ||
-				(tmp->parent->right == NULL))) {
-			tmp = tmp->parent;
+		while ((get_parent(tmp) != NULL) && (is_right_node(tmp) ||
+				(get_right(get_parent(tmp)) == NULL))) {
+			tmp = get_parent(tmp);
 			if (is_valid_node(tmp) &&
-					(rte_ipv6_addr_eq_prefix(&tmp->ip, &tmp_ip, depth) &&
+					(rte_ipv6_addr_eq_prefix(&tmp->ip, ip, depth) &&
 					(tmp->depth > depth)))
 				return tmp;
 		}
-		tmp = (tmp->parent != NULL) ? tmp->parent->right : NULL;
+		tmp = (get_parent(tmp) != NULL) ? get_right(get_parent(tmp)) :
+			NULL;
 	}
 	while (tmp) {
 		if (is_valid_node(tmp) &&
-				(rte_ipv6_addr_eq_prefix(&tmp->ip, &tmp_ip, depth) &&
+				(rte_ipv6_addr_eq_prefix(&tmp->ip, ip, depth) &&
 				(tmp->depth > depth))) {
 			prev = tmp;
 			if (flag == RTE_RIB6_GET_NXT_COVER)
 				return prev;
 		}
-		tmp = (tmp->left != NULL) ? tmp->left : tmp->right;
+		tmp = (get_left(tmp) != NULL) ? get_left(tmp) : get_right(tmp);
 	}
 	return prev;
 }
 
+struct rte_rib6_node *
+rte_rib6_get_nxt(struct rte_rib6 *rib,
+	const struct rte_ipv6_addr *ip,
+	uint8_t depth, struct rte_rib6_node *last, int flag)
+{
+	struct rte_ipv6_addr tmp_ip;
+
+	if (unlikely(rib == NULL || ip == NULL || depth > RTE_IPV6_MAX_DEPTH)) {
+		rte_errno = EINVAL;
+		return NULL;
+	}
+
+	tmp_ip = *ip;
+	rte_ipv6_addr_mask(&tmp_ip, depth);
+
+	return __rib6_get_nxt(rib, &tmp_ip, depth, last, flag);
+}
+
+int
+rte_rib6_get_nxt_bulk(struct rte_rib6 *rib, const struct rte_ipv6_addr *ip,
+	uint8_t depth, struct rte_rib6_node *last, int flag,
+	struct rte_rib6_node **nodes, unsigned int n)
+{
+	struct rte_ipv6_addr tmp_ip;
+	unsigned int i;
+
+	if (unlikely(rib == NULL || ip == NULL || depth > RTE_IPV6_MAX_DEPTH ||
+			nodes == NULL))
+		return -EINVAL;
+
+	tmp_ip = *ip;
+	rte_ipv6_addr_mask(&tmp_ip, depth);
+
+	for (i = 0; i < n; i++) {
+		last = __rib6_get_nxt(rib, &tmp_ip, depth, last, flag);
+		if (last == NULL)
+			break;
+		nodes[i] = last;
+	}
+
+	return i;
+}
+
 void
 rte_rib6_remove(struct rte_rib6 *rib,
 	const struct rte_ipv6_addr *ip, uint8_t depth)
 {
-	struct rte_rib6_node *cur, *prev, *child;
+	struct rte_rib6_node *cur, *prev, *child, *parent;
 
 	cur = rte_rib6_lookup_exact(rib, ip, depth);
 	if (cur == NULL)
@@ -245,22 +366,18 @@ rte_rib6_remove(struct rte_rib6 *rib,
 	--rib->cur_routes;
 	cur->flag &= ~RTE_RIB_VALID_NODE;
 	while (!is_valid_node(cur)) {
-		if ((cur->left != NULL) && (cur->right != NULL))
+		if ((get_left(cur) != NULL) && (get_right(cur) != NULL))
 			return;
-		child = (cur->left == NULL) ? cur->right : cur->left;
-		if (child != NULL)
-			child->parent = cur->parent;
-		if (cur->parent == NULL) {
-			rib->tree = child;
+		child = (get_left(cur) == NULL) ? get_right(cur) :
+			get_left(cur);
+		parent = get_parent(cur);
+		set_child(rib, parent, &cur->ip, child);
+		if (parent == NULL) {
 			node_free(rib, cur);
 			return;
 		}
-		if (cur->parent->left == cur)
-			cur->parent->left = child;
-		else
-			cur->parent->right = child;
 		prev = cur;
-		cur = cur->parent;
+		cur = parent;
 		node_free(rib, prev);
 	}
 }
@@ -269,7 +386,7 @@ struct rte_rib6_node *
 rte_rib6_insert(struct rte_rib6 *rib,
 	const struct rte_ipv6_addr *ip, uint8_t depth)
 {
-	struct rte_rib6_node **tmp;
+	struct rte_rib6_node *tmp;
 	struct rte_rib6_node *prev = NULL;
 	struct rte_rib6_node *new_node = NULL;
 	struct rte_rib6_node *common_node = NULL;
@@ -283,7 +400,7 @@ rte_rib6_insert(struct rte_rib6 *rib,
 		return NULL;
 	}
 
-	tmp = &rib->tree;
+	tmp = rib->tree;
 
 	tmp_ip = *ip;
 	rte_ipv6_addr_mask(&tmp_ip, depth);
@@ -299,9 +416,6 @@ rte_rib6_insert(struct rte_rib6 *rib,
 		rte_errno = ENOMEM;
 		return NULL;
 	}
-	new_node->left = NULL;
-	new_node->right = NULL;
-	new_node->parent = NULL;
 	new_node->ip = tmp_ip;
 	new_node->depth = depth;
 	new_node->flag = RTE_RIB_VALID_NODE;
@@ -309,11 +423,10 @@ rte_rib6_insert(struct rte_rib6 *rib,
 	/* traverse down the tree to find matching node or closest matching */
 	while (1) {
 		/* insert as the last node in the branch */
-		if (*tmp == NULL) {
-			*tmp = new_node;
-			new_node->parent = prev;
+		if (tmp == NULL) {
+			set_child(rib, prev, &tmp_ip, new_node);
 			++rib->cur_routes;
-			return *tmp;
+			return new_node;
 		}
 		/*
 		 * Intermediate node found.
@@ -321,27 +434,26 @@ rte_rib6_insert(struct rte_rib6 *rib,
 		 * but node with proper search criteria is found.
 		 * Validate intermediate node and return.
 		 */
-		if (rte_ipv6_addr_eq(&tmp_ip, &(*tmp)->ip) && (depth == (*tmp)->depth)) {
+		if (rte_ipv6_addr_eq(&tmp_ip, &tmp->ip) && (depth == tmp->depth)) {
 			node_free(rib, new_node);
-			(*tmp)->flag |= RTE_RIB_VALID_NODE;
+			tmp->flag |= RTE_RIB_VALID_NODE;
 			++rib->cur_routes;
-			return *tmp;
+			return tmp;
 		}
 
-		if (!rte_ipv6_addr_eq_prefix(&tmp_ip, &(*tmp)->ip, (*tmp)->depth) ||
-				((*tmp)->depth >= depth)) {
+		if (!rte_ipv6_addr_eq_prefix(&tmp_ip, &tmp->ip, tmp->depth) ||
+				(tmp->depth >= depth)) {
 			break;
 		}
-		prev = *tmp;
+		prev = tmp;
 
-		tmp = (get_dir(&tmp_ip, (*tmp)->depth)) ? &(*tmp)->right :
-				&(*tmp)->left;
+		tmp = get_nxt_node(tmp, &tmp_ip);
 	}
 
 	/* closest node found, new_node should be inserted in the middle */
-	common_depth = RTE_MIN(depth, (*tmp)->depth);
+	common_depth = RTE_MIN(depth, tmp->depth);
 	for (i = 0, d = 0; i < RTE_IPV6_ADDR_SIZE; i++) {
-		ip_xor = tmp_ip.a[i] ^ (*tmp)->ip.a[i];
+		ip_xor = tmp_ip.a[i] ^ tmp->ip.a[i];
 		if (ip_xor == 0)
 			d += 8;
 		else {
@@ -358,13 +470,8 @@ rte_rib6_insert(struct rte_rib6 *rib,
 	if (rte_ipv6_addr_eq(&common_prefix, &tmp_ip) &&
 			(common_depth == depth)) {
 		/* insert as a parent */
-		if (get_dir(&(*tmp)->ip, depth))
-			new_node->right = *tmp;
-		else
-			new_node->left = *tmp;
-		new_node->parent = (*tmp)->parent;
-		(*tmp)->parent = new_node;
-		*tmp = new_node;
+		set_child(rib, prev, &tmp_ip, new_node);
+		set_child(rib, new_node, &tmp->ip, tmp);
 	} else {
 		/* create intermediate node */
 		common_node = node_alloc(rib);
@@ -376,22 +483,123 @@ rte_rib6_insert(struct rte_rib6 *rib,
 		common_node->ip = common_prefix;
 		common_node->depth = common_depth;
 		common_node->flag = 0;
-		common_node->parent = (*tmp)->parent;
-		new_node->parent = common_node;
-		(*tmp)->parent = common_node;
-		if (get_dir(&(*tmp)->ip, common_depth) == 1) {
-			common_node->left = new_node;
-			common_node->right = *tmp;
-		} else {
-			common_node->left = *tmp;
-			common_node->right = new_node;
-		}
-		*tmp = common_node;
+		set_child(rib, prev, &tmp_ip, common_node);
+		set_child(rib, common_node, &new_node->ip, new_node);
+		set_child(rib, common_node, &tmp->ip, tmp);
 	}
 	++rib->cur_routes;
 	return new_node;
 }
 
+/*
+ * Get the node following node in depth first order, the order in which
+ * the tree is walked
+ */
+static struct rte_rib6_node *
+get_dfs_nxt(struct rte_rib6_node *node)
+{
+	if (get_left(node) != NULL)
+		return get_left(node);
+	if (get_right(node) != NULL)
+		return get_right(node);
+	while (get_parent(node) != NULL) {
+		if (!is_right_node(node) && (get_right(get_parent(node)) != NULL))
+			return get_right(get_parent(node));
+		node = get_parent(node);
+	}
+	return NULL;
+}
+
+/* Turn a link into the new index of the node plus one */
+static inline int32_t
+link_to_pos(const struct rte_rib6 *rib, const uint32_t *pos,
+	const struct rte_rib6_node *node, int32_t link)
+{
+	if (link == 0)
+		return 0;
+	return pos[get_node_idx(rib, get_link(node, link))] + 1;
+}
+
+/* Turn the new index of a node plus one back into a link */
+static inline int32_t
+pos_to_link(const struct rte_rib6 *rib, const struct rte_rib6_node *node,
+	int32_t pos)
+{
+	if (pos == 0)
+		return 0;
+	return make_link(node, get_node(rib, pos - 1));
+}
+
+int
+rte_rib6_compact(struct rte_rib6 *rib)
+{
+	struct rte_rib6_node *node;
+	uint32_t *pos;
+	void *tmp;
+	uint32_t i, j, num = 0;
+
+	if (unlikely(rib == NULL))
+		return -EINVAL;
+
+	if (rib->tree == NULL) {
+		rib->free_node = RIB6_NODE_NONE;
+		rib->used_nodes = 0;
+		return 0;
+	}
+
+	pos = rte_malloc_socket(NULL, sizeof(uint32_t) * rib->used_nodes, 0,
+		rib->socket_id);
+	tmp = rte_malloc_socket(NULL, rib->node_sz, 0, rib->socket_id);
+	if ((pos == NULL) || (tmp == NULL)) {
+		rte_free(pos);
+		rte_free(tmp);
+		return -ENOMEM;
+	}
+
+	for (i = 0; i < rib->used_nodes; i++)
+		pos[i] = RIB6_NODE_NONE;
+	for (node = rib->tree; node != NULL; node = get_dfs_nxt(node))
+		pos[get_node_idx(rib, node)] = num++;
+
+	/* links only depend on the node holding them while nodes move */
+	for (i = 0; i < rib->used_nodes; i++) {
+		if (pos[i] == RIB6_NODE_NONE)
+			continue;
+		node = get_node(rib, i);
+		node->left = link_to_pos(rib, pos, node, node->left);
+		node->right = link_to_pos(rib, pos, node, node->right);
+		node->parent = link_to_pos(rib, pos, node, node->parent);
+	}
+
+	/* every swap puts one node at its final place */
+	for (i = 0; i < rib->used_nodes; i++) {
+		while ((pos[i] != RIB6_NODE_NONE) && (pos[i] != i)) {
+			j = pos[i];
+			memcpy(tmp, get_node(rib, j), rib->node_sz);
+			memcpy(get_node(rib, j), get_node(rib, i), rib->node_sz);
+			memcpy(get_node(rib, i), tmp, rib->node_sz);
+			pos[i] = pos[j];
+			pos[j] = j;
+		}
+	}
+
+	for (i = 0; i < num; i++) {
+		node = get_node(rib, i);
+		node->left = pos_to_link(rib, node, node->left);
+		node->right = pos_to_link(rib, node, node->right);
+		node->parent = pos_to_link(rib, node, node->parent);
+	}
+
+	rib->tree = get_node(rib, 0);
+	rib->free_node = RIB6_NODE_NONE;
+	rib->used_nodes = num;
+
+	rte_free(tmp);
+	rte_free(pos);
+
+	return 0;
+}
+
 int
 rte_rib6_get_ip(const struct rte_rib6_node *node,
 		struct rte_ipv6_addr *ip)
@@ -451,22 +659,32 @@ rte_rib6_create(const char *name, int socket_id,
 	struct rte_rib6 *rib = NULL;
 	struct rte_tailq_entry *te;
 	struct rte_rib6_list *rib6_list;
-	struct rte_mempool *node_pool;
+	uint8_t *nodes;
+	size_t node_sz;
 
 	/* Check user arguments. */
-	if (unlikely(name == NULL || conf == NULL || conf->max_nodes <= 0)) {
+	if (unlikely(name == NULL || conf == NULL || conf->max_nodes <= 0 ||
+			conf->ext_sz > INT32_MAX || socket_id < -1)) {
 		rte_errno = EINVAL;
 		return NULL;
 	}
 
-	snprintf(mem_name, sizeof(mem_name), "MP_%s", name);
-	node_pool = rte_mempool_create(mem_name, conf->max_nodes,
-		sizeof(struct rte_rib6_node) + conf->ext_sz, 0, 0,
-		NULL, NULL, NULL, NULL, socket_id, 0);
+	/* the links must reach across the whole node array */
+	node_sz = RTE_ALIGN_CEIL(sizeof(struct rte_rib6_node) + conf->ext_sz,
+		RIB6_NODE_ALIGN);
+	if ((uint64_t)conf->max_nodes * node_sz >
+			(uint64_t)INT32_MAX * RIB6_NODE_ALIGN) {
+		rte_errno = EINVAL;
+		return NULL;
+	}
 
-	if (node_pool == NULL) {
+	snprintf(mem_name, sizeof(mem_name), "MP_%s", name);
+	nodes = rte_malloc_socket(mem_name, conf->max_nodes * node_sz,
+		RTE_CACHE_LINE_SIZE, socket_id);
+	if (nodes == NULL) {
 		RIB_LOG(ERR,
-			"Can not allocate mempool for RIB6 %s", name);
+			"Can not allocate nodes for RIB6 %s", name);
+		rte_errno = ENOMEM;
 		return NULL;
 	}
 
@@ -508,7 +726,10 @@ rte_rib6_create(const char *name, int socket_id,
 	rte_strlcpy(rib->name, name, sizeof(rib->name));
 	rib->tree = NULL;
 	rib->max_nodes = conf->max_nodes;
-	rib->node_pool = node_pool;
+	rib->nodes = nodes;
+	rib->node_sz = node_sz;
+	rib->free_node = RIB6_NODE_NONE;
+	rib->socket_id = socket_id;
 
 	te->data = (void *)rib;
 	TAILQ_INSERT_TAIL(rib6_list, te, next);
@@ -521,7 +742,7 @@ rte_rib6_create(const char *name, int socket_id,
 	rte_free(te);
 exit:
 	rte_mcfg_tailq_write_unlock();
-	rte_mempool_free(node_pool);
+	rte_free(nodes);
 
 	return NULL;
 }
@@ -561,7 +782,6 @@ rte_rib6_free(struct rte_rib6 *rib)
 {
 	struct rte_tailq_entry *te;
 	struct rte_rib6_list *rib6_list;
-	struct rte_rib6_node *tmp = NULL;
 
 	if (unlikely(rib == NULL)) {
 		rte_errno = EINVAL;
@@ -582,12 +802,7 @@ rte_rib6_free(struct rte_rib6 *rib)
 
 	rte_mcfg_tailq_write_unlock();
 
-	while ((tmp = rte_rib6_get_nxt(rib, 0, 0, tmp,
-			RTE_RIB6_GET_NXT_ALL)) != NULL)
-		rte_rib6_remove(rib, &tmp->ip, tmp->depth);
-
-	rte_mempool_free(rib->node_pool);
-
+	rte_free(rib->nodes);
 	rte_free(rib);
 	rte_free(te);
 }
@@ -88,6 +88,11 @@ rte_table_lpm_create(void *params, int socket_id, uint32_t entry_size)
 			__func__);
 		return NULL;
 	}
+	if (p->flags & RTE_LPM_F_VERSIONED) {
+		TABLE_LOG(ERR, "%s: Versioned LPM is not supported",
+			__func__);
+		return NULL;
+	}
 	entry_size = RTE_ALIGN(entry_size, sizeof(uint64_t));
 
 	/* Memory allocation */
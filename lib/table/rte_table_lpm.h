@@ -56,7 +56,9 @@ struct rte_table_lpm_params {
 	/**< Number of tbl8s to allocate. */
 	uint32_t number_tbl8s;
 
-	/**< This field is currently unused. */
+	/**< LPM feature flags from RTE_LPM_F_*. RTE_LPM_F_VERSIONED is
+	not supported: it needs a RCU QSBR variable, which cannot be
+	attached through the table API. */
 	int flags;
 
 	/** Number of bytes at the start of the table entry that uniquely